@@ -0,0 +1,917 @@
+#include "Core.h"
+#ifdef CC_BUILD_BENCHMARK
+#include "Builder.h"
+#include "Block.h"
+#include "BlockPhysics.h"
+#include "Constants.h"
+#include "Deflate.h"
+#include "Entity.h"
+#include "Errors.h"
+#include "ExtMath.h"
+#include "Formats.h"
+#include "Funcs.h"
+#include "Game.h"
+#include "Generator.h"
+#include "Graphics.h"
+#include "Lighting.h"
+#include "MapRenderer.h"
+#include "MeshCache.h"
+#include "Model.h"
+#include "Platform.h"
+#include "Stream.h"
+#include "String.h"
+#include "TexturePack.h"
+#include "Utils.h"
+#include "Workers.h"
+#include "World.h"
+
+/* Headless benchmark of how quickly the meshes of chunks are built, which does not need a window or GPU.
+   Build with 'make bench', then run 'ClassiCube-bench [map file] [iterations]'.
+   When no map file is given, a 256x64x256 map is generated from a fixed seed instead.
+   When the map file is 'flat', a 256x64x256 flatgrass map is generated instead.
+   Run 'ClassiCube-bench checksums' to instead measure CRC32/Adler32 throughput.
+   Run 'ClassiCube-bench sort' to instead measure sorting chunks by distance along several camera paths.
+   Run 'ClassiCube-bench inflate [files]' to instead measure decompression of .cw/.lvl/.zip files.
+   Run 'ClassiCube-bench meshcache' to instead measure building chunks with a cold and then warm mesh cache.
+   Run 'ClassiCube-bench flood [max ticks] [liquid budget]' to instead measure physics ticks while water floods a large basin.
+   Run 'ClassiCube-bench gen' to instead measure vanilla map generation, and check seeds still generate the same maps.
+   Run 'ClassiCube-bench entities [ticks] [count]' to instead measure ticking a full server's worth of moving network players. */
+#define BENCH_GEN_SEED 1234
+#define BENCH_DEF_ITERATIONS 5
+
+static struct ChunkInfo* chunks;
+
+/* Sets up 1D atlases like Atlas_Update1D would, without needing any textures */
+static void Bench_SetAtlases(int tilesPerAtlas) {
+	Atlas1D.TilesPerAtlas = tilesPerAtlas;
+	Atlas1D.Count         = (ATLAS2D_MAX_ROWS_COUNT * ATLAS2D_TILES_PER_ROW) / Atlas1D.TilesPerAtlas;
+	Atlas1D.InvTileSize   = 1.0f / Atlas1D.TilesPerAtlas;
+	Atlas1D.Mask          = Atlas1D.TilesPerAtlas - 1;
+	Atlas1D.Shift         = Math_Log2(Atlas1D.TilesPerAtlas);
+}
+
+static void Bench_Init(void) {
+	Blocks_Component.Init();
+	Workers_Component.Init();
+	World_Reset();
+
+	/* Same 1D atlases as the default 16x16 tiles terrain.png would produce */
+	Bench_SetAtlases(4096 / 16);
+	Builder_Component.Init();
+}
+
+static cc_bool Bench_LoadMap(const cc_string* path) {
+	IMapImporter importer;
+	struct Stream stream;
+	cc_result res;
+
+	importer = Map_FindImporter(path);
+	if (!importer) {
+		Platform_Log1("Unsupported map format: %s", path); return false;
+	}
+
+	res = Stream_OpenFile(&stream, path);
+	if (res) {
+		Platform_Log2("Error %h opening %s", &res, path); return false;
+	}
+
+	res = importer(&stream);
+	stream.Close(&stream);
+	if (res) {
+		Platform_Log2("Error %h decoding %s", &res, path); return false;
+	}
+
+	World_SetNewMap(World.Blocks, World.Width, World.Height, World.Length);
+	return true;
+}
+
+static void Bench_GenMap(int width, int height, int length, cc_bool flat) {
+	World_SetDimensions(width, height, length);
+	Gen_Blocks  = (BlockRaw*)Mem_Alloc(World.Volume, 1, "map blocks");
+	Gen_Seed    = BENCH_GEN_SEED;
+	Gen_Vanilla = true;
+
+	if (flat) {
+		FlatgrassGen_Generate();
+	} else {
+		NotchyGen_Generate();
+	}
+	World_SetNewMap(Gen_Blocks, width, height, length);
+	Gen_Blocks = NULL;
+}
+
+static void Bench_AllocChunks(void) {
+	struct ChunkPartInfo* parts;
+	int count;
+	MapRenderer_ChunksX = (World.Width  + CHUNK_MAX) >> CHUNK_SHIFT;
+	MapRenderer_ChunksY = (World.Height + CHUNK_MAX) >> CHUNK_SHIFT;
+	MapRenderer_ChunksZ = (World.Length + CHUNK_MAX) >> CHUNK_SHIFT;
+
+	MapRenderer_ChunksCount = MapRenderer_ChunksX * MapRenderer_ChunksY * MapRenderer_ChunksZ;
+	MapRenderer_1DUsedCount = Atlas1D.Count;
+	count = MapRenderer_ChunksCount * MapRenderer_1DUsedCount;
+
+	Mem_Free(chunks);
+	Mem_Free(MapRenderer_PartsNormal);
+	chunks = (struct ChunkInfo*)Mem_AllocCleared(MapRenderer_ChunksCount, sizeof(struct ChunkInfo), "chunk info");
+	parts  = (struct ChunkPartInfo*)Mem_AllocCleared(count * 2, sizeof(struct ChunkPartInfo), "chunk parts");
+	MapRenderer_PartsNormal      = parts;
+	MapRenderer_PartsTranslucent = parts + count;
+}
+
+static void Bench_ResetChunks(void) {
+	struct ChunkInfo* info = chunks;
+	int x, y, z;
+
+	/* Same order as MapRenderer_Pack, so occlusion can be calculated */
+	for (z = 0; z < World.Length; z += CHUNK_SIZE) {
+		for (y = 0; y < World.Height; y += CHUNK_SIZE) {
+			for (x = 0; x < World.Width; x += CHUNK_SIZE, info++) {
+				info->CentreX = x + HALF_CHUNK_SIZE;
+				info->CentreY = y + HALF_CHUNK_SIZE;
+				info->CentreZ = z + HALF_CHUNK_SIZE;
+
+				info->AllAir           = false;
+				info->NormalParts      = NULL;
+				info->TranslucentParts = NULL;
+			}
+		}
+	}
+}
+
+/* Returns the number of vertices in the given chunk parts, and adds the number of parts with any vertices to parts */
+static int Bench_CountVertices(struct ChunkPartInfo* ptr, int* parts) {
+	int i, j, count = 0;
+	if (!ptr) return 0;
+
+	for (i = 0; i < MapRenderer_1DUsedCount; i++, ptr += MapRenderer_ChunksCount) {
+		if (ptr->Offset < 0) continue;
+		(*parts)++;
+		count += ptr->SpriteCount;
+		for (j = 0; j < FACE_COUNT; j++) { count += ptr->Counts[j]; }
+	}
+	return count;
+}
+
+/* Builds all the chunks in the map multiple times, then returns the total number of vertices in the chunk meshes */
+static int Bench_Run(const char* name, cc_bool smoothLighting, cc_bool greedyMeshing, int iterations) {
+	struct BuilderTimings timings;
+	cc_uint64 beg, elapsed = 0;
+	int iter, i, meshed = 0, vertices = 0, parts = 0, partsKB;
+	struct ChunkInfo* info;
+	float totalMS, perSec, perChunk, readMS, occlusionMS, stretchMS, renderMS, compactMS, cacheMS;
+	int vertexSize = CHUNK_VERTEX_SIZE;
+
+	Builder_SmoothLighting = smoothLighting;
+	Builder_GreedyMeshing  = greedyMeshing;
+	Builder_ApplyActive();
+	Builder_TakeTimings(&timings);
+
+	for (iter = 0; iter < iterations; iter++) {
+		/* Lighting is lazily calculated while building, so reset it to measure the same work each iteration */
+		Lighting_Refresh();
+		Bench_ResetChunks();
+		beg = Stopwatch_Measure();
+
+		for (i = 0; i < MapRenderer_ChunksCount; i++) {
+			Builder_MakeChunk(&chunks[i]);
+		}
+		elapsed += Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+	}
+
+	for (i = 0; i < MapRenderer_ChunksCount; i++) {
+		info = &chunks[i];
+		if (!info->NormalParts && !info->TranslucentParts) continue;
+
+		meshed++;
+		vertices += Bench_CountVertices(info->NormalParts,      &parts);
+		vertices += Bench_CountVertices(info->TranslucentParts, &parts);
+	}
+	/* Every chunk has normal and translucent part info for every used 1D atlas */
+	partsKB = (int)(MapRenderer_ChunksCount * MapRenderer_1DUsedCount * 2 * sizeof(struct ChunkPartInfo) / 1024);
+	Builder_TakeTimings(&timings);
+
+	totalMS   = elapsed / 1000.0f;
+	perSec    = elapsed ? (float)MapRenderer_ChunksCount * iterations * 1000000.0f / elapsed : 0.0f;
+	perChunk  = meshed  ? (float)vertices / meshed : 0.0f;
+	readMS      = timings.ReadChunkData / 1000.0f;
+	occlusionMS = timings.Occlusion     / 1000.0f;
+	stretchMS   = timings.Stretch       / 1000.0f;
+	renderMS    = timings.RenderBlock   / 1000.0f;
+	compactMS   = timings.Compact       / 1000.0f;
+	cacheMS     = timings.Cache         / 1000.0f;
+
+	Platform_Log4("%c builder: %i iterations in %f2 ms (%f2 chunks/sec)", name, &iterations, &totalMS, &perSec);
+	Platform_Log3("  %i of %i chunks have a mesh, %f2 vertices per chunk with a mesh", &meshed, &MapRenderer_ChunksCount, &perChunk);
+	Platform_Log4("  ReadChunkData: %f2 ms, Occlusion: %f2 ms, Stretch: %f2 ms, RenderBlock: %f2 ms", &readMS, &occlusionMS, &stretchMS, &renderMS);
+	Platform_Log3("  Compact: %f2 ms, Cache: %f2 ms, %i bytes per uploaded vertex", &compactMS, &cacheMS, &vertexSize);
+	Platform_Log3("  %i chunk parts with vertices (each drawn separately), %i 1D atlases, %i KB of chunk part info", &parts, &MapRenderer_1DUsedCount, &partsKB);
+	return vertices;
+}
+
+static void Bench_CompareVertices(const char* name, int vertices, int normalVertices) {
+	float ratio    = vertices ? (float)normalVertices / vertices : 0.0f;
+	int size       = vertices       * CHUNK_VERTEX_SIZE / 1024;
+	int normalSize = normalVertices * CHUNK_VERTEX_SIZE / 1024;
+
+	Platform_Log4("%c builder: %f2x fewer vertices than normal builder (%i KB vs %i KB of vertices)", name, &ratio, &size, &normalSize);
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------Occlusion culling-----------------------------------------------------*
+*#########################################################################################################################*/
+/* Returns y of the highest non-air block in the given column, or -1 if the column is all air */
+static int Bench_SurfaceY(int x, int z) {
+	int y;
+	for (y = World.MaxY; y >= 0; y--) {
+		if (World_GetBlock(x, y, z) != BLOCK_AIR) return y;
+	}
+	return -1;
+}
+
+/* Returns y of the highest air block at least 8 blocks below the surface of the given column, or -1 if none */
+static int Bench_CaveY(int x, int z) {
+	int y = Bench_SurfaceY(x, z) - 8;
+	for (; y >= 0; y--) {
+		if (World_GetBlock(x, y, z) == BLOCK_AIR) return y;
+	}
+	return -1;
+}
+
+/* Calculates occlusion with the camera in the centre column of each chunk, then logs how many chunks were not occluded */
+static void Bench_Occlusion(const char* name, cc_bool underground) {
+	cc_uint64 beg, elapsed = 0;
+	int cx, cz, x, y, z, i;
+	int samples = 0, meshed = 0, visible = 0;
+	struct ChunkInfo* info;
+	float perVisible, perCalc;
+
+	for (cz = 0; cz < MapRenderer_ChunksZ; cz++) {
+		for (cx = 0; cx < MapRenderer_ChunksX; cx++) {
+			x = min(World.MaxX, (cx << CHUNK_SHIFT) + HALF_CHUNK_SIZE);
+			z = min(World.MaxZ, (cz << CHUNK_SHIFT) + HALF_CHUNK_SIZE);
+			/* Camera is roughly at eye level of a player standing on the surface */
+			y = underground ? Bench_CaveY(x, z) : Bench_SurfaceY(x, z) + 2;
+			if (y < 0) continue;
+
+			beg = Stopwatch_Measure();
+			MapRenderer_CalcOcclusion(chunks, cx, y >> CHUNK_SHIFT, cz);
+			elapsed += Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+			samples++;
+
+			for (i = 0; i < MapRenderer_ChunksCount; i++) {
+				info = &chunks[i];
+				if (!info->NormalParts && !info->TranslucentParts) continue;
+				if (!info->Occluded) visible++;
+			}
+		}
+	}
+
+	for (i = 0; i < MapRenderer_ChunksCount; i++) {
+		if (chunks[i].NormalParts || chunks[i].TranslucentParts) meshed++;
+	}
+	perVisible = samples ? (float)visible / samples : 0.0f;
+	perCalc    = samples ? (float)elapsed / samples : 0.0f;
+	Platform_Log4("  %c: %f2 of %i chunks with a mesh are not occluded on average (%f2 us per calculation)",
+		name, &perVisible, &meshed, &perCalc);
+}
+
+
+/*########################################################################################################################*
+*------------------------------------------------------Chunk sorting------------------------------------------------------*
+*#########################################################################################################################*/
+/* Chunks of a 1024x256x1024 map */
+#define BENCH_SORT_CHUNKS_X 64
+#define BENCH_SORT_CHUNKS_Y 16
+#define BENCH_SORT_CHUNKS_Z 64
+#define BENCH_SORT_STEPS 128
+static struct ChunkInfo** sortChunks;
+static cc_uint32* sortDists;
+
+/* Quicksort that the map renderer used to sort chunks with, to compare against */
+static void Bench_QuickSortChunks(int left, int right) {
+	struct ChunkInfo** values = sortChunks; struct ChunkInfo* value;
+	cc_uint32* keys = sortDists; cc_uint32 key;
+
+	while (left < right) {
+		int i = left, j = right;
+		cc_uint32 pivot = keys[(i + j) >> 1];
+
+		/* partition the list */
+		while (i <= j) {
+			while (pivot > keys[i]) i++;
+			while (pivot < keys[j]) j--;
+			QuickSort_Swap_KV_Maybe();
+		}
+		/* recurse into the smaller subset */
+		QuickSort_Recurse(Bench_QuickSortChunks)
+	}
+}
+
+/* Recalculates distances of chunks to the centre of the given chunk, then sorts the chunks by distance */
+static void Bench_SortChunks(const IVec3* pos, const IVec3* lastPos, cc_bool quicksort) {
+	struct ChunkInfo* info;
+	cc_bool nearlySorted;
+	int i, dx, dy, dz;
+
+	for (i = 0; i < MapRenderer_ChunksCount; i++) {
+		info = sortChunks[i];
+		dx = info->CentreX - pos->X; dy = info->CentreY - pos->Y; dz = info->CentreZ - pos->Z;
+		sortDists[i] = dx * dx + dy * dy + dz * dz;
+	}
+
+	if (quicksort) {
+		Bench_QuickSortChunks(0, MapRenderer_ChunksCount - 1);
+	} else {
+		nearlySorted = Math_AbsI(pos->X - lastPos->X) <= CHUNK_SIZE
+			&& Math_AbsI(pos->Y - lastPos->Y) <= CHUNK_SIZE && Math_AbsI(pos->Z - lastPos->Z) <= CHUNK_SIZE;
+		MapRenderer_SortChunks(sortChunks, sortDists, MapRenderer_ChunksCount, nearlySorted);
+	}
+}
+
+/* Replays the given camera path, then logs the average and worst time taken to update the sort order */
+static void Bench_SortPath(const char* name, const IVec3* path, cc_bool quicksort) {
+	cc_uint64 beg, elapsed, total = 0, worst = 0;
+	float avgMS, worstMS;
+	int i;
+
+	for (i = 0; i < MapRenderer_ChunksCount; i++) { sortChunks[i] = &chunks[i]; }
+	Bench_SortChunks(&path[0], &path[0], quicksort);
+
+	for (i = 1; i < BENCH_SORT_STEPS; i++) {
+		beg = Stopwatch_Measure();
+		Bench_SortChunks(&path[i], &path[i - 1], quicksort);
+		elapsed = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+
+		total += elapsed;
+		worst  = max(worst, elapsed);
+	}
+
+	for (i = 1; i < MapRenderer_ChunksCount; i++) {
+		if (sortDists[i - 1] > sortDists[i]) { Platform_Log1("%c: chunks not sorted!", name); break; }
+	}
+
+	avgMS   = total / 1000.0f / (BENCH_SORT_STEPS - 1);
+	worstMS = worst / 1000.0f;
+	Platform_Log4("  %c, %c: %f3 ms average, %f3 ms worst", name, quicksort ? "quicksort" : "new sort", &avgMS, &worstMS);
+}
+
+static void Bench_Sorting(void) {
+	IVec3 flying[BENCH_SORT_STEPS], diagonal[BENCH_SORT_STEPS], teleport[BENCH_SORT_STEPS];
+	struct ChunkInfo* info;
+	RNGState rnd;
+	int i, x, y, z;
+
+	MapRenderer_ChunksX     = BENCH_SORT_CHUNKS_X;
+	MapRenderer_ChunksY     = BENCH_SORT_CHUNKS_Y;
+	MapRenderer_ChunksZ     = BENCH_SORT_CHUNKS_Z;
+	MapRenderer_ChunksCount = BENCH_SORT_CHUNKS_X * BENCH_SORT_CHUNKS_Y * BENCH_SORT_CHUNKS_Z;
+
+	chunks     = (struct ChunkInfo*)Mem_AllocCleared(MapRenderer_ChunksCount, sizeof(struct ChunkInfo), "chunk info");
+	sortChunks = (struct ChunkInfo**)Mem_Alloc(MapRenderer_ChunksCount, sizeof(struct ChunkInfo*), "sorted chunks");
+	sortDists  = (cc_uint32*)Mem_Alloc(MapRenderer_ChunksCount, 4, "chunk distances");
+
+	for (z = 0, info = chunks; z < BENCH_SORT_CHUNKS_Z; z++) {
+		for (y = 0; y < BENCH_SORT_CHUNKS_Y; y++) {
+			for (x = 0; x < BENCH_SORT_CHUNKS_X; x++, info++) {
+				info->CentreX = (x << CHUNK_SHIFT) + HALF_CHUNK_SIZE;
+				info->CentreY = (y << CHUNK_SHIFT) + HALF_CHUNK_SIZE;
+				info->CentreZ = (z << CHUNK_SHIFT) + HALF_CHUNK_SIZE;
+			}
+		}
+	}
+
+	/* Camera crosses into the next chunk on every step */
+	Random_Seed(&rnd, BENCH_GEN_SEED);
+	for (i = 0; i < BENCH_SORT_STEPS; i++) {
+		flying[i].X = ((i % BENCH_SORT_CHUNKS_X) << CHUNK_SHIFT) + HALF_CHUNK_SIZE;
+		flying[i].Y = (8 << CHUNK_SHIFT) + HALF_CHUNK_SIZE;
+		flying[i].Z = (32 << CHUNK_SHIFT) + HALF_CHUNK_SIZE;
+
+		diagonal[i].X = ((i % BENCH_SORT_CHUNKS_X) << CHUNK_SHIFT) + HALF_CHUNK_SIZE;
+		diagonal[i].Y = (((i / 4) % BENCH_SORT_CHUNKS_Y) << CHUNK_SHIFT) + HALF_CHUNK_SIZE;
+		diagonal[i].Z = ((i % BENCH_SORT_CHUNKS_Z) << CHUNK_SHIFT) + HALF_CHUNK_SIZE;
+
+		teleport[i].X = (Random_Next(&rnd, BENCH_SORT_CHUNKS_X) << CHUNK_SHIFT) + HALF_CHUNK_SIZE;
+		teleport[i].Y = (Random_Next(&rnd, BENCH_SORT_CHUNKS_Y) << CHUNK_SHIFT) + HALF_CHUNK_SIZE;
+		teleport[i].Z = (Random_Next(&rnd, BENCH_SORT_CHUNKS_Z) << CHUNK_SHIFT) + HALF_CHUNK_SIZE;
+	}
+
+	Platform_Log1("Sorting %i chunks by distance, with camera path of:", &MapRenderer_ChunksCount);
+	Bench_SortPath("Flying",      flying,   true);
+	Bench_SortPath("Flying",      flying,   false);
+	Bench_SortPath("Diagonal",    diagonal, true);
+	Bench_SortPath("Diagonal",    diagonal, false);
+	Bench_SortPath("Teleporting", teleport, true);
+	Bench_SortPath("Teleporting", teleport, false);
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Checksums---------------------------------------------------------*
+*#########################################################################################################################*/
+#define BENCH_CHECKSUM_MAX_MB 256
+
+/* Byte at a time implementations, to compare throughput and results against */
+static cc_uint32 Bench_ByteCRC32(cc_uint32 crc, const cc_uint8* data, cc_uint32 length) {
+	cc_uint32 i;
+	for (i = 0; i < length; i++) {
+		crc = Utils_Crc32Table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return crc;
+}
+
+static cc_uint32 Bench_ByteAdler32(cc_uint32 adler, const cc_uint8* data, cc_uint32 length) {
+	cc_uint32 i, s1 = adler & 0xFFFF, s2 = (adler >> 16) & 0xFFFF;
+	for (i = 0; i < length; i++) {
+		s1 = (s1 + data[i]) % 65521;
+		s2 = (s2 + s1)      % 65521;
+	}
+	return (s2 << 16) | s1;
+}
+
+typedef cc_uint32 (*Bench_ChecksumFunc)(cc_uint32 value, const cc_uint8* data, cc_uint32 length);
+/* Returns throughput in MB/sec of calculating the checksum of the first length bytes of data */
+static float Bench_Checksum(Bench_ChecksumFunc func, cc_uint32 init, const cc_uint8* data, cc_uint32 length, cc_uint32* result) {
+	cc_uint64 beg, elapsed;
+	int i, repeats = (BENCH_CHECKSUM_MAX_MB << 20) / length;
+
+	beg = Stopwatch_Measure();
+	for (i = 0; i < repeats; i++) { *result = func(init, data, length); }
+	elapsed = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+	return elapsed ? (float)length * repeats / elapsed : 0.0f;
+}
+
+static void Bench_Checksums(void) {
+	cc_uint32 i, length, state = BENCH_GEN_SEED;
+	cc_uint32 crc, crcRef, adler, adlerRef;
+	float crcSpeed, crcRefSpeed, adlerSpeed, adlerRefSpeed;
+	cc_uint8* data;
+	int mb;
+
+	data = (cc_uint8*)Mem_Alloc(BENCH_CHECKSUM_MAX_MB << 20, 1, "checksum data");
+	for (i = 0; i < (BENCH_CHECKSUM_MAX_MB << 20); i++) {
+		state   = state * 1103515245 + 12345;
+		data[i] = (cc_uint8)(state >> 16);
+	}
+
+	for (mb = 1; mb <= BENCH_CHECKSUM_MAX_MB; mb *= 4) {
+		length = (cc_uint32)mb << 20;
+		crcSpeed      = Bench_Checksum(Utils_UpdateCRC32,   0xFFFFFFFFUL, data, length, &crc);
+		crcRefSpeed   = Bench_Checksum(Bench_ByteCRC32,     0xFFFFFFFFUL, data, length, &crcRef);
+		adlerSpeed    = Bench_Checksum(Utils_UpdateAdler32, 1,            data, length, &adler);
+		adlerRefSpeed = Bench_Checksum(Bench_ByteAdler32,   1,            data, length, &adlerRef);
+
+		Platform_Log3("%i MB: CRC32 %f2 MB/sec (byte loop %f2 MB/sec)",   &mb, &crcSpeed,   &crcRefSpeed);
+		Platform_Log3("%i MB: Adler32 %f2 MB/sec (byte loop %f2 MB/sec)", &mb, &adlerSpeed, &adlerRefSpeed);
+		if (crc != crcRef || adler != adlerRef) Platform_LogConst("  Checksums do not match byte loop results!");
+	}
+	Mem_Free(data);
+}
+
+
+/*########################################################################################################################*
+*------------------------------------------------------Decompression------------------------------------------------------*
+*#########################################################################################################################*/
+static cc_uint8 inflateBuffer[65536];
+static cc_uint32 inflatedSize;
+
+static cc_result Bench_DrainStream(struct Stream* stream) {
+	cc_uint32 read;
+	cc_result res;
+
+	for (;;) {
+		res = stream->Read(stream, inflateBuffer, sizeof(inflateBuffer), &read);
+		if (res || !read) return res;
+		inflatedSize += read;
+	}
+}
+
+static cc_result Bench_DrainZipEntry(const cc_string* path, struct Stream* data, struct ZipState* state) {
+	return Bench_DrainStream(data);
+}
+
+static cc_result Bench_InflateOnce(cc_uint8* data, cc_uint32 length, cc_bool isZip) {
+	struct GZipHeader gzHeader;
+	struct InflateState inflate;
+	struct ZipState zip;
+	struct Stream src, stream;
+	cc_result res;
+	Stream_ReadonlyMemory(&src, data, length);
+
+	if (isZip) {
+		Zip_Init(&zip, &src);
+		zip.ProcessEntry = Bench_DrainZipEntry;
+		return Zip_Extract(&zip);
+	}
+
+	GZipHeader_Init(&gzHeader);
+	while (!gzHeader.done) {
+		if ((res = GZipHeader_Read(&src, &gzHeader))) return res;
+	}
+	Inflate_MakeStream2(&stream, &inflate, &src);
+	return Bench_DrainStream(&stream);
+}
+
+static void Bench_Inflate(const cc_string* path, int iterations) {
+	static const cc_string zipExt = String_FromConst(".zip");
+	struct Stream stream;
+	cc_uint8* data;
+	cc_uint32 length;
+	cc_uint64 beg, elapsed;
+	float totalMS, perSec;
+	cc_bool isZip;
+	cc_result res;
+	int i;
+
+	res = Stream_OpenFile(&stream, path);
+	if (res) { Platform_Log2("Error %h opening %s", &res, path); return; }
+
+	res = stream.Length(&stream, &length);
+	if (!res) {
+		data = (cc_uint8*)Mem_Alloc(length, 1, "compressed data");
+		res  = Stream_Read(&stream, data, length);
+	}
+	stream.Close(&stream);
+	if (res) { Platform_Log2("Error %h reading %s", &res, path); return; }
+
+	isZip = String_CaselessEnds(path, &zipExt);
+	beg   = Stopwatch_Measure();
+	inflatedSize = 0;
+
+	for (i = 0; i < iterations && !res; i++) {
+		res = Bench_InflateOnce(data, length, isZip);
+	}
+	elapsed = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+	Mem_Free(data);
+	if (res) { Platform_Log2("Error %h decompressing %s", &res, path); return; }
+
+	totalMS = elapsed / 1000.0f;
+	perSec  = elapsed ? (float)inflatedSize / elapsed : 0.0f;
+	Platform_Log4("%s: %i iterations in %f2 ms (%f2 MB/sec decompressed)", path, &iterations, &totalMS, &perSec);
+}
+
+static void Bench_MeshCache(int iterations) {
+	cc_uint64 beg;
+	float openMS;
+
+	MeshCache_Enabled = true;
+	MeshCache_Component.OnNewMapLoaded();
+	if (!MeshCache_Active) { Platform_LogConst("Mesh cache could not be opened"); return; }
+	Bench_Run("Cold cache", false, false, 1);
+	Bench_Run("Warm cache", false, false, iterations);
+
+	/* Measure loading the index of the cache, like when rejoining the map */
+	MeshCache_Component.OnNewMap();
+	beg = Stopwatch_Measure();
+	MeshCache_Component.OnNewMapLoaded();
+	openMS = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure()) / 1000.0f;
+
+	Platform_Log1("Reopened mesh cache in %f2 ms", &openMS);
+	Bench_Run("Reopened cache", false, false, iterations);
+	MeshCache_Component.Free();
+}
+
+#define BENCH_FLOOD_MAX_TICKS 5000
+#define BENCH_FLOOD_BORDER 4
+
+/* Generates a flatgrass map with a basin dug out of the ground, and a few sponges on its floor */
+static void Bench_GenBasin(int width, int height, int length) {
+	int x, y, z, top;
+	World_SetDimensions(width, height, length);
+	Gen_Blocks = (BlockRaw*)Mem_Alloc(World.Volume, 1, "map blocks");
+	FlatgrassGen_Generate();
+	top = height / 2 - 1;
+
+	for (y = 1; y <= top; y++) {
+		for (z = BENCH_FLOOD_BORDER; z < length - BENCH_FLOOD_BORDER; z++) {
+			for (x = BENCH_FLOOD_BORDER; x < width - BENCH_FLOOD_BORDER; x++) {
+				Gen_Blocks[World_Pack(x, y, z)] = BLOCK_AIR;
+			}
+		}
+	}
+
+	for (z = 32; z < length - 32; z += 64) {
+		for (x = 32; x < width - 32; x += 64) {
+			Gen_Blocks[World_Pack(x, 1, z)] = BLOCK_SPONGE;
+		}
+	}
+	World_SetNewMap(Gen_Blocks, width, height, length);
+	Gen_Blocks = NULL;
+}
+
+static void Bench_Flood(int maxTicks, int budget) {
+	cc_uint64 beg, elapsed = 0;
+	int x, y, z, ticks, backlog, peak = 0, spread = 0, deferred = 0;
+	float totalMS, perSec;
+	cc_uint32 crc;
+#ifdef PALETTE_BLOCKS
+	BlockRaw* blocks;
+#endif
+
+	Bench_GenBasin(256, 64, 256);
+	Lighting_Component.OnNewMapLoaded();
+	MapRenderer_Component.OnNewMapLoaded();
+	Physics_Init();
+	Physics_SetEnabled(true);
+	Physics.LiquidBudget = budget;
+	/* Random ticks depend on a time seeded RNG, so only liquids are simulated to keep the result reproducible */
+	Mem_Set(Physics.OnRandomTick, 0, sizeof(Physics.OnRandomTick));
+	Platform_Log4("Map is %ix%ix%i, liquid budget is %i", &World.Width, &World.Height, &World.Length, &Physics.LiquidBudget);
+
+	x = World.Width / 2; y = World.Height / 2 - 2; z = World.Length / 2;
+	Game_UpdateBlock(x, y, z, BLOCK_WATER);
+	Physics.OnPlace[BLOCK_WATER](World_Pack(x, y, z), BLOCK_WATER);
+
+	for (ticks = 0; ticks < maxTicks; ) {
+		beg = Stopwatch_Measure();
+		Physics_Tick();
+		elapsed += Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+		ticks++;
+
+		backlog   = Physics.Water.Backlog;
+		peak      = max(peak, backlog);
+		spread   += Physics.Water.Activated;
+		deferred += Physics.Water.Deferred;
+		if (!backlog) break;
+	}
+
+	totalMS = elapsed / 1000.0f;
+	perSec  = elapsed ? ticks * 1000000.0f / elapsed : 0.0f;
+#ifdef PALETTE_BLOCKS
+	blocks  = (BlockRaw*)Mem_Alloc(World.Volume, 1, "map blocks");
+	World_UnpackLower(blocks, 0, World.Volume);
+	crc     = Utils_CRC32(blocks, World.Volume);
+	Mem_Free(blocks);
+#else
+	crc     = Utils_CRC32(World.Blocks, World.Volume);
+#endif
+
+	Platform_Log3("Flood: %i ticks in %f2 ms (%f2 ticks/sec)", &ticks, &totalMS, &perSec);
+	Platform_Log4("  Peak backlog: %i, %i spread, %i deferred, %i still queued", &peak, &spread, &deferred, &backlog);
+	Platform_Log1("  Blocks CRC32: %h", &crc);
+	Physics_Free();
+}
+
+/* CRC32 of the blocks generated for known seeds and sizes, so changes to the generator can be checked to not change maps */
+static const struct BenchGenMap {
+	int seed, width, height, length;
+	cc_uint32 crc;
+} genMaps[] = {
+	{    1234,  128,  64,  128, 0xCA899B81UL },
+	{      -1,  128, 128,  128, 0x1739FBC8UL },
+	{   98765,  256,  64,  256, 0xC0060C60UL },
+	{    1234,  512,  64,  512, 0x920D0D7CUL },
+	{ 1337420, 1024,  64, 1024, 0xC661DDE2UL }
+};
+
+static void Bench_Gen(void) {
+	const struct BenchGenMap* map;
+	cc_uint64 beg;
+	float totalMS;
+	cc_uint32 crc;
+	int i, failed = 0;
+
+	for (i = 0; i < Array_Elems(genMaps); i++) {
+		map = &genMaps[i];
+		World_SetDimensions(map->width, map->height, map->length);
+		Gen_Blocks  = (BlockRaw*)Mem_Alloc(World.Volume, 1, "map blocks");
+		Gen_Seed    = map->seed;
+		Gen_Vanilla = true;
+
+		beg = Stopwatch_Measure();
+		NotchyGen_Generate();
+		totalMS = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure()) / 1000.0f;
+
+		crc = Utils_CRC32(Gen_Blocks, World.Volume);
+		Mem_Free(Gen_Blocks);
+		Gen_Blocks = NULL;
+
+		Platform_Log4("Seed %i, %ix%ix%i:", &map->seed, &map->width, &map->height, &map->length);
+		Platform_Log3("  Generated in %f2 ms, CRC32 %h (%c)", &totalMS, &crc,
+					crc == map->crc ? "same" : "DIFFERENT");
+		if (crc != map->crc) failed++;
+	}
+
+	if (failed) Platform_Log1("%i maps generated differently to before", &failed);
+}
+
+
+#ifdef PALETTE_BLOCKS
+/*########################################################################################################################*
+*------------------------------------------------------Streamed map-------------------------------------------------------*
+*#########################################################################################################################*/
+/* Streams in the given bits of blocks in the same sized pieces as Protocol.c does */
+static void Bench_StreamBits(const BlockRaw* src, int volume, int shift) {
+	int i;
+	for (i = 0; i < volume; i += CHUNK_SIZE_3) {
+		World_StreamBlocks(src + i, i, min(CHUNK_SIZE_3, volume - i), shift);
+	}
+}
+
+/* Checks that a map streamed in as it would be from a server ends up with the same blocks as the map had */
+static void Bench_Stream(void) {
+	int width, height, length, volume, i;
+	BlockRaw* lower;
+	BlockRaw* upper;
+	cc_uint32 lowerCRC, upperCRC;
+	cc_uint64 beg;
+	float totalMS;
+
+	Bench_GenMap(256, 64, 256, false);
+	/* Some blocks above 255 to check that the upper bits are streamed in too */
+	for (i = 0; i < World.Volume; i += 997) {
+		World_SetBlock(i % World.Width, (i / World.Width) / World.Length, (i / World.Width) % World.Length, 256 + (i & 0xFF));
+	}
+	width = World.Width; height = World.Height; length = World.Length; volume = World.Volume;
+
+	lower = (BlockRaw*)Mem_Alloc(volume, 1, "map blocks");
+	upper = (BlockRaw*)Mem_Alloc(volume, 1, "map blocks");
+	World_UnpackLower(lower, 0, volume);
+	World_UnpackUpper(upper, 0, volume);
+	lowerCRC = Utils_CRC32(lower, volume);
+	upperCRC = Utils_CRC32(upper, volume);
+
+	World_NewMap();
+	beg = Stopwatch_Measure();
+	World_BeginStream(volume);
+	Bench_StreamBits(lower, volume, 0);
+	Bench_StreamBits(upper, volume, 8);
+	World_SetStreamedMap(width, height, length);
+	totalMS = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure()) / 1000.0f;
+
+	Mem_Set(lower, 0, volume); Mem_Set(upper, 0, volume);
+	World_UnpackLower(lower, 0, volume);
+	World_UnpackUpper(upper, 0, volume);
+	Platform_Log4("Map is %ix%ix%i, streamed in %f2 ms", &width, &height, &length, &totalMS);
+	Platform_Log2("  Lower bits: %c, upper bits: %c",
+				Utils_CRC32(lower, volume) == lowerCRC ? "same" : "DIFFERENT",
+				Utils_CRC32(upper, volume) == upperCRC ? "same" : "DIFFERENT");
+
+	Mem_Free(lower);
+	Mem_Free(upper);
+}
+#endif
+
+/*########################################################################################################################*
+*--------------------------------------------------------Entities---------------------------------------------------------*
+*#########################################################################################################################*/
+#define BENCH_ENTITIES_TICKS 20000
+#define BENCH_ENTITIES_COUNT ENTITIES_SELF_ID
+/* Skips over the local player's ID */
+#define Bench_EntityID(i) ((EntityID)((i) < ENTITIES_SELF_ID ? (i) : (i) + 1))
+
+/* Stand-in for the humanoid model, as the real models can't be created without a graphics context */
+static float Bench_GetEyeY(struct Entity* e) { return 26.0f / 16.0f; }
+static void Bench_GetCollisionSize(struct Entity* e) { Vec3_Set(e->Size, 8.6f / 16.0f, 28.1f / 16.0f, 8.6f / 16.0f); }
+static void Bench_GetPickingBounds(struct Entity* e) {
+	Vec3_Set(e->ModelAABB.Min, -8 / 16.0f,  0.0f, -4 / 16.0f);
+	Vec3_Set(e->ModelAABB.Max,  8 / 16.0f, 2.0f,  4 / 16.0f);
+}
+
+static void Bench_Entities(int ticks, int entities) {
+	static struct Model model;
+	struct ScheduledTask task;
+	struct LocationUpdate update;
+	struct NetPlayer* p;
+	struct Entity* e;
+	RNGState rnd;
+	Vec3 delta;
+	cc_uint64 beg, elapsed = 0;
+	cc_uint32 crc = 0xFFFFFFFFUL;
+	float totalMS, tickUS;
+	int i, j, k, count;
+
+	model.name             = "humanoid";
+	model.GetEyeY          = Bench_GetEyeY;
+	model.GetCollisionSize = Bench_GetCollisionSize;
+	model.GetPickingBounds = Bench_GetPickingBounds;
+	Models.Human           = &model;
+
+	for (i = 0; i < entities; i++) {
+		p = NetPlayers_Alloc(Bench_EntityID(i));
+		NetPlayer_Init(p);
+		Entities_Add(Bench_EntityID(i), &p->Base);
+	}
+	Random_Seed(&rnd, BENCH_GEN_SEED);
+	task.interval = GAME_DEF_TICKS;
+
+	for (i = 0; i < ticks; i++) {
+		/* Servers send a varying number of movement packets for each entity between ticks */
+		for (j = 0; j < entities; j++) {
+			count = Random_Next(&rnd, 3);
+			e     = Entities.List[Bench_EntityID(j)];
+
+			for (k = 0; k < count; k++) {
+				Vec3_Set(delta, Random_Float(&rnd) - 0.5f, Random_Float(&rnd) - 0.5f, Random_Float(&rnd) - 0.5f);
+				LocationUpdate_MakePosAndOri(&update, delta, Random_Float(&rnd) * 360.0f, 
+											Random_Float(&rnd) * 180.0f - 90.0f, true);
+				e->VTABLE->SetLocation(e, &update, true);
+			}
+		}
+
+		beg = Stopwatch_Measure();
+		Entities_Tick(&task);
+		elapsed += Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+	}
+
+	for (i = 0; i < entities; i++) {
+		p   = (struct NetPlayer*)Entities.List[Bench_EntityID(i)];
+		crc = Utils_UpdateCRC32(crc, (cc_uint8*)&p->Interp.Prev, sizeof(struct InterpState));
+		crc = Utils_UpdateCRC32(crc, (cc_uint8*)&p->Interp.Next, sizeof(struct InterpState));
+		crc = Utils_UpdateCRC32(crc, (cc_uint8*)&p->Interp.States[0], p->Interp.StatesCount * sizeof(struct InterpState));
+		crc = Utils_UpdateCRC32(crc, (cc_uint8*)&p->Base.Anim, sizeof(struct AnimatedComp));
+	}
+	crc ^= 0xFFFFFFFFUL;
+
+	totalMS = elapsed / 1000.0f;
+	tickUS  = (float)elapsed / ticks;
+	Platform_Log2("Ticked %i entities %i times", &entities, &ticks);
+	Platform_Log3("  Took %f2 ms, %f2 us per tick, CRC32 %h", &totalMS, &tickUS, &crc);
+}
+
+int main(int argc, char** argv) {
+	cc_string args[GAME_MAX_CMDARGS];
+	int i, argsCount, iterations = BENCH_DEF_ITERATIONS, budget = 0, count;
+	int normalVertices, greedyVertices;
+	Platform_Init();
+	Bench_Init();
+
+	argsCount = Platform_GetCommandLineArgs(argc, argv, args);
+	if (argsCount >= 1 && String_CaselessEqualsConst(&args[0], "checksums")) {
+		Bench_Checksums(); return 0;
+	}
+	if (argsCount >= 1 && String_CaselessEqualsConst(&args[0], "gen")) {
+		Bench_Gen(); return 0;
+	}
+#ifdef PALETTE_BLOCKS
+	if (argsCount >= 1 && String_CaselessEqualsConst(&args[0], "stream")) {
+		Bench_Stream(); return 0;
+	}
+#endif
+	if (argsCount >= 1 && String_CaselessEqualsConst(&args[0], "sort")) {
+		Bench_Sorting(); return 0;
+	}
+	if (argsCount >= 1 && String_CaselessEqualsConst(&args[0], "inflate")) {
+		for (i = 1; i < argsCount; i++) { Bench_Inflate(&args[i], iterations); }
+		return 0;
+	}
+
+	if (argsCount >= 2 && (!Convert_ParseInt(&args[1], &iterations) || iterations <= 0)) {
+		Platform_Log1("Invalid number of iterations: %s", &args[1]); return 1;
+	}
+
+	if (argsCount >= 1 && String_CaselessEqualsConst(&args[0], "entities")) {
+		count = BENCH_ENTITIES_COUNT;
+		if (argsCount >= 3 && (!Convert_ParseInt(&args[2], &count) || count <= 0 || count >= ENTITIES_MAX_COUNT)) {
+			Platform_Log1("Invalid number of entities: %s", &args[2]); return 1;
+		}
+
+		Bench_Entities(argsCount >= 2 ? iterations : BENCH_ENTITIES_TICKS, count);
+		return 0;
+	}
+
+	if (argsCount >= 1 && String_CaselessEqualsConst(&args[0], "flood")) {
+		if (argsCount >= 3 && (!Convert_ParseInt(&args[2], &budget) || budget < 0)) {
+			Platform_Log1("Invalid liquid budget: %s", &args[2]); return 1;
+		}
+
+		Bench_Flood(argsCount >= 2 ? iterations : BENCH_FLOOD_MAX_TICKS, budget);
+		return 0;
+	}
+
+	if (argsCount >= 1 && String_CaselessEqualsConst(&args[0], "meshcache")) {
+		Bench_GenMap(256, 64, 256, false);
+	} else if (argsCount >= 1 && String_CaselessEqualsConst(&args[0], "flat")) {
+		Bench_GenMap(256, 64, 256, true);
+	} else if (argsCount >= 1) {
+		if (!Bench_LoadMap(&args[0])) return 1;
+	} else {
+		Bench_GenMap(256, 64, 256, false);
+	}
+
+	Lighting_Component.OnNewMapLoaded();
+	Builder_Component.OnNewMapLoaded();
+	Bench_AllocChunks();
+	Platform_Log3("Map is %ix%ix%i", &World.Width, &World.Height, &World.Length);
+
+	if (argsCount >= 1 && String_CaselessEqualsConst(&args[0], "meshcache")) {
+		Bench_MeshCache(iterations); return 0;
+	}
+
+	normalVertices = Bench_Run("Normal",   false, false, iterations);
+	Platform_LogConst("Occlusion culling:");
+	Bench_Occlusion("On surface", false);
+	Bench_Occlusion("In caves",   true);
+	Bench_Run("Advanced", true,  false, iterations);
+
+	/* Greedy builder only merges faces into rectangles when each tile is a separate 1D atlas */
+	/*  (otherwise it is identical to the normal builder), so compare against that atlas layout */
+	Bench_SetAtlases(1);
+	Bench_AllocChunks();
+	greedyVertices = Bench_Run("Greedy", false, true, iterations);
+	Bench_CompareVertices("Greedy", greedyVertices, normalVertices);
+	return 0;
+}
+#endif
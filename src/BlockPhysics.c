@@ -13,6 +13,7 @@
 #include "Logger.h"
 #include "Vectors.h"
 #include "Chat.h"
+#include "Workers.h"
 
 /* Data for a resizable queue, used for liquid physic tick entries. */
 struct TickQueue {
@@ -84,12 +85,18 @@ static cc_uint32 TickQueue_Dequeue(struct TickQueue* queue) {
 	return result;
 }
 
+/* Retrieves the i'th entry from the front of the queue, without removing it. */
+static cc_uint32 TickQueue_Peek(struct TickQueue* queue, int i) {
+	return queue->entries[(queue->head + i) & queue->mask];
+}
+
 
 struct Physics_ Physics;
 static RNGState physics_rnd;
 static int physics_tickCount;
-static int physics_maxWaterX, physics_maxWaterY, physics_maxWaterZ;
 static struct TickQueue lavaQ, waterQ;
+/* Which blocks had a random tick handler when chunk summaries were last (re)calculated */
+static cc_bool physics_randomTicked[256];
 
 #define PHYSICS_DELAY_MASK 0xF8000000UL
 #define PHYSICS_POS_MASK   0x07FFFFFFUL
@@ -101,10 +108,8 @@ static struct TickQueue lavaQ, waterQ;
 static void Physics_OnNewMapLoaded(void* obj) {
 	TickQueue_Clear(&lavaQ);
 	TickQueue_Clear(&waterQ);
-
-	physics_maxWaterX = World.MaxX - 2;
-	physics_maxWaterY = World.MaxY - 2;
-	physics_maxWaterZ = World.MaxZ - 2;
+	Mem_Set(&Physics.Water, 0, sizeof(Physics.Water));
+	Mem_Set(&Physics.Lava,  0, sizeof(Physics.Lava));
 
 	Tree_Blocks = World.Blocks;
 	Random_SeedFromCurrentTime(&physics_rnd);
@@ -117,7 +122,7 @@ void Physics_SetEnabled(cc_bool enabled) {
 }
 
 static void Physics_Activate(int index) {
-	BlockID block = World.Blocks[index];
+	BlockID block = World_GetRawBlock(index);
 	PhysicsHandler activate = Physics.OnActivate[block];
 	if (activate) activate(index, block);
 }
@@ -161,11 +166,27 @@ void Physics_OnBlockChanged(int x, int y, int z, BlockID old, BlockID now) {
 	Physics_ActivateNeighbours(x, y, z, index);
 }
 
+/* Chunk summaries count the blocks with random tick handlers, but Physics.OnRandomTick */
+/*  can be changed at any time (e.g. by plugins), so the counts must then be recalculated */
+static void Physics_CheckRandomTickHandlers(void) {
+	cc_bool changed = false, ticked;
+	int i;
+
+	for (i = 0; i < Array_Elems(physics_randomTicked); i++) {
+		ticked   = Physics.OnRandomTick[i] != NULL;
+		changed |= ticked != physics_randomTicked[i];
+		physics_randomTicked[i] = ticked;
+	}
+	if (changed) World_InvalidateChunkSummaries();
+}
+
 static void Physics_TickRandomBlocks(void) {
+	struct ChunkSummary* summary;
 	int lo, hi, index;
 	BlockID block;
 	PhysicsHandler tick;
 	int x, y, z, x2, y2, z2;
+	Physics_CheckRandomTickHandlers();
 
 	for (y = 0; y < World.Height; y += CHUNK_SIZE) {
 		y2 = min(y + CHUNK_MAX, World.MaxY);
@@ -174,22 +195,26 @@ static void Physics_TickRandomBlocks(void) {
 			for (x = 0; x < World.Width; x += CHUNK_SIZE) {
 				x2 = min(x + CHUNK_MAX, World.MaxX);
 
+				/* Chunks without any blocks that can be randomly ticked (e.g. only air or stone) can be skipped */
+				summary = World_GetChunkSummary(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT);
+				if (summary && !summary->RandomTicks) continue;
+
 				/* Inlined 3 random ticks for this chunk */
 				lo = World_Pack( x,  y,  z);
 				hi = World_Pack(x2, y2, z2);
 				
 				index = Random_Range(&physics_rnd, lo, hi);
-				block = World.Blocks[index];
+				block = World_GetRawBlock(index);
 				tick = Physics.OnRandomTick[block];
 				if (tick) tick(index, block);
 
 				index = Random_Range(&physics_rnd, lo, hi);
-				block = World.Blocks[index];
+				block = World_GetRawBlock(index);
 				tick = Physics.OnRandomTick[block];
 				if (tick) tick(index, block);
 
 				index = Random_Range(&physics_rnd, lo, hi);
-				block = World.Blocks[index];
+				block = World_GetRawBlock(index);
 				tick = Physics.OnRandomTick[block];
 				if (tick) tick(index, block);
 			}
@@ -206,7 +231,7 @@ static void Physics_DoFalling(int index, BlockID block) {
 	/* Find lowest block can fall into */
 	while (index >= World.OneY) {
 		index -= World.OneY;
-		other  = World.Blocks[index];
+		other  = World_GetRawBlock(index);
 
 		if (other == BLOCK_AIR || (other >= BLOCK_WATER && other <= BLOCK_STILL_LAVA))
 			found = index;
@@ -223,6 +248,17 @@ static void Physics_DoFalling(int index, BlockID block) {
 	Physics_ActivateNeighbours(x, y, z, start);
 }
 
+static void Physics_BeginLiquidTick(struct PhysicsLiquidStats* stats) {
+	stats->Activated = 0;
+	stats->Deferred  = 0;
+}
+
+/* Returns whether no more entries of the given liquid can spread this tick */
+/* Once this happens, the rest of the liquid's queue is left untouched until the next tick */
+static cc_bool Physics_BudgetUsed(struct PhysicsLiquidStats* stats) {
+	return Physics.LiquidBudget && stats->Activated >= Physics.LiquidBudget;
+}
+
 static cc_bool Physics_CheckItem(struct TickQueue* queue, int* posIndex) {
 	cc_uint32 item = TickQueue_Dequeue(queue);
 	*posIndex     = (int)(item & PHYSICS_POS_MASK);
@@ -246,7 +282,7 @@ static void Physics_HandleSapling(int index, BlockID block) {
 	World_Unpack(index, x, y, z);
 
 	below = BLOCK_AIR;
-	if (y > 0) below = World.Blocks[index - World.OneY];
+	if (y > 0) below = World_GetRawBlock(index - World.OneY);
 	if (below != BLOCK_GRASS) return;
 
 	height = 5 + Random_Next(&physics_rnd, 3);
@@ -293,7 +329,7 @@ static void Physics_HandleFlower(int index, BlockID block) {
 	}
 
 	below = BLOCK_DIRT;
-	if (y > 0) below = World.Blocks[index - World.OneY];
+	if (y > 0) below = World_GetRawBlock(index - World.OneY);
 	if (!(below == BLOCK_DIRT || below == BLOCK_GRASS)) {
 		Game_UpdateBlock(x, y, z, BLOCK_AIR);
 		Physics_ActivateNeighbours(x, y, z, index);
@@ -312,7 +348,7 @@ static void Physics_HandleMushroom(int index, BlockID block) {
 	}
 
 	below = BLOCK_STONE;
-	if (y > 0) below = World.Blocks[index - World.OneY];
+	if (y > 0) below = World_GetRawBlock(index - World.OneY);
 	if (!(below == BLOCK_STONE || below == BLOCK_COBBLE)) {
 		Game_UpdateBlock(x, y, z, BLOCK_AIR);
 		Physics_ActivateNeighbours(x, y, z, index);
@@ -325,7 +361,7 @@ static void Physics_PlaceLava(int index, BlockID block) {
 }
 
 static void Physics_PropagateLava(int posIndex, int x, int y, int z) {
-	BlockID block = World.Blocks[posIndex];
+	BlockID block = World_GetRawBlock(posIndex);
 	if (block == BLOCK_WATER || block == BLOCK_STILL_WATER) {
 		Game_UpdateBlock(x, y, z, BLOCK_STONE);
 	} else if (Blocks.Collide[block] == COLLIDE_GAS) {
@@ -347,14 +383,19 @@ static void Physics_ActivateLava(int index, BlockID block) {
 
 static void Physics_TickLava(void) {
 	int i, count = lavaQ.count;
-	for (i = 0; i < count; i++) {
+	Physics_BeginLiquidTick(&Physics.Lava);
+
+	for (i = 0; i < count && !Physics_BudgetUsed(&Physics.Lava); i++) {
 		int index;
 		if (Physics_CheckItem(&lavaQ, &index)) {
-			BlockID block = World.Blocks[index];
+			BlockID block = World_GetRawBlock(index);
 			if (!(block == BLOCK_LAVA || block == BLOCK_STILL_LAVA)) continue;
+			Physics.Lava.Activated++;
 			Physics_ActivateLava(index, block);
 		}
 	}
+	Physics.Lava.Deferred = count - i;
+	Physics.Lava.Backlog  = lavaQ.count;
 }
 
 
@@ -362,49 +403,179 @@ static void Physics_PlaceWater(int index, BlockID block) {
 	TickQueue_Enqueue(&waterQ, PHYSICS_WATER_DELAY | index);
 }
 
-static void Physics_PropagateWater(int posIndex, int x, int y, int z) {
-	BlockID block = World.Blocks[posIndex];
-	int xx, yy, zz;
+/* Whether water can flow into the given block, if there is no sponge near it */
+static cc_bool Physics_CanFlowWater(int posIndex) {
+	BlockID block = World_GetRawBlock(posIndex);
+	return Blocks.Collide[block] == COLLIDE_GAS && block != BLOCK_ROPE;
+}
+
+/* Returns whether there is a sponge within 2 blocks of the given coordinates */
+static cc_bool Physics_HasSponge(int x, int y, int z) {
+	int minX = max(x - 2, 0), maxX = min(x + 2, World.MaxX);
+	int minY = max(y - 2, 0), maxY = min(y + 2, World.MaxY);
+	int minZ = max(z - 2, 0), maxZ = min(z + 2, World.MaxZ);
+	int yy, zz, i, end;
+
+	for (yy = minY; yy <= maxY; yy++) {
+		for (zz = minZ; zz <= maxZ; zz++) {
+			/* Scan each row directly, as World_GetBlock would recalculate the index of every block */
+			i   = World_Pack(minX, yy, zz);
+			end = i + (maxX - minX);
+
+			for (; i <= end; i++) {
+#if defined PALETTE_BLOCKS
+				if (World_GetBlockAt(i) != BLOCK_SPONGE) continue;
+#else
+				if (World.Blocks[i] != BLOCK_SPONGE) continue;
+#ifdef EXTENDED_BLOCKS
+				if (World.BlocksUpper && World_GetUpper(i)) continue;
+#endif
+#endif
+				return true;
+			}
+		}
+	}
+	return false;
+}
 
-	if (block == BLOCK_LAVA || block == BLOCK_STILL_LAVA) {
-		Game_UpdateBlock(x, y, z, BLOCK_STONE);
-	} else if (Blocks.Collide[block] == COLLIDE_GAS && block != BLOCK_ROPE) {
-		/* Sponge check */		
-		for (yy = (y < 2 ? 0 : y - 2); yy <= (y > physics_maxWaterY ? World.MaxY : y + 2); yy++) {
-			for (zz = (z < 2 ? 0 : z - 2); zz <= (z > physics_maxWaterZ ? World.MaxZ : z + 2); zz++) {
-				for (xx = (x < 2 ? 0 : x - 2); xx <= (x > physics_maxWaterX ? World.MaxX : x + 2); xx++) {
-					block = World_GetBlock(xx, yy, zz);
-					if (block == BLOCK_SPONGE) return;
-				}
+/* Returns whether any of the chunks the given box overlaps contain sponges, clamped to the map */
+static cc_bool Physics_MayHaveSponges(int minX, int minY, int minZ, int maxX, int maxY, int maxZ) {
+	int cx, cy, cz;
+	minX = max(minX, 0) >> CHUNK_SHIFT; maxX = min(maxX, World.MaxX) >> CHUNK_SHIFT;
+	minY = max(minY, 0) >> CHUNK_SHIFT; maxY = min(maxY, World.MaxY) >> CHUNK_SHIFT;
+	minZ = max(minZ, 0) >> CHUNK_SHIFT; maxZ = min(maxZ, World.MaxZ) >> CHUNK_SHIFT;
+
+	for (cy = minY; cy <= maxY; cy++) {
+		for (cz = minZ; cz <= maxZ; cz++) {
+			for (cx = minX; cx <= maxX; cx++) {
+				if (World_CountChunkSponges(cx, cy, cz)) return true;
 			}
 		}
+	}
+	return false;
+}
+
+/* Returns a bit mask of which neighbours of the given block water could flow into, but are next to a sponge */
+/* NOTE: Only reads the world, so can be called from worker threads */
+static int Physics_FindSponges(int index) {
+	int x, y, z, sponges = 0;
+	World_Unpack(index, x, y, z);
+	/* Sponges are rare, so first check if the chunks around all the neighbours have any sponges at all */
+	if (!Physics_MayHaveSponges(x - 3, y - 3, z - 3, x + 3, y + 2, z + 3)) return 0;
+
+	if (x > 0          && Physics_CanFlowWater(index - 1)           && Physics_HasSponge(x - 1, y,     z))     sponges |= 0x01;
+	if (x < World.MaxX && Physics_CanFlowWater(index + 1)           && Physics_HasSponge(x + 1, y,     z))     sponges |= 0x02;
+	if (z > 0          && Physics_CanFlowWater(index - World.Width) && Physics_HasSponge(x,     y,     z - 1)) sponges |= 0x04;
+	if (z < World.MaxZ && Physics_CanFlowWater(index + World.Width) && Physics_HasSponge(x,     y,     z + 1)) sponges |= 0x08;
+	if (y > 0          && Physics_CanFlowWater(index - World.OneY)  && Physics_HasSponge(x,     y - 1, z))     sponges |= 0x10;
+	return sponges;
+}
+
+static void Physics_PropagateWater(int posIndex, int x, int y, int z, int sponged) {
+	BlockID block = World_GetRawBlock(posIndex);
 
+	if (block == BLOCK_LAVA || block == BLOCK_STILL_LAVA) {
+		Game_UpdateBlock(x, y, z, BLOCK_STONE);
+	} else if (Physics_CanFlowWater(posIndex) && !sponged) {
 		TickQueue_Enqueue(&waterQ, PHYSICS_WATER_DELAY | posIndex);
 		Game_UpdateBlock(x, y, z, BLOCK_WATER);
 	}
 }
 
-static void Physics_ActivateWater(int index, BlockID block) {
+static void Physics_SpreadWater(int index, int sponges) {
 	int x, y, z;
 	World_Unpack(index, x, y, z);
 
-	if (x > 0)          Physics_PropagateWater(index - 1,           x - 1, y,     z);
-	if (x < World.MaxX) Physics_PropagateWater(index + 1,           x + 1, y,     z);
-	if (z > 0)          Physics_PropagateWater(index - World.Width, x,     y,     z - 1);
-	if (z < World.MaxZ) Physics_PropagateWater(index + World.Width, x,     y,     z + 1);
-	if (y > 0)          Physics_PropagateWater(index - World.OneY,  x,     y - 1, z);
+	if (x > 0)          Physics_PropagateWater(index - 1,           x - 1, y,     z,     sponges & 0x01);
+	if (x < World.MaxX) Physics_PropagateWater(index + 1,           x + 1, y,     z,     sponges & 0x02);
+	if (z > 0)          Physics_PropagateWater(index - World.Width, x,     y,     z - 1, sponges & 0x04);
+	if (z < World.MaxZ) Physics_PropagateWater(index + World.Width, x,     y,     z + 1, sponges & 0x08);
+	if (y > 0)          Physics_PropagateWater(index - World.OneY,  x,     y - 1, z,     sponges & 0x10);
+}
+
+static void Physics_ActivateWater(int index, BlockID block) {
+	Physics_SpreadWater(index, Physics_FindSponges(index));
+}
+
+/* Water entries are ticked in batches of entries from the front of the queue, each in two phases:
+   1) Sponge checks (the expensive part) are split across worker threads in slices of entries.
+      These only read the world, and nothing that happens during the tick can add or remove sponges.
+   2) The entries are then processed in queue order on the main thread, exactly like a serial tick would.
+      Blocks water can flow into only ever become water during a tick, so the sponge checks stay valid.
+   With a liquid budget, batches are only about as large as the remaining budget, so that
+   entries which can't spread this tick anyways are not dequeued or sponge checked at all. */
+#define PHYSICS_WATER_SLICE 1024
+static cc_uint32* waterBatch;
+static cc_uint8*  waterSponges;
+static int waterBatchCapacity, waterBatchCount;
+
+static void Physics_FindSpongesSlice(int item, int worker) {
+	int i   = item * PHYSICS_WATER_SLICE;
+	int end = min(i + PHYSICS_WATER_SLICE, waterBatchCount);
+	int index;
+	BlockID block;
+
+	for (; i < end; i++) {
+		/* Delayed entries are not activated this tick */
+		if (waterBatch[i] >= PHYSICS_ONE_DELAY) continue;
+		index = (int)(waterBatch[i] & PHYSICS_POS_MASK);
+
+		/* Blocks that are not water yet can only become water this tick if water can flow into them */
+		block = World_GetRawBlock(index);
+		if (block == BLOCK_WATER || block == BLOCK_STILL_WATER || Physics_CanFlowWater(index)) {
+			waterSponges[i] = Physics_FindSponges(index);
+		}
+	}
+}
+
+/* Copies up to count entries from the front of the water queue into the batch, then sponge checks them */
+static void Physics_CheckWaterBatch(int count) {
+	int i;
+	if (count > waterBatchCapacity) {
+		Mem_Free(waterBatch);
+		Mem_Free(waterSponges);
+		waterBatchCapacity = max(count, waterBatchCapacity * 2);
+		waterBatch   = (cc_uint32*)Mem_Alloc(waterBatchCapacity, 4, "physics water batch");
+		waterSponges = (cc_uint8*)Mem_Alloc(waterBatchCapacity, 1,  "physics water sponges");
+	}
+
+	for (i = 0; i < count; i++) { waterBatch[i] = TickQueue_Peek(&waterQ, i); }
+	waterBatchCount = count;
+	Workers_Run(Physics_FindSpongesSlice, (count + (PHYSICS_WATER_SLICE - 1)) / PHYSICS_WATER_SLICE);
 }
 
 static void Physics_TickWater(void) {
-	int i, count = waterQ.count;
-	for (i = 0; i < count; i++) {
-		int index;
-		if (Physics_CheckItem(&waterQ, &index)) {
-			BlockID block = World.Blocks[index];
+	int i, index, count, left = waterQ.count;
+	cc_uint32 item;
+	BlockID block;
+	Physics_BeginLiquidTick(&Physics.Water);
+
+	/* Only entries that were queued before this tick started are ticked */
+	while (left > 0 && !Physics_BudgetUsed(&Physics.Water)) {
+		count = left;
+		if (Physics.LiquidBudget) {
+			count = min(count, max(Physics.LiquidBudget - Physics.Water.Activated, PHYSICS_WATER_SLICE));
+		}
+		Physics_CheckWaterBatch(count);
+
+		for (i = 0; i < count && !Physics_BudgetUsed(&Physics.Water); i++) {
+			item  = TickQueue_Dequeue(&waterQ);
+			index = (int)(item & PHYSICS_POS_MASK);
+			left--;
+
+			if (item >= PHYSICS_ONE_DELAY) {
+				TickQueue_Enqueue(&waterQ, item - PHYSICS_ONE_DELAY);
+				continue;
+			}
+
+			block = World_GetRawBlock(index);
 			if (!(block == BLOCK_WATER || block == BLOCK_STILL_WATER)) continue;
-			Physics_ActivateWater(index, block);
+			Physics.Water.Activated++;
+			Physics_SpreadWater(index, waterSponges[i]);
 		}
 	}
+	Physics.Water.Deferred = left;
+	Physics.Water.Backlog  = waterQ.count;
 }
 
 
@@ -437,7 +608,7 @@ static void Physics_DeleteSponge(int index, BlockID block) {
 					if (!World_Contains(xx, yy, zz)) continue;
 
 					index = World_Pack(xx, yy, zz);
-					block = World.Blocks[index];
+					block = World_GetRawBlock(index);
 					if (block == BLOCK_WATER || block == BLOCK_STILL_WATER) {
 						TickQueue_Enqueue(&waterQ, index | PHYSICS_ONE_DELAY);
 					}
@@ -453,7 +624,7 @@ static void Physics_HandleSlab(int index, BlockID block) {
 	World_Unpack(index, x, y, z);
 	if (index < World.OneY) return;
 
-	if (World.Blocks[index - World.OneY] != BLOCK_SLAB) return;
+	if (World_GetRawBlock(index - World.OneY) != BLOCK_SLAB) return;
 	Game_UpdateBlock(x, y,     z, BLOCK_AIR);
 	Game_UpdateBlock(x, y - 1, z, BLOCK_DOUBLE_SLAB);
 }
@@ -463,7 +634,7 @@ static void Physics_HandleCobblestoneSlab(int index, BlockID block) {
 	World_Unpack(index, x, y, z);
 	if (index < World.OneY) return;
 
-	if (World.Blocks[index - World.OneY] != BLOCK_COBBLE_SLAB) return;
+	if (World_GetRawBlock(index - World.OneY) != BLOCK_COBBLE_SLAB) return;
 	Game_UpdateBlock(x, y,     z, BLOCK_AIR);
 	Game_UpdateBlock(x, y - 1, z, BLOCK_COBBLE);
 }
@@ -494,7 +665,7 @@ static void Physics_HandleTnt(int index, BlockID block) {
 				if (!World_Contains(xx, yy, zz)) continue;
 				index = World_Pack(xx, yy, zz);
 
-				block = World.Blocks[index];
+				block = World_GetRawBlock(index);
 				if (block < BLOCK_CPE_COUNT && blocksTnt[block]) continue;
 
 				Game_UpdateBlock(xx, yy, zz, BLOCK_AIR);
@@ -507,6 +678,7 @@ static void Physics_HandleTnt(int index, BlockID block) {
 void Physics_Init(void) {
 	Event_Register_(&WorldEvents.MapLoaded,    NULL, Physics_OnNewMapLoaded);
 	Physics.Enabled = Options_GetBool(OPT_BLOCK_PHYSICS, true);
+	Physics.LiquidBudget = Options_GetInt(OPT_LIQUID_BUDGET, 0, Int32_MaxValue, 0);
 	TickQueue_Init(&lavaQ);
 	TickQueue_Init(&waterQ);
 
@@ -549,10 +721,15 @@ void Physics_Init(void) {
 
 void Physics_Free(void) {
 	Event_Unregister_(&WorldEvents.MapLoaded,    NULL, Physics_OnNewMapLoaded);
+	Mem_Free(waterBatch);
+	Mem_Free(waterSponges);
+	waterBatch   = NULL;
+	waterSponges = NULL;
+	waterBatchCapacity = 0;
 }
 
 void Physics_Tick(void) {
-	if (!Physics.Enabled || !World.Blocks) return;
+	if (!Physics.Enabled || !World_HasBlocks()) return;
 
 	/*if ((tickCount % 5) == 0) {*/
 	Physics_TickLava();
@@ -6,6 +6,13 @@
 */
 typedef void (*PhysicsHandler)(int index, BlockID block);
 
+/* Statistics about a liquid's tick queue, updated every physics tick. */
+struct PhysicsLiquidStats {
+	int Backlog;   /* Number of entries still queued after the tick */
+	int Activated; /* Number of entries that spread liquid during the tick */
+	int Deferred;  /* Number of entries that were left queued untouched until the next tick, as the budget ran out */
+};
+
 CC_VAR extern struct Physics_ {
 	/* Whether block physics are enabled at all. */
 	cc_bool Enabled;
@@ -19,6 +26,10 @@ CC_VAR extern struct Physics_ {
 	PhysicsHandler OnPlace[256];
 	/* Called when user manually deletes a block. */
 	PhysicsHandler OnDelete[256];
+	/* Maximum number of entries of each liquid that spread per tick, 0 for no limit. */
+	/* Once the limit is reached, the rest of the queue is left until the next tick, so huge floods spread slower instead of stalling the game. */
+	int LiquidBudget;
+	struct PhysicsLiquidStats Water, Lava;
 } Physics;
 
 void Physics_SetEnabled(cc_bool enabled);
@@ -7,12 +7,14 @@
 #include "MapRenderer.h"
 #include "Graphics.h"
 #include "Drawer.h"
+#include "Workers.h"
 #include "ExtMath.h"
 #include "Block.h"
 #include "PackedCol.h"
 #include "TexturePack.h"
 #include "Game.h"
 #include "Options.h"
+#include "MeshCache.h"
 
 int Builder_SidesLevel, Builder_EdgeLevel;
 /* Packs an index into the 16x16x16 count array. Coordinates range from 0 to 15. */
@@ -20,25 +22,8 @@ int Builder_SidesLevel, Builder_EdgeLevel;
 /* Packs an index into the 18x18x18 chunk array. Coordinates range from -1 to 16. */
 #define Builder_PackChunk(xx, yy, zz) (((yy) + 1) * EXTCHUNK_SIZE_2 + ((zz) + 1) * EXTCHUNK_SIZE + ((xx) + 1))
 
-static BlockID* Builder_Chunk;
-static cc_uint8* Builder_Counts;
-static int* Builder_BitFlags;
-static cc_bool Builder_UseBitFlags;
-static int Builder_X, Builder_Y, Builder_Z;
-static BlockID Builder_Block;
-static int Builder_ChunkIndex;
-static cc_bool Builder_FullBright;
-static cc_bool Builder_Tinted;
-static int Builder_ChunkEndX, Builder_ChunkEndZ;
 static int Builder_Offsets[FACE_COUNT] = { -1,1, -EXTCHUNK_SIZE,EXTCHUNK_SIZE, -EXTCHUNK_SIZE_2,EXTCHUNK_SIZE_2 };
 
-static int (*Builder_StretchXLiquid)(int countIndex, int x, int y, int z, int chunkIndex, BlockID block);
-static int (*Builder_StretchX)(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
-static int (*Builder_StretchZ)(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
-static void (*Builder_RenderBlock)(int countsIndex);
-static void (*Builder_PreStretchTiles)(void);
-static void (*Builder_PostStretchTiles)(void);
-
 /* Contains state for vertices for a portion of a chunk mesh (vertices that are in a 1D atlas) */
 struct Builder1DPart {
 	struct VertexTextured* fVertices[FACE_COUNT];
@@ -46,10 +31,78 @@ struct Builder1DPart {
 	int sCount, sOffset, sAdvance;
 };
 
-/* Part builder data, for both normal and translucent parts.
-The first ATLAS1D_MAX_ATLASES parts are for normal parts, remainder are for translucent parts. */
-static struct Builder1DPart Builder_Parts[ATLAS1D_MAX_ATLASES * 2];
-static struct VertexTextured* Builder_Vertices;
+/* Contains all the state used while building the mesh of a single chunk. */
+/* NOTE: Each worker thread has its own context, so chunks can be built in parallel. */
+struct BuilderContext {
+	/* Blocks of the chunk, including the surrounding 1 block border */
+	BlockID Chunk[EXTCHUNK_SIZE_3];
+	cc_uint8 Counts[CHUNK_SIZE_3 * FACE_COUNT];
+	/* Number of rows a face was merged across (only used by greedy mesh builder) */
+	cc_uint8 Rows[CHUNK_SIZE_3 * FACE_COUNT];
+	int BitFlags[EXTCHUNK_SIZE_3];
+	/* Flood fill state for calculating which faces of the chunk can see each other */
+	cc_uint16 OpenRows[CHUNK_SIZE_2], VisitedRows[CHUNK_SIZE_2];
+	cc_uint32 FloodStack[CHUNK_SIZE_3];
+
+	int X, Y, Z;
+	BlockID Block;
+	int ChunkIndex;
+	cc_bool FullBright, Tinted;
+	int ChunkEndX, ChunkEndZ;
+
+	/* Part builder data, for both normal and translucent parts.
+	The first ATLAS1D_MAX_ATLASES parts are for normal parts, remainder are for translucent parts. */
+	struct Builder1DPart Parts[ATLAS1D_MAX_ATLASES * 2];
+	struct VertexTextured* Vertices;
+#ifdef CC_BUILD_COMPACTCHUNKS
+	/* Vertices are built into this context's own memory, then compacted into the chunk's mesh */
+	int VerticesCapacity;
+#endif
+	struct _DrawerData Drawer;
+	RNGState SpriteRng;
+
+	/* State for the advanced lighting mesh builder */
+	struct {
+		Vec3 minBB, maxBB;
+		int initBitFlags, lightFlags, baseOffset;
+		int* bitFlags;
+		float x1, y1, z1, x2, y2, z2;
+		PackedCol lerp[5], lerpX[5], lerpZ[5], lerpY[5];
+	} adv;
+#ifdef CC_BUILD_BENCHMARK
+	/* Raw stopwatch ticks spent in each phase of building */
+	struct BuilderTimings Timings;
+#endif
+};
+
+#ifdef CC_BUILD_BENCHMARK
+#define Builder_BeginPhase() phaseBeg = Stopwatch_Measure()
+#define Builder_EndPhase(phase) ctx->Timings.phase += Stopwatch_Measure() - phaseBeg
+#else
+#define Builder_BeginPhase()
+#define Builder_EndPhase(phase)
+#endif
+
+/* Vertices of a chunk mesh, which are built on a worker thread and then uploaded on the main thread */
+struct BuilderMesh {
+#ifdef CC_BUILD_COMPACTCHUNKS
+	struct VertexChunk* vertices;
+#else
+	struct VertexTextured* vertices;
+#endif
+	int count, capacity;
+	/* Key of the mesh in the mesh cache, 0 if the mesh isn't cached */
+	cc_uint64 key;
+	/* Cached mesh that vertices must be read from, NULL if the mesh was built */
+	const struct MeshCacheEntry* cached;
+};
+
+static int (*Builder_StretchXLiquid)(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block);
+static int (*Builder_StretchX)(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
+static int (*Builder_StretchZ)(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
+static void (*Builder_RenderBlock)(struct BuilderContext* ctx, int countsIndex);
+static void (*Builder_PreStretchTiles)(struct BuilderContext* ctx);
+static void (*Builder_PostStretchTiles)(struct BuilderContext* ctx);
 
 static int Builder1DPart_VerticesCount(struct Builder1DPart* part) {
 	int i, count = part->sCount;
@@ -57,23 +110,23 @@ static int Builder1DPart_VerticesCount(struct Builder1DPart* part) {
 	return count;
 }
 
-static int Builder1DPart_CalcOffsets(struct Builder1DPart* part, int offset) {
+static int Builder1DPart_CalcOffsets(struct BuilderContext* ctx, struct Builder1DPart* part, int offset) {
 	int i;
 	part->sOffset  = offset;
 	part->sAdvance = part->sCount >> 2;
 
 	offset += part->sCount;
 	for (i = 0; i < FACE_COUNT; i++) {
-		part->fVertices[i] = &Builder_Vertices[offset];
+		part->fVertices[i] = &ctx->Vertices[offset];
 		offset += part->fCount[i];
 	}
 	return offset;
 }
 
-static int Builder_TotalVerticesCount(void) {
+static int Builder_TotalVerticesCount(struct BuilderContext* ctx) {
 	int i, count = 0;
 	for (i = 0; i < ATLAS1D_MAX_ATLASES * 2; i++) {
-		count += Builder1DPart_VerticesCount(&Builder_Parts[i]);
+		count += Builder1DPart_VerticesCount(&ctx->Parts[i]);
 	}
 	return count;
 }
@@ -82,44 +135,19 @@ static int Builder_TotalVerticesCount(void) {
 /*########################################################################################################################*
 *----------------------------------------------------Base mesh builder----------------------------------------------------*
 *#########################################################################################################################*/
-static void AddSpriteVertices(BlockID block) {
+static void AddSpriteVertices(struct BuilderContext* ctx, BlockID block) {
 	int i = Atlas1D_Index(Block_Tex(block, FACE_XMAX));
-	struct Builder1DPart* part = &Builder_Parts[i];
+	struct Builder1DPart* part = &ctx->Parts[i];
 	part->sCount += 4 * 4;
 }
 
-static void AddVertices(BlockID block, Face face) {
+static void AddVertices(struct BuilderContext* ctx, BlockID block, Face face) {
 	int baseOffset = (Blocks.Draw[block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
 	int i = Atlas1D_Index(Block_Tex(block, face));
-	struct Builder1DPart* part = &Builder_Parts[baseOffset + i];
+	struct Builder1DPart* part = &ctx->Parts[baseOffset + i];
 	part->fCount[face] += 4;
 }
 
-#ifdef CC_BUILD_GL11
-static void BuildPartVbs(struct ChunkPartInfo* info) {
-	/* Sprites vertices are stored before chunk face sides */
-	int i, count, offset = info->Offset + info->SpriteCount;
-	for (i = 0; i < FACE_COUNT; i++) {
-		count = info->Counts[i];
-
-		if (count) {
-			info->Vbs[i] = Gfx_CreateVb2(&Builder_Vertices[offset], VERTEX_FORMAT_TEXTURED, count);
-			offset += count;
-		} else {
-			info->Vbs[i] = 0;
-		}
-	}
-
-	count  = info->SpriteCount;
-	offset = info->Offset;
-	if (count) {
-		info->Vbs[i] = Gfx_CreateVb2(&Builder_Vertices[offset], VERTEX_FORMAT_TEXTURED, count);
-	} else {
-		info->Vbs[i] = 0;
-	}
-}
-#endif
-
 static void SetPartInfo(struct Builder1DPart* part, int* offset, struct ChunkPartInfo* info, cc_bool* hasParts) {
 	int vCount = Builder1DPart_VerticesCount(part);
 	info->Offset = -1;
@@ -136,14 +164,10 @@ static void SetPartInfo(struct Builder1DPart* part, int* offset, struct ChunkPar
 	info->Counts[FACE_YMIN] = part->fCount[FACE_YMIN];
 	info->Counts[FACE_YMAX] = part->fCount[FACE_YMAX];
 	info->SpriteCount       = part->sCount;
-
-#ifdef CC_BUILD_GL11
-	BuildPartVbs(info);
-#endif
 }
 
 
-static void Builder_Stretch(int x1, int y1, int z1) {
+static void Builder_Stretch(struct BuilderContext* ctx, int x1, int y1, int z1) {
 	int xMax = min(World.Width,  x1 + CHUNK_SIZE);
 	int yMax = min(World.Height, y1 + CHUNK_SIZE);
 	int zMax = min(World.Length, z1 + CHUNK_SIZE);
@@ -152,95 +176,88 @@ static void Builder_Stretch(int x1, int y1, int z1) {
 	BlockID b;
 	int x, y, z, xx, yy, zz;
 
-#ifdef OCCLUSION
-	int flags = ComputeOcclusion();
-#endif
-#ifdef DEBUG_OCCLUSION
-	FastColour col = new FastColour(60, 60, 60, 255);
-	if (flags & 1) col.R = 255; /* x */
-	if (flags & 4) col.G = 255; /* y */
-	if (flags & 2) col.B = 255; /* z */
-	map.Sunlight = map.Shadowlight = col;
-	map.SunlightXSide = map.ShadowlightXSide = col;
-	map.SunlightZSide = map.ShadowlightZSide = col;
-	map.SunlightYBottom = map.ShadowlightYBottom = col;
-#endif
-	
 	for (y = y1, yy = 0; y < yMax; y++, yy++) {
 		for (z = z1, zz = 0; z < zMax; z++, zz++) {
 			cIndex = Builder_PackChunk(0, yy, zz);
 
 			for (x = x1, xx = 0; x < xMax; x++, xx++, cIndex++) {
-				b = Builder_Chunk[cIndex];
+				b = ctx->Chunk[cIndex];
 				if (Blocks.Draw[b] == DRAW_GAS) continue;
 				index = Builder_PackCount(xx, yy, zz);
 
 				/* Sprites can't be stretched, nor can then be they hidden by other blocks. */
 				/* Note sprites are drawn using DrawSprite and not with any of the DrawXFace. */
-				if (Blocks.Draw[b] == DRAW_SPRITE) { AddSpriteVertices(b); continue; }
+				if (Blocks.Draw[b] == DRAW_SPRITE) { AddSpriteVertices(ctx, b); continue; }
 
-				Builder_X = x; Builder_Y = y; Builder_Z = z;
-				Builder_FullBright = Blocks.FullBright[b];
+				ctx->X = x; ctx->Y = y; ctx->Z = z;
+				ctx->FullBright = Blocks.FullBright[b];
 				tileIdx = b * BLOCK_COUNT;
 				/* All of these function calls are inlined as they can be called tens of millions to hundreds of millions of times. */
 
-				if (Builder_Counts[index] == 0 ||
+				if (ctx->Counts[index] == 0 ||
 					(x == 0 && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(x != 0 && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex - 1]] & (1 << FACE_XMIN)) != 0)) {
-					Builder_Counts[index] = 0;
+					(x != 0 && (Blocks.Hidden[tileIdx + ctx->Chunk[cIndex - 1]] & (1 << FACE_XMIN)) != 0)) {
+					ctx->Counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchZ(index, x, y, z, cIndex, b, FACE_XMIN);
+					ctx->Counts[index] = Builder_StretchZ(ctx, index, x, y, z, cIndex, b, FACE_XMIN);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 ||
+				if (ctx->Counts[index] == 0 ||
 					(x == World.MaxX && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(x != World.MaxX && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex + 1]] & (1 << FACE_XMAX)) != 0)) {
-					Builder_Counts[index] = 0;
+					(x != World.MaxX && (Blocks.Hidden[tileIdx + ctx->Chunk[cIndex + 1]] & (1 << FACE_XMAX)) != 0)) {
+					ctx->Counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchZ(index, x, y, z, cIndex, b, FACE_XMAX);
+					ctx->Counts[index] = Builder_StretchZ(ctx, index, x, y, z, cIndex, b, FACE_XMAX);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 ||
+				if (ctx->Counts[index] == 0 ||
 					(z == 0 && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(z != 0 && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex - EXTCHUNK_SIZE]] & (1 << FACE_ZMIN)) != 0)) {
-					Builder_Counts[index] = 0;
+					(z != 0 && (Blocks.Hidden[tileIdx + ctx->Chunk[cIndex - EXTCHUNK_SIZE]] & (1 << FACE_ZMIN)) != 0)) {
+					ctx->Counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchX(index, Builder_X, Builder_Y, Builder_Z, cIndex, b, FACE_ZMIN);
+					ctx->Counts[index] = Builder_StretchX(ctx, index, ctx->X, ctx->Y, ctx->Z, cIndex, b, FACE_ZMIN);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 ||
+				if (ctx->Counts[index] == 0 ||
 					(z == World.MaxZ && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(z != World.MaxZ && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex + EXTCHUNK_SIZE]] & (1 << FACE_ZMAX)) != 0)) {
-					Builder_Counts[index] = 0;
+					(z != World.MaxZ && (Blocks.Hidden[tileIdx + ctx->Chunk[cIndex + EXTCHUNK_SIZE]] & (1 << FACE_ZMAX)) != 0)) {
+					ctx->Counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_ZMAX);
+					ctx->Counts[index] = Builder_StretchX(ctx, index, x, y, z, cIndex, b, FACE_ZMAX);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 || y == 0 ||
-					(Blocks.Hidden[tileIdx + Builder_Chunk[cIndex - EXTCHUNK_SIZE_2]] & (1 << FACE_YMIN)) != 0) {
-					Builder_Counts[index] = 0;
+				if (ctx->Counts[index] == 0 || y == 0 ||
+					(Blocks.Hidden[tileIdx + ctx->Chunk[cIndex - EXTCHUNK_SIZE_2]] & (1 << FACE_YMIN)) != 0) {
+					ctx->Counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_YMIN);
+					ctx->Counts[index] = Builder_StretchX(ctx, index, x, y, z, cIndex, b, FACE_YMIN);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 ||
-					(Blocks.Hidden[tileIdx + Builder_Chunk[cIndex + EXTCHUNK_SIZE_2]] & (1 << FACE_YMAX)) != 0) {
-					Builder_Counts[index] = 0;
+				if (ctx->Counts[index] == 0 ||
+					(Blocks.Hidden[tileIdx + ctx->Chunk[cIndex + EXTCHUNK_SIZE_2]] & (1 << FACE_YMAX)) != 0) {
+					ctx->Counts[index] = 0;
 				} else if (b < BLOCK_WATER || b > BLOCK_STILL_LAVA) {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_YMAX);
+					ctx->Counts[index] = Builder_StretchX(ctx, index, x, y, z, cIndex, b, FACE_YMAX);
 				} else {
-					Builder_Counts[index] = Builder_StretchXLiquid(index, x, y, z, cIndex, b);
+					ctx->Counts[index] = Builder_StretchXLiquid(ctx, index, x, y, z, cIndex, b);
 				}
 			}
 		}
 	}
 }
 
+#if defined PALETTE_BLOCKS
+/* World_GetBlock is slow with palette chunks, so each row of blocks is read at once instead */
+#define ReadChunkRow(x, y, z, count) World_GetBlockRow(row, x, y, z, count);
+#else
+#define ReadChunkRow(x, y, z, count)
+#endif
+
 #define ReadChunkBody(get_block)\
 for (yy = -1; yy < 17; ++yy) {\
 	y = yy + y1;\
@@ -248,32 +265,37 @@ for (yy = -1; yy < 17; ++yy) {\
 \
 		index  = World_Pack(x1 - 1, y, z1 + zz);\
 		cIndex = Builder_PackChunk(-1, yy, zz);\
+		ReadChunkRow(x1 - 1, y, z1 + zz, EXTCHUNK_SIZE)\
 		for (xx = -1; xx < 17; ++xx, ++index, ++cIndex) {\
 \
 			block    = get_block;\
 			allAir   = allAir   && Blocks.Draw[block] == DRAW_GAS;\
 			allSolid = allSolid && Blocks.FullOpaque[block];\
-			Builder_Chunk[cIndex] = block;\
+			ctx->Chunk[cIndex] = block;\
 		}\
 	}\
 }
 
-static cc_bool ReadChunkData(int x1, int y1, int z1, cc_bool* outAllAir) {
+static cc_bool ReadChunkData(struct BuilderContext* ctx, int x1, int y1, int z1, cc_bool* outAllAir) {
+#if defined PALETTE_BLOCKS
+	BlockID row[EXTCHUNK_SIZE];
+#else
 	BlockRaw* blocks = World.Blocks;
-	BlockRaw* blocks2;
+#endif
 	cc_bool allAir = true, allSolid = true;
 	int index, cIndex;
 	BlockID block;
 	int xx, yy, zz, y;
 
-#ifndef EXTENDED_BLOCKS
+#if defined PALETTE_BLOCKS
+	ReadChunkBody(row[xx + 1]);
+#elif !defined EXTENDED_BLOCKS
 	ReadChunkBody(blocks[index]);
 #else
 	if (World.IDMask <= 0xFF) {
 		ReadChunkBody(blocks[index]);
 	} else {
-		blocks2 = World.Blocks2;
-		ReadChunkBody(blocks[index] | (blocks2[index] << 8));
+		ReadChunkBody(blocks[index] | (World_GetUpper(index) << 8));
 	}
 #endif
 
@@ -294,6 +316,7 @@ for (yy = -1; yy < 17; ++yy) {\
 \
 		index  = World_Pack(x1 - 1, y, z);\
 		cIndex = Builder_PackChunk(-1, yy, zz);\
+		ReadChunkRow(xMin, y, z, xMax - xMin)\
 \
 		for (xx = -1; xx < 17; ++xx, ++index, ++cIndex) {\
 			x = xx + x1;\
@@ -302,27 +325,32 @@ for (yy = -1; yy < 17; ++yy) {\
 \
 			block  = get_block;\
 			allAir = allAir && Blocks.Draw[block] == DRAW_GAS;\
-			Builder_Chunk[cIndex] = block;\
+			ctx->Chunk[cIndex] = block;\
 		}\
 	}\
 }
 
-static cc_bool ReadBorderChunkData(int x1, int y1, int z1, cc_bool* outAllAir) {
+static cc_bool ReadBorderChunkData(struct BuilderContext* ctx, int x1, int y1, int z1, cc_bool* outAllAir) {
+#if defined PALETTE_BLOCKS
+	BlockID row[EXTCHUNK_SIZE];
+	int xMin = max(x1 - 1, 0), xMax = min(x1 + CHUNK_SIZE + 1, World.Width);
+#else
 	BlockRaw* blocks = World.Blocks;
-	BlockRaw* blocks2;
+#endif
 	cc_bool allAir = true;
 	int index, cIndex;
 	BlockID block;
 	int xx, yy, zz, x, y, z;
 
-#ifndef EXTENDED_BLOCKS
+#if defined PALETTE_BLOCKS
+	ReadBorderChunkBody(row[x - xMin]);
+#elif !defined EXTENDED_BLOCKS
 	ReadBorderChunkBody(blocks[index]);
 #else
 	if (World.IDMask <= 0xFF) {
 		ReadBorderChunkBody(blocks[index]);
 	} else {
-		blocks2 = World.Blocks2;
-		ReadBorderChunkBody(blocks[index] | (blocks2[index] << 8));
+		ReadBorderChunkBody(blocks[index] | (World_GetUpper(index) << 8));
 	}
 #endif
 
@@ -330,20 +358,222 @@ static cc_bool ReadBorderChunkData(int x1, int y1, int z1, cc_bool* outAllAir) {
 	return false;
 }
 
-static cc_bool BuildChunk(int x1, int y1, int z1, struct ChunkInfo* info) {
-	BlockID chunk[EXTCHUNK_SIZE_3]; 
-	cc_uint8 counts[CHUNK_SIZE_3 * FACE_COUNT]; 
-	int bitFlags[EXTCHUNK_SIZE_3];
+/* Expands the given bits of a row of blocks to cover the runs of open blocks they are in */
+static int Builder_FillRow(int bits, int open) {
+	int prev;
+	do {
+		prev  = bits;
+		bits |= ((bits << 1) | (bits >> 1)) & open;
+	} while (bits != prev);
+	return bits;
+}
+
+#define Builder_FloodTo(onFace, face, row) \
+if (onFace) { faces |= 1 << face; } else {\
+	next = bits & open[row] & ~visited[row];\
+	if (next) { visited[row] |= next; stack[count++] = ((row) << 16) | next; }\
+}
+
+/* Calculates which faces of the chunk can see each other through its non-opaque blocks, by flood filling */
+/*  each group of connected non-opaque blocks and recording which faces of the chunk the group touches */
+/* NOTE: Flood fill works on whole rows of blocks along the X axis at once, as bitmasks */
+static void Builder_CalcConnects(struct BuilderContext* ctx, struct ChunkInfo* info) {
+	cc_uint16* open    = ctx->OpenRows;
+	cc_uint16* visited = ctx->VisitedRows;
+	cc_uint32* stack   = ctx->FloodStack;
+	int row, cur, bits, next, count, faces, face;
+	int cIndex, xx, yy, zz, opaque = 0;
+
+	for (yy = 0, row = 0; yy < CHUNK_SIZE; yy++) {
+		for (zz = 0; zz < CHUNK_SIZE; zz++, row++) {
+			cIndex = Builder_PackChunk(0, yy, zz);
+			bits   = 0;
+
+			for (xx = 0; xx < CHUNK_SIZE; xx++, cIndex++) {
+				if (Blocks.FullOpaque[ctx->Chunk[cIndex]]) { opaque++; } else { bits |= 1 << xx; }
+			}
+			open[row] = bits; visited[row] = 0;
+		}
+	}
+
+	/* Too few opaque blocks to form a wall across the chunk, so skip the costly flood fill */
+	/* (this just means less chunks are occluded, in the rare case that the blocks do separate faces) */
+	if (opaque < CHUNK_SIZE_2) {
+		Mem_Set(info->Connects, CHUNK_CONNECTS_ALL, FACE_COUNT); return;
+	}
+	Mem_Set(info->Connects, 0, FACE_COUNT);
+
+	for (row = 0; row < CHUNK_SIZE_2; row++) {
+		while ((bits = open[row] & ~visited[row])) {
+			bits &= -bits; /* lowest unvisited block */
+			visited[row] |= bits;
+			stack[0] = (row << 16) | bits;
+			count = 1; faces = 0;
+
+			while (count) {
+				next = stack[--count];
+				cur  = next >> 16;
+				zz   = cur & CHUNK_MASK; yy = cur >> CHUNK_SHIFT;
+
+				bits = Builder_FillRow(next & 0xFFFF, open[cur] & ~visited[cur]);
+				visited[cur] |= bits;
+				if (bits & 1)                faces |= 1 << FACE_XMIN;
+				if (bits & (1 << CHUNK_MAX)) faces |= 1 << FACE_XMAX;
+
+				Builder_FloodTo(zz == 0,         FACE_ZMIN, cur - 1);
+				Builder_FloodTo(zz == CHUNK_MAX, FACE_ZMAX, cur + 1);
+				Builder_FloodTo(yy == 0,         FACE_YMIN, cur - CHUNK_SIZE);
+				Builder_FloodTo(yy == CHUNK_MAX, FACE_YMAX, cur + CHUNK_SIZE);
+			}
 
-	cc_bool allAir, allSolid, onBorder;
+			for (face = 0; face < FACE_COUNT; face++) {
+				if (faces & (1 << face)) info->Connects[face] |= faces;
+			}
+		}
+	}
+}
+
+#ifdef CC_BUILD_COMPACTCHUNKS
+/* Rounds to nearest, biased so the truncating float to int conversion also works for negative values */
+#define Builder_Fixed(value, scale) ((cc_int16)((int)((value) * (scale) + 32768.5f) - 32768))
+
+/* Converts the built vertices to fixed point, with positions relative to the chunk's origin */
+static void Builder_CompactVertices(struct BuilderContext* ctx, struct BuilderMesh* mesh, int x1, int y1, int z1) {
+	struct VertexTextured* src = ctx->Vertices;
+	struct VertexChunk* dst    = mesh->vertices;
+	int i, v, tileEnd, vScale = CHUNK_TEX_SCALE_V;
+	int tiles = Atlas1D.TilesPerAtlas, tileUnits = vScale / tiles;
+
+	for (i = 0; i < mesh->count; i++, src++, dst++) {
+		dst->X   = Builder_Fixed(src->X - x1, VERTEX_CHUNK_POS_SCALE);
+		dst->Y   = Builder_Fixed(src->Y - y1, VERTEX_CHUNK_POS_SCALE);
+		dst->Z   = Builder_Fixed(src->Z - z1, VERTEX_CHUNK_POS_SCALE);
+		dst->W   = 0;
+		dst->Col = src->Col;
+		dst->U   = Builder_Fixed(src->U, CHUNK_TEX_SCALE_U);
+
+		if (tiles == 1) { dst->V = Builder_Fixed(src->V, vScale); continue; }
+		/* Float V of the bottom edge of a tile is inset only slightly (see UV2_Scale), which can round */
+		/*  to exactly the top edge of the next tile. So keep V at least one unit inside its own tile */
+		v       = (int)(src->V * vScale + 0.5f);
+		tileEnd = ((int)(src->V * tiles) + 1) * tileUnits - 1;
+		dst->V  = (cc_int16)min(v, tileEnd);
+	}
+}
+#endif
+
+static void Builder_ReserveMesh(struct BuilderMesh* mesh, int count) {
+	/* add an extra element to fix crashing on some GPUs */
+	if (count + 1 <= mesh->capacity) return;
+	Mem_Free(mesh->vertices);
+	mesh->capacity = count + 1;
+#ifdef CC_BUILD_COMPACTCHUNKS
+	mesh->vertices = (struct VertexChunk*)Mem_Alloc(mesh->capacity, sizeof(struct VertexChunk), "chunk vertices");
+#else
+	mesh->vertices = (struct VertexTextured*)Mem_Alloc(mesh->capacity, sizeof(struct VertexTextured), "chunk vertices");
+#endif
+}
+
+/* Calculates the key of the chunk's mesh in the mesh cache, from everything the mesh is built from */
+static cc_uint64 Builder_CalcCacheKey(struct BuilderContext* ctx, int x1, int y1, int z1) {
+	cc_uint8 used[BLOCK_COUNT];
+	BlockID blocks[BLOCK_COUNT];
+	cc_uint8 hidden[BLOCK_COUNT];
+	cc_int16 heights[EXTCHUNK_SIZE];
+	int state[20];
+	cc_uint64 key;
+	int i, j, x, z, h, count = 0;
+	BlockID b;
+
+	state[0]  = x1; state[1] = y1; state[2] = z1;
+	state[3]  = World.Width; state[4] = World.Height; state[5] = World.Length;
+	state[6]  = Builder_SidesLevel; state[7] = Builder_EdgeLevel;
+	state[8]  = Env.EdgeHeight;     state[9] = Env_SidesHeight;
+	state[10] = Env.SunCol;    state[11] = Env.SunXSide;    state[12] = Env.SunZSide;    state[13] = Env.SunYMin;
+	state[14] = Env.ShadowCol; state[15] = Env.ShadowXSide; state[16] = Env.ShadowZSide; state[17] = Env.ShadowYMin;
+	state[18] = Atlas1D.TilesPerAtlas | (MapRenderer_1DUsedCount << 16);
+	state[19] = Builder_SmoothLighting | (Builder_GreedyMeshing << 1) | (Game_ClassicMode << 2) | (CHUNK_VERTEX_SIZE << 8);
+
+	key = MeshCache_Hash(MESHCACHE_HASH_SEED, state, sizeof(state));
+	key = MeshCache_Hash(key, ctx->Chunk, sizeof(ctx->Chunk));
+
+	/* Blocks are only lit or not based on the light height, so heights far above/below the chunk are equivalent */
+	for (z = z1 - 1; z <= z1 + CHUNK_SIZE; z++) {
+		if (z < 0 || z >= World.Length) continue;
+
+		for (x = x1 - 1, i = 0; x <= x1 + CHUNK_SIZE; x++, i++) {
+			h = (x < 0 || x >= World.Width) ? 0 : Lighting_Heightmap[Lighting_Pack(x, z)];
+			Math_Clamp(h, y1 - 3, y1 + CHUNK_SIZE + 1);
+			heights[i] = (cc_int16)h;
+		}
+		key = MeshCache_Hash(key, heights, sizeof(heights));
+	}
+
+	/* Properties of the blocks in the chunk */
+	Mem_Set(used, 0, sizeof(used));
+	for (i = 0; i < EXTCHUNK_SIZE_3; i++) { used[ctx->Chunk[i]] = true; }
+	for (i = 0; i < BLOCK_COUNT; i++) {
+		if (used[i]) blocks[count++] = (BlockID)i;
+	}
+
+	for (i = 0; i < count; i++) {
+		b   = blocks[i];
+		key = MeshCache_Hash(key, &b, sizeof(BlockID));
+		key = MeshCache_Hash(key, &Blocks.Draw[b],         sizeof(Blocks.Draw[b]));
+		key = MeshCache_Hash(key, &Blocks.FullBright[b],   sizeof(Blocks.FullBright[b]));
+		key = MeshCache_Hash(key, &Blocks.Tinted[b],       sizeof(Blocks.Tinted[b]));
+		key = MeshCache_Hash(key, &Blocks.FogCol[b],       sizeof(Blocks.FogCol[b]));
+		key = MeshCache_Hash(key, &Blocks.LightOffset[b],  sizeof(Blocks.LightOffset[b]));
+		key = MeshCache_Hash(key, &Blocks.SpriteOffset[b], sizeof(Blocks.SpriteOffset[b]));
+		key = MeshCache_Hash(key, &Blocks.FullOpaque[b],   sizeof(Blocks.FullOpaque[b]));
+		key = MeshCache_Hash(key, &Blocks.CanStretch[b],   sizeof(Blocks.CanStretch[b]));
+		key = MeshCache_Hash(key, &Blocks.MinBB[b],        sizeof(Vec3));
+		key = MeshCache_Hash(key, &Blocks.MaxBB[b],        sizeof(Vec3));
+		key = MeshCache_Hash(key, &Blocks.RenderMinBB[b],  sizeof(Vec3));
+		key = MeshCache_Hash(key, &Blocks.RenderMaxBB[b],  sizeof(Vec3));
+		key = MeshCache_Hash(key, &Blocks.Textures[b * FACE_COUNT], FACE_COUNT * sizeof(TextureLoc));
+
+		for (j = 0; j < count; j++) { hidden[j] = Blocks.Hidden[b * BLOCK_COUNT + blocks[j]]; }
+		key = MeshCache_Hash(key, hidden, count);
+	}
+	/* 0 is used for meshes that aren't cached */
+	return key ? key : 1;
+}
+
+/* Sets up the chunk's mesh from the mesh cache, with the vertices later read by the main thread */
+static cc_bool Builder_FindCached(struct BuilderContext* ctx, struct ChunkInfo* info, struct BuilderMesh* mesh, int chunkIndex) {
+	const struct MeshCacheEntry* entry = MeshCache_Find(chunkIndex, mesh->key);
+	const struct MeshCachePart* src;
+	struct Builder1DPart* part;
+	int i, j;
+	if (!entry) return false;
+
+	Mem_Copy(info->Connects, entry->Connects, FACE_COUNT);
+	for (i = 0; i < entry->PartsCount; i++) {
+		src  = &entry->Parts[i];
+		part = &ctx->Parts[src->Index];
+
+		for (j = 0; j < FACE_COUNT; j++) { part->fCount[j] = src->Counts[j]; }
+		part->sCount = src->Counts[FACE_COUNT];
+	}
+
+	Builder_ReserveMesh(mesh, entry->Count);
+	mesh->count  = entry->Count;
+	mesh->cached = entry;
+	return true;
+}
+
+static cc_bool BuildChunk(struct BuilderContext* ctx, int x1, int y1, int z1, struct ChunkInfo* info, struct BuilderMesh* mesh) {
+	cc_bool allAir, allSolid, onBorder, cached;
 	int xMax, yMax, zMax, totalVerts;
 	int cIndex, index;
 	int x, y, z, xx, yy, zz;
+#ifdef CC_BUILD_BENCHMARK
+	cc_uint64 phaseBeg;
+#endif
 
-	Builder_Chunk  = chunk;
-	Builder_Counts = counts;
-	Builder_BitFlags = bitFlags;
-	Builder_PreStretchTiles();
+	Builder_PreStretchTiles(ctx);
+	Builder_BeginPhase();
 	
 	onBorder = 
 		x1 == 0 || y1 == 0 || z1 == 0   || x1 + CHUNK_SIZE >= World.Width ||
@@ -351,67 +581,138 @@ static cc_bool BuildChunk(int x1, int y1, int z1, struct ChunkInfo* info) {
 
 	if (onBorder) {
 		/* less optimal case here */
-		Mem_Set(chunk, BLOCK_AIR, EXTCHUNK_SIZE_3 * sizeof(BlockID));
-		allSolid = ReadBorderChunkData(x1, y1, z1, &allAir);
+		Mem_Set(ctx->Chunk, BLOCK_AIR, EXTCHUNK_SIZE_3 * sizeof(BlockID));
+		allSolid = ReadBorderChunkData(ctx, x1, y1, z1, &allAir);
 	} else {
-		allSolid = ReadChunkData(x1, y1, z1, &allAir);
+		allSolid = ReadChunkData(ctx, x1, y1, z1, &allAir);
 	}
+	Builder_EndPhase(ReadChunkData);
 
 	info->AllAir = allAir;
-	if (allAir || allSolid) return false;
-	Lighting_LightHint(x1 - 1, z1 - 1);
+	if (allAir || allSolid) {
+		Mem_Set(info->Connects, allAir ? CHUNK_CONNECTS_ALL : 0, FACE_COUNT);
+		return false;
+	}
+
+	if (MeshCache_Active) {
+		Builder_BeginPhase();
+		mesh->key = Builder_CalcCacheKey(ctx, x1, y1, z1);
+		cached    = Builder_FindCached(ctx, info, mesh, MapRenderer_Pack(x1 >> CHUNK_SHIFT, y1 >> CHUNK_SHIFT, z1 >> CHUNK_SHIFT));
+		Builder_EndPhase(Cache);
+		if (cached) return mesh->count > 0;
+	}
+
+	Builder_BeginPhase();
+	Builder_CalcConnects(ctx, info);
+	Builder_EndPhase(Occlusion);
 
-	Mem_Set(counts, 1, CHUNK_SIZE_3 * FACE_COUNT);
+	Mem_Set(ctx->Counts, 1, CHUNK_SIZE_3 * FACE_COUNT);
 	xMax = min(World.Width,  x1 + CHUNK_SIZE);
 	yMax = min(World.Height, y1 + CHUNK_SIZE);
 	zMax = min(World.Length, z1 + CHUNK_SIZE);
 
-	Builder_ChunkEndX = xMax; Builder_ChunkEndZ = zMax;
-	Builder_Stretch(x1, y1, z1);
+	ctx->ChunkEndX = xMax; ctx->ChunkEndZ = zMax;
+	Builder_BeginPhase();
+	Builder_Stretch(ctx, x1, y1, z1);
+	Builder_EndPhase(Stretch);
 
-	totalVerts = Builder_TotalVerticesCount();
+	totalVerts = Builder_TotalVerticesCount(ctx);
 	if (!totalVerts) return false;
 
-#ifndef CC_BUILD_GL11
-	/* add an extra element to fix crashing on some GPUs */
-	Builder_Vertices = (struct VertexTextured*)Gfx_RecreateAndLockVb(&info->Vb,
-													VERTEX_FORMAT_TEXTURED, totalVerts + 1);
+	Builder_ReserveMesh(mesh, totalVerts);
+	mesh->count   = totalVerts;
+#ifdef CC_BUILD_COMPACTCHUNKS
+	if (totalVerts > ctx->VerticesCapacity) {
+		Mem_Free(ctx->Vertices);
+		ctx->VerticesCapacity = totalVerts;
+		ctx->Vertices = (struct VertexTextured*)Mem_Alloc(totalVerts, sizeof(struct VertexTextured), "chunk build vertices");
+	}
 #else
-	/* NOTE: Relies on assumption vb is ignored by GL11 Gfx_LockVb implementation */
-	Builder_Vertices = (struct VertexTextured*)Gfx_LockVb(0, 
-													VERTEX_FORMAT_TEXTURED, totalVerts + 1);
+	ctx->Vertices = mesh->vertices;
 #endif
-	Builder_PostStretchTiles();
+	Builder_PostStretchTiles(ctx);
+	Builder_BeginPhase();
 
 	for (y = y1, yy = 0; y < yMax; y++, yy++) {
 		for (z = z1, zz = 0; z < zMax; z++, zz++) {
 			cIndex = Builder_PackChunk(0, yy, zz);
 
 			for (x = x1, xx = 0; x < xMax; x++, xx++, cIndex++) {
-				Builder_Block = chunk[cIndex];
-				if (Blocks.Draw[Builder_Block] == DRAW_GAS) continue;
+				ctx->Block = ctx->Chunk[cIndex];
+				if (Blocks.Draw[ctx->Block] == DRAW_GAS) continue;
 
 				index = Builder_PackCount(xx, yy, zz);
-				Builder_X = x; Builder_Y = y; Builder_Z = z;
-				Builder_ChunkIndex = cIndex;
-				Builder_RenderBlock(index);
+				ctx->X = x; ctx->Y = y; ctx->Z = z;
+				ctx->ChunkIndex = cIndex;
+				Builder_RenderBlock(ctx, index);
 			}
 		}
 	}
+	Builder_EndPhase(RenderBlock);
+
+#ifdef CC_BUILD_COMPACTCHUNKS
+	Builder_BeginPhase();
+	Builder_CompactVertices(ctx, mesh, x1, y1, z1);
+	Builder_EndPhase(Compact);
+#endif
+	return true;
+}
 
+#ifdef CC_BUILD_GL11
+static void BuildPartVbs(struct ChunkPartInfo* info, struct VertexTextured* vertices) {
+	/* Sprites vertices are stored before chunk face sides */
+	int i, count, offset = info->Offset + info->SpriteCount;
+	for (i = 0; i < FACE_COUNT; i++) {
+		count = info->Counts[i];
+
+		if (count) {
+			info->Vbs[i] = Gfx_CreateVb2(&vertices[offset], VERTEX_FORMAT_TEXTURED, count);
+			offset += count;
+		} else {
+			info->Vbs[i] = 0;
+		}
+	}
+
+	count  = info->SpriteCount;
+	offset = info->Offset;
+	if (count) {
+		info->Vbs[i] = Gfx_CreateVb2(&vertices[offset], VERTEX_FORMAT_TEXTURED, count);
+	} else {
+		info->Vbs[i] = 0;
+	}
+}
+#endif
+
+/* Uploads the vertices built for the given chunk to the GPU. Must be called on the main thread. */
+static void UploadChunk(struct ChunkInfo* info, struct BuilderMesh* mesh) {
 #ifndef CC_BUILD_GL11
+	void* data = Gfx_RecreateAndLockVb(&info->Vb, CHUNK_VERTEX_FORMAT, mesh->count + 1);
+	Mem_Copy(data, mesh->vertices, mesh->count * CHUNK_VERTEX_SIZE);
 	Gfx_UnlockVb(info->Vb);
+#else
+	int partsIndex, i, curIdx;
+	partsIndex = MapRenderer_Pack(info->CentreX >> CHUNK_SHIFT, info->CentreY >> CHUNK_SHIFT, info->CentreZ >> CHUNK_SHIFT);
+	for (i = 0; i < MapRenderer_1DUsedCount; i++) {
+		curIdx = partsIndex + i * MapRenderer_ChunksCount;
+
+		if (MapRenderer_PartsNormal[curIdx].Offset >= 0)
+			BuildPartVbs(&MapRenderer_PartsNormal[curIdx],      mesh->vertices);
+		if (MapRenderer_PartsTranslucent[curIdx].Offset >= 0)
+			BuildPartVbs(&MapRenderer_PartsTranslucent[curIdx], mesh->vertices);
+	}
 #endif
-	return true;
 }
 
-void Builder_MakeChunk(struct ChunkInfo* info) {
+static void MakeChunk(struct BuilderContext* ctx, struct ChunkInfo* info, struct BuilderMesh* mesh) {
 	int x = info->CentreX - 8, y = info->CentreY - 8, z = info->CentreZ - 8;
 	cc_bool hasMesh, hasNorm, hasTran;
 	int partsIndex;
 	int i, j, curIdx, offset;
 
-	hasMesh = BuildChunk(x, y, z, info);
+	mesh->count  = 0;
+	mesh->key    = 0;
+	mesh->cached = NULL;
+	hasMesh = BuildChunk(ctx, x, y, z, info, mesh);
 	if (!hasMesh) return;
 
 	partsIndex = MapRenderer_Pack(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT);
@@ -423,8 +724,8 @@ void Builder_MakeChunk(struct ChunkInfo* info) {
 		j = i + ATLAS1D_MAX_ATLASES;
 		curIdx = partsIndex + i * MapRenderer_ChunksCount;
 
-		SetPartInfo(&Builder_Parts[i], &offset, &MapRenderer_PartsNormal[curIdx],      &hasNorm);
-		SetPartInfo(&Builder_Parts[j], &offset, &MapRenderer_PartsTranslucent[curIdx], &hasTran);
+		SetPartInfo(&ctx->Parts[i], &offset, &MapRenderer_PartsNormal[curIdx],      &hasNorm);
+		SetPartInfo(&ctx->Parts[j], &offset, &MapRenderer_PartsTranslucent[curIdx], &hasTran);
 	}
 
 	if (hasNorm) {
@@ -433,40 +734,187 @@ void Builder_MakeChunk(struct ChunkInfo* info) {
 	if (hasTran) {
 		info->TranslucentParts = &MapRenderer_PartsTranslucent[partsIndex];
 	}
+}
+
+static struct BuilderContext* contexts[WORKERS_MAX_COUNT];
+static struct BuilderMesh* meshes;
+static int meshesCapacity;
+static struct ChunkInfo** batchChunks;
+
+static void BuildChunkWorker(int item, int worker) {
+	/* Allocated on the worker thread, as it may never be needed by the other workers */
+	if (!contexts[worker]) {
+		contexts[worker] = (struct BuilderContext*)Mem_AllocCleared(1, sizeof(struct BuilderContext), "chunk builder context");
+	}
+	MakeChunk(contexts[worker], batchChunks[item], &meshes[item]);
+}
+
+static struct MeshCachePart cacheParts[ATLAS1D_MAX_ATLASES * 2];
+static int AddCachePart(int count, struct ChunkPartInfo* info, int index) {
+	struct MeshCachePart* part = &cacheParts[count];
+	int i;
+	if (info->Offset < 0) return count;
+
+	part->Index = index;
+	for (i = 0; i < FACE_COUNT; i++) { part->Counts[i] = info->Counts[i]; }
+	part->Counts[FACE_COUNT] = info->SpriteCount;
+	return count + 1;
+}
+
+/* Appends a newly built mesh to the mesh cache */
+static void StoreCachedMesh(struct ChunkInfo* info, struct BuilderMesh* mesh) {
+	int partsIndex, i, curIdx, count = 0;
+	partsIndex = MapRenderer_Pack(info->CentreX >> CHUNK_SHIFT, info->CentreY >> CHUNK_SHIFT, info->CentreZ >> CHUNK_SHIFT);
+
+	for (i = 0; i < MapRenderer_1DUsedCount; i++) {
+		curIdx = partsIndex + i * MapRenderer_ChunksCount;
+
+		if (info->NormalParts)      count = AddCachePart(count, &MapRenderer_PartsNormal[curIdx],      i);
+		if (info->TranslucentParts) count = AddCachePart(count, &MapRenderer_PartsTranslucent[curIdx], i + ATLAS1D_MAX_ATLASES);
+	}
+	MeshCache_Store(partsIndex, mesh->key, info->Connects, cacheParts, count, mesh->vertices, mesh->count);
+}
+
+/* Reads the vertices of meshes found in the mesh cache, and stores newly built meshes in the mesh cache */
+static void UpdateCachedMesh(int item) {
+	struct ChunkInfo* info   = batchChunks[item];
+	struct BuilderMesh* mesh = &meshes[item];
+	int chunkIndex;
+
+	if (mesh->cached) {
+		if (MeshCache_ReadVertices(mesh->cached, mesh->vertices)) return;
+		/* Cached vertices couldn't be read, so just build the mesh again instead */
+		chunkIndex = MapRenderer_Pack(info->CentreX >> CHUNK_SHIFT, info->CentreY >> CHUNK_SHIFT, info->CentreZ >> CHUNK_SHIFT);
+		MeshCache_Invalidate(chunkIndex);
+
+		info->NormalParts      = NULL;
+		info->TranslucentParts = NULL;
+		BuildChunkWorker(item, 0);
+	}
+	if (mesh->key) StoreCachedMesh(info, mesh);
+}
+
+static cc_bool IsSummaryOpaque(int cx, int cy, int cz) {
+	struct ChunkSummary* summary = World_GetChunkSummary(cx, cy, cz);
+	return summary && summary->Opaque == summary->Total;
+}
+
+cc_bool Builder_IsChunkEmpty(struct ChunkInfo* info) {
+	int cx = info->CentreX >> CHUNK_SHIFT, cy = info->CentreY >> CHUNK_SHIFT, cz = info->CentreZ >> CHUNK_SHIFT;
+	int x1 = cx << CHUNK_SHIFT, y1 = cy << CHUNK_SHIFT, z1 = cz << CHUNK_SHIFT;
+	struct ChunkSummary* summary;
+	cc_bool onBorder;
+
+	summary = World_GetChunkSummary(cx, cy, cz);
+	if (!summary) return false;
+	if (summary->Gas == summary->Total) {
+		info->AllAir = true;
+		Mem_Set(info->Connects, CHUNK_CONNECTS_ALL, FACE_COUNT);
+		return true;
+	}
+	if (summary->Opaque != summary->Total) return false;
 
-#ifdef OCCLUSION
-	if (info.NormalParts != null || info.TranslucentParts != null)
-		info.occlusionFlags = (cc_uint8)ComputeOcclusion();
+	/* Sides of chunks on the map borders may still be visible */
+	onBorder = 
+		x1 == 0 || y1 == 0 || z1 == 0   || x1 + CHUNK_SIZE >= World.Width ||
+		y1 + CHUNK_SIZE >= World.Height || z1 + CHUNK_SIZE >= World.Length;
+	if (onBorder) return false;
+
+	/* Fully buried, so every face is hidden by a neighbouring opaque block */
+	if (!IsSummaryOpaque(cx - 1, cy, cz) || !IsSummaryOpaque(cx + 1, cy, cz)
+		|| !IsSummaryOpaque(cx, cy - 1, cz) || !IsSummaryOpaque(cx, cy + 1, cz)
+		|| !IsSummaryOpaque(cx, cy, cz - 1) || !IsSummaryOpaque(cx, cy, cz + 1)) return false;
+
+	Mem_Set(info->Connects, 0, FACE_COUNT);
+	return true;
+}
+
+void Builder_MakeChunks(struct ChunkInfo** chunks, int count) {
+	struct BuilderMesh* newMeshes;
+	struct ChunkInfo* info;
+	int i, builds = 0;
+	if (count <= 0) return;
+
+	if (count > meshesCapacity) {
+		newMeshes = (struct BuilderMesh*)Mem_AllocCleared(count, sizeof(struct BuilderMesh), "chunk meshes");
+		if (meshes) Mem_Copy(newMeshes, meshes, meshesCapacity * sizeof(struct BuilderMesh));
+		Mem_Free(meshes);
+		Mem_Free(batchChunks);
+
+		meshes         = newMeshes;
+		meshesCapacity = count;
+		batchChunks    = (struct ChunkInfo**)Mem_Alloc(count, sizeof(struct ChunkInfo*), "chunk batch");
+	}
+
+	for (i = 0; i < count; i++) {
+		info = chunks[i];
+		/* Chunks known to be empty don't need their blocks read at all */
+		if (Builder_IsChunkEmpty(info)) continue;
+
+		/* Lighting heightmap is lazily calculated, so must be done before building on other threads */
+		Lighting_LightHint(info->CentreX - 8 - 1, info->CentreZ - 8 - 1);
+		batchChunks[builds++] = info;
+	}
+	Workers_Run(BuildChunkWorker, builds);
+
+	for (i = 0; i < builds; i++) {
+		if (meshes[i].key) UpdateCachedMesh(i);
+		/* Benchmark runs without a GPU, so there's nothing to upload to */
+#ifndef CC_BUILD_BENCHMARK
+		if (meshes[i].count) UploadChunk(batchChunks[i], &meshes[i]);
 #endif
+	}
 }
 
-static cc_bool Builder_OccludedLiquid(int chunkIndex) {
+void Builder_MakeChunk(struct ChunkInfo* info) { Builder_MakeChunks(&info, 1); }
+
+#ifdef CC_BUILD_BENCHMARK
+void Builder_TakeTimings(struct BuilderTimings* timings) {
+	struct BuilderTimings* src;
+	int i;
+	Mem_Set(timings, 0, sizeof(struct BuilderTimings));
+
+	for (i = 0; i < WORKERS_MAX_COUNT; i++) {
+		if (!contexts[i]) continue;
+		src = &contexts[i]->Timings;
+
+		timings->ReadChunkData += Stopwatch_ElapsedMicroseconds(0, src->ReadChunkData);
+		timings->Occlusion     += Stopwatch_ElapsedMicroseconds(0, src->Occlusion);
+		timings->Stretch       += Stopwatch_ElapsedMicroseconds(0, src->Stretch);
+		timings->RenderBlock   += Stopwatch_ElapsedMicroseconds(0, src->RenderBlock);
+		timings->Compact       += Stopwatch_ElapsedMicroseconds(0, src->Compact);
+		timings->Cache         += Stopwatch_ElapsedMicroseconds(0, src->Cache);
+		Mem_Set(src, 0, sizeof(struct BuilderTimings));
+	}
+}
+#endif
+
+static cc_bool Builder_OccludedLiquid(struct BuilderContext* ctx, int chunkIndex) {
 	chunkIndex += EXTCHUNK_SIZE_2; /* Checking y above */
 	return
-		Blocks.FullOpaque[Builder_Chunk[chunkIndex]]
-		&& Blocks.Draw[Builder_Chunk[chunkIndex - EXTCHUNK_SIZE]] != DRAW_GAS
-		&& Blocks.Draw[Builder_Chunk[chunkIndex - 1]] != DRAW_GAS
-		&& Blocks.Draw[Builder_Chunk[chunkIndex + 1]] != DRAW_GAS
-		&& Blocks.Draw[Builder_Chunk[chunkIndex + EXTCHUNK_SIZE]] != DRAW_GAS;
+		Blocks.FullOpaque[ctx->Chunk[chunkIndex]]
+		&& Blocks.Draw[ctx->Chunk[chunkIndex - EXTCHUNK_SIZE]] != DRAW_GAS
+		&& Blocks.Draw[ctx->Chunk[chunkIndex - 1]] != DRAW_GAS
+		&& Blocks.Draw[ctx->Chunk[chunkIndex + 1]] != DRAW_GAS
+		&& Blocks.Draw[ctx->Chunk[chunkIndex + EXTCHUNK_SIZE]] != DRAW_GAS;
 }
 
-static void DefaultPreStretchTiles(void) {
-	Mem_Set(Builder_Parts, 0, sizeof(Builder_Parts));
+static void DefaultPreStretchTiles(struct BuilderContext* ctx) {
+	Mem_Set(ctx->Parts, 0, sizeof(ctx->Parts));
 }
 
-static void DefaultPostStretchTiles(void) {
+static void DefaultPostStretchTiles(struct BuilderContext* ctx) {
 	int i, j, offset;
 	offset = 0;
 	for (i = 0; i < ATLAS1D_MAX_ATLASES; i++) {
 		j = i + ATLAS1D_MAX_ATLASES;
 
-		offset = Builder1DPart_CalcOffsets(&Builder_Parts[i], offset);
-		offset = Builder1DPart_CalcOffsets(&Builder_Parts[j], offset);
+		offset = Builder1DPart_CalcOffsets(ctx, &ctx->Parts[i], offset);
+		offset = Builder1DPart_CalcOffsets(ctx, &ctx->Parts[j], offset);
 	}
 }
 
-static RNGState spriteRng;
-static void Builder_DrawSprite(void) {
+static void Builder_DrawSprite(struct BuilderContext* ctx) {
 	struct Builder1DPart* part;
 	struct VertexTextured v;
 	PackedCol white = PACKEDCOL_WHITE;
@@ -480,59 +928,59 @@ static void Builder_DrawSprite(void) {
 	float valX, valY, valZ;
 	float x1,y1,z1, x2,y2,z2;
 	
-	X  = (float)Builder_X; Y = (float)Builder_Y; Z = (float)Builder_Z;
+	X  = (float)ctx->X; Y = (float)ctx->Y; Z = (float)ctx->Z;
 	x1 = X + 2.50f/16.0f; y1 = Y;        z1 = Z + 2.50f/16.0f;
 	x2 = X + 13.5f/16.0f; y2 = Y + 1.0f; z2 = Z + 13.5f/16.0f;
 
 #define s_u1 0.0f
 #define s_u2 UV2_Scale
-	loc = Block_Tex(Builder_Block, FACE_XMAX);
+	loc = Block_Tex(ctx->Block, FACE_XMAX);
 	v1  = Atlas1D_RowId(loc) * Atlas1D.InvTileSize;
 	v2  = v1 + Atlas1D.InvTileSize * UV2_Scale;
 
-	offsetType = Blocks.SpriteOffset[Builder_Block];
+	offsetType = Blocks.SpriteOffset[ctx->Block];
 	if (offsetType >= 6 && offsetType <= 7) {
-		Random_Seed(&spriteRng, (Builder_X + 1217 * Builder_Z) & 0x7fffffff);
-		valX = Random_Range(&spriteRng, -3, 3 + 1) / 16.0f;
-		valY = Random_Range(&spriteRng, 0,  3 + 1) / 16.0f;
-		valZ = Random_Range(&spriteRng, -3, 3 + 1) / 16.0f;
+		Random_Seed(&ctx->SpriteRng, (ctx->X + 1217 * ctx->Z) & 0x7fffffff);
+		valX = Random_Range(&ctx->SpriteRng, -3, 3 + 1) / 16.0f;
+		valY = Random_Range(&ctx->SpriteRng, 0,  3 + 1) / 16.0f;
+		valZ = Random_Range(&ctx->SpriteRng, -3, 3 + 1) / 16.0f;
 
 		x1 += valX - 1.7f/16.0f; x2 += valX + 1.7f/16.0f;
 		z1 += valZ - 1.7f/16.0f; z2 += valZ + 1.7f/16.0f;
 		if (offsetType == 7) { y1 -= valY; y2 -= valY; }
 	}
 	
-	part  = &Builder_Parts[Atlas1D_Index(loc)];
-	v.Col = Builder_FullBright ? white : Lighting_Col_Sprite_Fast(Builder_X, Builder_Y, Builder_Z);
-	Block_Tint(v.Col, Builder_Block);
+	part  = &ctx->Parts[Atlas1D_Index(loc)];
+	v.Col = ctx->FullBright ? white : Lighting_Col_Sprite_Fast(ctx->X, ctx->Y, ctx->Z);
+	Block_Tint(v.Col, ctx->Block);
 
 	/* Draw Z axis */
 	index = part->sOffset;
-	v.X = x1; v.Y = y1; v.Z = z1; v.U = s_u2; v.V = v2; Builder_Vertices[index + 0] = v;
-	          v.Y = y2;                       v.V = v1; Builder_Vertices[index + 1] = v;
-	v.X = x2;           v.Z = z2; v.U = s_u1;           Builder_Vertices[index + 2] = v;
-	          v.Y = y1;                       v.V = v2; Builder_Vertices[index + 3] = v;
+	v.X = x1; v.Y = y1; v.Z = z1; v.U = s_u2; v.V = v2; ctx->Vertices[index + 0] = v;
+	          v.Y = y2;                       v.V = v1; ctx->Vertices[index + 1] = v;
+	v.X = x2;           v.Z = z2; v.U = s_u1;           ctx->Vertices[index + 2] = v;
+	          v.Y = y1;                       v.V = v2; ctx->Vertices[index + 3] = v;
 
 	/* Draw Z axis mirrored */
 	index += part->sAdvance;
-	v.X = x2; v.Y = y1; v.Z = z2; v.U = s_u2;           Builder_Vertices[index + 0] = v;
-	          v.Y = y2;                       v.V = v1; Builder_Vertices[index + 1] = v;
-	v.X = x1;           v.Z = z1; v.U = s_u1;           Builder_Vertices[index + 2] = v;
-	          v.Y = y1;                       v.V = v2; Builder_Vertices[index + 3] = v;
+	v.X = x2; v.Y = y1; v.Z = z2; v.U = s_u2;           ctx->Vertices[index + 0] = v;
+	          v.Y = y2;                       v.V = v1; ctx->Vertices[index + 1] = v;
+	v.X = x1;           v.Z = z1; v.U = s_u1;           ctx->Vertices[index + 2] = v;
+	          v.Y = y1;                       v.V = v2; ctx->Vertices[index + 3] = v;
 
 	/* Draw X axis */
 	index += part->sAdvance;
-	v.X = x1; v.Y = y1; v.Z = z2; v.U = s_u2;           Builder_Vertices[index + 0] = v;
-	          v.Y = y2;                       v.V = v1; Builder_Vertices[index + 1] = v;
-	v.X = x2;           v.Z = z1; v.U = s_u1;           Builder_Vertices[index + 2] = v;
-	          v.Y = y1;                       v.V = v2; Builder_Vertices[index + 3] = v;
+	v.X = x1; v.Y = y1; v.Z = z2; v.U = s_u2;           ctx->Vertices[index + 0] = v;
+	          v.Y = y2;                       v.V = v1; ctx->Vertices[index + 1] = v;
+	v.X = x2;           v.Z = z1; v.U = s_u1;           ctx->Vertices[index + 2] = v;
+	          v.Y = y1;                       v.V = v2; ctx->Vertices[index + 3] = v;
 
 	/* Draw X axis mirrored */
 	index += part->sAdvance;
-	v.X = x2; v.Y = y1; v.Z = z1; v.U = s_u2;           Builder_Vertices[index + 0] = v;
-	          v.Y = y2;                       v.V = v1; Builder_Vertices[index + 1] = v;
-	v.X = x1;           v.Z = z2; v.U = s_u1;           Builder_Vertices[index + 2] = v;
-	          v.Y = y1;                       v.V = v2; Builder_Vertices[index + 3] = v;
+	v.X = x2; v.Y = y1; v.Z = z1; v.U = s_u2;           ctx->Vertices[index + 0] = v;
+	          v.Y = y2;                       v.V = v1; ctx->Vertices[index + 1] = v;
+	v.X = x1;           v.Z = z2; v.U = s_u1;           ctx->Vertices[index + 2] = v;
+	          v.Y = y1;                       v.V = v2; ctx->Vertices[index + 3] = v;
 
 	part->sOffset += 4;
 }
@@ -561,72 +1009,72 @@ static PackedCol Normal_LightCol(int x, int y, int z, Face face, BlockID block)
 	return 0; /* should never happen */
 }
 
-static cc_bool Normal_CanStretch(BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
-	BlockID cur = Builder_Chunk[chunkIndex];
+static cc_bool Normal_CanStretch(struct BuilderContext* ctx, BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
+	BlockID cur = ctx->Chunk[chunkIndex];
 
-	if (cur != initial || Block_IsFaceHidden(cur, Builder_Chunk[chunkIndex + Builder_Offsets[face]], face)) return false;
-	if (Builder_FullBright) return true;
+	if (cur != initial || Block_IsFaceHidden(cur, ctx->Chunk[chunkIndex + Builder_Offsets[face]], face)) return false;
+	if (ctx->FullBright) return true;
 
-	return Normal_LightCol(Builder_X, Builder_Y, Builder_Z, face, initial) == Normal_LightCol(x, y, z, face, cur);
+	return Normal_LightCol(ctx->X, ctx->Y, ctx->Z, face, initial) == Normal_LightCol(x, y, z, face, cur);
 }
 
-static int NormalBuilder_StretchXLiquid(int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
+static int NormalBuilder_StretchXLiquid(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
 	int count = 1; cc_bool stretchTile;
-	if (Builder_OccludedLiquid(chunkIndex)) return 0;
+	if (Builder_OccludedLiquid(ctx, chunkIndex)) return 0;
 	
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << FACE_YMAX)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Normal_CanStretch(block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(chunkIndex)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < ctx->ChunkEndX && stretchTile && Normal_CanStretch(ctx, block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(ctx, chunkIndex)) {
+		ctx->Counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, FACE_YMAX);
+	AddVertices(ctx, block, FACE_YMAX);
 	return count;
 }
 
-static int NormalBuilder_StretchX(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int NormalBuilder_StretchX(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Normal_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < ctx->ChunkEndX && stretchTile && Normal_CanStretch(ctx, block, chunkIndex, x, y, z, face)) {
+		ctx->Counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
-static int NormalBuilder_StretchZ(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int NormalBuilder_StretchZ(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
 	z++;
 	chunkIndex += EXTCHUNK_SIZE;
 	countIndex += CHUNK_SIZE * FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (z < Builder_ChunkEndZ && stretchTile && Normal_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	while (z < ctx->ChunkEndZ && stretchTile && Normal_CanStretch(ctx, block, chunkIndex, x, y, z, face)) {
+		ctx->Counts[countIndex] = 0;
 		count++;
 		z++;
 		chunkIndex += EXTCHUNK_SIZE;
 		countIndex += CHUNK_SIZE * FACE_COUNT;
 	}
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
-static void NormalBuilder_RenderBlock(int index) {	
+static void NormalBuilder_RenderBlock(struct BuilderContext* ctx, int index) {	
 	/* counters */
 	int count_XMin, count_XMax, count_ZMin;
 	int count_ZMax, count_YMin, count_YMax;
@@ -643,93 +1091,93 @@ static void NormalBuilder_RenderBlock(int index) {
 	PackedCol col;
 	int offset;
 
-	if (Blocks.Draw[Builder_Block] == DRAW_SPRITE) {
-		Builder_FullBright = Blocks.FullBright[Builder_Block];
-		Builder_Tinted     = Blocks.Tinted[Builder_Block];
-		Builder_DrawSprite();
+	if (Blocks.Draw[ctx->Block] == DRAW_SPRITE) {
+		ctx->FullBright = Blocks.FullBright[ctx->Block];
+		ctx->Tinted     = Blocks.Tinted[ctx->Block];
+		Builder_DrawSprite(ctx);
 		return;
 	}
 
-	count_XMin = Builder_Counts[index + FACE_XMIN];
-	count_XMax = Builder_Counts[index + FACE_XMAX];
-	count_ZMin = Builder_Counts[index + FACE_ZMIN];
-	count_ZMax = Builder_Counts[index + FACE_ZMAX];
-	count_YMin = Builder_Counts[index + FACE_YMIN];
-	count_YMax = Builder_Counts[index + FACE_YMAX];
+	count_XMin = ctx->Counts[index + FACE_XMIN];
+	count_XMax = ctx->Counts[index + FACE_XMAX];
+	count_ZMin = ctx->Counts[index + FACE_ZMIN];
+	count_ZMax = ctx->Counts[index + FACE_ZMAX];
+	count_YMin = ctx->Counts[index + FACE_YMIN];
+	count_YMax = ctx->Counts[index + FACE_YMAX];
 
 	if (!count_XMin && !count_XMax && !count_ZMin &&
 		!count_ZMax && !count_YMin && !count_YMax) return;
 
-	fullBright = Blocks.FullBright[Builder_Block];
-	baseOffset = (Blocks.Draw[Builder_Block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
-	lightFlags = Blocks.LightOffset[Builder_Block];
+	fullBright = Blocks.FullBright[ctx->Block];
+	baseOffset = (Blocks.Draw[ctx->Block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
+	lightFlags = Blocks.LightOffset[ctx->Block];
 
-	Drawer.MinBB = Blocks.MinBB[Builder_Block]; Drawer.MinBB.Y = 1.0f - Drawer.MinBB.Y;
-	Drawer.MaxBB = Blocks.MaxBB[Builder_Block]; Drawer.MaxBB.Y = 1.0f - Drawer.MaxBB.Y;
+	ctx->Drawer.MinBB = Blocks.MinBB[ctx->Block]; ctx->Drawer.MinBB.Y = 1.0f - ctx->Drawer.MinBB.Y;
+	ctx->Drawer.MaxBB = Blocks.MaxBB[ctx->Block]; ctx->Drawer.MaxBB.Y = 1.0f - ctx->Drawer.MaxBB.Y;
 
-	min = Blocks.RenderMinBB[Builder_Block]; max = Blocks.RenderMaxBB[Builder_Block];
-	Drawer.X1 = Builder_X + min.X; Drawer.Y1 = Builder_Y + min.Y; Drawer.Z1 = Builder_Z + min.Z;
-	Drawer.X2 = Builder_X + max.X; Drawer.Y2 = Builder_Y + max.Y; Drawer.Z2 = Builder_Z + max.Z;
+	min = Blocks.RenderMinBB[ctx->Block]; max = Blocks.RenderMaxBB[ctx->Block];
+	ctx->Drawer.X1 = ctx->X + min.X; ctx->Drawer.Y1 = ctx->Y + min.Y; ctx->Drawer.Z1 = ctx->Z + min.Z;
+	ctx->Drawer.X2 = ctx->X + max.X; ctx->Drawer.Y2 = ctx->Y + max.Y; ctx->Drawer.Z2 = ctx->Z + max.Z;
 
-	Drawer.Tinted  = Blocks.Tinted[Builder_Block];
-	Drawer.TintCol = Blocks.FogCol[Builder_Block];
+	ctx->Drawer.Tinted  = Blocks.Tinted[ctx->Block];
+	ctx->Drawer.TintCol = Blocks.FogCol[ctx->Block];
 
 	if (count_XMin) {
-		loc    = Block_Tex(Builder_Block, FACE_XMIN);
+		loc    = Block_Tex(ctx->Block, FACE_XMIN);
 		offset = (lightFlags >> FACE_XMIN) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->Parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? white :
-			Builder_X >= offset ? Lighting_Col_XSide_Fast(Builder_X - offset, Builder_Y, Builder_Z) : Env.SunXSide;
-		Drawer_XMin(count_XMin, col, loc, &part->fVertices[FACE_XMIN]);
+			ctx->X >= offset ? Lighting_Col_XSide_Fast(ctx->X - offset, ctx->Y, ctx->Z) : Env.SunXSide;
+		Drawer_XMin2(&ctx->Drawer, count_XMin, col, loc, &part->fVertices[FACE_XMIN]);
 	}
 
 	if (count_XMax) {
-		loc    = Block_Tex(Builder_Block, FACE_XMAX);
+		loc    = Block_Tex(ctx->Block, FACE_XMAX);
 		offset = (lightFlags >> FACE_XMAX) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->Parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? white :
-			Builder_X <= (World.MaxX - offset) ? Lighting_Col_XSide_Fast(Builder_X + offset, Builder_Y, Builder_Z) : Env.SunXSide;
-		Drawer_XMax(count_XMax, col, loc, &part->fVertices[FACE_XMAX]);
+			ctx->X <= (World.MaxX - offset) ? Lighting_Col_XSide_Fast(ctx->X + offset, ctx->Y, ctx->Z) : Env.SunXSide;
+		Drawer_XMax2(&ctx->Drawer, count_XMax, col, loc, &part->fVertices[FACE_XMAX]);
 	}
 
 	if (count_ZMin) {
-		loc    = Block_Tex(Builder_Block, FACE_ZMIN);
+		loc    = Block_Tex(ctx->Block, FACE_ZMIN);
 		offset = (lightFlags >> FACE_ZMIN) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->Parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? white :
-			Builder_Z >= offset ? Lighting_Col_ZSide_Fast(Builder_X, Builder_Y, Builder_Z - offset) : Env.SunZSide;
-		Drawer_ZMin(count_ZMin, col, loc, &part->fVertices[FACE_ZMIN]);
+			ctx->Z >= offset ? Lighting_Col_ZSide_Fast(ctx->X, ctx->Y, ctx->Z - offset) : Env.SunZSide;
+		Drawer_ZMin2(&ctx->Drawer, count_ZMin, col, loc, &part->fVertices[FACE_ZMIN]);
 	}
 
 	if (count_ZMax) {
-		loc    = Block_Tex(Builder_Block, FACE_ZMAX);
+		loc    = Block_Tex(ctx->Block, FACE_ZMAX);
 		offset = (lightFlags >> FACE_ZMAX) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->Parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? white :
-			Builder_Z <= (World.MaxZ - offset) ? Lighting_Col_ZSide_Fast(Builder_X, Builder_Y, Builder_Z + offset) : Env.SunZSide;
-		Drawer_ZMax(count_ZMax, col, loc, &part->fVertices[FACE_ZMAX]);
+			ctx->Z <= (World.MaxZ - offset) ? Lighting_Col_ZSide_Fast(ctx->X, ctx->Y, ctx->Z + offset) : Env.SunZSide;
+		Drawer_ZMax2(&ctx->Drawer, count_ZMax, col, loc, &part->fVertices[FACE_ZMAX]);
 	}
 
 	if (count_YMin) {
-		loc    = Block_Tex(Builder_Block, FACE_YMIN);
+		loc    = Block_Tex(ctx->Block, FACE_YMIN);
 		offset = (lightFlags >> FACE_YMIN) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->Parts[baseOffset + Atlas1D_Index(loc)];
 
-		col = fullBright ? white : Lighting_Col_YMin_Fast(Builder_X, Builder_Y - offset, Builder_Z);
-		Drawer_YMin(count_YMin, col, loc, &part->fVertices[FACE_YMIN]);
+		col = fullBright ? white : Lighting_Col_YMin_Fast(ctx->X, ctx->Y - offset, ctx->Z);
+		Drawer_YMin2(&ctx->Drawer, count_YMin, col, loc, &part->fVertices[FACE_YMIN]);
 	}
 
 	if (count_YMax) {
-		loc    = Block_Tex(Builder_Block, FACE_YMAX);
+		loc    = Block_Tex(ctx->Block, FACE_YMAX);
 		offset = (lightFlags >> FACE_YMAX) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->Parts[baseOffset + Atlas1D_Index(loc)];
 
-		col = fullBright ? white : Lighting_Col_YMax_Fast(Builder_X, (Builder_Y + 1) - offset, Builder_Z);
-		Drawer_YMax(count_YMax, col, loc, &part->fVertices[FACE_YMAX]);
+		col = fullBright ? white : Lighting_Col_YMax_Fast(ctx->X, (ctx->Y + 1) - offset, ctx->Z);
+		Drawer_YMax2(&ctx->Drawer, count_YMax, col, loc, &part->fVertices[FACE_YMAX]);
 	}
 }
 
@@ -739,7 +1187,6 @@ static void Builder_SetDefault(void) {
 	Builder_StretchZ       = NULL;
 	Builder_RenderBlock    = NULL;
 
-	Builder_UseBitFlags      = false;
 	Builder_PreStretchTiles  = DefaultPreStretchTiles;
 	Builder_PostStretchTiles = DefaultPostStretchTiles;
 }
@@ -754,14 +1201,149 @@ static void NormalBuilder_SetActive(void) {
 
 
 /*########################################################################################################################*
-*-------------------------------------------------Advanced mesh builder---------------------------------------------------*
+*--------------------------------------------------Greedy mesh builder----------------------------------------------------*
 *#########################################################################################################################*/
-static Vec3 adv_minBB, adv_maxBB;
-static int adv_initBitFlags, adv_lightFlags, adv_baseOffset;
-static int* adv_bitFlags;
-static float adv_x1, adv_y1, adv_z1, adv_x2, adv_y2, adv_z2;
-static PackedCol adv_lerp[5], adv_lerpX[5], adv_lerpZ[5], adv_lerpY[5];
+/* Same as the normal mesh builder, except that faces are merged into rectangles instead of just into rows. */
+/* Merging in the second axis means the texture has to repeat along V, which is only possible when each */
+/* 1D atlas consists of a single tile. (e.g. when the GPU's max texture height is the tile size) */
+/* Otherwise, merged faces would cross into the next tiles of the atlas, so this is identical to the normal builder. */
+/* NOTE: Atlases are deliberately not split into single tiles just for this, as that multiplies */
+/* the number of chunk parts (and therefore draw calls) by over 3x in the benchmark map. */
+static cc_bool Greedy_CanMergeRows(void) { return Atlas1D.TilesPerAtlas == 1; }
+
+static cc_bool Greedy_FullHeight(BlockID block) {
+	return Blocks.MinBB[block].Y       == 0.0f && Blocks.MaxBB[block].Y       == 1.0f
+		&& Blocks.RenderMinBB[block].Y == 0.0f && Blocks.RenderMaxBB[block].Y == 1.0f;
+}
+
+/* Tries to merge the row of faces just stretched with the row of faces before it. */
+/* YMin/YMax rows are merged along Z, other faces are merged along Y. */
+/* NOTE: The merged face is drawn by the last row, so the earlier row is removed */
+static void Greedy_MergeRows(struct BuilderContext* ctx, int countIndex, int chunkIndex, BlockID block, Face face, int count) {
+	int x = ctx->X, y = ctx->Y, z = ctx->Z;
+	int prevIndex, baseOffset, i;
+	ctx->Rows[countIndex] = 1;
+	if (!Greedy_CanMergeRows()) return;
+
+	if (face >= FACE_YMIN) {
+		if (!(z & CHUNK_MASK) || !(Blocks.CanStretch[block] & (1 << FACE_XMIN))) return;
+		prevIndex   = countIndex - CHUNK_SIZE * FACE_COUNT;
+		chunkIndex -= EXTCHUNK_SIZE; z--;
+	} else {
+		if (!(y & CHUNK_MASK) || !Greedy_FullHeight(block)) return;
+		prevIndex   = countIndex - CHUNK_SIZE_2 * FACE_COUNT;
+		chunkIndex -= EXTCHUNK_SIZE_2; y--;
+	}
+
+	if (ctx->Counts[prevIndex] != count || ctx->Chunk[chunkIndex] != block) return;
+	if (ctx->Rows[prevIndex] >= CHUNK_SIZE) return;
+	if (!ctx->FullBright && Normal_LightCol(x, y, z, face, block) != Normal_LightCol(ctx->X, ctx->Y, ctx->Z, face, block)) return;
+
+	ctx->Rows[countIndex]  = ctx->Rows[prevIndex] + 1;
+	ctx->Counts[prevIndex] = 0;
+
+	/* Undo the AddVertices from when the earlier row was stretched */
+	baseOffset = (Blocks.Draw[block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
+	i = Atlas1D_Index(Block_Tex(block, face));
+	ctx->Parts[baseOffset + i].fCount[face] -= 4;
+}
+
+static int GreedyBuilder_StretchX(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+	int count = NormalBuilder_StretchX(ctx, countIndex, x, y, z, chunkIndex, block, face);
+	Greedy_MergeRows(ctx, countIndex, chunkIndex, block, face, count);
+	return count;
+}
+
+static int GreedyBuilder_StretchZ(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+	int count = NormalBuilder_StretchZ(ctx, countIndex, x, y, z, chunkIndex, block, face);
+	Greedy_MergeRows(ctx, countIndex, chunkIndex, block, face, count);
+	return count;
+}
+
+/* Draws a face, extending the block's bounds back over the earlier rows when it was merged across multiple rows */
+static void Greedy_DrawFace(struct BuilderContext* ctx, Face face, int count, int rows, PackedCol col, TextureLoc loc, struct VertexTextured** vertices) {
+	const struct _DrawerData* d = &ctx->Drawer;
+	struct _DrawerData merged;
+
+	if (rows > 1) {
+		merged = ctx->Drawer; d = &merged;
+		/* V is calculated the same way Drawer calculates U for faces stretched across multiple blocks */
+		if (face >= FACE_YMIN) {
+			merged.Z1 -= rows - 1; merged.MaxBB.Z += (rows - 1) / UV2_Scale;
+		} else {
+			merged.Y1 -= rows - 1; merged.MinBB.Y += (rows - 1) / UV2_Scale;
+		}
+	}
+
+	switch (face) {
+	case FACE_XMIN: Drawer_XMin2(d, count, col, loc, vertices); break;
+	case FACE_XMAX: Drawer_XMax2(d, count, col, loc, vertices); break;
+	case FACE_ZMIN: Drawer_ZMin2(d, count, col, loc, vertices); break;
+	case FACE_ZMAX: Drawer_ZMax2(d, count, col, loc, vertices); break;
+	case FACE_YMIN: Drawer_YMin2(d, count, col, loc, vertices); break;
+	case FACE_YMAX: Drawer_YMax2(d, count, col, loc, vertices); break;
+	}
+}
+
+static void GreedyBuilder_RenderBlock(struct BuilderContext* ctx, int index) {
+	PackedCol white = PACKEDCOL_WHITE;
+	BlockID block   = ctx->Block;
+	int baseOffset, count, face;
+	cc_bool fullBright;
+	Vec3 min, max;
+
+	struct Builder1DPart* part;
+	TextureLoc loc;
+	PackedCol col;
+
+	if (Blocks.Draw[block] == DRAW_SPRITE) {
+		ctx->FullBright = Blocks.FullBright[block];
+		ctx->Tinted     = Blocks.Tinted[block];
+		Builder_DrawSprite(ctx);
+		return;
+	}
+
+	fullBright = Blocks.FullBright[block];
+	baseOffset = (Blocks.Draw[block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
+
+	ctx->Drawer.MinBB = Blocks.MinBB[block]; ctx->Drawer.MinBB.Y = 1.0f - ctx->Drawer.MinBB.Y;
+	ctx->Drawer.MaxBB = Blocks.MaxBB[block]; ctx->Drawer.MaxBB.Y = 1.0f - ctx->Drawer.MaxBB.Y;
+
+	min = Blocks.RenderMinBB[block]; max = Blocks.RenderMaxBB[block];
+	ctx->Drawer.X1 = ctx->X + min.X; ctx->Drawer.Y1 = ctx->Y + min.Y; ctx->Drawer.Z1 = ctx->Z + min.Z;
+	ctx->Drawer.X2 = ctx->X + max.X; ctx->Drawer.Y2 = ctx->Y + max.Y; ctx->Drawer.Z2 = ctx->Z + max.Z;
 
+	ctx->Drawer.Tinted  = Blocks.Tinted[block];
+	ctx->Drawer.TintCol = Blocks.FogCol[block];
+
+	for (face = 0; face < FACE_COUNT; face++) {
+		count = ctx->Counts[index + face];
+		if (!count) continue;
+
+		loc  = Block_Tex(block, face);
+		part = &ctx->Parts[baseOffset + Atlas1D_Index(loc)];
+		col  = fullBright ? white : Normal_LightCol(ctx->X, ctx->Y, ctx->Z, face, block);
+
+		/* Liquid tops are stretched by NormalBuilder_StretchXLiquid, so are never merged */
+		if (face == FACE_YMAX && block >= BLOCK_WATER && block <= BLOCK_STILL_LAVA) {
+			Drawer_YMax2(&ctx->Drawer, count, col, loc, &part->fVertices[face]);
+		} else {
+			Greedy_DrawFace(ctx, face, count, ctx->Rows[index + face], col, loc, &part->fVertices[face]);
+		}
+	}
+}
+
+static void GreedyBuilder_SetActive(void) {
+	NormalBuilder_SetActive();
+	Builder_StretchX    = GreedyBuilder_StretchX;
+	Builder_StretchZ    = GreedyBuilder_StretchZ;
+	Builder_RenderBlock = GreedyBuilder_RenderBlock;
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------Advanced mesh builder---------------------------------------------------*
+*#########################################################################################################################*/
 enum ADV_MASK {
 	/* z-1 cube points */
 	xM1_yM1_zM1, xM1_yCC_zM1, xM1_yP1_zM1,
@@ -777,7 +1359,7 @@ enum ADV_MASK {
 	xP1_yM1_zP1, xP1_yCC_zP1, xP1_yP1_zP1,
 };
 
-static int Adv_Lit(int x, int y, int z, int cIndex) {
+static int Adv_Lit(struct BuilderContext* ctx, int x, int y, int z, int cIndex) {
 	int flags, offset, lightHeight;
 	BlockID block;
 	if (y < 0 || y >= World.Height) return 7; /* all faces lit */
@@ -788,41 +1370,41 @@ static int Adv_Lit(int x, int y, int z, int cIndex) {
 	}
 
 	flags = 0;
-	block = Builder_Chunk[cIndex];
+	block = ctx->Chunk[cIndex];
 	lightHeight    = Lighting_Heightmap[Lighting_Pack(x, z)];
-	adv_lightFlags = Blocks.LightOffset[block];
+	ctx->adv.lightFlags = Blocks.LightOffset[block];
 
 	/* Use fact Light(Y.YMin) == Light((Y-1).YMax) */
-	offset = (adv_lightFlags >> FACE_YMIN) & 1;
+	offset = (ctx->adv.lightFlags >> FACE_YMIN) & 1;
 	flags |= ((y - offset) > lightHeight ? 1 : 0);
 
 	/* Light is same for all the horizontal faces */
 	flags |= (y > lightHeight ? 2 : 0);
 
 	/* Use fact Light((Y+1).YMin) == Light(Y.YMax) */
-	offset = (adv_lightFlags >> FACE_YMAX) & 1;
+	offset = (ctx->adv.lightFlags >> FACE_YMAX) & 1;
 	flags |= ((y - offset) >= lightHeight ? 4 : 0);
 
 	/* Dynamic lighting */
 	if (Blocks.FullBright[block])                       flags |= 5;
-	if (Blocks.FullBright[Builder_Chunk[cIndex + 324]]) flags |= 4;
-	if (Blocks.FullBright[Builder_Chunk[cIndex - 324]]) flags |= 1;
+	if (Blocks.FullBright[ctx->Chunk[cIndex + 324]]) flags |= 4;
+	if (Blocks.FullBright[ctx->Chunk[cIndex - 324]]) flags |= 1;
 	return flags;
 }
 
-static int Adv_ComputeLightFlags(int x, int y, int z, int cIndex) {
-	if (Builder_FullBright) return (1 << xP1_yP1_zP1) - 1; /* all faces fully bright */
+static int Adv_ComputeLightFlags(struct BuilderContext* ctx, int x, int y, int z, int cIndex) {
+	if (ctx->FullBright) return (1 << xP1_yP1_zP1) - 1; /* all faces fully bright */
 
 	return
-		Adv_Lit(x - 1, y, z - 1, cIndex - 1 - 18) << xM1_yM1_zM1 |
-		Adv_Lit(x - 1, y, z,     cIndex - 1)      << xM1_yM1_zCC |
-		Adv_Lit(x - 1, y, z + 1, cIndex - 1 + 18) << xM1_yM1_zP1 |
-		Adv_Lit(x,     y, z - 1, cIndex + 0 - 18) << xCC_yM1_zM1 |
-		Adv_Lit(x,     y, z,     cIndex + 0)      << xCC_yM1_zCC |
-		Adv_Lit(x,     y, z + 1, cIndex + 0 + 18) << xCC_yM1_zP1 |
-		Adv_Lit(x + 1, y, z - 1, cIndex + 1 - 18) << xP1_yM1_zM1 |
-		Adv_Lit(x + 1, y, z,     cIndex + 1)      << xP1_yM1_zCC |
-		Adv_Lit(x + 1, y, z + 1, cIndex + 1 + 18) << xP1_yM1_zP1;
+		Adv_Lit(ctx, x - 1, y, z - 1, cIndex - 1 - 18) << xM1_yM1_zM1 |
+		Adv_Lit(ctx, x - 1, y, z,     cIndex - 1)      << xM1_yM1_zCC |
+		Adv_Lit(ctx, x - 1, y, z + 1, cIndex - 1 + 18) << xM1_yM1_zP1 |
+		Adv_Lit(ctx, x,     y, z - 1, cIndex + 0 - 18) << xCC_yM1_zM1 |
+		Adv_Lit(ctx, x,     y, z,     cIndex + 0)      << xCC_yM1_zCC |
+		Adv_Lit(ctx, x,     y, z + 1, cIndex + 0 + 18) << xCC_yM1_zP1 |
+		Adv_Lit(ctx, x + 1, y, z - 1, cIndex + 1 - 18) << xP1_yM1_zM1 |
+		Adv_Lit(ctx, x + 1, y, z,     cIndex + 1)      << xP1_yM1_zCC |
+		Adv_Lit(ctx, x + 1, y, z + 1, cIndex + 1 + 18) << xP1_yM1_zP1;
 }
 
 static int adv_masks[FACE_COUNT] = {
@@ -853,388 +1435,388 @@ static int adv_masks[FACE_COUNT] = {
 };
 
 
-static cc_bool Adv_CanStretch(BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
-	BlockID cur = Builder_Chunk[chunkIndex];
-	adv_bitFlags[chunkIndex] = Adv_ComputeLightFlags(x, y, z, chunkIndex);
+static cc_bool Adv_CanStretch(struct BuilderContext* ctx, BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
+	BlockID cur = ctx->Chunk[chunkIndex];
+	ctx->adv.bitFlags[chunkIndex] = Adv_ComputeLightFlags(ctx, x, y, z, chunkIndex);
 
 	return cur == initial
-		&& !Block_IsFaceHidden(cur, Builder_Chunk[chunkIndex + Builder_Offsets[face]], face)
-		&& (adv_initBitFlags == adv_bitFlags[chunkIndex]
+		&& !Block_IsFaceHidden(cur, ctx->Chunk[chunkIndex + Builder_Offsets[face]], face)
+		&& (ctx->adv.initBitFlags == ctx->adv.bitFlags[chunkIndex]
 		/* Check that this face is either fully bright or fully in shadow */
-		&& (adv_initBitFlags == 0 || (adv_initBitFlags & adv_masks[face]) == adv_masks[face]));
+		&& (ctx->adv.initBitFlags == 0 || (ctx->adv.initBitFlags & adv_masks[face]) == adv_masks[face]));
 }
 
-static int Adv_StretchXLiquid(int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
+static int Adv_StretchXLiquid(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
 	int count = 1; cc_bool stretchTile;
-	if (Builder_OccludedLiquid(chunkIndex)) return 0;
-	adv_initBitFlags = Adv_ComputeLightFlags(x, y, z, chunkIndex);
-	adv_bitFlags[chunkIndex] = adv_initBitFlags;
+	if (Builder_OccludedLiquid(ctx, chunkIndex)) return 0;
+	ctx->adv.initBitFlags = Adv_ComputeLightFlags(ctx, x, y, z, chunkIndex);
+	ctx->adv.bitFlags[chunkIndex] = ctx->adv.initBitFlags;
 
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << FACE_YMAX)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Adv_CanStretch(block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(chunkIndex)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < ctx->ChunkEndX && stretchTile && Adv_CanStretch(ctx, block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(ctx, chunkIndex)) {
+		ctx->Counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, FACE_YMAX);
+	AddVertices(ctx, block, FACE_YMAX);
 	return count;
 }
 
-static int Adv_StretchX(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int Adv_StretchX(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
-	adv_initBitFlags = Adv_ComputeLightFlags(x, y, z, chunkIndex);
-	adv_bitFlags[chunkIndex] = adv_initBitFlags;
+	ctx->adv.initBitFlags = Adv_ComputeLightFlags(ctx, x, y, z, chunkIndex);
+	ctx->adv.bitFlags[chunkIndex] = ctx->adv.initBitFlags;
 	
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Adv_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < ctx->ChunkEndX && stretchTile && Adv_CanStretch(ctx, block, chunkIndex, x, y, z, face)) {
+		ctx->Counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
-static int Adv_StretchZ(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int Adv_StretchZ(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
-	adv_initBitFlags = Adv_ComputeLightFlags(x, y, z, chunkIndex);
-	adv_bitFlags[chunkIndex] = adv_initBitFlags;
+	ctx->adv.initBitFlags = Adv_ComputeLightFlags(ctx, x, y, z, chunkIndex);
+	ctx->adv.bitFlags[chunkIndex] = ctx->adv.initBitFlags;
 
 	z++;
 	chunkIndex += EXTCHUNK_SIZE;
 	countIndex += CHUNK_SIZE * FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (z < Builder_ChunkEndZ && stretchTile && Adv_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	while (z < ctx->ChunkEndZ && stretchTile && Adv_CanStretch(ctx, block, chunkIndex, x, y, z, face)) {
+		ctx->Counts[countIndex] = 0;
 		count++;
 		z++;
 		chunkIndex += EXTCHUNK_SIZE;
 		countIndex += CHUNK_SIZE * FACE_COUNT;
 	}
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
 
 #define Adv_CountBits(F, a, b, c, d) (((F >> a) & 1) + ((F >> b) & 1) + ((F >> c) & 1) + ((F >> d) & 1))
 
-static void Adv_DrawXMin(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_XMIN);
+static void Adv_DrawXMin(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->Block, FACE_XMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.Z, u2 = (count - 1) + adv_maxBB.Z * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.Y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->adv.minBB.Z, u2 = (count - 1) + ctx->adv.maxBB.Z * UV2_Scale;
+	float v1 = vOrigin + ctx->adv.maxBB.Y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->adv.minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->Parts[ctx->adv.baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->adv.bitFlags[ctx->ChunkIndex];
 	int aY0_Z0 = Adv_CountBits(F, xM1_yM1_zM1, xM1_yCC_zM1, xM1_yM1_zCC, xM1_yCC_zCC);
 	int aY0_Z1 = Adv_CountBits(F, xM1_yM1_zP1, xM1_yCC_zP1, xM1_yM1_zCC, xM1_yCC_zCC);
 	int aY1_Z0 = Adv_CountBits(F, xM1_yP1_zM1, xM1_yCC_zM1, xM1_yP1_zCC, xM1_yCC_zCC);
 	int aY1_Z1 = Adv_CountBits(F, xM1_yP1_zP1, xM1_yCC_zP1, xM1_yP1_zCC, xM1_yCC_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpX[aY0_Z0], col1_0 = Builder_FullBright ? white : adv_lerpX[aY1_Z0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpX[aY1_Z1], col0_1 = Builder_FullBright ? white : adv_lerpX[aY0_Z1];
+	PackedCol col0_0 = ctx->FullBright ? white : ctx->adv.lerpX[aY0_Z0], col1_0 = ctx->FullBright ? white : ctx->adv.lerpX[aY1_Z0];
+	PackedCol col1_1 = ctx->FullBright ? white : ctx->adv.lerpX[aY1_Z1], col0_1 = ctx->FullBright ? white : ctx->adv.lerpX[aY0_Z1];
 	struct VertexTextured* vertices, v;
 
-	if (Builder_Tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->Tinted) {
+		tint   = Blocks.FogCol[ctx->Block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->fVertices[FACE_XMIN];
-	v.X = adv_x1;
+	v.X = ctx->adv.x1;
 	if (aY0_Z0 + aY1_Z1 > aY0_Z1 + aY1_Z0) {
-		v.Y = adv_y2; v.Z = adv_z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
-		v.Y = adv_y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
-		              v.Z = adv_z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
-		v.Y = adv_y2;                                       v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.Y = ctx->adv.y2; v.Z = ctx->adv.z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.Y = ctx->adv.y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
+		              v.Z = ctx->adv.z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
+		v.Y = ctx->adv.y2;                                       v.V = v1; v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.Y = adv_y2; v.Z = adv_z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		              v.Z = adv_z1;               v.U = u1;           v.Col = col1_0; *vertices++ = v;
-		v.Y = adv_y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
-		              v.Z = adv_z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
+		v.Y = ctx->adv.y2; v.Z = ctx->adv.z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		              v.Z = ctx->adv.z1;               v.U = u1;           v.Col = col1_0; *vertices++ = v;
+		v.Y = ctx->adv.y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
+		              v.Z = ctx->adv.z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
 	}
 	part->fVertices[FACE_XMIN] = vertices;
 }
 
-static void Adv_DrawXMax(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_XMAX);
+static void Adv_DrawXMax(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->Block, FACE_XMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = (count - adv_minBB.Z), u2 = (1 - adv_maxBB.Z) * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.Y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = (count - ctx->adv.minBB.Z), u2 = (1 - ctx->adv.maxBB.Z) * UV2_Scale;
+	float v1 = vOrigin + ctx->adv.maxBB.Y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->adv.minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->Parts[ctx->adv.baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->adv.bitFlags[ctx->ChunkIndex];
 	int aY0_Z0 = Adv_CountBits(F, xP1_yM1_zM1, xP1_yCC_zM1, xP1_yM1_zCC, xP1_yCC_zCC);
 	int aY0_Z1 = Adv_CountBits(F, xP1_yM1_zP1, xP1_yCC_zP1, xP1_yM1_zCC, xP1_yCC_zCC);
 	int aY1_Z0 = Adv_CountBits(F, xP1_yP1_zM1, xP1_yCC_zM1, xP1_yP1_zCC, xP1_yCC_zCC);
 	int aY1_Z1 = Adv_CountBits(F, xP1_yP1_zP1, xP1_yCC_zP1, xP1_yP1_zCC, xP1_yCC_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpX[aY0_Z0], col1_0 = Builder_FullBright ? white : adv_lerpX[aY1_Z0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpX[aY1_Z1], col0_1 = Builder_FullBright ? white : adv_lerpX[aY0_Z1];
+	PackedCol col0_0 = ctx->FullBright ? white : ctx->adv.lerpX[aY0_Z0], col1_0 = ctx->FullBright ? white : ctx->adv.lerpX[aY1_Z0];
+	PackedCol col1_1 = ctx->FullBright ? white : ctx->adv.lerpX[aY1_Z1], col0_1 = ctx->FullBright ? white : ctx->adv.lerpX[aY0_Z1];
 	struct VertexTextured* vertices, v;
 
-	if (Builder_Tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->Tinted) {
+		tint   = Blocks.FogCol[ctx->Block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->fVertices[FACE_XMAX];
-	v.X = adv_x2;
+	v.X = ctx->adv.x2;
 	if (aY0_Z0 + aY1_Z1 > aY0_Z1 + aY1_Z0) {
-		v.Y = adv_y2; v.Z = adv_z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
-		              v.Z = adv_z2 + (count - 1); v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		v.Y = adv_y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
-		              v.Z = adv_z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		v.Y = ctx->adv.y2; v.Z = ctx->adv.z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
+		              v.Z = ctx->adv.z2 + (count - 1); v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		v.Y = ctx->adv.y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
+		              v.Z = ctx->adv.z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
 	} else {
-		v.Y = adv_y2; v.Z = adv_z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		v.Y = adv_y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
-		              v.Z = adv_z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
-		v.Y = adv_y2;                                       v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.Y = ctx->adv.y2; v.Z = ctx->adv.z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.Y = ctx->adv.y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
+		              v.Z = ctx->adv.z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		v.Y = ctx->adv.y2;                                       v.V = v1; v.Col = col1_0; *vertices++ = v;
 	}
 	part->fVertices[FACE_XMAX] = vertices;
 }
 
-static void Adv_DrawZMin(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_ZMIN);
+static void Adv_DrawZMin(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->Block, FACE_ZMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = (count - adv_minBB.X), u2 = (1 - adv_maxBB.X) * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.Y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = (count - ctx->adv.minBB.X), u2 = (1 - ctx->adv.maxBB.X) * UV2_Scale;
+	float v1 = vOrigin + ctx->adv.maxBB.Y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->adv.minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->Parts[ctx->adv.baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->adv.bitFlags[ctx->ChunkIndex];
 	int aX0_Y0 = Adv_CountBits(F, xM1_yM1_zM1, xM1_yCC_zM1, xCC_yM1_zM1, xCC_yCC_zM1);
 	int aX0_Y1 = Adv_CountBits(F, xM1_yP1_zM1, xM1_yCC_zM1, xCC_yP1_zM1, xCC_yCC_zM1);
 	int aX1_Y0 = Adv_CountBits(F, xP1_yM1_zM1, xP1_yCC_zM1, xCC_yM1_zM1, xCC_yCC_zM1);
 	int aX1_Y1 = Adv_CountBits(F, xP1_yP1_zM1, xP1_yCC_zM1, xCC_yP1_zM1, xCC_yCC_zM1);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpZ[aX0_Y0], col1_0 = Builder_FullBright ? white : adv_lerpZ[aX1_Y0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpZ[aX1_Y1], col0_1 = Builder_FullBright ? white : adv_lerpZ[aX0_Y1];
+	PackedCol col0_0 = ctx->FullBright ? white : ctx->adv.lerpZ[aX0_Y0], col1_0 = ctx->FullBright ? white : ctx->adv.lerpZ[aX1_Y0];
+	PackedCol col1_1 = ctx->FullBright ? white : ctx->adv.lerpZ[aX1_Y1], col0_1 = ctx->FullBright ? white : ctx->adv.lerpZ[aX0_Y1];
 	struct VertexTextured* vertices, v;
 
-	if (Builder_Tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->Tinted) {
+		tint   = Blocks.FogCol[ctx->Block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->fVertices[FACE_ZMIN];
-	v.Z = adv_z1;
+	v.Z = ctx->adv.z1;
 	if (aX1_Y1 + aX0_Y0 > aX0_Y1 + aX1_Y0) {
-		v.X = adv_x2 + (count - 1); v.Y = adv_y1; v.U = u2; v.V = v2; v.Col = col1_0; *vertices++ = v;
-		v.X = adv_x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
-		                            v.Y = adv_y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1); v.Y = ctx->adv.y1; v.U = u2; v.V = v2; v.Col = col1_0; *vertices++ = v;
+		v.X = ctx->adv.x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		                            v.Y = ctx->adv.y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.X = adv_x1;               v.Y = adv_y1; v.U = u1; v.V = v2; v.Col = col0_0; *vertices++ = v;
-		                            v.Y = adv_y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		                            v.Y = adv_y1;           v.V = v2; v.Col = col1_0; *vertices++ = v;
+		v.X = ctx->adv.x1;               v.Y = ctx->adv.y1; v.U = u1; v.V = v2; v.Col = col0_0; *vertices++ = v;
+		                            v.Y = ctx->adv.y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		                            v.Y = ctx->adv.y1;           v.V = v2; v.Col = col1_0; *vertices++ = v;
 	}
 	part->fVertices[FACE_ZMIN] = vertices;
 }
 
-static void Adv_DrawZMax(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_ZMAX);
+static void Adv_DrawZMax(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->Block, FACE_ZMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.X, u2 = (count - 1) + adv_maxBB.X * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.Y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->adv.minBB.X, u2 = (count - 1) + ctx->adv.maxBB.X * UV2_Scale;
+	float v1 = vOrigin + ctx->adv.maxBB.Y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->adv.minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->Parts[ctx->adv.baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->adv.bitFlags[ctx->ChunkIndex];
 	int aX0_Y0 = Adv_CountBits(F, xM1_yM1_zP1, xM1_yCC_zP1, xCC_yM1_zP1, xCC_yCC_zP1);
 	int aX1_Y0 = Adv_CountBits(F, xP1_yM1_zP1, xP1_yCC_zP1, xCC_yM1_zP1, xCC_yCC_zP1);
 	int aX0_Y1 = Adv_CountBits(F, xM1_yP1_zP1, xM1_yCC_zP1, xCC_yP1_zP1, xCC_yCC_zP1);
 	int aX1_Y1 = Adv_CountBits(F, xP1_yP1_zP1, xP1_yCC_zP1, xCC_yP1_zP1, xCC_yCC_zP1);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpZ[aX1_Y1], col1_0 = Builder_FullBright ? white : adv_lerpZ[aX1_Y0];
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpZ[aX0_Y0], col0_1 = Builder_FullBright ? white : adv_lerpZ[aX0_Y1];
+	PackedCol col1_1 = ctx->FullBright ? white : ctx->adv.lerpZ[aX1_Y1], col1_0 = ctx->FullBright ? white : ctx->adv.lerpZ[aX1_Y0];
+	PackedCol col0_0 = ctx->FullBright ? white : ctx->adv.lerpZ[aX0_Y0], col0_1 = ctx->FullBright ? white : ctx->adv.lerpZ[aX0_Y1];
 	struct VertexTextured* vertices, v;
 
-	if (Builder_Tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->Tinted) {
+		tint   = Blocks.FogCol[ctx->Block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->fVertices[FACE_ZMAX];
-	v.Z = adv_z2;
+	v.Z = ctx->adv.z2;
 	if (aX1_Y1 + aX0_Y0 > aX0_Y1 + aX1_Y0) {
-		v.X = adv_x1;               v.Y = adv_y2; v.U = u1; v.V = v1; v.Col = col0_1; *vertices++ = v;
-		                            v.Y = adv_y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
-		                            v.Y = adv_y2;           v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.X = ctx->adv.x1;               v.Y = ctx->adv.y2; v.U = u1; v.V = v1; v.Col = col0_1; *vertices++ = v;
+		                            v.Y = ctx->adv.y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		                            v.Y = ctx->adv.y2;           v.V = v1; v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.X = adv_x2 + (count - 1); v.Y = adv_y2; v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		v.X = adv_x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
-		                            v.Y = adv_y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1); v.Y = ctx->adv.y2; v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.X = ctx->adv.x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
+		                            v.Y = ctx->adv.y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
 	}
 	part->fVertices[FACE_ZMAX] = vertices;
 }
 
-static void Adv_DrawYMin(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_YMIN);
+static void Adv_DrawYMin(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->Block, FACE_YMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.X, u2 = (count - 1) + adv_maxBB.X * UV2_Scale;
-	float v1 = vOrigin + adv_minBB.Z * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_maxBB.Z * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->adv.minBB.X, u2 = (count - 1) + ctx->adv.maxBB.X * UV2_Scale;
+	float v1 = vOrigin + ctx->adv.minBB.Z * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->adv.maxBB.Z * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->Parts[ctx->adv.baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->adv.bitFlags[ctx->ChunkIndex];
 	int aX0_Z0 = Adv_CountBits(F, xM1_yM1_zM1, xM1_yM1_zCC, xCC_yM1_zM1, xCC_yM1_zCC);
 	int aX1_Z0 = Adv_CountBits(F, xP1_yM1_zM1, xP1_yM1_zCC, xCC_yM1_zM1, xCC_yM1_zCC);
 	int aX0_Z1 = Adv_CountBits(F, xM1_yM1_zP1, xM1_yM1_zCC, xCC_yM1_zP1, xCC_yM1_zCC);
 	int aX1_Z1 = Adv_CountBits(F, xP1_yM1_zP1, xP1_yM1_zCC, xCC_yM1_zP1, xCC_yM1_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_1 = Builder_FullBright ? white : adv_lerpY[aX0_Z1], col1_1 = Builder_FullBright ? white : adv_lerpY[aX1_Z1];
-	PackedCol col1_0 = Builder_FullBright ? white : adv_lerpY[aX1_Z0], col0_0 = Builder_FullBright ? white : adv_lerpY[aX0_Z0];
+	PackedCol col0_1 = ctx->FullBright ? white : ctx->adv.lerpY[aX0_Z1], col1_1 = ctx->FullBright ? white : ctx->adv.lerpY[aX1_Z1];
+	PackedCol col1_0 = ctx->FullBright ? white : ctx->adv.lerpY[aX1_Z0], col0_0 = ctx->FullBright ? white : ctx->adv.lerpY[aX0_Z0];
 	struct VertexTextured* vertices, v;
 
-	if (Builder_Tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->Tinted) {
+		tint   = Blocks.FogCol[ctx->Block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->fVertices[FACE_YMIN];
-	v.Y = adv_y1;
+	v.Y = ctx->adv.y1;
 	if (aX0_Z1 + aX1_Z0 > aX0_Z0 + aX1_Z1) {
-		v.X = adv_x2 + (count - 1); v.Z = adv_z2; v.U = u2; v.V = v2; v.Col = col1_1; *vertices++ = v;
-		v.X = adv_x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
-		                            v.Z = adv_z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1); v.Z = ctx->adv.z2; v.U = u2; v.V = v2; v.Col = col1_1; *vertices++ = v;
+		v.X = ctx->adv.x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
+		                            v.Z = ctx->adv.z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
 	} else {
-		v.X = adv_x1;               v.Z = adv_z2; v.U = u1; v.V = v2; v.Col = col0_1; *vertices++ = v;
-		                            v.Z = adv_z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
-		                            v.Z = adv_z2;           v.V = v2; v.Col = col1_1; *vertices++ = v;
+		v.X = ctx->adv.x1;               v.Z = ctx->adv.z2; v.U = u1; v.V = v2; v.Col = col0_1; *vertices++ = v;
+		                            v.Z = ctx->adv.z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		                            v.Z = ctx->adv.z2;           v.V = v2; v.Col = col1_1; *vertices++ = v;
 	}
 	part->fVertices[FACE_YMIN] = vertices;
 }
 
-static void Adv_DrawYMax(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_YMAX);
+static void Adv_DrawYMax(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->Block, FACE_YMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.X, u2 = (count - 1) + adv_maxBB.X * UV2_Scale;
-	float v1 = vOrigin + adv_minBB.Z * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_maxBB.Z * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->adv.minBB.X, u2 = (count - 1) + ctx->adv.maxBB.X * UV2_Scale;
+	float v1 = vOrigin + ctx->adv.minBB.Z * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->adv.maxBB.Z * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->Parts[ctx->adv.baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->adv.bitFlags[ctx->ChunkIndex];
 	int aX0_Z0 = Adv_CountBits(F, xM1_yP1_zM1, xM1_yP1_zCC, xCC_yP1_zM1, xCC_yP1_zCC);
 	int aX1_Z0 = Adv_CountBits(F, xP1_yP1_zM1, xP1_yP1_zCC, xCC_yP1_zM1, xCC_yP1_zCC);
 	int aX0_Z1 = Adv_CountBits(F, xM1_yP1_zP1, xM1_yP1_zCC, xCC_yP1_zP1, xCC_yP1_zCC);
 	int aX1_Z1 = Adv_CountBits(F, xP1_yP1_zP1, xP1_yP1_zCC, xCC_yP1_zP1, xCC_yP1_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerp[aX0_Z0], col1_0 = Builder_FullBright ? white : adv_lerp[aX1_Z0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerp[aX1_Z1], col0_1 = Builder_FullBright ? white : adv_lerp[aX0_Z1];
+	PackedCol col0_0 = ctx->FullBright ? white : ctx->adv.lerp[aX0_Z0], col1_0 = ctx->FullBright ? white : ctx->adv.lerp[aX1_Z0];
+	PackedCol col1_1 = ctx->FullBright ? white : ctx->adv.lerp[aX1_Z1], col0_1 = ctx->FullBright ? white : ctx->adv.lerp[aX0_Z1];
 	struct VertexTextured* vertices, v;
 
-	if (Builder_Tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->Tinted) {
+		tint   = Blocks.FogCol[ctx->Block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->fVertices[FACE_YMAX];
-	v.Y = adv_y2;
+	v.Y = ctx->adv.y2;
 	if (aX0_Z0 + aX1_Z1 > aX0_Z1 + aX1_Z0) {
-		v.X = adv_x2 + (count - 1); v.Z = adv_z1; v.U = u2; v.V = v1; v.Col = col1_0; *vertices++ = v;
-		v.X = adv_x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
-		                            v.Z = adv_z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1); v.Z = ctx->adv.z1; v.U = u2; v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.X = ctx->adv.x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		                            v.Z = ctx->adv.z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.X = adv_x1;               v.Z = adv_z1; v.U = u1; v.V = v1; v.Col = col0_0; *vertices++ = v;
-		                            v.Z = adv_z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		                            v.Z = adv_z1;           v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.X = ctx->adv.x1;               v.Z = ctx->adv.z1; v.U = u1; v.V = v1; v.Col = col0_0; *vertices++ = v;
+		                            v.Z = ctx->adv.z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		                            v.Z = ctx->adv.z1;           v.V = v1; v.Col = col1_0; *vertices++ = v;
 	}
 	part->fVertices[FACE_YMAX] = vertices;
 }
 
-static void Adv_RenderBlock(int index) {
+static void Adv_RenderBlock(struct BuilderContext* ctx, int index) {
 	Vec3 min, max;
 	int count_XMin, count_XMax, count_ZMin;
 	int count_ZMax, count_YMin, count_YMax;
 
-	if (Blocks.Draw[Builder_Block] == DRAW_SPRITE) {
-		Builder_FullBright = Blocks.FullBright[Builder_Block];
-		Builder_Tinted     = Blocks.Tinted[Builder_Block];
-		Builder_DrawSprite();
+	if (Blocks.Draw[ctx->Block] == DRAW_SPRITE) {
+		ctx->FullBright = Blocks.FullBright[ctx->Block];
+		ctx->Tinted     = Blocks.Tinted[ctx->Block];
+		Builder_DrawSprite(ctx);
 		return;
 	}
 
-	count_XMin = Builder_Counts[index + FACE_XMIN];
-	count_XMax = Builder_Counts[index + FACE_XMAX];
-	count_ZMin = Builder_Counts[index + FACE_ZMIN];
-	count_ZMax = Builder_Counts[index + FACE_ZMAX];
-	count_YMin = Builder_Counts[index + FACE_YMIN];
-	count_YMax = Builder_Counts[index + FACE_YMAX];
+	count_XMin = ctx->Counts[index + FACE_XMIN];
+	count_XMax = ctx->Counts[index + FACE_XMAX];
+	count_ZMin = ctx->Counts[index + FACE_ZMIN];
+	count_ZMax = ctx->Counts[index + FACE_ZMAX];
+	count_YMin = ctx->Counts[index + FACE_YMIN];
+	count_YMax = ctx->Counts[index + FACE_YMAX];
 
 	if (!count_XMin && !count_XMax && !count_ZMin &&
 		!count_ZMax && !count_YMin && !count_YMax) return;
 
-	Builder_FullBright = Blocks.FullBright[Builder_Block];
-	adv_baseOffset = (Blocks.Draw[Builder_Block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
-	adv_lightFlags = Blocks.LightOffset[Builder_Block];
-	Builder_Tinted = Blocks.Tinted[Builder_Block];
+	ctx->FullBright = Blocks.FullBright[ctx->Block];
+	ctx->adv.baseOffset = (Blocks.Draw[ctx->Block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
+	ctx->adv.lightFlags = Blocks.LightOffset[ctx->Block];
+	ctx->Tinted = Blocks.Tinted[ctx->Block];
 
-	min = Blocks.RenderMinBB[Builder_Block]; max = Blocks.RenderMaxBB[Builder_Block];
-	adv_x1 = Builder_X + min.X; adv_y1 = Builder_Y + min.Y; adv_z1 = Builder_Z + min.Z;
-	adv_x2 = Builder_X + max.X; adv_y2 = Builder_Y + max.Y; adv_z2 = Builder_Z + max.Z;
+	min = Blocks.RenderMinBB[ctx->Block]; max = Blocks.RenderMaxBB[ctx->Block];
+	ctx->adv.x1 = ctx->X + min.X; ctx->adv.y1 = ctx->Y + min.Y; ctx->adv.z1 = ctx->Z + min.Z;
+	ctx->adv.x2 = ctx->X + max.X; ctx->adv.y2 = ctx->Y + max.Y; ctx->adv.z2 = ctx->Z + max.Z;
 
-	adv_minBB = Blocks.MinBB[Builder_Block]; adv_maxBB = Blocks.MaxBB[Builder_Block];
-	adv_minBB.Y = 1.0f - adv_minBB.Y; adv_maxBB.Y = 1.0f - adv_maxBB.Y;
+	ctx->adv.minBB = Blocks.MinBB[ctx->Block]; ctx->adv.maxBB = Blocks.MaxBB[ctx->Block];
+	ctx->adv.minBB.Y = 1.0f - ctx->adv.minBB.Y; ctx->adv.maxBB.Y = 1.0f - ctx->adv.maxBB.Y;
 
-	if (count_XMin) Adv_DrawXMin(count_XMin);
-	if (count_XMax) Adv_DrawXMax(count_XMax);
-	if (count_ZMin) Adv_DrawZMin(count_ZMin);
-	if (count_ZMax) Adv_DrawZMax(count_ZMax);
-	if (count_YMin) Adv_DrawYMin(count_YMin);
-	if (count_YMax) Adv_DrawYMax(count_YMax);
+	if (count_XMin) Adv_DrawXMin(ctx, count_XMin);
+	if (count_XMax) Adv_DrawXMax(ctx, count_XMax);
+	if (count_ZMin) Adv_DrawZMin(ctx, count_ZMin);
+	if (count_ZMax) Adv_DrawZMax(ctx, count_ZMax);
+	if (count_YMin) Adv_DrawYMin(ctx, count_YMin);
+	if (count_YMax) Adv_DrawYMax(ctx, count_YMax);
 }
 
-static void Adv_PreStretchTiles(void) {
+static void Adv_PreStretchTiles(struct BuilderContext* ctx) {
 	int i;
-	DefaultPreStretchTiles();
-	adv_bitFlags = Builder_BitFlags;
+	DefaultPreStretchTiles(ctx);
+	ctx->adv.bitFlags = ctx->BitFlags;
 
 	for (i = 0; i <= 4; i++) {
-		adv_lerp[i]  = PackedCol_Lerp(Env.ShadowCol,   Env.SunCol,   i / 4.0f);
-		adv_lerpX[i] = PackedCol_Lerp(Env.ShadowXSide, Env.SunXSide, i / 4.0f);
-		adv_lerpZ[i] = PackedCol_Lerp(Env.ShadowZSide, Env.SunZSide, i / 4.0f);
-		adv_lerpY[i] = PackedCol_Lerp(Env.ShadowYMin,  Env.SunYMin,  i / 4.0f);
+		ctx->adv.lerp[i]  = PackedCol_Lerp(Env.ShadowCol,   Env.SunCol,   i / 4.0f);
+		ctx->adv.lerpX[i] = PackedCol_Lerp(Env.ShadowXSide, Env.SunXSide, i / 4.0f);
+		ctx->adv.lerpZ[i] = PackedCol_Lerp(Env.ShadowZSide, Env.SunZSide, i / 4.0f);
+		ctx->adv.lerpY[i] = PackedCol_Lerp(Env.ShadowYMin,  Env.SunYMin,  i / 4.0f);
 	}
 }
 
@@ -1252,9 +1834,12 @@ static void AdvBuilder_SetActive(void) {
 *---------------------------------------------------Builder interface-----------------------------------------------------*
 *#########################################################################################################################*/
 cc_bool Builder_SmoothLighting;
+cc_bool Builder_GreedyMeshing;
 void Builder_ApplyActive(void) {
 	if (Builder_SmoothLighting) {
 		AdvBuilder_SetActive();
+	} else if (Builder_GreedyMeshing) {
+		GreedyBuilder_SetActive();
 	} else {
 		NormalBuilder_SetActive();
 	}
@@ -1269,6 +1854,7 @@ static void OnInit(void) {
 	Builder_Offsets[FACE_YMAX] =  EXTCHUNK_SIZE_2;
 
 	if (!Game_ClassicMode) Builder_SmoothLighting = Options_GetBool(OPT_SMOOTH_LIGHTING, false);
+	Builder_GreedyMeshing = Options_GetBool(OPT_GREEDY_MESHING, false);
 	Builder_ApplyActive();
 }
 
@@ -1277,9 +1863,30 @@ static void OnNewMapLoaded(void) {
 	Builder_EdgeLevel  = max(0, Env.EdgeHeight);
 }
 
+static void OnFree(void) {
+	int i;
+	for (i = 0; i < WORKERS_MAX_COUNT; i++) {
+		if (!contexts[i]) continue;
+#ifdef CC_BUILD_COMPACTCHUNKS
+		Mem_Free(contexts[i]->Vertices);
+#endif
+		Mem_Free(contexts[i]);
+		contexts[i] = NULL;
+	}
+
+	for (i = 0; i < meshesCapacity; i++) {
+		Mem_Free(meshes[i].vertices);
+	}
+	Mem_Free(meshes);
+	Mem_Free(batchChunks);
+	meshes      = NULL;
+	batchChunks = NULL;
+	meshesCapacity = 0;
+}
+
 struct IGameComponent Builder_Component = {
 	OnInit, /* Init */
-	NULL, /* Free */
+	OnFree, /* Free */
 	NULL, /* Reset */
 	NULL, /* OnNewMap */
 	OnNewMapLoaded /* OnNewMapLoaded */
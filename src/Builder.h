@@ -15,9 +15,27 @@ extern struct IGameComponent Builder_Component;
 extern int Builder_SidesLevel, Builder_EdgeLevel;
 /* Whether smooth/advanced lighting mesh builder is used. */
 extern cc_bool Builder_SmoothLighting;
+/* Whether greedy mesh builder is used, which merges faces into rectangles instead of just rows. */
+/* NOTE: Faces are only merged into rectangles when each 1D atlas consists of a single tile. */
+/* NOTE: This is not used when Builder_SmoothLighting is enabled. */
+extern cc_bool Builder_GreedyMeshing;
 
 /* Builds the mesh of vertices for the given chunk. */
 void Builder_MakeChunk(struct ChunkInfo* info);
+/* Builds the meshes of vertices for the given chunks. */
+/* NOTE: The meshes are built in parallel across all the worker threads. (see Workers.h) */
+void Builder_MakeChunks(struct ChunkInfo** chunks, int count);
+/* Returns whether the mesh of the given chunk is known to be empty, without reading any of its blocks. */
+/* (i.e. when the chunk is all air, or it and its neighbours are all opaque, according to World_GetChunkSummary) */
+/* NOTE: When the mesh is known to be empty, this also sets which faces of the chunk can see each other. */
+cc_bool Builder_IsChunkEmpty(struct ChunkInfo* info);
 
 void Builder_ApplyActive(void);
+
+#ifdef CC_BUILD_BENCHMARK
+/* Time spent in each phase of building chunk meshes, in microseconds. */
+struct BuilderTimings { cc_uint64 ReadChunkData, Occlusion, Stretch, RenderBlock, Compact, Cache; };
+/* Adds up the time spent in each phase by all worker threads, then resets those times to 0. */
+void Builder_TakeTimings(struct BuilderTimings* timings);
+#endif
 #endif
@@ -131,7 +131,7 @@ typedef cc_uint8 TextureLoc;
 #endif
 
 typedef cc_uint8 BlockRaw;
-typedef cc_uint8 EntityID;
+typedef cc_uint16 EntityID;
 typedef cc_uint8 Face;
 typedef cc_uint32 cc_result;
 typedef cc_uint64 TimeMS;
@@ -245,6 +245,11 @@ Thus it is **NOT SAFE** to allocate a string on the stack. */
 #endif
 #endif
 
+/* Chunk meshes use the compact VertexChunk format, which needs 16 bit vertex attributes */
+#if defined CC_BUILD_GL && !defined CC_BUILD_GL11
+#define CC_BUILD_COMPACTCHUNKS
+#endif
+
 #ifdef CC_BUILD_D3D9
 typedef void* GfxResourceID;
 #else
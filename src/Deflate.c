@@ -6,6 +6,7 @@
 #include "Stream.h"
 #include "Errors.h"
 #include "Utils.h"
+#include "Workers.h"
 
 #define Header_ReadU8(value) if ((res = s->ReadU8(s, &value))) return res;
 /*########################################################################################################################*
@@ -142,7 +143,7 @@ enum INFLATE_STATE_ {
 };
 
 /* Insert next byte into the bit buffer */
-#define Inflate_GetByte(state) state->AvailIn--; state->Bits |= (cc_uint32)(*state->NextIn++) << state->NumBits; state->NumBits += 8;
+#define Inflate_GetByte(state) state->AvailIn--; state->Bits |= (cc_uint64)(*state->NextIn++) << state->NumBits; state->NumBits += 8;
 /* Retrieves bits from the bit buffer */
 #define Inflate_PeekBits(state, bits) (state->Bits & ((1UL << (bits)) - 1UL))
 /* Consumes/eats up bits from the bit buffer */
@@ -164,8 +165,9 @@ enum INFLATE_STATE_ {
 #define Inflate_NextCompressState(state) ((state->AvailIn >= INFLATE_FASTINF_IN && state->AvailOut >= INFLATE_FASTINF_OUT) ? INFLATE_STATE_FASTCOMPRESSED : INFLATE_STATE_COMPRESSED_LIT)
 /* The maximum amount of bytes that can be output is 258 */
 #define INFLATE_FASTINF_OUT 258
-/* The most input bytes required for huffman codes and extra data is 16 + 5 + 16 + 13 bits. Add 3 extra bytes to account for putting data into the bit buffer. */
-#define INFLATE_FASTINF_IN 10
+/* The bit buffer is refilled by reading 8 bytes at once. After refilling there are always at least 56 bits, */
+/*  which is enough for the most bits a length and distance pair can need (15 + 5 + 15 + 13 bits) */
+#define INFLATE_FASTINF_IN 8
 
 static cc_uint32 Huffman_ReverseBits(cc_uint32 n, cc_uint8 bits) {
 	n = ((n & 0xAAAA) >> 1) | ((n & 0x5555) << 1);
@@ -296,46 +298,6 @@ static int Huffman_Decode(struct InflateState* state, struct HuffmanTable* table
 	return -1;
 }
 
-/* Inline the common <= 9 bits case */
-#define Huffman_UNSAFE_Decode(state, table, result) \
-{\
-	Inflate_UNSAFE_EnsureBits(state, INFLATE_MAX_BITS);\
-	packed = table.Fast[Inflate_PeekBits(state, INFLATE_FAST_BITS)];\
-	if (packed >= 0) {\
-		consumedBits = packed >> INFLATE_FAST_BITS;\
-		Inflate_ConsumeBits(state, consumedBits);\
-		result = packed & 0x1FF;\
-	} else {\
-		result = Huffman_UNSAFE_Decode_Slow(state, &table);\
-	}\
-}
-
-static int Huffman_UNSAFE_Decode_Slow(struct InflateState* state, struct HuffmanTable* table) {
-	cc_uint32 i, j, codeword;
-	int offset;
-
-	/* Slow, bit by bit lookup. Need to reverse order for huffman. */
-	codeword = Inflate_PeekBits(state,       INFLATE_FAST_BITS);
-	codeword = Huffman_ReverseBits(codeword, INFLATE_FAST_BITS);
-
-	for (i = INFLATE_FAST_BITS + 1, j = INFLATE_FAST_BITS; i < INFLATE_MAX_BITS; i++, j++) {
-		codeword = (codeword << 1) | ((state->Bits >> j) & 1);
-
-		if (codeword < table->EndCodewords[i]) {
-			offset = table->FirstOffsets[i] + (codeword - table->FirstCodewords[i]);
-			Inflate_ConsumeBits(state, i);
-			return table->Values[offset];
-		}
-	}
-
-	Inflate_Fail(state, INF_ERR_INVALID_CODE);
-	/* Need to exit the fast decode loop */
-	/* TODO: This means a few garbage bytes can get written */
-	/* to the output, but it probably doesn't matter */
-	state->AvailIn = 0;
-	return 0;
-}
-
 void Inflate_Init2(struct InflateState* state, struct Stream* source) {
 	state->State = INFLATE_STATE_HEADER;
 	state->LastBlock = false;
@@ -389,67 +351,218 @@ static const cc_uint8 codelens_order[INFLATE_MAX_CODELENS] = {
 	16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15 
 };
 
+/* Entries in the fast lookup tables are packed as:
+	bits 0-7   - number of bits used by the codeword(s)
+	bits 8-11  - number of extra bits that follow the codeword (lengths and distances)
+	bits 12-15 - type of entry
+	bits 16-31 - literal(s), base length, or base distance
+  An entry of 0 means the codeword is longer than the table bits, so must be decoded the slow way */
+enum INFLATE_ENTRY_ { INFLATE_ENTRY_LONG, INFLATE_ENTRY_LIT, INFLATE_ENTRY_LIT2, INFLATE_ENTRY_LEN, INFLATE_ENTRY_END, INFLATE_ENTRY_DIST };
+#define Inflate_MakeEntry(type, value, codeBits, extraBits) (((cc_uint32)(value) << 16) | ((type) << 12) | ((extraBits) << 8) | (codeBits))
+#define Inflate_EntryType(entry)  (((entry) >> 12) & 0x0F)
+#define Inflate_EntryBits(entry)  ((entry) & 0xFF)
+#define Inflate_EntryExtra(entry) (((entry) >> 8) & 0x0F)
+
+static cc_uint32 Inflate_LitEntry(int lit, int codeBits) {
+	if (lit < 256)  return Inflate_MakeEntry(INFLATE_ENTRY_LIT, lit, codeBits, 0);
+	if (lit == 256) return Inflate_MakeEntry(INFLATE_ENTRY_END, 0,   codeBits, 0);
+
+	lit -= 257;
+	return Inflate_MakeEntry(INFLATE_ENTRY_LEN, len_base[lit], codeBits, len_bits[lit]);
+}
+
+static cc_uint32 Inflate_DistEntry(int dist, int codeBits) {
+	return Inflate_MakeEntry(INFLATE_ENTRY_DIST, dist_base[dist], codeBits, dist_bits[dist]);
+}
+
+/* Builds a fast lookup table, which decodes a codeword and its extra bits in one lookup */
+/* NOTE: table must have already been built from bitLens using Huffman_Build */
+static void Inflate_BuildFastTable(cc_uint32* fast, int fastBits, const struct HuffmanTable* table, 
+									const cc_uint8* bitLens, int count, cc_bool lits) {
+	cc_uint16 codewords[INFLATE_MAX_BITS];
+	cc_uint32 entry, first, second;
+	int i, j, len, size = 1 << fastBits;
+
+	Mem_Set(fast, 0, size * sizeof(cc_uint32));
+	Mem_Copy(codewords, table->FirstCodewords, sizeof(codewords));
+
+	for (i = 0; i < count; i++) {
+		len = bitLens[i];
+		if (!len) continue;
+		j = codewords[len]++;
+		if (len > fastBits) continue;
+
+		/* Huffman codes are read backwards, so the entry goes in every index ending in the reversed codeword */
+		entry = lits ? Inflate_LitEntry(i, len) : Inflate_DistEntry(i, len);
+		for (j = Huffman_ReverseBits(j, len); j < size; j += 1 << len) { fast[j] = entry; }
+	}
+	if (!lits) return;
+
+	/* Pack two literals into one entry, when both codewords fit in the table bits */
+	/* Iterates backwards, because fast[i >> bits] must not have been combined yet */
+	for (i = size - 1; i > 0; i--) {
+		first = fast[i];
+		if (Inflate_EntryType(first) != INFLATE_ENTRY_LIT) continue;
+		second = fast[i >> Inflate_EntryBits(first)];
+
+		if (Inflate_EntryType(second) != INFLATE_ENTRY_LIT) continue;
+		len = Inflate_EntryBits(first) + Inflate_EntryBits(second);
+		if (len > fastBits) continue;
+
+		fast[i] = Inflate_MakeEntry(INFLATE_ENTRY_LIT2, (first >> 16) | ((second >> 16) << 8), len, 0);
+	}
+}
+
+static void Inflate_BuildFastTables(struct InflateState* s, const cc_uint8* litLens, int numLits, const cc_uint8* distLens, int numDists) {
+	Inflate_BuildFastTable(s->FastLits,  INFLATE_FASTLITS_BITS,  &s->Table.Lits, litLens,  numLits,  true);
+	Inflate_BuildFastTable(s->FastDists, INFLATE_FASTDISTS_BITS, &s->TableDists, distLens, numDists, false);
+}
+
+/* Decodes a huffman codeword that is too long to be in the fast lookup table */
+/* Returns -1 if there is no valid codeword */
+static int Huffman_DecodeLong(const struct HuffmanTable* table, cc_uint64 bits, cc_uint32* codeBits) {
+	cc_uint32 i, codeword = 0;
+
+	for (i = 1; i < INFLATE_MAX_BITS; i++) {
+		codeword = (codeword << 1) | ((cc_uint32)(bits >> (i - 1)) & 1);
+
+		if (codeword < table->EndCodewords[i]) {
+			*codeBits = i;
+			return table->Values[table->FirstOffsets[i] + (codeword - table->FirstCodewords[i])];
+		}
+	}
+	return -1;
+}
+
+#if defined __GNUC__ && !defined CC_BIG_ENDIAN
+/* gcc/clang compile this into a single unaligned load */
+static CC_INLINE cc_uint64 Inflate_Read64(const cc_uint8* p) { cc_uint64 v; __builtin_memcpy(&v, p, 8); return v; }
+#define Inflate_Copy8(dst, src) __builtin_memcpy(dst, src, 8)
+#else
+#define Inflate_Copy8(dst, src) Mem_Copy(dst, src, 8)
+#define Inflate_Read32(p) ((cc_uint32)(p)[0] | ((cc_uint32)(p)[1] << 8) | ((cc_uint32)(p)[2] << 16) | ((cc_uint32)(p)[3] << 24))
+#define Inflate_Read64(p) ((cc_uint64)Inflate_Read32(p) | ((cc_uint64)Inflate_Read32((p) + 4) << 32))
+#endif
+
 static void Inflate_InflateFast(struct InflateState* s) {
+	/* bit buffer variables */
+	cc_uint64 bits;
+	cc_uint32 numBits, availIn, availOut, refill;
+	cc_uint8* in;
+
 	/* huffman variables */
-	cc_uint32 lit, len, dist;
-	cc_uint32 bits, lenIdx, distIdx;
-	int packed, consumedBits;
+	cc_uint32 entry, type, codeBits, extraBits;
+	cc_uint32 len, dist;
+	int value;
 
 	/* window variables */
 	cc_uint8* window;
+	cc_uint8* src;
+	cc_uint8* dst;
 	cc_uint32 i, curIdx, startIdx;
 	cc_uint32 copyStart, copyLen, partLen;
 
+	/* Work on local copies, as writes to the window could otherwise alias the state */
+	bits     = s->Bits;
+	numBits  = s->NumBits;
+	in       = s->NextIn;
+	availIn  = s->AvailIn;
+	availOut = s->AvailOut;
+
 	window = s->Window;
 	curIdx = s->WindowIndex;
 	copyStart = s->WindowIndex;
 	copyLen   = 0;
 
 #define INFLATE_FAST_COPY_MAX (INFLATE_WINDOW_SIZE - INFLATE_FASTINF_OUT)
-	while (s->AvailOut >= INFLATE_FASTINF_OUT && s->AvailIn >= INFLATE_FASTINF_IN && copyLen < INFLATE_FAST_COPY_MAX) {
-		Huffman_UNSAFE_Decode(s, s->Table.Lits, lit);
+	while (availOut >= INFLATE_FASTINF_OUT && availIn >= INFLATE_FASTINF_IN && copyLen < INFLATE_FAST_COPY_MAX) {
+		/* Branchless refill - unused bits above numBits are just loaded again next time */
+		bits    |= Inflate_Read64(in) << numBits;
+		refill   = (63 - numBits) >> 3;
+		in      += refill; availIn -= refill;
+		numBits |= 56;
+
+		entry = s->FastLits[bits & ((1 << INFLATE_FASTLITS_BITS) - 1)];
+		if (!entry) {
+			value = Huffman_DecodeLong(&s->Table.Lits, bits, &codeBits);
+			if (value < 0) { Inflate_Fail(s, INF_ERR_INVALID_CODE); break; }
+			entry = Inflate_LitEntry(value, codeBits);
+		}
+		type     = Inflate_EntryType(entry);
+		codeBits = Inflate_EntryBits(entry);
+		bits >>= codeBits; numBits -= codeBits;
+
+		if (type == INFLATE_ENTRY_LIT) {
+			window[curIdx] = (cc_uint8)(entry >> 16);
+			curIdx = (curIdx + 1) & INFLATE_WINDOW_MASK;
+			availOut--; copyLen++;
+			continue;
+		} else if (type == INFLATE_ENTRY_LIT2) {
+			window[curIdx] = (cc_uint8)(entry >> 16);
+			curIdx = (curIdx + 1) & INFLATE_WINDOW_MASK;
+			window[curIdx] = (cc_uint8)(entry >> 24);
+			curIdx = (curIdx + 1) & INFLATE_WINDOW_MASK;
+			availOut -= 2; copyLen += 2;
+			continue;
+		} else if (type == INFLATE_ENTRY_END) {
+			s->State = Inflate_NextBlockState(s);
+			break;
+		}
 
-		if (lit <= 256) {
-			if (lit < 256) {
-				window[curIdx] = (cc_uint8)lit;
-				s->AvailOut--; copyLen++;
-				curIdx = (curIdx + 1) & INFLATE_WINDOW_MASK;
+		/* Length and its extra bits */
+		extraBits = Inflate_EntryExtra(entry);
+		len   = (entry >> 16) + ((cc_uint32)bits & ((1U << extraBits) - 1));
+		bits >>= extraBits; numBits -= extraBits;
+
+		/* Distance and its extra bits */
+		entry = s->FastDists[bits & ((1 << INFLATE_FASTDISTS_BITS) - 1)];
+		if (!entry) {
+			value = Huffman_DecodeLong(&s->TableDists, bits, &codeBits);
+			if (value < 0) { Inflate_Fail(s, INF_ERR_INVALID_CODE); break; }
+			entry = Inflate_DistEntry(value, codeBits);
+		}
+		codeBits  = Inflate_EntryBits(entry);
+		extraBits = Inflate_EntryExtra(entry);
+		dist  = (entry >> 16) + ((cc_uint32)(bits >> codeBits) & ((1U << extraBits) - 1));
+		bits >>= codeBits + extraBits; numBits -= codeBits + extraBits;
+
+		/* Window infinitely repeats like ...xyz|uvwxyz|uvwxyz|uvw... */
+		/* If start and end don't cross a boundary, can avoid masking index */
+		startIdx = (curIdx - dist) & INFLATE_WINDOW_MASK;
+		if (curIdx >= startIdx && (curIdx + len) < INFLATE_WINDOW_SIZE) {
+			src = &window[startIdx];
+			dst = &window[curIdx];
+
+			if (dist >= 8) {
+				/* Each 8 bytes read have always already been written, even when source and destination overlap */
+				for (i = 0; i + 8 <= len; i += 8) { Inflate_Copy8(dst + i, src + i); }
+				for (; i < len; i++) { dst[i] = src[i]; }
+			} else if (dist == 1) {
+				/* Run of the same byte */
+				Mem_Set(dst, *src, len);
 			} else {
-				s->State = Inflate_NextBlockState(s);
-				break;
-			}
-		} else {
-			lenIdx = lit - 257;
-			bits = len_bits[lenIdx];
-			Inflate_UNSAFE_EnsureBits(s, bits);
-			len  = len_base[lenIdx] + Inflate_ReadBits(s, bits);
-
-			Huffman_UNSAFE_Decode(s, s->TableDists, distIdx);
-			bits = dist_bits[distIdx];
-			Inflate_UNSAFE_EnsureBits(s, bits);
-			dist = dist_base[distIdx] + Inflate_ReadBits(s, bits);
-	
-			/* Window infinitely repeats like ...xyz|uvwxyz|uvwxyz|uvw... */
-			/* If start and end don't cross a boundary, can avoid masking index */
-			startIdx = (curIdx - dist) & INFLATE_WINDOW_MASK;
-			if (curIdx >= startIdx && (curIdx + len) < INFLATE_WINDOW_SIZE) {
-				cc_uint8* src = &window[startIdx]; 
-				cc_uint8* dst = &window[curIdx];
-
+				/* Overlapping copy which repeats the last 'dist' bytes */
 				for (i = 0; i < (len & ~0x3); i += 4) {
 					*dst++ = *src++; *dst++ = *src++; *dst++ = *src++; *dst++ = *src++;
 				}
 				for (; i < len; i++) { *dst++ = *src++; }
-			} else {
-				for (i = 0; i < len; i++) {
-					window[(curIdx + i) & INFLATE_WINDOW_MASK] = window[(startIdx + i) & INFLATE_WINDOW_MASK];
-				}
 			}
-			curIdx = (curIdx + len) & INFLATE_WINDOW_MASK;
-			s->AvailOut -= len; copyLen += len;
+		} else {
+			for (i = 0; i < len; i++) {
+				window[(curIdx + i) & INFLATE_WINDOW_MASK] = window[(startIdx + i) & INFLATE_WINDOW_MASK];
+			}
 		}
+		curIdx = (curIdx + len) & INFLATE_WINDOW_MASK;
+		availOut -= len; copyLen += len;
 	}
 
+	/* Bits above numBits must be 0 for the slow decoding path */
+	s->Bits     = numBits ? bits & (((cc_uint64)1 << numBits) - 1) : 0;
+	s->NumBits  = numBits;
+	s->NextIn   = in;
+	s->AvailIn  = availIn;
+	s->AvailOut = availOut;
+
 	s->WindowIndex = curIdx;
 	if (!copyLen) return;
 
@@ -497,6 +610,7 @@ void Inflate_Process(struct InflateState* s) {
 			case 1: { /* Fixed/static huffman compressed */
 				(void)Huffman_Build(&s->Table.Lits, fixed_lits,  INFLATE_MAX_LITS);
 				(void)Huffman_Build(&s->TableDists, fixed_dists, INFLATE_MAX_DISTS);
+				Inflate_BuildFastTables(s, fixed_lits, INFLATE_MAX_LITS, fixed_dists, INFLATE_MAX_DISTS);
 				s->State = Inflate_NextCompressState(s);
 			} break;
 
@@ -606,6 +720,7 @@ void Inflate_Process(struct InflateState* s) {
 				if (res) { Inflate_Fail(s, res); return; }
 				res = Huffman_Build(&s->TableDists, s->Buffer + s->NumLits, s->NumDists);
 				if (res) { Inflate_Fail(s, res); return; }
+				Inflate_BuildFastTables(s, s->Buffer, s->NumLits, s->Buffer + s->NumLits, s->NumDists);
 			}
 			break;
 		}
@@ -786,10 +901,6 @@ static const cc_uint16 deflate_dist[31] = {
 
 /* Pushes given bits, but does not write them */
 #define Deflate_PushBits(state, value, bits) state->Bits |= (value) << state->NumBits; state->NumBits += (bits);
-/* Pushes bits of the huffman codeword bits for the given literal, but does not write them */
-#define Deflate_PushLit(state, value) Deflate_PushBits(state, state->LitsCodewords[value], state->LitsLens[value])
-/* Pushes given bits (reversing for huffman code), but does not write them */
-#define Deflate_PushHuff(state, value, bits) Deflate_PushBits(state, Huffman_ReverseBits(value, bits), bits)
 /* Writes given byte to output */
 #define Deflate_WriteByte(state) *state->NextOut++ = state->Bits; state->AvailOut--; state->Bits >>= 8; state->NumBits -= 8;
 /* Flushes bits in buffer to output buffer */
@@ -797,143 +908,610 @@ static const cc_uint16 deflate_dist[31] = {
 
 #define MIN_MATCH_LEN 3
 #define MAX_MATCH_LEN 258
+/* Blocks with fewer symbols than this are never split in half */
+#define DEFLATE_MIN_SPLIT 1024
+
+/* Parameters for finding matches at each compression level */
+struct DeflateConfig {
+	cc_uint16 maxChain; /* Maximum number of earlier positions checked for a match */
+	cc_uint16 niceLen;  /* Stops searching once a match at least this long is found */
+	cc_bool lazy;       /* Whether to check if a longer match starts at the next byte */
+};
+static const struct DeflateConfig deflate_configs[10] = {
+	{    0,   0, false }, /* 0: stored blocks only */
+	{    4,   8, false }, /* 1: fast greedy matching */
+	{    8,  16, false },
+	{   32,  32, false },
+	{   16,  16, true  },
+	{   32,  32, true  },
+	{  128, 128, true  }, /* 6: lazy matching */
+	{  256, 128, true  },
+	{  512, 258, true  },
+	{  256, 258, false }  /* 9: optimal parsing */
+};
 
 /* Number of bytes that match (are the same) from a and b */
 static int Deflate_MatchLen(cc_uint8* a, cc_uint8* b, int maxLen) {
 	int i = 0;
-	while (i < maxLen && *a == *b) { i++; a++; b++; }
+	/* Compare 8 bytes at once, then find which byte is different */
+	while (i + 8 <= maxLen && Inflate_Read64(a + i) == Inflate_Read64(b + i)) { i += 8; }
+	while (i < maxLen && a[i] == b[i]) { i++; }
 	return i;
 }
 
 /* Hashes 3 bytes of data */
 static cc_uint32 Deflate_Hash(cc_uint8* src) {
-	return (cc_uint32)((src[0] << 8) ^ (src[1] << 4) ^ (src[2])) & DEFLATE_HASH_MASK;
+	return (cc_uint32)((src[0] << 10) ^ (src[1] << 5) ^ (src[2])) & DEFLATE_HASH_MASK;
 }
 
-/* Writes a literal to state->Output */
-static void Deflate_Lit(struct DeflateState* state, int lit) {
-	Deflate_PushLit(state, lit);
-	Deflate_FlushBits(state);
+/* Index of the length code for the given match length */
+static int Deflate_LenCode(int len) {
+	int j;
+	for (j = 0; len >= deflate_len[j + 1]; j++);
+	return j;
 }
 
-/* Writes a length-distance pair to state->Output */
-static void Deflate_LenDist(struct DeflateState* state, int len, int dist) {
+/* Index of the distance code for the given match distance */
+static int Deflate_DistCode(int dist) {
 	int j;
-	/* TODO: Do we actually need the if (len_bits[j]) ????????? does writing 0 bits matter??? */
+	for (j = 0; dist >= deflate_dist[j + 1]; j++);
+	return j;
+}
 
-	for (j = 0; len >= deflate_len[j + 1]; j++);
-	Deflate_PushLit(state, j + 257);
-	if (len_bits[j]) { Deflate_PushBits(state, len - deflate_len[j], len_bits[j]); }
-	Deflate_FlushBits(state);
 
-	for (j = 0; dist >= deflate_dist[j + 1]; j++);
-	Deflate_PushHuff(state, j, 5);
-	if (dist_bits[j]) { Deflate_PushBits(state, dist - deflate_dist[j], dist_bits[j]); }
-	Deflate_FlushBits(state);
+/*########################################################################################################################*
+*--------------------------------------------------Deflate match finding--------------------------------------------------*
+*#########################################################################################################################*/
+/* Inserts the given position into the hash chains */
+static void Deflate_Insert(struct DeflateState* s, int pos, int end) {
+	cc_uint32 hash;
+	if (end - pos < MIN_MATCH_LEN) return;
+
+	hash = Deflate_Hash(&s->Input[pos]);
+	s->Prev[pos]  = s->Head[hash];
+	s->Head[hash] = pos;
 }
 
-/* Moves "current block" to "previous block", adjusting state if needed. */
-static void Deflate_MoveBlock(struct DeflateState* state) {
-	int i;
-	Mem_Copy(state->Input, state->Input + DEFLATE_BLOCK_SIZE, DEFLATE_BLOCK_SIZE);
-	state->InputPosition = DEFLATE_BLOCK_SIZE;
+/* Finds the longest earlier match for the data starting at the given position */
+/* NOTE: Must be called before the given position is inserted into the hash chains */
+static int Deflate_FindMatch(struct DeflateState* s, int pos, int end, int* dist) {
+	const struct DeflateConfig* cfg = &deflate_configs[s->Level];
+	cc_uint8* input = s->Input;
+	cc_uint8* cur   = input + pos;
+	int maxLen  = min(end - pos, MAX_MATCH_LEN);
+	int bestLen = MIN_MATCH_LEN - 1; /* Match must be at least 3 bytes */
+	int chain   = cfg->maxChain;
+	int match, len;
+
+	*dist = 0;
+	if (maxLen < MIN_MATCH_LEN) return 0;
+	match = s->Head[Deflate_Hash(cur)];
+
+	for (; match && chain; chain--, match = s->Prev[match]) {
+		/* Quickly skip matches that can't be longer than the current best match */
+		if (input[match + bestLen] != cur[bestLen]) continue;
+		len = Deflate_MatchLen(&input[match], cur, maxLen);
+		if (len <= bestLen) continue;
+
+		bestLen = len;
+		*dist   = pos - match;
+		if (len >= cfg->niceLen || len == maxLen) break;
+	}
+	return *dist ? bestLen : 0;
+}
 
-	/* adjust hash table offsets, removing offsets that are no longer in data at all */
-	for (i = 0; i < Array_Elems(state->Head); i++) {
-		state->Head[i] = state->Head[i] < DEFLATE_BLOCK_SIZE ? 0 : (state->Head[i] - DEFLATE_BLOCK_SIZE);
+static void Deflate_AddLit(struct DeflateState* s, int lit) {
+	s->SymValues[s->NumSyms] = lit;
+	s->SymDists[s->NumSyms]  = 0;
+	s->NumSyms++;
+}
+
+static void Deflate_AddMatch(struct DeflateState* s, int len, int dist) {
+	s->SymValues[s->NumSyms] = len;
+	s->SymDists[s->NumSyms]  = dist;
+	s->NumSyms++;
+}
+
+/* Converts current block of data into symbols, using greedy or lazy matching */
+/* Based off descriptions from http://www.gzip.org/algorithm.txt */
+static void Deflate_ParseLazy(struct DeflateState* s, int len) {
+	const struct DeflateConfig* cfg = &deflate_configs[s->Level];
+	int pos = DEFLATE_BLOCK_SIZE, end = DEFLATE_BLOCK_SIZE + len;
+	int curLen = 0, curDist = 0, nextLen, nextDist, i;
+	cc_bool found = false;
+
+	while (pos < end) {
+		if (!found) curLen = Deflate_FindMatch(s, pos, end, &curDist);
+		Deflate_Insert(s, pos, end);
+		found = false;
+
+		/* Lazy evaluation: Find longest match starting at next byte */
+		/* If that's longer than the longest match at current byte, throwaway this match */
+		if (curLen && cfg->lazy && curLen < cfg->niceLen) {
+			nextLen = Deflate_FindMatch(s, pos + 1, end, &nextDist);
+
+			if (nextLen > curLen) {
+				Deflate_AddLit(s, s->Input[pos]);
+				curLen = nextLen; curDist = nextDist;
+				pos++; found = true;
+				continue;
+			}
+		}
+
+		if (curLen) {
+			Deflate_AddMatch(s, curLen, curDist);
+			for (i = 1; i < curLen; i++) { Deflate_Insert(s, pos + i, end); }
+			pos += curLen;
+		} else {
+			Deflate_AddLit(s, s->Input[pos]);
+			pos++;
+		}
 	}
-	for (i = 0; i < Array_Elems(state->Prev); i++) {
-		state->Prev[i] = state->Prev[i] < DEFLATE_BLOCK_SIZE ? 0 : (state->Prev[i] - DEFLATE_BLOCK_SIZE);
+}
+
+/* Converts current block of data into the symbols that are estimated to need the fewest bits */
+/* Since estimating the cost of every possible sequence of matches is far too slow, this instead */
+/*  considers every length (up to the longest match) at each position, and works backwards from */
+/*  the end of the data to find the sequence of literals and matches with the lowest total cost */
+static void Deflate_ParseOptimal(struct DeflateState* s, int len) {
+	cc_uint32 lenCosts[MAX_MATCH_LEN + 1];
+	cc_uint32 best, cost, distCost;
+	int beg, end = DEFLATE_BLOCK_SIZE + len;
+	int i, j, count, maxLen, choice, dist;
+
+	for (i = MIN_MATCH_LEN; i <= MAX_MATCH_LEN; i++) {
+		j = Deflate_LenCode(i);
+		lenCosts[i] = s->CostLits[257 + j] + len_bits[j];
+	}
+
+	/* Data is parsed in pieces, to limit the memory needed for the costs of each position */
+	for (beg = DEFLATE_BLOCK_SIZE; beg < end; beg += count) {
+		count = min(end - beg, DEFLATE_OPT_SIZE);
+
+		for (i = 0; i < count; i++) {
+			/* After a maximum length match, the rest of that match is almost certainly still the longest */
+			if (i && s->OptLens[i - 1] == MAX_MATCH_LEN) {
+				s->OptLens[i]  = s->OptLens[i - 1] - 1;
+				s->OptDists[i] = s->OptDists[i - 1];
+			} else {
+				s->OptLens[i]  = Deflate_FindMatch(s, beg + i, beg + count, &dist);
+				s->OptDists[i] = dist;
+			}
+			Deflate_Insert(s, beg + i, end);
+		}
+
+		s->OptCosts[count] = 0;
+		for (i = count - 1; i >= 0; i--) {
+			best   = s->CostLits[s->Input[beg + i]] + s->OptCosts[i + 1];
+			choice = 1;
+			maxLen = s->OptLens[i];
+
+			if (maxLen) {
+				j = Deflate_DistCode(s->OptDists[i]);
+				distCost = s->CostDists[j] + dist_bits[j];
+
+				/* Maximum length matches are always used in full, as otherwise runs are very slow */
+				j = maxLen == MAX_MATCH_LEN ? maxLen : MIN_MATCH_LEN;
+				for (; j <= maxLen; j++) {
+					cost = lenCosts[j] + distCost + s->OptCosts[i + j];
+					if (cost < best) { best = cost; choice = j; }
+				}
+			}
+			s->OptCosts[i] = best;
+			s->OptLens[i]  = choice;
+		}
+
+		for (i = 0; i < count; i += s->OptLens[i]) {
+			if (s->OptLens[i] == 1) {
+				Deflate_AddLit(s, s->Input[beg + i]);
+			} else {
+				Deflate_AddMatch(s, s->OptLens[i], s->OptDists[i]);
+			}
+		}
 	}
 }
 
-/* Compresses current block of data */
-static cc_result Deflate_FlushBlock(struct DeflateState* state, int len) {
-	cc_uint32 hash, nextHash;
-	int bestLen, maxLen, matchLen, depth;
-	int bestPos, pos, nextPos;
-	cc_uint16 oldHead;
-	cc_uint8* input;
-	cc_uint8* cur;
-	cc_result res;
 
-	if (!state->WroteHeader) {
-		state->WroteHeader = true;
-		Deflate_PushBits(state, 3, 3); /* final block TRUE, block type FIXED */
+/*########################################################################################################################*
+*--------------------------------------------------Deflate huffman codes--------------------------------------------------*
+*#########################################################################################################################*/
+enum DEFLATE_BLOCK_TYPE { DEFLATE_BLOCK_STORED, DEFLATE_BLOCK_FIXED, DEFLATE_BLOCK_DYNAMIC };
+static const cc_uint8 codelens_bits[3] = { 2, 3, 7 };
+
+/* Describes how a range of symbols is encoded in a block */
+struct DeflateBlock {
+	int Type, Offset, Bytes; /* Block type, and where in Input the block's data starts and ends */
+	cc_uint32 LitsFreqs[INFLATE_MAX_LITS];
+	cc_uint32 DistsFreqs[INFLATE_MAX_DISTS];
+	cc_uint32 CodeLensFreqs[INFLATE_MAX_CODELENS];
+
+	cc_uint16 LitsCodewords[INFLATE_MAX_LITS];
+	cc_uint8 LitsLens[INFLATE_MAX_LITS];
+	cc_uint16 DistsCodewords[INFLATE_MAX_DISTS];
+	cc_uint8 DistsLens[INFLATE_MAX_DISTS];
+	cc_uint16 CodeLensCodewords[INFLATE_MAX_CODELENS];
+	cc_uint8 CodeLensLens[INFLATE_MAX_CODELENS];
+	int NumLits, NumDists, NumCodeLens;
+
+	/* Run length encoded bit lengths of the lits and dists codewords */
+	cc_uint8 RLE[INFLATE_MAX_LITS_DISTS], RLEExtra[INFLATE_MAX_LITS_DISTS];
+	int NumRLE;
+};
+
+/* Constructs a huffman encoding table (for values to codewords) */
+static void Deflate_BuildTable(const cc_uint8* lens, int count, cc_uint16* codewords, cc_uint8* bitlens) {
+	int i, j, offset, codeword;
+	struct HuffmanTable table;
+
+	/* NOTE: Can ignore since lens table is not user controlled */
+	(void)Huffman_Build(&table, lens, count);
+	for (i = 0; i < INFLATE_MAX_BITS; i++) {
+		if (!table.EndCodewords[i]) continue;
+		count = table.EndCodewords[i] - table.FirstCodewords[i];
+
+		for (j = 0; j < count; j++) {
+			offset   = table.Values[table.FirstOffsets[i] + j];
+			codeword = table.FirstCodewords[i] + j;
+			bitlens[offset]   = i;
+			codewords[offset] = Huffman_ReverseBits(codeword, i);
+		}
+	}
+}
+
+/* Calculates the bit lengths of huffman codewords for the given frequencies of each value */
+/* Uses the in-place algorithm from "In-Place Calculation of Minimum-Redundancy Codes" (Moffat, Katajainen) */
+static void Deflate_CalcLengths(const cc_uint32* freqs, int count, int maxBits, cc_uint8* lens) {
+	int syms[INFLATE_MAX_LITS], A[INFLATE_MAX_LITS];
+	int numCodes[INFLATE_MAX_BITS] = { 0 };
+	int i, j, n = 0, root, leaf, next, avbl, used, depth;
+	cc_uint32 total;
+
+	Mem_Set(lens, 0, count);
+	/* Sort used values by ascending frequency */
+	for (i = 0; i < count; i++) {
+		if (!freqs[i]) continue;
+		for (j = n; j > 0 && freqs[syms[j - 1]] > freqs[i]; j--) { syms[j] = syms[j - 1]; }
+		syms[j] = i; n++;
+	}
+
+	/* Always use at least two codewords, as some decoders reject a tree with just one codeword */
+	if (n < 2) {
+		i = n ? syms[0] : 0;
+		lens[i] = 1; lens[i ? 0 : 1] = 1;
+		return;
+	}
+	for (i = 0; i < n; i++) { A[i] = freqs[syms[i]]; }
+
+	/* Work out the parent of each internal node */
+	A[0] += A[1]; root = 0; leaf = 2;
+	for (next = 1; next < n - 1; next++) {
+		if (leaf >= n || A[root] < A[leaf]) {
+			A[next] = A[root]; A[root++] = next;
+		} else { A[next] = A[leaf++]; }
+
+		if (leaf >= n || (root < next && A[root] < A[leaf])) {
+			A[next] += A[root]; A[root++] = next;
+		} else { A[next] += A[leaf++]; }
 	}
 
-	/* Based off descriptions from http://www.gzip.org/algorithm.txt and
-	https://github.com/nothings/stb/blob/master/stb_image_write.h */
-	input = state->Input;
-	cur   = input + DEFLATE_BLOCK_SIZE;
-
-	/* Compress current block of data */
-	/* Use > instead of >=, because also try match at one byte after current */
-	while (len > MIN_MATCH_LEN) {
-		hash   = Deflate_Hash(cur);
-		maxLen = min(len, MAX_MATCH_LEN);
-
-		bestLen = MIN_MATCH_LEN - 1; /* Match must be at least 3 bytes */
-		bestPos = 0;
-
-		/* Find longest match starting at this byte */
-		/* Only explore up to 5 previous matches, to avoid slow performance */
-		/* (i.e prefer quickly saving maps/screenshots to completely optimal filesize) */
-		pos = state->Head[hash];
-		for (depth = 0; pos != 0 && depth < 5; depth++) {
-			matchLen = Deflate_MatchLen(&input[pos], cur, maxLen);
-			if (matchLen > bestLen) { bestLen = matchLen; bestPos = pos; }
-			pos = state->Prev[pos];
+	/* Then the depth of each internal node */
+	A[n - 2] = 0;
+	for (next = n - 3; next >= 0; next--) { A[next] = A[A[next]] + 1; }
+
+	/* Then the depth of each leaf node */
+	avbl = 1; used = depth = 0; root = n - 2; next = n - 1;
+	while (avbl > 0) {
+		while (root >= 0 && A[root] == depth) { used++; root--; }
+		while (avbl > used) { A[next--] = depth; avbl--; }
+		avbl = 2 * used; depth++; used = 0;
+	}
+
+	/* Limit codewords to maxBits, then lengthen shorter codewords until the tree is valid again */
+	for (i = 0; i < n; i++) { numCodes[min(A[i], maxBits)]++; }
+	total = 0;
+	for (i = 1; i <= maxBits; i++) { total += (cc_uint32)numCodes[i] << (maxBits - i); }
+
+	for (; total > (1UL << maxBits); total--) {
+		numCodes[maxBits]--;
+		for (i = maxBits - 1; i > 0; i--) {
+			if (!numCodes[i]) continue;
+			numCodes[i]--; numCodes[i + 1] += 2;
+			break;
 		}
+	}
 
-		/* Insert this entry into the hash chain */
-		pos = (int)(cur - input);
-		oldHead = state->Head[hash];
-		state->Head[hash] = pos;
-		state->Prev[pos]  = oldHead;
+	/* Least frequent values get the longest codewords */
+	for (i = maxBits, j = 0; i > 0; i--) {
+		for (n = numCodes[i]; n > 0; n--) { lens[syms[j++]] = i; }
+	}
+}
 
-		/* Lazy evaluation: Find longest match starting at next byte */
-		/* If that's longer than the longest match at current byte, throwaway this match */
-		if (bestPos) {
-			nextHash = Deflate_Hash(cur + 1);
-			nextPos  = state->Head[nextHash];
-			maxLen   = min(len - 1, MAX_MATCH_LEN);
-
-			for (depth = 0; nextPos != 0 && depth < 5; depth++) {
-				matchLen = Deflate_MatchLen(&input[nextPos], cur + 1, maxLen);
-				if (matchLen > bestLen) { bestPos = 0; break; }
-				nextPos = state->Prev[nextPos];
-			}
+/* Counts how often each value is used by the given range of symbols */
+static void Deflate_CountSymbols(struct DeflateState* s, int beg, int end, struct DeflateBlock* b) {
+	int i, len, dist;
+	Mem_Set(b->LitsFreqs,  0, sizeof(b->LitsFreqs));
+	Mem_Set(b->DistsFreqs, 0, sizeof(b->DistsFreqs));
+	b->Bytes = 0;
+
+	for (i = beg; i < end; i++) {
+		len  = s->SymValues[i];
+		dist = s->SymDists[i];
+
+		if (dist) {
+			b->LitsFreqs[257 + Deflate_LenCode(len)]++;
+			b->DistsFreqs[Deflate_DistCode(dist)]++;
+			b->Bytes += len;
+		} else {
+			b->LitsFreqs[len]++;
+			b->Bytes++;
 		}
+	}
+	b->LitsFreqs[256] = 1; /* end of block */
+}
+
+static void Deflate_AddRLE(struct DeflateBlock* b, int value, int extra) {
+	b->RLE[b->NumRLE]      = value;
+	b->RLEExtra[b->NumRLE] = extra;
+	b->NumRLE++;
+	b->CodeLensFreqs[value]++;
+}
+
+/* Run length encodes the bit lengths of the lits and dists codewords */
+static void Deflate_EncodeLengths(struct DeflateBlock* b) {
+	cc_uint8 lens[INFLATE_MAX_LITS_DISTS];
+	int i, run, len, prev = -1, total;
+
+	for (b->NumLits = 286; b->NumLits > 257 && !b->LitsLens[b->NumLits - 1]; b->NumLits--) {}
+	for (b->NumDists = 30; b->NumDists > 1 && !b->DistsLens[b->NumDists - 1]; b->NumDists--) {}
 
-		if (bestPos) {
-			Deflate_LenDist(state, bestLen, pos - bestPos);
-			len -= bestLen; cur += bestLen;
+	Mem_Copy(lens, b->LitsLens, b->NumLits);
+	Mem_Copy(lens + b->NumLits, b->DistsLens, b->NumDists);
+	total = b->NumLits + b->NumDists;
+
+	Mem_Set(b->CodeLensFreqs, 0, sizeof(b->CodeLensFreqs));
+	b->NumRLE = 0;
+
+	for (i = 0; i < total; i += run, prev = len) {
+		len = lens[i];
+		for (run = 1; i + run < total && lens[i + run] == len; run++) {}
+
+		if (len == 0 && run >= 11) {
+			run = min(run, 138); Deflate_AddRLE(b, 18, run - 11);
+		} else if (len == 0 && run >= 3) {
+			run = min(run, 10);  Deflate_AddRLE(b, 17, run - 3);
+		} else if (len == prev && run >= 3) {
+			run = min(run, 6);   Deflate_AddRLE(b, 16, run - 3);
 		} else {
-			Deflate_Lit(state, *cur);
-			len--; cur++;
+			run = 1;             Deflate_AddRLE(b, len, 0);
 		}
+	}
+}
 
-		/* leave room for a few bytes and literals at end */
-		if (state->AvailOut >= 20) continue;
-		res = Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
-		state->NextOut  = state->Output;
-		state->AvailOut = DEFLATE_OUT_SIZE;
-		if (res) return res;
+/* Builds the dynamic huffman codes for the counted values */
+static void Deflate_BuildCodes(struct DeflateBlock* b) {
+	int i;
+	Deflate_CalcLengths(b->LitsFreqs,  INFLATE_MAX_LITS,  15, b->LitsLens);
+	Deflate_CalcLengths(b->DistsFreqs, INFLATE_MAX_DISTS, 15, b->DistsLens);
+	Deflate_EncodeLengths(b);
+	Deflate_CalcLengths(b->CodeLensFreqs, INFLATE_MAX_CODELENS, 7, b->CodeLensLens);
+
+	for (i = INFLATE_MAX_CODELENS; i > 4 && !b->CodeLensLens[codelens_order[i - 1]]; i--) {}
+	b->NumCodeLens = i;
+
+	Deflate_BuildTable(b->LitsLens,     INFLATE_MAX_LITS,     b->LitsCodewords,     b->LitsLens);
+	Deflate_BuildTable(b->DistsLens,    INFLATE_MAX_DISTS,    b->DistsCodewords,    b->DistsLens);
+	Deflate_BuildTable(b->CodeLensLens, INFLATE_MAX_CODELENS, b->CodeLensCodewords, b->CodeLensLens);
+}
+
+/* Works out the cheapest way of encoding the given range of symbols, returning the number of bits needed */
+static cc_uint32 Deflate_PlanBlock(struct DeflateState* s, int beg, int end, struct DeflateBlock* b) {
+	cc_uint32 extra = 0, dynamic, fixed, stored;
+	int i, value;
+
+	Deflate_CountSymbols(s, beg, end, b);
+	Deflate_BuildCodes(b);
+
+	for (i = 0; i < 29; i++) { extra += b->LitsFreqs[257 + i] * len_bits[i]; }
+	for (i = 0; i < 30; i++) { extra += b->DistsFreqs[i]      * dist_bits[i]; }
+	dynamic = 3 + 5 + 5 + 4 + 3 * b->NumCodeLens + extra;
+	fixed   = 3 + extra;
+	stored  = 3 + 7 + 32 + 8 * b->Bytes;
+
+	for (i = 0; i < b->NumRLE; i++) {
+		value    = b->RLE[i];
+		dynamic += b->CodeLensLens[value];
+		if (value >= 16) dynamic += codelens_bits[value - 16];
+	}
+	for (i = 0; i < INFLATE_MAX_LITS; i++) {
+		dynamic += b->LitsFreqs[i] * b->LitsLens[i];
+		fixed   += b->LitsFreqs[i] * s->LitsLens[i];
+	}
+	for (i = 0; i < INFLATE_MAX_DISTS; i++) {
+		dynamic += b->DistsFreqs[i] * b->DistsLens[i];
+		fixed   += b->DistsFreqs[i] * s->DistsLens[i];
 	}
 
-	/* literals for last few bytes */
-	while (len > 0) {
-		Deflate_Lit(state, *cur);
-		len--; cur++;
+	b->Type = DEFLATE_BLOCK_DYNAMIC;
+	if (fixed <= dynamic) { b->Type = DEFLATE_BLOCK_FIXED; dynamic = fixed; }
+	if (stored < dynamic) { b->Type = DEFLATE_BLOCK_STORED; dynamic = stored; }
+	return dynamic;
+}
+
+/* Updates the estimated bit costs used for optimal parsing, based on the codes used by the given block */
+static void Deflate_UpdateCosts(struct DeflateState* s, struct DeflateBlock* b) {
+	int i;
+	if (b->Type != DEFLATE_BLOCK_DYNAMIC) return;
+
+	/* Values not used in the previous block are probably rare, so assume a long codeword */
+	for (i = 0; i < INFLATE_MAX_LITS; i++) {
+		s->CostLits[i]  = b->LitsLens[i]  ? b->LitsLens[i]  : 12;
+	}
+	for (i = 0; i < INFLATE_MAX_DISTS; i++) {
+		s->CostDists[i] = b->DistsLens[i] ? b->DistsLens[i] : 12;
 	}
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------Deflate compression---------------------------------------------------*
+*#########################################################################################################################*/
+static void Deflate_WriteBits(struct DeflateState* state, cc_uint32 value, int bits) {
+	Deflate_PushBits(state, value, bits);
+	Deflate_FlushBits(state);
+}
+
+/* Writes data in output buffer to destination stream, if output buffer is nearly full */
+static cc_result Deflate_CheckOutput(struct DeflateState* state) {
+	cc_result res;
+	/* leave room for a few bytes and symbols at end */
+	if (state->AvailOut >= 20) return 0;
 
 	res = Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
 	state->NextOut  = state->Output;
 	state->AvailOut = DEFLATE_OUT_SIZE;
+	return res;
+}
+
+static cc_result Deflate_WriteStored(struct DeflateState* state, const cc_uint8* data, int len) {
+	cc_result res;
+	int count;
+
+	/* Stored blocks start on a byte boundary */
+	if (state->NumBits) Deflate_WriteBits(state, 0, 8 - state->NumBits);
+	Deflate_WriteBits(state, len,          16);
+	Deflate_WriteBits(state, len ^ 0xFFFF, 16);
+
+	while (len) {
+		if ((res = Deflate_CheckOutput(state))) return res;
+		count = min(len, (int)state->AvailOut);
+
+		Mem_Copy(state->NextOut, data, count);
+		state->NextOut  += count; state->AvailOut -= count;
+		data            += count; len             -= count;
+	}
+	return Deflate_CheckOutput(state);
+}
 
+static cc_result Deflate_WriteSymbols(struct DeflateState* state, int beg, int end, 
+								const cc_uint16* litsCodewords,  const cc_uint8* litsLens,
+								const cc_uint16* distsCodewords, const cc_uint8* distsLens) {
+	int i, j, value, dist;
+	cc_result res;
+
+	for (i = beg; i < end; i++) {
+		value = state->SymValues[i];
+		dist  = state->SymDists[i];
+
+		if (dist) {
+			j = Deflate_LenCode(value);
+			Deflate_WriteBits(state, litsCodewords[257 + j], litsLens[257 + j]);
+			Deflate_WriteBits(state, value - deflate_len[j], len_bits[j]);
+
+			j = Deflate_DistCode(dist);
+			Deflate_WriteBits(state, distsCodewords[j], distsLens[j]);
+			Deflate_WriteBits(state, dist - deflate_dist[j], dist_bits[j]);
+		} else {
+			Deflate_WriteBits(state, litsCodewords[value], litsLens[value]);
+		}
+		if ((res = Deflate_CheckOutput(state))) return res;
+	}
+
+	/* Write huffman encoded "literal 256" to terminate symbols */
+	Deflate_WriteBits(state, litsCodewords[256], litsLens[256]);
+	return Deflate_CheckOutput(state);
+}
+
+static cc_result Deflate_WriteBlock(struct DeflateState* state, int beg, int end, struct DeflateBlock* b, cc_bool final) {
+	int i, value;
+	cc_result res;
+	Deflate_WriteBits(state, final | (b->Type << 1), 3);
+
+	if (b->Type == DEFLATE_BLOCK_STORED) {
+		return Deflate_WriteStored(state, &state->Input[b->Offset], b->Bytes);
+	} else if (b->Type == DEFLATE_BLOCK_FIXED) {
+		return Deflate_WriteSymbols(state, beg, end, state->LitsCodewords, state->LitsLens, 
+									state->DistsCodewords, state->DistsLens);
+	}
+
+	Deflate_WriteBits(state, b->NumLits  - 257, 5);
+	Deflate_WriteBits(state, b->NumDists - 1,   5);
+	Deflate_WriteBits(state, b->NumCodeLens - 4, 4);
+	for (i = 0; i < b->NumCodeLens; i++) {
+		Deflate_WriteBits(state, b->CodeLensLens[codelens_order[i]], 3);
+		if ((res = Deflate_CheckOutput(state))) return res;
+	}
+
+	for (i = 0; i < b->NumRLE; i++) {
+		value = b->RLE[i];
+		Deflate_WriteBits(state, b->CodeLensCodewords[value], b->CodeLensLens[value]);
+		if (value >= 16) Deflate_WriteBits(state, b->RLEExtra[i], codelens_bits[value - 16]);
+		if ((res = Deflate_CheckOutput(state))) return res;
+	}
+	return Deflate_WriteSymbols(state, beg, end, b->LitsCodewords, b->LitsLens, 
+								b->DistsCodewords, b->DistsLens);
+}
+
+/* Moves "current block" to "previous block", adjusting state if needed. */
+static void Deflate_MoveBlock(struct DeflateState* state) {
+	int i, pos;
+	Mem_Copy(state->Input, state->Input + DEFLATE_BLOCK_SIZE, DEFLATE_BLOCK_SIZE);
+	state->InputPosition = DEFLATE_BLOCK_SIZE;
+
+	/* adjust hash table offsets, removing offsets that are no longer in data at all */
+	for (i = 0; i < Array_Elems(state->Head); i++) {
+		state->Head[i] = state->Head[i] < DEFLATE_BLOCK_SIZE ? 0 : (state->Head[i] - DEFLATE_BLOCK_SIZE);
+	}
+	for (i = 0; i < DEFLATE_BLOCK_SIZE; i++) {
+		pos = state->Prev[i + DEFLATE_BLOCK_SIZE];
+		state->Prev[i] = pos < DEFLATE_BLOCK_SIZE ? 0 : (pos - DEFLATE_BLOCK_SIZE);
+	}
+}
+
+/* Compresses current block of data */
+static cc_result Deflate_FlushBlock(struct DeflateState* state, int len, cc_bool final) {
+	struct DeflateBlock whole, first, second;
+	cc_uint32 cost, splitCost = Int32_MaxValue;
+	int mid, count;
+	cc_result res;
+
+	state->NumSyms = 0;
+	whole.Offset   = DEFLATE_BLOCK_SIZE;
+
+	if (state->Level == 0) {
+		whole.Type  = DEFLATE_BLOCK_STORED;
+		whole.Bytes = len;
+		res = Deflate_WriteBlock(state, 0, 0, &whole, final);
+	} else {
+		if (state->Level == 9) {
+			Deflate_ParseOptimal(state, len);
+		} else {
+			Deflate_ParseLazy(state, len);
+		}
+		count = state->NumSyms;
+		cost  = Deflate_PlanBlock(state, 0, count, &whole);
+
+		/* Splitting into two blocks with separate huffman codes may be smaller, */
+		/*  if the kind of data changes a lot partway through the block */
+		mid = count / 2;
+		if (mid >= DEFLATE_MIN_SPLIT) {
+			splitCost = Deflate_PlanBlock(state, 0, mid, &first) + Deflate_PlanBlock(state, mid, count, &second);
+			first.Offset  = DEFLATE_BLOCK_SIZE;
+			second.Offset = DEFLATE_BLOCK_SIZE + first.Bytes;
+		}
+
+		if (splitCost < cost) {
+			res = Deflate_WriteBlock(state, 0, mid, &first, false);
+			if (!res) res = Deflate_WriteBlock(state, mid, count, &second, final);
+			Deflate_UpdateCosts(state, &second);
+		} else {
+			res = Deflate_WriteBlock(state, 0, count, &whole, final);
+			Deflate_UpdateCosts(state, &whole);
+		}
+	}
+
+	if (res) return res;
 	Deflate_MoveBlock(state);
-	return res;
+	return 0;
 }
 
 /* Adds data to buffered output data, flushing if needed */
@@ -958,56 +1536,53 @@ static cc_result Deflate_StreamWrite(struct Stream* stream, const cc_uint8* data
 		data += len;
 
 		if (state->InputPosition == DEFLATE_BUFFER_SIZE) {
-			res = Deflate_FlushBlock(state, DEFLATE_BLOCK_SIZE);
+			res = Deflate_FlushBlock(state, DEFLATE_BLOCK_SIZE, false);
 			if (res) return res;
 		}
 	}
 	return 0;
 }
 
-/* Flushes any buffered data, then writes terminating symbol */
+/* Flushes any buffered data as the final block */
 static cc_result Deflate_StreamClose(struct Stream* stream) {
 	struct DeflateState* state;
 	cc_result res;
 
 	state = (struct DeflateState*)stream->Meta.Inflate;
-	res   = Deflate_FlushBlock(state, state->InputPosition - DEFLATE_BLOCK_SIZE);
+	res   = Deflate_FlushBlock(state, state->InputPosition - DEFLATE_BLOCK_SIZE, true);
 	if (res) return res;
 
-	/* Write huffman encoded "literal 256" to terminate symbols */
-	Deflate_PushLit(state, 256);
-	Deflate_FlushBits(state);
-
 	/* In case last byte still has a few extra bits */
-	if (state->NumBits) {
-		while (state->NumBits < 8) { Deflate_PushBits(state, 0, 1); }
-		Deflate_FlushBits(state);
-	}
-
+	if (state->NumBits) Deflate_WriteBits(state, 0, 8 - state->NumBits);
 	return Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
 }
 
-/* Constructs a huffman encoding table (for values to codewords) */
-static void Deflate_BuildTable(const cc_uint8* lens, int count, cc_uint16* codewords, cc_uint8* bitlens) {
-	int i, j, offset, codeword;
-	struct HuffmanTable table;
+/* Writes all compressed data so far, ending on a byte boundary without ending the DEFLATE stream */
+/* NOTE: Must only be called when no data is buffered (i.e. after writing a multiple of DEFLATE_BLOCK_SIZE bytes) */
+static cc_result Deflate_FlushAligned(struct DeflateState* state) {
+	cc_result res;
+	/* An empty stored block pads the output to a byte boundary */
+	Deflate_WriteBits(state, DEFLATE_BLOCK_STORED << 1, 3);
+	if ((res = Deflate_WriteStored(state, NULL, 0))) return res;
 
-	/* NOTE: Can ignore since lens table is not user controlled */
-	(void)Huffman_Build(&table, lens, count);
-	for (i = 0; i < INFLATE_MAX_BITS; i++) {
-		if (!table.EndCodewords[i]) continue;
-		count = table.EndCodewords[i] - table.FirstCodewords[i];
+	res = Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
+	state->NextOut  = state->Output;
+	state->AvailOut = DEFLATE_OUT_SIZE;
+	return res;
+}
 
-		for (j = 0; j < count; j++) {
-			offset   = table.Values[table.FirstOffsets[i] + j];
-			codeword = table.FirstCodewords[i] + j;
-			bitlens[offset]   = i;
-			codewords[offset] = Huffman_ReverseBits(codeword, i);
-		}
+/* Uses the end of the given data as the data preceding the data to compress, so matches can refer back to it */
+static void Deflate_SetDictionary(struct DeflateState* state, const cc_uint8* data, int len) {
+	int i, count = min(len, DEFLATE_BLOCK_SIZE);
+	int beg = DEFLATE_BLOCK_SIZE - count;
+
+	Mem_Copy(&state->Input[beg], data + (len - count), count);
+	for (i = beg; i < DEFLATE_BLOCK_SIZE; i++) {
+		Deflate_Insert(state, i, DEFLATE_BLOCK_SIZE);
 	}
 }
 
-void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struct Stream* underlying) {
+void Deflate_MakeStream2(struct Stream* stream, struct DeflateState* state, struct Stream* underlying, int level) {
 	Stream_Init(stream);
 	stream->Meta.Inflate = state;
 	stream->Write = Deflate_StreamWrite;
@@ -1021,11 +1596,20 @@ void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struc
 	state->NextOut  = state->Output;
 	state->AvailOut = DEFLATE_OUT_SIZE;
 	state->Dest     = underlying;
-	state->WroteHeader = false;
+	state->Level    = level < 0 ? 0 : (level > 9 ? 9 : level);
 
 	Mem_Set(state->Head, 0, sizeof(state->Head));
 	Mem_Set(state->Prev, 0, sizeof(state->Prev));
-	Deflate_BuildTable(fixed_lits, INFLATE_MAX_LITS, state->LitsCodewords, state->LitsLens);
+	Deflate_BuildTable(fixed_lits,  INFLATE_MAX_LITS,  state->LitsCodewords,  state->LitsLens);
+	Deflate_BuildTable(fixed_dists, INFLATE_MAX_DISTS, state->DistsCodewords, state->DistsLens);
+
+	/* Until the first block has been written, assume values are encoded with the fixed huffman codes */
+	Mem_Copy(state->CostLits,  state->LitsLens,  sizeof(state->CostLits));
+	Mem_Copy(state->CostDists, state->DistsLens, sizeof(state->CostDists));
+}
+
+void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struct Stream* underlying) {
+	Deflate_MakeStream2(stream, state, underlying, DEFLATE_DEFAULT_LEVEL);
 }
 
 
@@ -1045,15 +1629,8 @@ static cc_result GZip_StreamClose(struct Stream* stream) {
 
 static cc_result GZip_StreamWrite(struct Stream* stream, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
 	struct GZipState* state = (struct GZipState*)stream->Meta.Inflate;
-	cc_uint32 i, crc32 = state->Crc32;
 	state->Size += count;
-
-	/* TODO: Optimise this calculation */
-	for (i = 0; i < count; i++) {
-		crc32 = Utils_Crc32Table[(crc32 ^ data[i]) & 0xFF] ^ (crc32 >> 8);
-	}
-
-	state->Crc32 = crc32;
+	state->Crc32 = Utils_UpdateCRC32(state->Crc32, data, count);
 	return Deflate_StreamWrite(stream, data, count, modified);
 }
 
@@ -1067,14 +1644,184 @@ static cc_result GZip_StreamWriteFirst(struct Stream* stream, const cc_uint8* da
 	return GZip_StreamWrite(stream, data, count, modified);
 }
 
-void GZip_MakeStream(struct Stream* stream, struct GZipState* state, struct Stream* underlying) {
-	Deflate_MakeStream(stream, &state->Base, underlying);
+void GZip_MakeStream2(struct Stream* stream, struct GZipState* state, struct Stream* underlying, int level) {
+	Deflate_MakeStream2(stream, &state->Base, underlying, level);
 	state->Crc32  = 0xFFFFFFFFUL;
 	state->Size   = 0;
 	stream->Write = GZip_StreamWriteFirst;
 	stream->Close = GZip_StreamClose;
 }
 
+void GZip_MakeStream(struct Stream* stream, struct GZipState* state, struct Stream* underlying) {
+	GZip_MakeStream2(stream, state, underlying, DEFLATE_DEFAULT_LEVEL);
+}
+
+
+/*########################################################################################################################*
+*------------------------------------------------GZip (parallel compress)-------------------------------------------------*
+*#########################################################################################################################*/
+/* Data is split into blocks of this size, which are each compressed separately */
+/* NOTE: Must be a multiple of DEFLATE_BLOCK_SIZE, so no data is left buffered after compressing a block */
+#define PGZIP_BLOCK_SIZE (128 * 1024)
+/* Data that can't be compressed is written as stored blocks, which is slightly larger than the data */
+#define PGZIP_OUT_SIZE (PGZIP_BLOCK_SIZE + 1024)
+
+struct ParallelGZipBlock {
+	cc_uint8* Input;   /* Data to compress (preceded by the data before it) */
+	cc_uint8* Output;  /* Compressed DEFLATE data */
+	cc_uint32 InputLen, OutputLen, Crc32;
+	cc_result Result;
+};
+
+struct ParallelGZipState {
+	struct Stream* Dest;
+	int Level, NumBlocks, UsedBlocks;
+	cc_bool WroteHeader, HasDictionary, Final;
+	cc_uint32 Used;  /* Number of bytes buffered in Buffer */
+	cc_uint32 Crc32, Size;
+	/* Holds the data for every block in a batch, after the end of the previous batch's data */
+	cc_uint8* Buffer;
+	struct ParallelGZipBlock Blocks[WORKERS_MAX_COUNT];
+	struct DeflateState* States[WORKERS_MAX_COUNT];
+};
+static void ParallelGZip_CompressBlock(void* arg, int item, int worker) {
+	struct ParallelGZipState* s = (struct ParallelGZipState*)arg;
+	struct ParallelGZipBlock* b = &s->Blocks[item];
+	struct DeflateState* state  = s->States[worker];
+	struct Stream out, comp;
+	cc_result res;
+
+	Stream_WriteonlyMemory(&out, b->Output, PGZIP_OUT_SIZE);
+	Deflate_MakeStream2(&comp, state, &out, s->Level);
+	/* Prime with the data before this block, so matches can still refer back to it */
+	if (item || s->HasDictionary) {
+		Deflate_SetDictionary(state, b->Input - DEFLATE_BLOCK_SIZE, DEFLATE_BLOCK_SIZE);
+	}
+
+	res = Stream_Write(&comp, b->Input, b->InputLen);
+	if (!res) {
+		/* Only the very last block should end the DEFLATE stream */
+		res = s->Final && item == s->UsedBlocks - 1 ? comp.Close(&comp) : Deflate_FlushAligned(state);
+	}
+
+	b->Crc32     = Utils_CRC32(b->Input, b->InputLen);
+	b->OutputLen = PGZIP_OUT_SIZE - out.Meta.Mem.Left;
+	b->Result    = res;
+}
+
+/* Compresses all the buffered blocks across the worker threads, then writes them in order */
+static cc_result ParallelGZip_CompressBatch(struct ParallelGZipState* s, cc_bool final) {
+	static cc_uint8 header[10] = { 0x1F, 0x8B, 0x08 }; /* GZip header */
+	struct ParallelGZipBlock* b;
+	cc_uint8* data = s->Buffer + DEFLATE_BLOCK_SIZE;
+	cc_uint32 left = s->Used;
+	cc_result res;
+	int i;
+
+	if (!s->WroteHeader) {
+		s->WroteHeader = true;
+		if ((res = Stream_Write(s->Dest, header, sizeof(header)))) return res;
+	}
+
+	/* Even with no data, there must be a final block to end the DEFLATE stream */
+	s->UsedBlocks = max(1, (int)((left + PGZIP_BLOCK_SIZE - 1) / PGZIP_BLOCK_SIZE));
+	s->Final      = final;
+	for (i = 0; i < s->UsedBlocks; i++) {
+		b = &s->Blocks[i];
+		b->Input    = data + i * PGZIP_BLOCK_SIZE;
+		b->InputLen = min(left, PGZIP_BLOCK_SIZE);
+		left       -= b->InputLen;
+	}
+
+	Workers_RunWith(ParallelGZip_CompressBlock, s, s->UsedBlocks);
+
+	for (i = 0; i < s->UsedBlocks; i++) {
+		b = &s->Blocks[i];
+		if (b->Result) return b->Result;
+		if ((res = Stream_Write(s->Dest, b->Output, b->OutputLen))) return res;
+
+		s->Crc32 = Utils_CombineCRC32(s->Crc32, b->Crc32, b->InputLen);
+		s->Size += b->InputLen;
+	}
+
+	/* End of this batch is the dictionary for the first block of the next batch */
+	Mem_Copy(s->Buffer, s->Buffer + s->Used, DEFLATE_BLOCK_SIZE);
+	s->HasDictionary = true;
+	s->Used = 0;
+	return 0;
+}
+
+static cc_result ParallelGZip_StreamWrite(struct Stream* stream, const cc_uint8* data, cc_uint32 total, cc_uint32* modified) {
+	struct ParallelGZipState* s = (struct ParallelGZipState*)stream->Meta.Inflate;
+	cc_uint32 batchSize = s->NumBlocks * PGZIP_BLOCK_SIZE;
+	cc_uint32 len;
+	cc_result res;
+	*modified = 0;
+
+	while (total > 0) {
+		len = min(total, batchSize - s->Used);
+		Mem_Copy(s->Buffer + DEFLATE_BLOCK_SIZE + s->Used, data, len);
+
+		s->Used   += len; *modified += len;
+		data      += len; total     -= len;
+		if (s->Used < batchSize) continue;
+
+		if ((res = ParallelGZip_CompressBatch(s, false))) return res;
+	}
+	return 0;
+}
+
+static void ParallelGZip_Free(struct ParallelGZipState* s) {
+	int i;
+	for (i = 0; i < WORKERS_MAX_COUNT; i++) {
+		Mem_Free(s->Blocks[i].Output);
+		Mem_Free(s->States[i]);
+	}
+	Mem_Free(s->Buffer);
+	Mem_Free(s);
+}
+
+static cc_result ParallelGZip_StreamClose(struct Stream* stream) {
+	struct ParallelGZipState* s = (struct ParallelGZipState*)stream->Meta.Inflate;
+	cc_uint8 data[8];
+	cc_result res;
+
+	if (!(res = ParallelGZip_CompressBatch(s, true))) {
+		Stream_SetU32_LE(&data[0], s->Crc32);
+		Stream_SetU32_LE(&data[4], s->Size);
+		res = Stream_Write(s->Dest, data, sizeof(data));
+	}
+
+	ParallelGZip_Free(s);
+	return res;
+}
+
+cc_result GZip_MakeParallelStream(struct Stream* stream, struct Stream* underlying, int level) {
+	struct ParallelGZipState* s;
+	int i, count = Workers_Count;
+
+	s = (struct ParallelGZipState*)Mem_TryAllocCleared(1, sizeof(struct ParallelGZipState));
+	if (!s) return ERR_OUT_OF_MEMORY;
+	s->Buffer = (cc_uint8*)Mem_TryAlloc(DEFLATE_BLOCK_SIZE + count * PGZIP_BLOCK_SIZE, 1);
+	if (!s->Buffer) { ParallelGZip_Free(s); return ERR_OUT_OF_MEMORY; }
+
+	for (i = 0; i < count; i++) {
+		s->Blocks[i].Output = (cc_uint8*)Mem_TryAlloc(PGZIP_OUT_SIZE, 1);
+		s->States[i]        = (struct DeflateState*)Mem_TryAlloc(1, sizeof(struct DeflateState));
+		if (!s->Blocks[i].Output || !s->States[i]) { ParallelGZip_Free(s); return ERR_OUT_OF_MEMORY; }
+	}
+
+	Stream_Init(stream);
+	stream->Meta.Inflate = s;
+	stream->Write = ParallelGZip_StreamWrite;
+	stream->Close = ParallelGZip_StreamClose;
+
+	s->Dest      = underlying;
+	s->Level     = level;
+	s->NumBlocks = count;
+	return 0;
+}
+
 
 /*########################################################################################################################*
 *-----------------------------------------------------ZLib (compress)-----------------------------------------------------*
@@ -1091,37 +1838,36 @@ static cc_result ZLib_StreamClose(struct Stream* stream) {
 
 static cc_result ZLib_StreamWrite(struct Stream* stream, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
 	struct ZLibState* state = (struct ZLibState*)stream->Meta.Inflate;
-	cc_uint32 i, adler32 = state->Adler32;
-	cc_uint32 s1 = adler32 & 0xFFFF, s2 = (adler32 >> 16) & 0xFFFF;
-
-	/* TODO: Optimise this calculation */
-	for (i = 0; i < count; i++) {
-		#define ADLER32_BASE 65521
-		s1 = (s1 + data[i]) % ADLER32_BASE;
-		s2 = (s2 + s1)      % ADLER32_BASE;
-	}
-
-	state->Adler32 = (s2 << 16) | s1;
+	state->Adler32 = Utils_UpdateAdler32(state->Adler32, data, count);
 	return Deflate_StreamWrite(stream, data, count, modified);
 }
 
 static cc_result ZLib_StreamWriteFirst(struct Stream* stream, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
-	static cc_uint8 header[2] = { 0x78, 0x9C }; /* ZLib header */
 	struct ZLibState* state = (struct ZLibState*)stream->Meta.Inflate;
+	int level = state->Base.Level;
+	cc_uint8 header[2];
 	cc_result res;
 
+	/* ZLib header, with compression level hint */
+	header[0] = 0x78;
+	header[1] = level < 2 ? 0x01 : (level < 6 ? 0x5E : (level == 6 ? 0x9C : 0xDA));
+
 	if ((res = Stream_Write(state->Base.Dest, header, sizeof(header)))) return res;
 	stream->Write = ZLib_StreamWrite;
 	return ZLib_StreamWrite(stream, data, count, modified);
 }
 
-void ZLib_MakeStream(struct Stream* stream, struct ZLibState* state, struct Stream* underlying) {
-	Deflate_MakeStream(stream, &state->Base, underlying);
+void ZLib_MakeStream2(struct Stream* stream, struct ZLibState* state, struct Stream* underlying, int level) {
+	Deflate_MakeStream2(stream, &state->Base, underlying, level);
 	state->Adler32 = 1;
 	stream->Write = ZLib_StreamWriteFirst;
 	stream->Close = ZLib_StreamClose;
 }
 
+void ZLib_MakeStream(struct Stream* stream, struct ZLibState* state, struct Stream* underlying) {
+	ZLib_MakeStream2(stream, state, underlying, DEFLATE_DEFAULT_LEVEL);
+}
+
 
 /*########################################################################################################################*
 *--------------------------------------------------------ZipEntry---------------------------------------------------------*
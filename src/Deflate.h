@@ -28,6 +28,8 @@ cc_result ZLibHeader_Read(struct Stream* s, struct ZLibHeader* header);
 #define INFLATE_MAX_LITS_DISTS (INFLATE_MAX_LITS + INFLATE_MAX_DISTS)
 #define INFLATE_MAX_BITS 16
 #define INFLATE_FAST_BITS 9
+#define INFLATE_FASTLITS_BITS 10
+#define INFLATE_FASTDISTS_BITS 8
 #define INFLATE_WINDOW_SIZE 0x8000UL
 #define INFLATE_WINDOW_MASK 0x7FFFUL
 
@@ -42,7 +44,7 @@ struct HuffmanTable {
 struct InflateState {
 	cc_uint8 State;
 	cc_bool LastBlock; /* Whether the last DEFLATE block has been encounted in the stream */
-	cc_uint32 Bits;    /* Holds bits across byte boundaries */
+	cc_uint64 Bits;    /* Holds bits across byte boundaries */
 	cc_uint32 NumBits; /* Number of bits in Bits buffer */
 
 	cc_uint8* NextIn;   /* Pointer within Input buffer to next byte that can be read */
@@ -63,6 +65,8 @@ struct InflateState {
 		struct HuffmanTable Lits;           /* Values represent literal or lengths */
 	} Table; /* union to save on memory */
 	struct HuffmanTable TableDists;         /* Values represent distances back */
+	cc_uint32 FastLits[1 << INFLATE_FASTLITS_BITS];   /* Combined literal(s)/length lookup table for fast decoding */
+	cc_uint32 FastDists[1 << INFLATE_FASTDISTS_BITS]; /* Combined distance lookup table for fast decoding */
 	cc_uint8 Window[INFLATE_WINDOW_SIZE];    /* Holds circular buffer of recent output data, used for LZ77 */
 	cc_result result;
 };
@@ -81,8 +85,11 @@ CC_API void Inflate_MakeStream2(struct Stream* stream, struct InflateState* stat
 #define DEFLATE_BLOCK_SIZE  16384
 #define DEFLATE_BUFFER_SIZE 32768
 #define DEFLATE_OUT_SIZE 8192
-#define DEFLATE_HASH_SIZE 0x1000UL
-#define DEFLATE_HASH_MASK 0x0FFFUL
+#define DEFLATE_HASH_SIZE 0x8000UL
+#define DEFLATE_HASH_MASK 0x7FFFUL
+#define DEFLATE_OPT_SIZE 4096
+/* Compression level used when saving maps and screenshots */
+#define DEFLATE_DEFAULT_LEVEL 6
 struct DeflateState {
 	cc_uint32 Bits;         /* Holds bits across byte boundaries */
 	cc_uint32 NumBits;      /* Number of bits in Bits buffer */
@@ -91,29 +98,53 @@ struct DeflateState {
 	cc_uint8* NextOut;    /* Pointer within Output buffer to next byte that can be written */
 	cc_uint32 AvailOut;   /* Max number of bytes that can be written to Output buffer */
 	struct Stream* Dest; /* Destination that Output buffer is written to */
-
-	cc_uint16 LitsCodewords[INFLATE_MAX_LITS]; /* Codewords for each value */
-	cc_uint8 LitsLens[INFLATE_MAX_LITS];       /* Bit lengths of each codeword */
+	int Level;           /* Compression level, from 0 (stored) to 9 (optimal parsing) */
+
+	cc_uint16 LitsCodewords[INFLATE_MAX_LITS];   /* Fixed huffman codewords for each value */
+	cc_uint8 LitsLens[INFLATE_MAX_LITS];         /* Bit lengths of each fixed huffman codeword */
+	cc_uint16 DistsCodewords[INFLATE_MAX_DISTS]; /* Fixed huffman codewords for each distance */
+	cc_uint8 DistsLens[INFLATE_MAX_DISTS];       /* Bit lengths of each fixed huffman distance codeword */
+	cc_uint8 CostLits[INFLATE_MAX_LITS];   /* Estimated bit cost of each value (for optimal parsing) */
+	cc_uint8 CostDists[INFLATE_MAX_DISTS]; /* Estimated bit cost of each distance (for optimal parsing) */
 	
 	cc_uint8 Input[DEFLATE_BUFFER_SIZE];
 	cc_uint8 Output[DEFLATE_OUT_SIZE];
-	int Head[DEFLATE_HASH_SIZE];
-	int Prev[DEFLATE_BUFFER_SIZE];
-	cc_bool WroteHeader;
+	cc_uint16 Head[DEFLATE_HASH_SIZE];
+	cc_uint16 Prev[DEFLATE_BUFFER_SIZE];
+
+	int NumSyms; /* Number of symbols in the current block */
+	cc_uint16 SymValues[DEFLATE_BLOCK_SIZE]; /* Literal byte, or length of a match */
+	cc_uint16 SymDists[DEFLATE_BLOCK_SIZE];  /* 0 for a literal, otherwise distance of the match */
+	cc_uint32 OptCosts[DEFLATE_OPT_SIZE + 1];
+	cc_uint16 OptLens[DEFLATE_OPT_SIZE];
+	cc_uint16 OptDists[DEFLATE_OPT_SIZE];
 };
 /* Compresses input data using DEFLATE, then writes compressed output to another stream. Write only stream. */
 /* DEFLATE compression is pure compressed data, there is no header or footer. */
 CC_API void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struct Stream* underlying);
+/* Same as Deflate_MakeStream, but with the given compression level instead of DEFLATE_DEFAULT_LEVEL. */
+/* level ranges from 0 (no compression) to 9 (best but slowest compression) */
+/*  0 = stored blocks, 1-3 = greedy matching, 4-8 = lazy matching, 9 = optimal parsing */
+CC_API void Deflate_MakeStream2(struct Stream* stream, struct DeflateState* state, struct Stream* underlying, int level);
 
 struct GZipState { struct DeflateState Base; cc_uint32 Crc32, Size; };
 /* Compresses input data using GZIP, then writes compressed output to another stream. Write only stream. */
 /* GZIP compression is GZIP header, followed by DEFLATE compressed data, followed by GZIP footer. */
 CC_API void GZip_MakeStream(struct Stream* stream, struct GZipState* state, struct Stream* underlying);
+/* Same as GZip_MakeStream, but with the given compression level. (see Deflate_MakeStream2) */
+CC_API void GZip_MakeStream2(struct Stream* stream, struct GZipState* state, struct Stream* underlying, int level);
+/* Compresses input data using GZIP, then writes compressed output to another stream. Write only stream. */
+/* Data is split into blocks which are compressed in parallel across the worker threads. (see Workers.h) */
+/* NOTE: Returns ERR_OUT_OF_MEMORY when there isn't enough memory, in which case use GZip_MakeStream instead. */
+/* NOTE: Allocated memory is only freed when the stream is closed, so stream MUST always be closed. */
+CC_API cc_result GZip_MakeParallelStream(struct Stream* stream, struct Stream* underlying, int level);
 
 struct ZLibState { struct DeflateState Base; cc_uint32 Adler32; };
 /* Compresses input data using ZLIB, then writes compressed output to another stream. Write only stream. */
 /* ZLIB compression is ZLIB header, followed by DEFLATE compressed data, followed by ZLIB footer. */
 CC_API void ZLib_MakeStream(struct Stream* stream, struct ZLibState* state, struct Stream* underlying);
+/* Same as ZLib_MakeStream, but with the given compression level. (see Deflate_MakeStream2) */
+CC_API void ZLib_MakeStream2(struct Stream* stream, struct ZLibState* state, struct Stream* underlying, int level);
 
 /* Minimal data needed to describe an entry in a .zip archive. */
 struct ZipEntry { cc_uint32 CompressedSize, UncompressedSize, LocalHeaderOffset, CRC32; };
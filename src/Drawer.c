@@ -4,116 +4,140 @@
 #include "Graphics.h"
 struct _DrawerData Drawer;
 
-void Drawer_XMin(int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices) {
+void Drawer_XMin2(const struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices) {
 	struct VertexTextured* ptr = *vertices; struct VertexTextured v;
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = Drawer.MinBB.Z;
-	float u2 = (count - 1) + Drawer.MaxBB.Z * UV2_Scale;
-	float v1 = vOrigin + Drawer.MaxBB.Y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + Drawer.MinBB.Y * Atlas1D.InvTileSize * UV2_Scale;
+	float u1 = d->MinBB.Z;
+	float u2 = (count - 1) + d->MaxBB.Z * UV2_Scale;
+	float v1 = vOrigin + d->MaxBB.Y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + d->MinBB.Y * Atlas1D.InvTileSize * UV2_Scale;
 
-	if (Drawer.Tinted) col = PackedCol_Tint(col, Drawer.TintCol);
-	v.X = Drawer.X1; v.Col = col;
+	if (d->Tinted) col = PackedCol_Tint(col, d->TintCol);
+	v.X = d->X1; v.Col = col;
 
-	v.Y = Drawer.Y2; v.Z = Drawer.Z2 + (count - 1); v.U = u2; v.V = v1; *ptr++ = v;
-	v.Z = Drawer.Z1;							    v.U = u1;           *ptr++ = v;
-	v.Y = Drawer.Y1;										  v.V = v2; *ptr++ = v;
-	v.Z = Drawer.Z2 + (count - 1);                  v.U = u2;           *ptr++ = v;
+	v.Y = d->Y2; v.Z = d->Z2 + (count - 1); v.U = u2; v.V = v1; *ptr++ = v;
+	v.Z = d->Z1;							    v.U = u1;           *ptr++ = v;
+	v.Y = d->Y1;										  v.V = v2; *ptr++ = v;
+	v.Z = d->Z2 + (count - 1);                  v.U = u2;           *ptr++ = v;
 	*vertices = ptr;
 }
 
-void Drawer_XMax(int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices) {
+void Drawer_XMax2(const struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices) {
 	struct VertexTextured* ptr = *vertices; struct VertexTextured v;
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = (count - Drawer.MinBB.Z);
-	float u2 = (1 - Drawer.MaxBB.Z) * UV2_Scale;
-	float v1 = vOrigin + Drawer.MaxBB.Y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + Drawer.MinBB.Y * Atlas1D.InvTileSize * UV2_Scale;
+	float u1 = (count - d->MinBB.Z);
+	float u2 = (1 - d->MaxBB.Z) * UV2_Scale;
+	float v1 = vOrigin + d->MaxBB.Y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + d->MinBB.Y * Atlas1D.InvTileSize * UV2_Scale;
 
-	if (Drawer.Tinted) col = PackedCol_Tint(col, Drawer.TintCol);
-	v.X = Drawer.X2; v.Col = col;
+	if (d->Tinted) col = PackedCol_Tint(col, d->TintCol);
+	v.X = d->X2; v.Col = col;
 
-	v.Y = Drawer.Y2; v.Z = Drawer.Z1; v.U = u1; v.V = v1; *ptr++ = v;
-	v.Z = Drawer.Z2 + (count - 1);    v.U = u2;           *ptr++ = v;
-	v.Y = Drawer.Y1;                            v.V = v2; *ptr++ = v;
-	v.Z = Drawer.Z1;                  v.U = u1;           *ptr++ = v;
+	v.Y = d->Y2; v.Z = d->Z1; v.U = u1; v.V = v1; *ptr++ = v;
+	v.Z = d->Z2 + (count - 1);    v.U = u2;           *ptr++ = v;
+	v.Y = d->Y1;                            v.V = v2; *ptr++ = v;
+	v.Z = d->Z1;                  v.U = u1;           *ptr++ = v;
 	*vertices = ptr;
 }
 
-void Drawer_ZMin(int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices) {
+void Drawer_ZMin2(const struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices) {
 	struct VertexTextured* ptr = *vertices; struct VertexTextured v;
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = (count - Drawer.MinBB.X);
-	float u2 = (1 - Drawer.MaxBB.X) * UV2_Scale;
-	float v1 = vOrigin + Drawer.MaxBB.Y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + Drawer.MinBB.Y * Atlas1D.InvTileSize * UV2_Scale;
+	float u1 = (count - d->MinBB.X);
+	float u2 = (1 - d->MaxBB.X) * UV2_Scale;
+	float v1 = vOrigin + d->MaxBB.Y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + d->MinBB.Y * Atlas1D.InvTileSize * UV2_Scale;
 
-	if (Drawer.Tinted) col = PackedCol_Tint(col, Drawer.TintCol);
-	v.Z = Drawer.Z1; v.Col = col;
+	if (d->Tinted) col = PackedCol_Tint(col, d->TintCol);
+	v.Z = d->Z1; v.Col = col;
 
-	v.X = Drawer.X2 + (count - 1); v.Y = Drawer.Y1; v.U = u2; v.V = v2; *ptr++ = v;
-	v.X = Drawer.X1;                                v.U = u1;           *ptr++ = v;
-	v.Y = Drawer.Y2;                                          v.V = v1; *ptr++ = v;
-	v.X = Drawer.X2 + (count - 1);                  v.U = u2;           *ptr++ = v;
+	v.X = d->X2 + (count - 1); v.Y = d->Y1; v.U = u2; v.V = v2; *ptr++ = v;
+	v.X = d->X1;                                v.U = u1;           *ptr++ = v;
+	v.Y = d->Y2;                                          v.V = v1; *ptr++ = v;
+	v.X = d->X2 + (count - 1);                  v.U = u2;           *ptr++ = v;
 	*vertices = ptr;
 }
 
-void Drawer_ZMax(int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices) {
+void Drawer_ZMax2(const struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices) {
 	struct VertexTextured* ptr = *vertices; struct VertexTextured v;
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = Drawer.MinBB.X;
-	float u2 = (count - 1) + Drawer.MaxBB.X * UV2_Scale;
-	float v1 = vOrigin + Drawer.MaxBB.Y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + Drawer.MinBB.Y * Atlas1D.InvTileSize * UV2_Scale;
+	float u1 = d->MinBB.X;
+	float u2 = (count - 1) + d->MaxBB.X * UV2_Scale;
+	float v1 = vOrigin + d->MaxBB.Y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + d->MinBB.Y * Atlas1D.InvTileSize * UV2_Scale;
 
-	if (Drawer.Tinted) col = PackedCol_Tint(col, Drawer.TintCol);
-	v.Z = Drawer.Z2; v.Col = col;
+	if (d->Tinted) col = PackedCol_Tint(col, d->TintCol);
+	v.Z = d->Z2; v.Col = col;
 
-	v.X = Drawer.X2 + (count - 1); v.Y = Drawer.Y2; v.U = u2; v.V = v1; *ptr++ = v;
-	v.X = Drawer.X1;                                v.U = u1;           *ptr++ = v;
-	v.Y = Drawer.Y1;                                          v.V = v2; *ptr++ = v;
-	v.X = Drawer.X2 + (count - 1);                  v.U = u2;           *ptr++ = v;
+	v.X = d->X2 + (count - 1); v.Y = d->Y2; v.U = u2; v.V = v1; *ptr++ = v;
+	v.X = d->X1;                                v.U = u1;           *ptr++ = v;
+	v.Y = d->Y1;                                          v.V = v2; *ptr++ = v;
+	v.X = d->X2 + (count - 1);                  v.U = u2;           *ptr++ = v;
 	*vertices = ptr;
 }
 
-void Drawer_YMin(int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices) {
+void Drawer_YMin2(const struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices) {
 	struct VertexTextured* ptr = *vertices; struct VertexTextured v;
 
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
-	float u1 = Drawer.MinBB.X;
-	float u2 = (count - 1) + Drawer.MaxBB.X * UV2_Scale;
-	float v1 = vOrigin + Drawer.MinBB.Z * Atlas1D.InvTileSize;
-	float v2 = vOrigin + Drawer.MaxBB.Z * Atlas1D.InvTileSize * UV2_Scale;
-
-	if (Drawer.Tinted) col = PackedCol_Tint(col, Drawer.TintCol);
-	v.Y = Drawer.Y1; v.Col = col;
-
-	v.X = Drawer.X2 + (count - 1); v.Z = Drawer.Z2; v.U = u2; v.V = v2; *ptr++ = v;
-	v.X = Drawer.X1;                                v.U = u1;           *ptr++ = v;
-	v.Z = Drawer.Z1;                                          v.V = v1; *ptr++ = v;
-	v.X = Drawer.X2 + (count - 1);                  v.U = u2;           *ptr++ = v;
+	float u1 = d->MinBB.X;
+	float u2 = (count - 1) + d->MaxBB.X * UV2_Scale;
+	float v1 = vOrigin + d->MinBB.Z * Atlas1D.InvTileSize;
+	float v2 = vOrigin + d->MaxBB.Z * Atlas1D.InvTileSize * UV2_Scale;
+
+	if (d->Tinted) col = PackedCol_Tint(col, d->TintCol);
+	v.Y = d->Y1; v.Col = col;
+
+	v.X = d->X2 + (count - 1); v.Z = d->Z2; v.U = u2; v.V = v2; *ptr++ = v;
+	v.X = d->X1;                                v.U = u1;           *ptr++ = v;
+	v.Z = d->Z1;                                          v.V = v1; *ptr++ = v;
+	v.X = d->X2 + (count - 1);                  v.U = u2;           *ptr++ = v;
 	*vertices = ptr;
 }
 
-void Drawer_YMax(int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices) {
+void Drawer_YMax2(const struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices) {
 	struct VertexTextured* ptr = *vertices; struct VertexTextured v;
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = Drawer.MinBB.X;
-	float u2 = (count - 1) + Drawer.MaxBB.X * UV2_Scale;
-	float v1 = vOrigin + Drawer.MinBB.Z * Atlas1D.InvTileSize;
-	float v2 = vOrigin + Drawer.MaxBB.Z * Atlas1D.InvTileSize * UV2_Scale;
+	float u1 = d->MinBB.X;
+	float u2 = (count - 1) + d->MaxBB.X * UV2_Scale;
+	float v1 = vOrigin + d->MinBB.Z * Atlas1D.InvTileSize;
+	float v2 = vOrigin + d->MaxBB.Z * Atlas1D.InvTileSize * UV2_Scale;
 
-	if (Drawer.Tinted) col = PackedCol_Tint(col, Drawer.TintCol);
-	v.Y = Drawer.Y2; v.Col = col;
+	if (d->Tinted) col = PackedCol_Tint(col, d->TintCol);
+	v.Y = d->Y2; v.Col = col;
 
-	v.X = Drawer.X2 + (count - 1); v.Z = Drawer.Z1; v.U = u2; v.V = v1; *ptr++ = v;
-	v.X = Drawer.X1;                                v.U = u1;           *ptr++ = v;
-	v.Z = Drawer.Z2;                                          v.V = v2; *ptr++ = v;
-	v.X = Drawer.X2 + (count - 1);                  v.U = u2;           *ptr++ = v;
+	v.X = d->X2 + (count - 1); v.Z = d->Z1; v.U = u2; v.V = v1; *ptr++ = v;
+	v.X = d->X1;                                v.U = u1;           *ptr++ = v;
+	v.Z = d->Z2;                                          v.V = v2; *ptr++ = v;
+	v.X = d->X2 + (count - 1);                  v.U = u2;           *ptr++ = v;
 	*vertices = ptr;
 }
+
+void Drawer_XMin(int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices) {
+	Drawer_XMin2(&Drawer, count, col, texLoc, vertices);
+}
+
+void Drawer_XMax(int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices) {
+	Drawer_XMax2(&Drawer, count, col, texLoc, vertices);
+}
+
+void Drawer_ZMin(int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices) {
+	Drawer_ZMin2(&Drawer, count, col, texLoc, vertices);
+}
+
+void Drawer_ZMax(int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices) {
+	Drawer_ZMax2(&Drawer, count, col, texLoc, vertices);
+}
+
+void Drawer_YMin(int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices) {
+	Drawer_YMin2(&Drawer, count, col, texLoc, vertices);
+}
+
+void Drawer_YMax(int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices) {
+	Drawer_YMax2(&Drawer, count, col, texLoc, vertices);
+}
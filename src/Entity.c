@@ -320,15 +320,17 @@ void Entity_SetName(struct Entity* e, const cc_string* name) {
 *------------------------------------------------------Entity skins-------------------------------------------------------*
 *#########################################################################################################################*/
 static struct Entity* Entity_FirstOtherWithSameSkinAndFetchedSkin(struct Entity* except) {
+	const EntityID* ids;
 	struct Entity* e;
 	cc_string skin, eSkin;
-	int i;
+	int i, count;
 
 	skin = String_FromRawArray(except->SkinRaw);
-	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
-		if (!Entities.List[i] || Entities.List[i] == except) continue;
+	ids  = Entities_UNSAFE_GetIDs(&count);
+	for (i = 0; i < count; i++) {
+		e = Entities.List[ids[i]];
+		if (!e || e == except) continue;
 
-		e     = Entities.List[i];
 		eSkin = String_FromRawArray(e->SkinRaw);
 		if (e->SkinFetchState && String_Equals(&skin, &eSkin)) return e;
 	}
@@ -354,17 +356,19 @@ static void Entity_ResetSkin(struct Entity* e) {
 
 /* Copies or resets skin data for all entity with same skin */
 static void Entity_SetSkinAll(struct Entity* source, cc_bool reset) {
+	const EntityID* ids;
 	struct Entity* e;
 	cc_string skin, eSkin;
-	int i;
+	int i, count;
 
 	skin = String_FromRawArray(source->SkinRaw);
 	source->MobTextureId = Utils_IsUrlPrefix(&skin) ? source->TextureId : 0;
+	ids  = Entities_UNSAFE_GetIDs(&count);
 
-	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
-		if (!Entities.List[i]) continue;
+	for (i = 0; i < count; i++) {
+		e = Entities.List[ids[i]];
+		if (!e) continue;
 
-		e     = Entities.List[i];
 		eSkin = String_FromRawArray(e->SkinRaw);
 		if (!String_Equals(&skin, &eSkin)) continue;
 
@@ -504,12 +508,16 @@ static void Entity_CheckSkin(struct Entity* e) {
 
 /* Returns true if no other entities are sharing this skin texture */
 static cc_bool CanDeleteTexture(struct Entity* except) {
-	int i;
+	const EntityID* ids;
+	struct Entity* e;
+	int i, count;
 	if (!except->TextureId) return false;
+	ids = Entities_UNSAFE_GetIDs(&count);
 
-	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
-		if (!Entities.List[i] || Entities.List[i] == except)  continue;
-		if (Entities.List[i]->TextureId == except->TextureId) return false;
+	for (i = 0; i < count; i++) {
+		e = Entities.List[ids[i]];
+		if (!e || e == except) continue;
+		if (e->TextureId == except->TextureId) return false;
 	}
 	return true;
 }
@@ -540,23 +548,72 @@ void Entity_SetSkin(struct Entity* e, const cc_string* skin) {
 *#########################################################################################################################*/
 struct _EntitiesData Entities;
 static EntityID entities_closestId;
+/* IDs of the entities in Entities.List, so that empty slots are never iterated over */
+static EntityID entities_ids[ENTITIES_MAX_COUNT];
+static int entities_count;
+/* Index of each entity's ID in entities_ids plus 1, or 0 if not in entities_ids */
+static cc_uint16 entities_index[ENTITIES_MAX_COUNT];
+
+static void NetPlayers_Release(struct Entity* e);
+static void NetPlayers_FreePool(void);
+
+static void Entities_Track(EntityID id) {
+	if (entities_index[id]) return;
+	entities_ids[entities_count++] = id;
+	entities_index[id] = entities_count;
+}
+
+static void Entities_Untrack(EntityID id) {
+	int i = entities_index[id] - 1;
+	if (i < 0) return;
+
+	/* Move the last ID into the now empty slot */
+	entities_count--;
+	entities_ids[i] = entities_ids[entities_count];
+	entities_index[entities_ids[i]] = i + 1;
+	entities_index[id] = 0;
+}
+
+/* Entities with classic IDs can be directly assigned to Entities.List (e.g. by plugins), */
+/*  so those IDs are rechecked every tick. (this doesn't depend on ENTITIES_MAX_COUNT) */
+static void Entities_CheckClassicIDs(void) {
+	int id;
+	for (id = 0; id < ENTITIES_CLASSIC_COUNT; id++) {
+		if (Entities.List[id]) {
+			Entities_Track((EntityID)id);
+		} else {
+			Entities_Untrack((EntityID)id);
+		}
+	}
+}
+
+const EntityID* Entities_UNSAFE_GetIDs(int* count) {
+	*count = entities_count;
+	return entities_ids;
+}
 
 void Entities_Tick(struct ScheduledTask* task) {
+	struct Entity* e;
 	int i;
-	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
-		if (!Entities.List[i]) continue;
-		Entities.List[i]->VTABLE->Tick(Entities.List[i], task->interval);
+	Entities_CheckClassicIDs();
+
+	for (i = 0; i < entities_count; i++) {
+		e = Entities.List[entities_ids[i]];
+		if (!e) continue;
+		e->VTABLE->Tick(e, task->interval);
 	}
 }
 
 void Entities_RenderModels(double delta, float t) {
+	struct Entity* e;
 	int i;
 	Gfx_SetTexturing(true);
 	Gfx_SetAlphaTest(true);
-	
-	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
-		if (!Entities.List[i]) continue;
-		Entities.List[i]->VTABLE->RenderModel(Entities.List[i], delta, t);
+
+	for (i = 0; i < entities_count; i++) {
+		e = Entities.List[entities_ids[i]];
+		if (!e) continue;
+		e->VTABLE->RenderModel(e, delta, t);
 	}
 	Gfx_SetTexturing(false);
 	Gfx_SetAlphaTest(false);
@@ -566,7 +623,7 @@ void Entities_RenderModels(double delta, float t) {
 void Entities_RenderNames(void) {
 	struct LocalPlayer* p = &LocalPlayer_Instance;
 	cc_bool hadFog;
-	int i;
+	int i, id;
 
 	if (Entities.NamesMode == NAME_MODE_NONE) return;
 	entities_closestId = Entities_GetClosest(&p->Base);
@@ -577,10 +634,11 @@ void Entities_RenderNames(void) {
 	hadFog = Gfx_GetFog();
 	if (hadFog) Gfx_SetFog(false);
 
-	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
-		if (!Entities.List[i]) continue;
-		if (i != entities_closestId || i == ENTITIES_SELF_ID) {
-			Entities.List[i]->VTABLE->RenderName(Entities.List[i]);
+	for (i = 0; i < entities_count; i++) {
+		id = entities_ids[i];
+		if (!Entities.List[id]) continue;
+		if (id != entities_closestId || id == ENTITIES_SELF_ID) {
+			Entities.List[id]->VTABLE->RenderName(Entities.List[id]);
 		}
 	}
 
@@ -592,7 +650,7 @@ void Entities_RenderNames(void) {
 void Entities_RenderHoveredNames(void) {
 	struct LocalPlayer* p = &LocalPlayer_Instance;
 	cc_bool allNames, hadFog;
-	int i;
+	int i, id;
 
 	if (Entities.NamesMode == NAME_MODE_NONE) return;
 	allNames = !(Entities.NamesMode == NAME_MODE_HOVERED || Entities.NamesMode == NAME_MODE_ALL) 
@@ -604,10 +662,11 @@ void Entities_RenderHoveredNames(void) {
 	hadFog = Gfx_GetFog();
 	if (hadFog) Gfx_SetFog(false);
 
-	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
-		if (!Entities.List[i]) continue;
-		if ((i == entities_closestId || allNames) && i != ENTITIES_SELF_ID) {
-			Entities.List[i]->VTABLE->RenderName(Entities.List[i]);
+	for (i = 0; i < entities_count; i++) {
+		id = entities_ids[i];
+		if (!Entities.List[id]) continue;
+		if ((id == entities_closestId || allNames) && id != ENTITIES_SELF_ID) {
+			Entities.List[id]->VTABLE->RenderName(Entities.List[id]);
 		}
 	}
 
@@ -620,34 +679,46 @@ void Entities_RenderHoveredNames(void) {
 static void Entity_ContextLost(struct Entity* e) { DeleteNameTex(e); }
 
 static void Entities_ContextLost(void* obj) {
+	struct Entity* e;
 	int i;
-	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
-		if (!Entities.List[i]) continue;
-		Entity_ContextLost(Entities.List[i]);
+	for (i = 0; i < entities_count; i++) {
+		e = Entities.List[entities_ids[i]];
+		if (e) Entity_ContextLost(e);
 	}
 	Gfx_DeleteTexture(&ShadowComponent_ShadowTex);
 
 	if (Gfx.ManagedTextures) return;
-	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
-		if (!Entities.List[i]) continue;
-		DeleteSkin(Entities.List[i]);
+	for (i = 0; i < entities_count; i++) {
+		e = Entities.List[entities_ids[i]];
+		if (e) DeleteSkin(e);
 	}
 }
 /* No OnContextCreated, names/skin textures remade when needed */
 
 static void Entities_ChatFontChanged(void* obj) {
+	struct Entity* e;
 	int i;
-	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
-		if (!Entities.List[i]) continue;
-		DeleteNameTex(Entities.List[i]);
+	for (i = 0; i < entities_count; i++) {
+		e = Entities.List[entities_ids[i]];
 		/* name redraw is deferred until rendered */
+		if (e) DeleteNameTex(e);
 	}
 }
 
+void Entities_Add(EntityID id, struct Entity* e) {
+	Entities.List[id] = e;
+	Entities_Track(id);
+	Event_RaiseInt(&EntityEvents.Added, id);
+}
+
 void Entities_Remove(EntityID id) {
+	struct Entity* e = Entities.List[id];
 	Event_RaiseInt(&EntityEvents.Removed, id);
-	Entities.List[id]->VTABLE->Despawn(Entities.List[id]);
+	e->VTABLE->Despawn(e);
+
 	Entities.List[id] = NULL;
+	Entities_Untrack(id);
+	NetPlayers_Release(e);
 }
 
 EntityID Entities_GetClosest(struct Entity* src) {
@@ -656,22 +727,27 @@ EntityID Entities_GetClosest(struct Entity* src) {
 	float closestDist = MATH_POS_INF;
 	EntityID targetId = ENTITIES_SELF_ID;
 
+	struct Entity* entity;
 	float t0, t1;
-	int i;
+	int i, id;
 
-	for (i = 0; i < ENTITIES_SELF_ID; i++) { /* because we don't want to pick against local player */
-		struct Entity* entity = Entities.List[i];
+	for (i = 0; i < entities_count; i++) {
+		id = entities_ids[i];
+		/* because we don't want to pick against local player */
+		if (id == ENTITIES_SELF_ID) continue;
+		entity = Entities.List[id];
 		if (!entity) continue;
 
 		if (Intersection_RayIntersectsRotatedBox(eyePos, dir, entity, &t0, &t1) && t0 < closestDist) {
 			closestDist = t0;
-			targetId = (EntityID)i;
+			targetId = (EntityID)id;
 		}
 	}
 	return targetId;
 }
 
 void Entities_DrawShadows(void) {
+	struct Entity* e;
 	int i;
 	if (Entities.ShadowsMode == SHADOW_MODE_NONE) return;
 	ShadowComponent_BoundShadowTex = false;
@@ -685,9 +761,12 @@ void Entities_DrawShadows(void) {
 	ShadowComponent_Draw(Entities.List[ENTITIES_SELF_ID]);
 
 	if (Entities.ShadowsMode == SHADOW_MODE_CIRCLE_ALL) {	
-		for (i = 0; i < ENTITIES_SELF_ID; i++) {
-			if (!Entities.List[i] || !Entities.List[i]->ShouldRender) continue;
-			ShadowComponent_Draw(Entities.List[i]);
+		for (i = 0; i < entities_count; i++) {
+			if (entities_ids[i] == ENTITIES_SELF_ID) continue;
+			e = Entities.List[entities_ids[i]];
+
+			if (!e || !e->ShouldRender) continue;
+			ShadowComponent_Draw(e);
 		}
 	}
 
@@ -702,10 +781,13 @@ void Entities_DrawShadows(void) {
 *--------------------------------------------------------TabList----------------------------------------------------------*
 *#########################################################################################################################*/
 struct _TabListData TabList;
+/* ID of each entry in the names buffer, in the same order as the buffer */
+static EntityID tablist_owners[TABLIST_MAX_NAMES];
 
 /* Removes the names from the names buffer for the given id. */
 static void TabList_Delete(EntityID id) {
-	int i, index;
+	int i, index, count;
+	EntityID owner;
 	index = TabList.NameOffsets[id];
 	if (!index) return;
 
@@ -713,9 +795,12 @@ static void TabList_Delete(EntityID id) {
 	StringsBuffer_Remove(&TabList._buffer, index - 2);
 	StringsBuffer_Remove(&TabList._buffer, index - 3);
 
-	/* Indices after this entry need to be shifted down */
-	for (i = 0; i < TABLIST_MAX_NAMES; i++) {
-		if (TabList.NameOffsets[i] > index) TabList.NameOffsets[i] -= 3;
+	/* Indices of the entries after this entry need to be shifted down */
+	count = TabList._buffer.count / 3;
+	for (i = index / 3; i <= count; i++) {
+		owner = tablist_owners[i];
+		tablist_owners[i - 1] = owner;
+		TabList.NameOffsets[owner] -= 3;
 	}
 }
 
@@ -753,6 +838,7 @@ void TabList_Set(EntityID id, const cc_string* player, const cc_string* list, co
 
 	TabList.NameOffsets[id] = TabList._buffer.count;
 	TabList.GroupRanks[id]  = rank;
+	tablist_owners[TabList._buffer.count / 3 - 1] = id;
 	Event_RaiseInt(events, id);
 }
 
@@ -1144,9 +1230,12 @@ static void NetPlayer_RenderModel(struct Entity* e, double deltaTime, float t) {
 	Vec3_Lerp(&e->Position, &p->Interp.Prev.Pos, &p->Interp.Next.Pos, t);
 	InterpComp_LerpAngles((struct InterpComp*)(&p->Interp), e, t);
 
-	AnimatedComp_GetCurrent(e, t);
+	/* Culling only depends on position, so animation is only calculated for visible players */
 	p->Base.ShouldRender = Model_ShouldRender(e);
-	if (p->Base.ShouldRender) Model_Render(e->Model, e);
+	if (!p->Base.ShouldRender) return;
+
+	AnimatedComp_GetCurrent(e, t);
+	Model_Render(e->Model, e);
 }
 
 static void NetPlayer_RenderName(struct Entity* e) {
@@ -1170,6 +1259,60 @@ void NetPlayer_Init(struct NetPlayer* p) {
 	p->Base.VTABLE = &netPlayer_VTABLE;
 }
 
+/* NetPlayers for IDs outside NetPlayers_List are allocated in blocks of this many */
+#define NETPLAYERS_BLOCK_SIZE 64
+#define NETPLAYERS_MAX_BLOCKS (ENTITIES_MAX_COUNT / NETPLAYERS_BLOCK_SIZE)
+static struct NetPlayer* netPlayers_blocks[NETPLAYERS_MAX_BLOCKS];
+static int netPlayers_blocksCount;
+/* Indices of the pooled NetPlayers which aren't currently used */
+static cc_uint16 netPlayers_free[NETPLAYERS_MAX_BLOCKS * NETPLAYERS_BLOCK_SIZE];
+static int netPlayers_freeCount;
+
+static void NetPlayers_AllocBlock(void) {
+	int i, base = netPlayers_blocksCount * NETPLAYERS_BLOCK_SIZE;
+	if (netPlayers_blocksCount == NETPLAYERS_MAX_BLOCKS) Logger_Abort("Too many pooled NetPlayers");
+
+	netPlayers_blocks[netPlayers_blocksCount++] = (struct NetPlayer*)Mem_Alloc(NETPLAYERS_BLOCK_SIZE,
+													sizeof(struct NetPlayer), "NetPlayers block");
+	/* Add in reverse, so the players at the start of the block are used first */
+	for (i = NETPLAYERS_BLOCK_SIZE - 1; i >= 0; i--) {
+		netPlayers_free[netPlayers_freeCount++] = base + i;
+	}
+}
+
+struct NetPlayer* NetPlayers_Alloc(EntityID id) {
+	int index;
+	if (id < ENTITIES_SELF_ID) return &NetPlayers_List[id];
+
+	if (!netPlayers_freeCount) NetPlayers_AllocBlock();
+	index = netPlayers_free[--netPlayers_freeCount];
+	return &netPlayers_blocks[index / NETPLAYERS_BLOCK_SIZE][index % NETPLAYERS_BLOCK_SIZE];
+}
+
+/* Returns the given entity to the pool, if it is a pooled NetPlayer */
+static void NetPlayers_Release(struct Entity* e) {
+	struct NetPlayer* p = (struct NetPlayer*)e;
+	struct NetPlayer* block;
+	int i;
+
+	for (i = 0; i < netPlayers_blocksCount; i++) {
+		block = netPlayers_blocks[i];
+		if (p < block || p >= block + NETPLAYERS_BLOCK_SIZE) continue;
+
+		netPlayers_free[netPlayers_freeCount++] = i * NETPLAYERS_BLOCK_SIZE + (int)(p - block);
+		return;
+	}
+}
+
+static void NetPlayers_FreePool(void) {
+	int i;
+	for (i = 0; i < netPlayers_blocksCount; i++) {
+		Mem_Free(netPlayers_blocks[i]);
+	}
+	netPlayers_blocksCount = 0;
+	netPlayers_freeCount   = 0;
+}
+
 
 /*########################################################################################################################*
 *---------------------------------------------------Entities component----------------------------------------------------*
@@ -1189,15 +1332,18 @@ static void Entities_Init(void) {
 	if (Game_ClassicMode) Entities.ShadowsMode = SHADOW_MODE_NONE;
 
 	Entities.List[ENTITIES_SELF_ID] = &LocalPlayer_Instance.Base;
+	Entities_Track(ENTITIES_SELF_ID);
 	LocalPlayer_Init();
 }
 
 static void Entities_Free(void) {
-	int i;
-	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
-		if (!Entities.List[i]) continue;
-		Entities_Remove((EntityID)i);
+	Entities_CheckClassicIDs();
+	/* Entities_Remove moves the last ID into the removed ID's slot */
+	while (entities_count) {
+		Entities_Remove(entities_ids[entities_count - 1]);
 	}
+
+	NetPlayers_FreePool();
 	Gfx_DeleteTexture(&ShadowComponent_ShadowTex);
 }
 
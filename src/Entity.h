@@ -16,7 +16,10 @@ extern struct IGameComponent Entities_Component;
 
 /* Offset used to avoid floating point roundoff errors. */
 #define ENTITY_ADJUSTMENT 0.001f
-#define ENTITIES_MAX_COUNT 256
+/* Max number of entities, when the server supports extended entity IDs. */
+#define ENTITIES_MAX_COUNT 8192
+/* Number of entity IDs in the original classic protocol. */
+#define ENTITIES_CLASSIC_COUNT 256
 #define ENTITIES_SELF_ID 255
 
 enum NameMode {
@@ -130,6 +133,7 @@ void Entity_SetSkin(struct Entity* e, const cc_string* skin);
 
 /* Global data for all entities */
 /* (Actual entities may point to NetPlayers_List or elsewhere) */
+/* NOTE: Entities with IDs above ENTITIES_CLASSIC_COUNT must be added with Entities_Add */
 CC_VAR extern struct _EntitiesData {
 	struct Entity* List[ENTITIES_MAX_COUNT];
 	cc_uint8 NamesMode, ShadowsMode;
@@ -143,14 +147,19 @@ void Entities_RenderModels(double delta, float t);
 void Entities_RenderNames(void);
 /* Renders hovered entity name tags. (these appears through blocks) */
 void Entities_RenderHoveredNames(void);
+/* Adds the given entity, raising EntityEvents.Added event. */
+CC_API void Entities_Add(EntityID id, struct Entity* e);
 /* Removes the given entity, raising EntityEvents.Removed event. */
 void Entities_Remove(EntityID id);
+/* Returns the IDs of all existing entities. (in no particular order) */
+/* NOTE: Only valid until an entity is added or removed */
+const EntityID* Entities_UNSAFE_GetIDs(int* count);
 /* Gets the ID of the closest entity to the given entity. */
 EntityID Entities_GetClosest(struct Entity* src);
 /* Draws shadows under entities, depending on Entities.ShadowsMode */
 void Entities_DrawShadows(void);
 
-#define TABLIST_MAX_NAMES 256
+#define TABLIST_MAX_NAMES ENTITIES_MAX_COUNT
 /* Data for all entries in tab list */
 CC_VAR extern struct _TabListData {
 	/* Buffer indices for player/list/group names. */
@@ -182,6 +191,9 @@ struct NetPlayer {
 };
 CC_API void NetPlayer_Init(struct NetPlayer* player);
 extern struct NetPlayer NetPlayers_List[ENTITIES_SELF_ID];
+/* Returns the NetPlayer to use for the entity with the given ID. */
+/* NOTE: IDs outside NetPlayers_List use NetPlayers from a pool, which Entities_Remove returns them to */
+struct NetPlayer* NetPlayers_Alloc(EntityID id);
 
 struct LocalPlayerInput;
 struct LocalPlayerInput {
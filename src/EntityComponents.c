@@ -287,10 +287,11 @@ float HacksComp_CalcSpeedFactor(struct HacksComp* hacks, cc_bool canSpeed) {
 *#########################################################################################################################*/
 static void InterpComp_RemoveOldestRotY(struct InterpComp* interp) {
 	int i;
-	for (i = 0; i < Array_Elems(interp->RotYStates); i++) {
+	interp->RotYCount--;
+	/* Only need to move down states that are actually in use */
+	for (i = 0; i < interp->RotYCount; i++) {
 		interp->RotYStates[i] = interp->RotYStates[i + 1];
 	}
-	interp->RotYCount--;
 }
 
 static void InterpComp_AddRotY(struct InterpComp* interp, float state) {
@@ -333,10 +334,11 @@ static void InterpComp_SetPos(struct InterpState* state, struct LocationUpdate*
 *#########################################################################################################################*/
 static void NetInterpComp_RemoveOldestState(struct NetInterpComp* interp) {
 	int i;
-	for (i = 0; i < Array_Elems(interp->States); i++) {
+	interp->StatesCount--;
+	/* Only need to move down states that are actually in use */
+	for (i = 0; i < interp->StatesCount; i++) {
 		interp->States[i] = interp->States[i + 1];
 	}
-	interp->StatesCount--;
 }
 
 static void NetInterpComp_AddState(struct NetInterpComp* interp, struct InterpState state) {
@@ -1201,15 +1203,17 @@ float PhysicsComp_CalcJumpVelocity(float jumpHeight) {
 }
 
 void PhysicsComp_DoEntityPush(struct Entity* entity) {
+	const EntityID* ids;
 	struct Entity* other;
 	cc_bool yIntersects;
 	Vec3 dir;
 	float dist, pushStrength;
-	int id;
+	int i, count;
 	dir.Y = 0.0f;
+	ids   = Entities_UNSAFE_GetIDs(&count);
 
-	for (id = 0; id < ENTITIES_MAX_COUNT; id++) {
-		other = Entities.List[id];
+	for (i = 0; i < count; i++) {
+		other = Entities.List[ids[i]];
 		if (!other || other == entity) continue;
 		if (!other->Model->pushes)     continue;
 
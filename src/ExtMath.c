@@ -129,6 +129,22 @@ int Random_Next(RNGState* seed, int n) {
 	return val;
 }
 
+void Random_Skip(RNGState* seed, cc_uint64 steps) {
+	/* Each step is seed = seed * mul + add, so combine steps by repeated squaring */
+	cc_uint64 mul = RND_VALUE, add = 0xBLL;
+	cc_uint64 totalMul = 1, totalAdd = 0;
+
+	for (; steps; steps >>= 1) {
+		if (steps & 1) {
+			totalMul = (totalMul * mul) & RND_MASK;
+			totalAdd = (totalAdd * mul + add) & RND_MASK;
+		}
+		add = ((mul + 1) * add) & RND_MASK;
+		mul = (mul * mul) & RND_MASK;
+	}
+	*seed = (*seed * totalMul + totalAdd) & RND_MASK;
+}
+
 float Random_Float(RNGState* seed) {
 	int raw;
 
@@ -65,6 +65,9 @@ CC_API void Random_Seed(RNGState* rnd, int seed);
 CC_API int Random_Next(RNGState* rnd, int n);
 /* Returns real from 0 inclusive to 1 exclusive */
 CC_API float Random_Float(RNGState* rnd);
+/* Advances the RNG as if Random_Float had been called the given number of times. */
+/* NOTE: Random_Next can very rarely use more than one step, so callers must allow for that. */
+CC_API void Random_Skip(RNGState* rnd, cc_uint64 steps);
 /* Returns integer from min inclusive to max exclusive */
 static CC_INLINE int Random_Range(RNGState* rnd, int min, int max) {
 	return min + Random_Next(rnd, max - min);
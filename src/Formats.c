@@ -499,6 +499,21 @@ static BlockRaw* Cw_GetBlocks(struct NbtTag* tag) {
 	return ptr;
 }
 
+#ifdef EXTENDED_BLOCKS
+static void Cw_SetUpper(struct NbtTag* tag) {
+	BlockRaw* blocks = Cw_GetBlocks(tag);
+	BlockRaw* upper;
+	int count = tag->dataSize;
+
+	upper = (BlockRaw*)Mem_AllocCleared(World_UpperSize(count), 1, ".cw map blocks");
+	World_PackUpper(upper, 0, blocks, count);
+	Mem_Free(blocks);
+
+	Mem_Free(World.BlocksUpper);
+	World_SetMapUpper(upper);
+}
+#endif
+
 static void Cw_Callback_1(struct NbtTag* tag) {
 	if (IsTag(tag, "X")) { World.Width  = NbtTag_U16(tag); return; }
 	if (IsTag(tag, "Y")) { World.Height = NbtTag_U16(tag); return; }
@@ -518,7 +533,7 @@ static void Cw_Callback_1(struct NbtTag* tag) {
 		World.Blocks = Cw_GetBlocks(tag);
 	}
 #ifdef EXTENDED_BLOCKS
-	if (IsTag(tag, "BlockArray2")) World_SetMapUpper(Cw_GetBlocks(tag));
+	if (IsTag(tag, "BlockArray2")) Cw_SetUpper(tag);
 #endif
 }
 
@@ -939,6 +954,24 @@ cc_result Dat_Load(struct Stream* stream) {
 /*########################################################################################################################*
 *--------------------------------------------------ClassicWorld export----------------------------------------------------*
 *#########################################################################################################################*/
+/* Writes the lower 8 bits of all the blocks in the world */
+static cc_result WriteLowerBlocks(struct Stream* stream) {
+#ifdef PALETTE_BLOCKS
+	BlockRaw tmp[8192];
+	cc_result res;
+	int i, count;
+
+	for (i = 0; i < World.Volume; i += count) {
+		count = World.Volume - i; count = min(count, sizeof(tmp));
+		World_UnpackLower(tmp, i, count);
+		if ((res = Stream_Write(stream, tmp, count))) return res;
+	}
+	return 0;
+#else
+	return Stream_Write(stream, World.Blocks, World.Volume);
+#endif
+}
+
 #define CW_META_RGB NBT_I16,0,1,'R',0,0,  NBT_I16,0,1,'G',0,0,  NBT_I16,0,1,'B',0,0,
 
 static int Cw_WriteEndString(cc_uint8* data, const cc_string* text) {
@@ -1095,7 +1128,7 @@ cc_result Cw_Save(struct Stream* stream) {
 	PackedCol col;
 	struct LocalPlayer* p = &LocalPlayer_Instance;
 	cc_result res;
-	int b, len;
+	int b, len, i, count;
 
 	Mem_Copy(tmp, cw_begin, sizeof(cw_begin));
 	{
@@ -1113,15 +1146,22 @@ cc_result Cw_Save(struct Stream* stream) {
 		tmp[112] = Math_Deg2Packed(p->SpawnPitch);
 	}
 	if ((res = Stream_Write(stream, tmp,      sizeof(cw_begin)))) return res;
-	if ((res = Stream_Write(stream, World.Blocks, World.Volume))) return res;
+	if ((res = WriteLowerBlocks(stream))) return res;
 
-	if (World.Blocks != World.Blocks2) {
+#ifdef EXTENDED_BLOCKS
+	if (World.IDMask > 0xFF) {
 		Mem_Copy(tmp, cw_map2, sizeof(cw_map2));
 		Stream_SetU32_BE(&tmp[14], World.Volume);
+		if ((res = Stream_Write(stream, tmp, sizeof(cw_map2)))) return res;
 
-		if ((res = Stream_Write(stream, tmp,        sizeof(cw_map2)))) return res;
-		if ((res = Stream_Write(stream, World.Blocks2, World.Volume))) return res;
+		/* Upper bits are stored bit-packed, but .cw format stores them as a full byte per block */
+		for (i = 0; i < World.Volume; i += count) {
+			count = World.Volume - i; count = min(count, sizeof(tmp));
+			World_UnpackUpper(tmp, i, count);
+			if ((res = Stream_Write(stream, tmp, count))) return res;
+		}
 	}
+#endif
 
 	Mem_Copy(tmp, cw_meta_cpe, sizeof(cw_meta_cpe));
 	{
@@ -1186,7 +1226,7 @@ cc_result Schematic_Save(struct Stream* stream) {
 		Stream_SetU32_BE(&tmp[74], World.Volume);
 	}
 	if ((res = Stream_Write(stream, tmp, sizeof(sc_begin)))) return res;
-	if ((res = Stream_Write(stream, World.Blocks, World.Volume))) return res;
+	if ((res = WriteLowerBlocks(stream))) return res;
 
 	Mem_Copy(tmp, sc_data, sizeof(sc_data));
 	{
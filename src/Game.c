@@ -33,9 +33,11 @@
 #include "Audio.h"
 #include "Stream.h"
 #include "Builder.h"
+#include "MeshCache.h"
 #include "Protocol.h"
 #include "Picking.h"
 #include "Animations.h"
+#include "Workers.h"
 #ifdef CC_BUILD_WEB
 #include <emscripten.h>
 #endif
@@ -185,6 +187,47 @@ void Game_UpdateBlock(int x, int y, int z, BlockID block) {
 	MapRenderer_OnBlockChanged(x, y, z, block);
 }
 
+#define GAME_MAX_BATCH 256
+void Game_UpdateBlocks(const cc_int32* indices, const BlockID* blocks, int count) {
+	IVec3 coords[GAME_MAX_BATCH];
+	BlockID olds[GAME_MAX_BATCH], news[GAME_MAX_BATCH];
+	int i = 0, n, index, last = -2, rem;
+	int x = 0, y = 0, z = 0;
+	BlockID old, block;
+
+	while (i < count) {
+		for (n = 0; i < count && n < GAME_MAX_BATCH; i++) {
+			index = indices[i];
+			if (index < 0 || index >= World.Volume) continue;
+
+			/* Bulk updates are mostly runs of adjacent blocks, which avoids World_Unpack's divisions */
+			if (index == last + 1 && x < World.MaxX) {
+				x++;
+			} else {
+				y   = index / World.OneY;
+				rem = index - y * World.OneY;
+				z   = rem / World.Width;
+				x   = rem - z * World.Width;
+			}
+			last = index;
+
+			old   = World_GetBlock(x, y, z);
+			block = blocks[i];
+			if (old == block) continue;
+			World_SetBlock(x, y, z, block);
+
+			if (Weather_Heightmap) {
+				EnvRenderer_OnBlockChanged(x, y, z, old, block);
+			}
+			MapRenderer_OnBlockChanged(x, y, z, block);
+
+			coords[n].X = x; coords[n].Y = y; coords[n].Z = z;
+			olds[n] = old; news[n] = block; n++;
+		}
+		Lighting_OnBlocksChanged(coords, olds, news, n);
+	}
+}
+
 void Game_ChangeBlock(int x, int y, int z, BlockID block) {
 	BlockID old = World_GetBlock(x, y, z);
 	Game_UpdateBlock(x, y, z, block);
@@ -365,6 +408,7 @@ static void Game_Load(void) {
 	Event_Register_(&WindowEvents.Closing,      NULL, Game_Free);
 
 	Game_AddComponent(&World_Component);
+	Game_AddComponent(&Workers_Component);
 	Game_AddComponent(&Textures_Component);
 	Game_AddComponent(&Input_Component);
 	Game_AddComponent(&Camera_Component);
@@ -383,6 +427,7 @@ static void Game_Load(void) {
 	Game_AddComponent(&Animations_Component);
 	Game_AddComponent(&Inventory_Component);
 	Game_AddComponent(&Builder_Component);
+	Game_AddComponent(&MeshCache_Component);
 	Game_AddComponent(&MapRenderer_Component);
 	Game_AddComponent(&EnvRenderer_Component);
 	Game_AddComponent(&Server_Component);
@@ -61,6 +61,9 @@ void Game_Reset(void);
 /* (updating state means recalculating light, redrawing chunk block is in, etc) */
 /* NOTE: This does NOT notify the server, use Game_ChangeBlock for that. */
 CC_API void Game_UpdateBlock(int x, int y, int z, BlockID block);
+/* Same as calling Game_UpdateBlock for each block, but state associated with blocks is only updated once per chunk. */
+/* NOTE: indices are packed world coordinates (see World_Pack), and any outside the world are ignored. */
+CC_API void Game_UpdateBlocks(const cc_int32* indices, const BlockID* blocks, int count);
 /* Calls Game_UpdateBlock, then informs server connection of the block change. */
 /* In multiplayer this is sent to the server, in singleplayer just activates physics. */
 CC_API void Game_ChangeBlock(int x, int y, int z, BlockID block);
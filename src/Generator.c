@@ -1,10 +1,18 @@
 #include "Generator.h"
+/* Noise is calculated for 4 samples at once with SSE2, but only when scalar float maths also uses SSE. */
+/* Otherwise (e.g. x87 maths) results could differ slightly from the scalar path, changing the map for a seed. */
+/* NOTE: Included before Funcs.h, as C++ system headers undefine its min/max macros */
+#if defined __SSE2_MATH__ || defined _M_X64
+#define GEN_NOISE_SSE2
+#include <emmintrin.h>
+#endif
 #include "BlockID.h"
 #include "ExtMath.h"
 #include "Funcs.h"
 #include "Platform.h"
 #include "World.h"
 #include "Utils.h"
+#include "Workers.h"
 
 volatile float Gen_CurrentProgress;
 volatile const char* Gen_CurrentState;
@@ -112,13 +120,21 @@ static float ImprovedNoise_Calc(const cc_uint8* p, float x, float y) {
 }
 
 
-struct OctaveNoise { cc_uint8 p[8][NOISE_TABLE_SIZE]; int octaves; };
+struct OctaveNoise {
+	cc_uint8 p[8][NOISE_TABLE_SIZE]; int octaves;
+#ifdef GEN_NOISE_SSE2
+	cc_uint8 grads[8][NOISE_TABLE_SIZE]; /* p[p[i]] & 0xF, to halve lookups when calculating several samples */
+#endif
+};
 static void OctaveNoise_Init(struct OctaveNoise* n, RNGState* rnd, int octaves) {
-	int i;
+	int i, j;
 	n->octaves = octaves;
 	
 	for (i = 0; i < octaves; i++) {
 		ImprovedNoise_Init(n->p[i], rnd);
+#ifdef GEN_NOISE_SSE2
+		for (j = 0; j < NOISE_TABLE_SIZE; j++) { n->grads[i][j] = n->p[i][n->p[i][j]] & 0xF; }
+#endif
 	}
 }
 
@@ -148,6 +164,106 @@ static float CombinedNoise_Calc(const struct CombinedNoise* n, float x, float y)
 }
 
 
+#ifdef GEN_NOISE_SSE2
+/* Gradients of ImprovedNoise_Calc (i.e. the values packed into xFlags and yFlags) */
+static const float noiseGradX[16] = { 1,-1, 1,-1, 1,-1, 1,-1, 0, 0, 0, 0, 1, 0,-1, 0 };
+static const float noiseGradY[16] = { 1, 1,-1,-1, 0, 0, 0, 0, 1,-1, 1,-1, 1,-1, 1,-1 };
+
+/* Same as ImprovedNoise_Calc, but for 4 samples at once. Performs the exact same float operations in the same order, */
+/*  so results are identical. Permutation table lookups are still done per sample, as SSE2 has no gather. */
+static __m128 ImprovedNoise_Calc4(const cc_uint8* p, const cc_uint8* grads, __m128 x, __m128 y) {
+	int X[4], Y[4], h[4][4];
+	__m128i xFloor, yFloor, mask;
+	__m128 u, v, x1, y1, g22, g12, g21, g11, c1, c2;
+	__m128 six = _mm_set1_ps(6), fifteen = _mm_set1_ps(15), ten = _mm_set1_ps(10), one = _mm_set1_ps(1);
+	int i, A, B;
+
+	/* x >= 0 ? (int)x : (int)x - 1 */
+	xFloor = _mm_add_epi32(_mm_cvttps_epi32(x), _mm_castps_si128(_mm_cmpnge_ps(x, _mm_setzero_ps())));
+	yFloor = _mm_add_epi32(_mm_cvttps_epi32(y), _mm_castps_si128(_mm_cmpnge_ps(y, _mm_setzero_ps())));
+	mask   = _mm_set1_epi32(0xFF);
+	_mm_storeu_si128((__m128i*)X, _mm_and_si128(xFloor, mask));
+	_mm_storeu_si128((__m128i*)Y, _mm_and_si128(yFloor, mask));
+	x = _mm_sub_ps(x, _mm_cvtepi32_ps(xFloor));
+	y = _mm_sub_ps(y, _mm_cvtepi32_ps(yFloor));
+
+	u = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(x, x), x), _mm_add_ps(_mm_mul_ps(x, _mm_sub_ps(_mm_mul_ps(x, six), fifteen)), ten));
+	v = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(y, y), y), _mm_add_ps(_mm_mul_ps(y, _mm_sub_ps(_mm_mul_ps(y, six), fifteen)), ten));
+
+	for (i = 0; i < 4; i++) {
+		A = p[X[i]] + Y[i]; B = p[X[i] + 1] + Y[i];
+		h[0][i] = grads[A]; h[1][i] = grads[B];
+		h[2][i] = grads[A + 1]; h[3][i] = grads[B + 1];
+	}
+
+#define Noise_Grad4(j, gradX, gradY) _mm_add_ps( \
+	_mm_mul_ps(_mm_setr_ps(noiseGradX[h[j][0]], noiseGradX[h[j][1]], noiseGradX[h[j][2]], noiseGradX[h[j][3]]), gradX), \
+	_mm_mul_ps(_mm_setr_ps(noiseGradY[h[j][0]], noiseGradY[h[j][1]], noiseGradY[h[j][2]], noiseGradY[h[j][3]]), gradY))
+
+	x1  = _mm_sub_ps(x, one);
+	y1  = _mm_sub_ps(y, one);
+	g22 = Noise_Grad4(0, x,  y);
+	g12 = Noise_Grad4(1, x1, y);
+	c1  = _mm_add_ps(g22, _mm_mul_ps(u, _mm_sub_ps(g12, g22)));
+
+	g21 = Noise_Grad4(2, x,  y1);
+	g11 = Noise_Grad4(3, x1, y1);
+	c2  = _mm_add_ps(g21, _mm_mul_ps(u, _mm_sub_ps(g11, g21)));
+
+	return _mm_add_ps(c1, _mm_mul_ps(v, _mm_sub_ps(c2, c1)));
+}
+
+static __m128 OctaveNoise_Calc4(const struct OctaveNoise* n, __m128 x, __m128 y) {
+	float amplitude = 1, freq = 1;
+	__m128 sum = _mm_setzero_ps(), noise;
+	int i;
+
+	for (i = 0; i < n->octaves; i++) {
+		noise = ImprovedNoise_Calc4(n->p[i], n->grads[i], _mm_mul_ps(x, _mm_set1_ps(freq)), _mm_mul_ps(y, _mm_set1_ps(freq)));
+		sum   = _mm_add_ps(sum, _mm_mul_ps(noise, _mm_set1_ps(amplitude)));
+		amplitude *= 2.0f;
+		freq *= 0.5f;
+	}
+	return sum;
+}
+
+static __m128 CombinedNoise_Calc4(const struct CombinedNoise* n, __m128 x, __m128 y) {
+	__m128 offset = OctaveNoise_Calc4(&n->noise2, x, y);
+	return OctaveNoise_Calc4(&n->noise1, _mm_add_ps(x, offset), y);
+}
+
+/* Returns x * xScale for the 4 samples starting at x */
+#define Noise_Row4(x, xScale) _mm_mul_ps(_mm_cvtepi32_ps(_mm_setr_epi32(x, x + 1, x + 2, x + 3)), _mm_set1_ps(xScale))
+#endif
+
+/* Calculates out[x] = OctaveNoise_Calc(n, x * xScale, y) for each x from 0 to count - 1 */
+static void OctaveNoise_CalcRow(const struct OctaveNoise* n, float xScale, float y, float* out, int count) {
+	int x = 0;
+#ifdef GEN_NOISE_SSE2
+	for (; x + 4 <= count; x += 4) {
+		_mm_storeu_ps(out + x, OctaveNoise_Calc4(n, Noise_Row4(x, xScale), _mm_set1_ps(y)));
+	}
+#endif
+	for (; x < count; x++) { out[x] = OctaveNoise_Calc(n, x * xScale, y); }
+}
+
+/* Calculates out[x] = CombinedNoise_Calc(n, x * xScale, y) for each x from 0 to count - 1 */
+/* If skip is not NULL, samples where skip[x] is greater than 0 are not needed, so may not be calculated */
+static void CombinedNoise_CalcRow(const struct CombinedNoise* n, float xScale, float y, const float* skip, float* out, int count) {
+	int x = 0;
+#ifdef GEN_NOISE_SSE2
+	for (; x + 4 <= count; x += 4) {
+		if (skip && skip[x] > 0 && skip[x + 1] > 0 && skip[x + 2] > 0 && skip[x + 3] > 0) continue;
+		_mm_storeu_ps(out + x, CombinedNoise_Calc4(n, Noise_Row4(x, xScale), _mm_set1_ps(y)));
+	}
+#endif
+	for (; x < count; x++) {
+		if (skip && skip[x] > 0) continue;
+		out[x] = CombinedNoise_Calc(n, x * xScale, y);
+	}
+}
+
+
 /*########################################################################################################################*
 *----------------------------------------------------Notchy map gen-------------------------------------------------------*
 *#########################################################################################################################*/
@@ -155,13 +271,56 @@ static int waterLevel, minHeight;
 static cc_int16* Heightmap;
 static RNGState rnd;
 
-static void NotchyGen_FillOblateSpheroid(int x, int y, int z, float radius, BlockRaw block) {
+/* Stages that can be split up are processed across the worker threads, in rows or slabs along Z. */
+/* Noise used by the stage currently being processed, which the worker threads read from */
+static struct CombinedNoise stageNoise1, stageNoise2;
+static struct OctaveNoise   stageNoise3, stageNoise4;
+/* Rows of noise calculated by each worker thread (see OctaveNoise_CalcRow) */
+static float* stageRows;
+static int stageMinHeights[WORKERS_MAX_COUNT];
+
+/* Items are handed out to worker threads in order, so the highest item started is close enough for progress */
+static void NotchyGen_ItemProgress(int item, int count, float offset, float scale) {
+	float progress = offset + ((float)item / count) * scale;
+	if (progress > Gen_CurrentProgress) Gen_CurrentProgress = progress;
+}
+
+static void NotchyGen_AllocRows(int rowsPerWorker) {
+	stageRows = (float*)Mem_Alloc(World.Width * rowsPerWorker * Workers_Count, sizeof(float), "gen noise rows");
+}
+
+/* Caves and ore veins are carved out of oblate spheroids along random paths. The paths only depend on the RNG, */
+/*  so they are calculated first and stored. Spheroids only ever replace stone with the same block in a stage, */
+/*  so the order they are filled in does not matter, and slabs of the map can be filled in by different threads. */
+struct GenSpheroid { int x, y, z; float radius; };
+static struct GenSpheroid* spheroids;
+static int spheroidsCount, spheroidsCapacity;
+static BlockRaw spheroidsBlock;
+
+/* Indices of the spheroids overlapping each slab, with the list for slab i starting at slabStarts[i] */
+#define GEN_SLAB_SHIFT 4
+static int* slabSpheroids;
+static int* slabStarts;
+static int slabsCount;
+
+static void NotchyGen_AddSpheroid(int x, int y, int z, float radius) {
+	struct GenSpheroid* s;
+	if (spheroidsCount == spheroidsCapacity) {
+		spheroidsCapacity = max(1024, spheroidsCapacity * 2);
+		spheroids = (struct GenSpheroid*)Mem_Realloc(spheroids, spheroidsCapacity, sizeof(struct GenSpheroid), "gen spheroids");
+	}
+
+	s = &spheroids[spheroidsCount++];
+	s->x = x; s->y = y; s->z = z; s->radius = radius;
+}
+
+static void NotchyGen_FillOblateSpheroid(int x, int y, int z, float radius, BlockRaw block, int minZ, int maxZ) {
 	int xBeg = Math_Floor(max(x - radius, 0));
 	int xEnd = Math_Floor(min(x + radius, World.MaxX));
 	int yBeg = Math_Floor(max(y - radius, 0));
 	int yEnd = Math_Floor(min(y + radius, World.MaxY));
-	int zBeg = Math_Floor(max(z - radius, 0));
-	int zEnd = Math_Floor(min(z + radius, World.MaxZ));
+	int zBeg = max(Math_Floor(max(z - radius, 0)), minZ);
+	int zEnd = min(Math_Floor(min(z + radius, World.MaxZ)), maxZ);
 
 	float radiusSq = radius * radius;
 	int index;
@@ -181,6 +340,63 @@ static void NotchyGen_FillOblateSpheroid(int x, int y, int z, float radius, Bloc
 	}
 }
 
+/* Returns the range of Z slabs that the given spheroid fills blocks in, or false if it doesn't fill any blocks */
+static cc_bool NotchyGen_SpheroidSlabs(const struct GenSpheroid* s, int* minSlab, int* maxSlab) {
+	int zBeg = Math_Floor(max(s->z - s->radius, 0));
+	int zEnd = Math_Floor(min(s->z + s->radius, World.MaxZ));
+	if (zBeg > zEnd) return false;
+
+	*minSlab = zBeg >> GEN_SLAB_SHIFT;
+	*maxSlab = zEnd >> GEN_SLAB_SHIFT;
+	return true;
+}
+
+static void NotchyGen_FillSlab(int slab, int worker) {
+	int minZ = slab << GEN_SLAB_SHIFT, maxZ = min(minZ + (1 << GEN_SLAB_SHIFT), World.Length) - 1;
+	const struct GenSpheroid* s;
+	int i;
+
+	NotchyGen_ItemProgress(slab, slabsCount, 0.5f, 0.5f);
+	for (i = slabStarts[slab]; i < slabStarts[slab + 1]; i++) {
+		s = &spheroids[slabSpheroids[i]];
+		NotchyGen_FillOblateSpheroid(s->x, s->y, s->z, s->radius, spheroidsBlock, minZ, maxZ);
+	}
+}
+
+/* Fills in all the stored spheroids with the given block, then clears the stored spheroids */
+static void NotchyGen_FillSpheroids(BlockRaw block) {
+	int slabs = (World.Length + ((1 << GEN_SLAB_SHIFT) - 1)) >> GEN_SLAB_SHIFT;
+	int i, j, minSlab, maxSlab, total = 0;
+	slabStarts = (int*)Mem_AllocCleared(slabs + 1, sizeof(int), "gen slab starts");
+
+	/* Count spheroids per slab first, so all the lists can be packed into one array */
+	for (i = 0; i < spheroidsCount; i++) {
+		if (!NotchyGen_SpheroidSlabs(&spheroids[i], &minSlab, &maxSlab)) continue;
+		for (j = minSlab; j <= maxSlab; j++) { slabStarts[j + 1]++; }
+	}
+	for (j = 0; j < slabs; j++) { slabStarts[j + 1] += slabStarts[j]; }
+	total = slabStarts[slabs];
+
+	slabSpheroids = (int*)Mem_Alloc(max(total, 1), sizeof(int), "gen slab spheroids");
+	for (i = 0; i < spheroidsCount; i++) {
+		if (!NotchyGen_SpheroidSlabs(&spheroids[i], &minSlab, &maxSlab)) continue;
+		for (j = minSlab; j <= maxSlab; j++) { slabSpheroids[slabStarts[j]++] = i; }
+	}
+	/* Filling the lists moved each start to the end of its list, i.e. the start of the next list */
+	for (j = slabs; j > 0; j--) { slabStarts[j] = slabStarts[j - 1]; }
+	slabStarts[0] = 0;
+
+	spheroidsBlock = block;
+	slabsCount     = slabs;
+	Workers_Run(NotchyGen_FillSlab, slabs);
+
+	Mem_Free(slabSpheroids);
+	Mem_Free(slabStarts);
+	Mem_Free(spheroids);
+	spheroids = NULL;
+	spheroidsCount = 0; spheroidsCapacity = 0;
+}
+
 #define STACK_FAST 8192
 static void NotchyGen_FloodFill(int index, BlockRaw block) {
 	int* stack;
@@ -217,40 +433,54 @@ static void NotchyGen_FloodFill(int index, BlockRaw block) {
 }
 
 
-static void NotchyGen_CreateHeightmap(void) {
+static void NotchyGen_HeightmapRow(int z, int worker) {
 	float hLow, hHigh, height;
-	int hIndex = 0, adjHeight;
-	int x, z;
-	struct CombinedNoise n1, n2;
-	struct OctaveNoise n3;
+	int hIndex = z * World.Width, adjHeight, x;
+	/* Noise is calculated a row at a time, so several samples can be calculated at once */
+	float* lows  = stageRows + World.Width * 3 * worker;
+	float* highs = lows + World.Width;
+	float* sels  = lows + World.Width * 2;
 
-	CombinedNoise_Init(&n1, &rnd, 8, 8);
-	CombinedNoise_Init(&n2, &rnd, 8, 8);	
-	OctaveNoise_Init(&n3, &rnd, 6);
+	NotchyGen_ItemProgress(z, World.Length, 0.0f, 1.0f);
+	CombinedNoise_CalcRow(&stageNoise1, 1.3f, z * 1.3f, NULL, lows, World.Width);
+	OctaveNoise_CalcRow(&stageNoise3,   1.0f, (float)z, sels, World.Width);
+	CombinedNoise_CalcRow(&stageNoise2, 1.3f, z * 1.3f, sels, highs, World.Width);
 
-	Gen_CurrentState = "Building heightmap";
-	for (z = 0; z < World.Length; z++) {
-		Gen_CurrentProgress = (float)z / World.Length;
-
-		for (x = 0; x < World.Width; x++) {
-			hLow   = CombinedNoise_Calc(&n1, x * 1.3f, z * 1.3f) / 6 - 4;
-			height = hLow;
+	for (x = 0; x < World.Width; x++) {
+		hLow   = lows[x] / 6 - 4;
+		height = hLow;
 
-			if (OctaveNoise_Calc(&n3, (float)x, (float)z) <= 0) {
-				hHigh = CombinedNoise_Calc(&n2, x * 1.3f, z * 1.3f) / 5 + 6;
-				height = max(hLow, hHigh);
-			}
+		if (sels[x] <= 0) {
+			hHigh = highs[x] / 5 + 6;
+			height = max(hLow, hHigh);
+		}
 
-			height *= 0.5f;
-			if (height < 0) height *= 0.8f;
+		height *= 0.5f;
+		if (height < 0) height *= 0.8f;
 
-			adjHeight = (int)(height + waterLevel);
-			minHeight = min(adjHeight, minHeight);
-			Heightmap[hIndex++] = adjHeight;
-		}
+		adjHeight = (int)(height + waterLevel);
+		stageMinHeights[worker] = min(adjHeight, stageMinHeights[worker]);
+		Heightmap[hIndex++] = adjHeight;
 	}
 }
 
+static void NotchyGen_CreateHeightmap(void) {
+	int i;
+	CombinedNoise_Init(&stageNoise1, &rnd, 8, 8);
+	CombinedNoise_Init(&stageNoise2, &rnd, 8, 8);
+	OctaveNoise_Init(&stageNoise3, &rnd, 6);
+
+	NotchyGen_AllocRows(3);
+	for (i = 0; i < Workers_Count; i++) { stageMinHeights[i] = minHeight; }
+
+	Gen_CurrentProgress = 0.0f;
+	Gen_CurrentState    = "Building heightmap";
+	Workers_Run(NotchyGen_HeightmapRow, World.Length);
+
+	for (i = 0; i < Workers_Count; i++) { minHeight = min(minHeight, stageMinHeights[i]); }
+	Mem_Free(stageRows);
+}
+
 static int NotchyGen_CreateStrataFast(void) {
 	cc_uint32 oneY = (cc_uint32)World.OneY;
 	int stoneHeight, airHeight;
@@ -280,43 +510,50 @@ static int NotchyGen_CreateStrataFast(void) {
 	return max(stoneHeight, 1);
 }
 
-static void NotchyGen_CreateStrata(void) {
+static int strataMinStoneY;
+static void NotchyGen_StrataRow(int z, int worker) {
 	int dirtThickness, dirtHeight;
-	int minStoneY, stoneHeight;
-	int hIndex = 0, maxY = World.MaxY, index = 0;
-	int x, y, z;
-	struct OctaveNoise n;
+	int minStoneY = strataMinStoneY, stoneHeight;
+	int hIndex = z * World.Width, maxY = World.MaxY, index = 0;
+	int x, y;
+	float* noise = stageRows + World.Width * worker;
 
-	/* Try to bulk fill bottom of the map if possible */
-	minStoneY = NotchyGen_CreateStrataFast();
-	OctaveNoise_Init(&n, &rnd, 8);
+	NotchyGen_ItemProgress(z, World.Length, 0.0f, 1.0f);
+	OctaveNoise_CalcRow(&stageNoise3, 1.0f, (float)z, noise, World.Width);
 
-	Gen_CurrentState = "Creating strata";
-	for (z = 0; z < World.Length; z++) {
-		Gen_CurrentProgress = (float)z / World.Length;
-
-		for (x = 0; x < World.Width; x++) {
-			dirtThickness = (int)(OctaveNoise_Calc(&n, (float)x, (float)z) / 24 - 4);
-			dirtHeight    = Heightmap[hIndex++];
-			stoneHeight   = dirtHeight + dirtThickness;
+	for (x = 0; x < World.Width; x++) {
+		dirtThickness = (int)(noise[x] / 24 - 4);
+		dirtHeight    = Heightmap[hIndex++];
+		stoneHeight   = dirtHeight + dirtThickness;
 
-			stoneHeight = min(stoneHeight, maxY);
-			dirtHeight  = min(dirtHeight,  maxY);
+		stoneHeight = min(stoneHeight, maxY);
+		dirtHeight  = min(dirtHeight,  maxY);
 
-			index = World_Pack(x, minStoneY, z);
-			for (y = minStoneY; y <= stoneHeight; y++) {
-				Gen_Blocks[index] = BLOCK_STONE; index += World.OneY;
-			}
+		index = World_Pack(x, minStoneY, z);
+		for (y = minStoneY; y <= stoneHeight; y++) {
+			Gen_Blocks[index] = BLOCK_STONE; index += World.OneY;
+		}
 
-			stoneHeight = max(stoneHeight, 0);
-			index = World_Pack(x, (stoneHeight + 1), z);
-			for (y = stoneHeight + 1; y <= dirtHeight; y++) {
-				Gen_Blocks[index] = BLOCK_DIRT; index += World.OneY;
-			}
+		stoneHeight = max(stoneHeight, 0);
+		index = World_Pack(x, (stoneHeight + 1), z);
+		for (y = stoneHeight + 1; y <= dirtHeight; y++) {
+			Gen_Blocks[index] = BLOCK_DIRT; index += World.OneY;
 		}
 	}
 }
 
+static void NotchyGen_CreateStrata(void) {
+	/* Try to bulk fill bottom of the map if possible */
+	strataMinStoneY = NotchyGen_CreateStrataFast();
+	OctaveNoise_Init(&stageNoise3, &rnd, 8);
+	NotchyGen_AllocRows(1);
+
+	Gen_CurrentProgress = 0.0f;
+	Gen_CurrentState    = "Creating strata";
+	Workers_Run(NotchyGen_StrataRow, World.Length);
+	Mem_Free(stageRows);
+}
+
 static void NotchyGen_CarveCaves(void) {
 	int cavesCount, caveLen;
 	float caveX, caveY, caveZ;
@@ -328,7 +565,7 @@ static void NotchyGen_CarveCaves(void) {
 	cavesCount       = World.Volume / 8192;
 	Gen_CurrentState = "Carving caves";
 	for (i = 0; i < cavesCount; i++) {
-		Gen_CurrentProgress = (float)i / cavesCount;
+		Gen_CurrentProgress = ((float)i / cavesCount) * 0.5f;
 
 		caveX = (float)Random_Next(&rnd, World.Width);
 		caveY = (float)Random_Next(&rnd, World.Height);
@@ -357,9 +594,10 @@ static void NotchyGen_CarveCaves(void) {
 			radius = (World.Height - cenY) / (float)World.Height;
 			radius = 1.2f + (radius * 3.5f + 1.0f) * caveRadius;
 			radius = radius * Math_SinF(j * MATH_PI / caveLen);
-			NotchyGen_FillOblateSpheroid(cenX, cenY, cenZ, radius, BLOCK_AIR);
+			NotchyGen_AddSpheroid(cenX, cenY, cenZ, radius);
 		}
 	}
+	NotchyGen_FillSpheroids(BLOCK_AIR);
 }
 
 static void NotchyGen_CarveOreVeins(float abundance, const char* state, BlockRaw block) {
@@ -372,7 +610,7 @@ static void NotchyGen_CarveOreVeins(float abundance, const char* state, BlockRaw
 	numVeins         = (int)(World.Volume * abundance / 16384);
 	Gen_CurrentState = state;
 	for (i = 0; i < numVeins; i++) {
-		Gen_CurrentProgress = (float)i / numVeins;
+		Gen_CurrentProgress = ((float)i / numVeins) * 0.5f;
 
 		veinX = (float)Random_Next(&rnd, World.Width);
 		veinY = (float)Random_Next(&rnd, World.Height);
@@ -393,9 +631,10 @@ static void NotchyGen_CarveOreVeins(float abundance, const char* state, BlockRaw
 			deltaPhi   = deltaPhi   * 0.9f + Random_Float(&rnd) - Random_Float(&rnd);
 
 			radius = abundance * Math_SinF(j * MATH_PI / veinLen) + 1.0f;
-			NotchyGen_FillOblateSpheroid((int)veinX, (int)veinY, (int)veinZ, radius, block);
+			NotchyGen_AddSpheroid((int)veinX, (int)veinY, (int)veinZ, radius);
 		}
 	}
+	NotchyGen_FillSpheroids(block);
 }
 
 static void NotchyGen_FloodFillWaterBorders(void) {
@@ -457,105 +696,189 @@ static void NotchyGen_FloodFillLava(void) {
 	}
 }
 
-static void NotchyGen_CreateSurfaceLayer(void) {	
-	int hIndex = 0, index;
+static void NotchyGen_SurfaceRow(int z, int worker) {
+	int hIndex = z * World.Width, index;
 	BlockRaw above;
-	int x, y, z;
-	struct OctaveNoise n1, n2;
+	int x, y;
 
-	OctaveNoise_Init(&n1, &rnd, 8);
-	OctaveNoise_Init(&n2, &rnd, 8);
+	NotchyGen_ItemProgress(z, World.Length, 0.0f, 1.0f);
+	for (x = 0; x < World.Width; x++) {
+		y = Heightmap[hIndex++];
+		if (y < 0 || y >= World.Height) continue;
 
-	Gen_CurrentState = "Creating surface";
-	for (z = 0; z < World.Length; z++) {
-		Gen_CurrentProgress = (float)z / World.Length;
+		index = World_Pack(x, y, z);
+		above = y >= World.MaxY ? BLOCK_AIR : Gen_Blocks[index + World.OneY];
 
-		for (x = 0; x < World.Width; x++) {
-			y = Heightmap[hIndex++];
-			if (y < 0 || y >= World.Height) continue;
+		/* TODO: update heightmap */
+		if (above == BLOCK_WATER && (OctaveNoise_Calc(&stageNoise4, (float)x, (float)z) > 12)) {
+			Gen_Blocks[index] = BLOCK_GRAVEL;
+		} else if (above == BLOCK_AIR) {
+			Gen_Blocks[index] = (y <= waterLevel && (OctaveNoise_Calc(&stageNoise3, (float)x, (float)z) > 8)) ? BLOCK_SAND : BLOCK_GRASS;
+		}
+	}
+}
 
-			index = World_Pack(x, y, z);
-			above = y >= World.MaxY ? BLOCK_AIR : Gen_Blocks[index + World.OneY];
+static void NotchyGen_CreateSurfaceLayer(void) {
+	OctaveNoise_Init(&stageNoise3, &rnd, 8);
+	OctaveNoise_Init(&stageNoise4, &rnd, 8);
 
-			/* TODO: update heightmap */
-			if (above == BLOCK_WATER && (OctaveNoise_Calc(&n2, (float)x, (float)z) > 12)) {
-				Gen_Blocks[index] = BLOCK_GRAVEL;
-			} else if (above == BLOCK_AIR) {
-				Gen_Blocks[index] = (y <= waterLevel && (OctaveNoise_Calc(&n1, (float)x, (float)z) > 8)) ? BLOCK_SAND : BLOCK_GRASS;
-			}
+	Gen_CurrentProgress = 0.0f;
+	Gen_CurrentState    = "Creating surface";
+	Workers_Run(NotchyGen_SurfaceRow, World.Length);
+}
+
+
+/* Patches of plants are found in parallel, by giving each worker thread a range of patches. */
+/* Each patch always uses the same number of RNG steps, so the RNG state the serial loop would have */
+/*  at the start of each range can be calculated with Random_Skip. (Random_Next very rarely uses extra steps, */
+/*  in which case the later ranges are found again from the right state) */
+/* Plants are only placed on air, so each range records where its plants go without changing the map, */
+/*  then the plants are placed in order, skipping places an earlier patch already put a plant in. */
+#define GEN_PATCHES_PER_RANGE 256
+struct GenPlant { int index; BlockRaw block; };
+struct GenPatchRange {
+	RNGState start, end;
+	struct GenPlant* plants;
+	int count, capacity;
+};
+typedef void (*Gen_PatchFunc)(RNGState* rnd, struct GenPatchRange* range);
+
+static Gen_PatchFunc patchFunc;
+static struct GenPatchRange* patchRanges;
+static int patchesCount, rangesCount;
+
+static void NotchyGen_AddPlant(struct GenPatchRange* range, int index, BlockRaw block) {
+	if (range->count == range->capacity) {
+		range->capacity = max(64, range->capacity * 2);
+		range->plants   = (struct GenPlant*)Mem_Realloc(range->plants, range->capacity, sizeof(struct GenPlant), "gen plants");
+	}
+	range->plants[range->count].index = index;
+	range->plants[range->count].block = block;
+	range->count++;
+}
+
+static void NotchyGen_FindPatches(int item) {
+	struct GenPatchRange* range = &patchRanges[item];
+	int i   = item * GEN_PATCHES_PER_RANGE;
+	int end = min(i + GEN_PATCHES_PER_RANGE, patchesCount);
+	RNGState rng = range->start;
+
+	for (range->count = 0; i < end; i++) { patchFunc(&rng, range); }
+	range->end = rng;
+}
+
+static void NotchyGen_FindPatchesWorker(int item, int worker) {
+	NotchyGen_ItemProgress(item, rangesCount, 0.0f, 1.0f);
+	NotchyGen_FindPatches(item);
+}
+
+static void NotchyGen_PlantPatches(Gen_PatchFunc func, int count, int stepsPerPatch) {
+	struct GenPatchRange* range;
+	RNGState start = rnd;
+	int i, j;
+
+	patchFunc    = func;
+	patchesCount = count;
+	rangesCount  = (count + (GEN_PATCHES_PER_RANGE - 1)) / GEN_PATCHES_PER_RANGE;
+	patchRanges  = (struct GenPatchRange*)Mem_AllocCleared(max(rangesCount, 1), sizeof(struct GenPatchRange), "gen patch ranges");
+
+	for (i = 0; i < rangesCount; i++) {
+		patchRanges[i].start = start;
+		Random_Skip(&start, (cc_uint64)stepsPerPatch * GEN_PATCHES_PER_RANGE);
+	}
+
+	Gen_CurrentProgress = 0.0f;
+	Workers_Run(NotchyGen_FindPatchesWorker, rangesCount);
+
+	for (i = 0; i < rangesCount; i++) {
+		range = &patchRanges[i];
+		/* Random_Next used extra steps in an earlier range, so this range started from the wrong state */
+		if (range->start != rnd) {
+			range->start = rnd;
+			NotchyGen_FindPatches(i);
 		}
+
+		for (j = 0; j < range->count; j++) {
+			if (Gen_Blocks[range->plants[j].index] != BLOCK_AIR) continue;
+			Gen_Blocks[range->plants[j].index] = range->plants[j].block;
+		}
+		rnd = range->end;
+		Mem_Free(range->plants);
 	}
+	Mem_Free(patchRanges);
+	patchRanges = NULL;
 }
 
-static void NotchyGen_PlantFlowers(void) {
-	int numPatches;
+/* Number of RNG steps a flower patch uses */
+#define GEN_FLOWER_STEPS (3 + 10 * 5 * 4)
+static void NotchyGen_FlowerPatch(RNGState* rnd, struct GenPatchRange* range) {
 	BlockRaw block;
 	int patchX,  patchZ;
 	int flowerX, flowerY, flowerZ;
-	int i, j, k, index;
-
-	numPatches       = World.Width * World.Length / 3000;
-	Gen_CurrentState = "Planting flowers";
-	for (i = 0; i < numPatches; i++) {
-		Gen_CurrentProgress = (float)i / numPatches;
+	int j, k, index;
 
-		block  = (BlockRaw)(BLOCK_DANDELION + Random_Next(&rnd, 2));
-		patchX = Random_Next(&rnd, World.Width);
-		patchZ = Random_Next(&rnd, World.Length);
+	block  = (BlockRaw)(BLOCK_DANDELION + Random_Next(rnd, 2));
+	patchX = Random_Next(rnd, World.Width);
+	patchZ = Random_Next(rnd, World.Length);
 
-		for (j = 0; j < 10; j++) {
-			flowerX = patchX; flowerZ = patchZ;
-			for (k = 0; k < 5; k++) {
-				flowerX += Random_Next(&rnd, 6) - Random_Next(&rnd, 6);
-				flowerZ += Random_Next(&rnd, 6) - Random_Next(&rnd, 6);
+	for (j = 0; j < 10; j++) {
+		flowerX = patchX; flowerZ = patchZ;
+		for (k = 0; k < 5; k++) {
+			flowerX += Random_Next(rnd, 6) - Random_Next(rnd, 6);
+			flowerZ += Random_Next(rnd, 6) - Random_Next(rnd, 6);
 
-				if (!World_ContainsXZ(flowerX, flowerZ)) continue;
-				flowerY = Heightmap[flowerZ * World.Width + flowerX] + 1;
-				if (flowerY <= 0 || flowerY >= World.Height) continue;
+			if (!World_ContainsXZ(flowerX, flowerZ)) continue;
+			flowerY = Heightmap[flowerZ * World.Width + flowerX] + 1;
+			if (flowerY <= 0 || flowerY >= World.Height) continue;
 
-				index = World_Pack(flowerX, flowerY, flowerZ);
-				if (Gen_Blocks[index] == BLOCK_AIR && Gen_Blocks[index - World.OneY] == BLOCK_GRASS)
-					Gen_Blocks[index] = block;
-			}
+			index = World_Pack(flowerX, flowerY, flowerZ);
+			if (Gen_Blocks[index] == BLOCK_AIR && Gen_Blocks[index - World.OneY] == BLOCK_GRASS)
+				NotchyGen_AddPlant(range, index, block);
 		}
 	}
 }
 
-static void NotchyGen_PlantMushrooms(void) {
-	int numPatches, groundHeight;
+static void NotchyGen_PlantFlowers(void) {
+	Gen_CurrentState = "Planting flowers";
+	NotchyGen_PlantPatches(NotchyGen_FlowerPatch, World.Width * World.Length / 3000, GEN_FLOWER_STEPS);
+}
+
+/* Number of RNG steps a mushroom patch uses */
+#define GEN_MUSHROOM_STEPS (4 + 20 * 5 * 4)
+static void NotchyGen_MushroomPatch(RNGState* rnd, struct GenPatchRange* range) {
+	int groundHeight;
 	BlockRaw block;
 	int patchX, patchY, patchZ;
 	int mushX,  mushY,  mushZ;
-	int i, j, k, index;
-
-	numPatches       = World.Volume / 2000;
-	Gen_CurrentState = "Planting mushrooms";
-	for (i = 0; i < numPatches; i++) {
-		Gen_CurrentProgress = (float)i / numPatches;
-
-		block  = (BlockRaw)(BLOCK_BROWN_SHROOM + Random_Next(&rnd, 2));
-		patchX = Random_Next(&rnd, World.Width);
-		patchY = Random_Next(&rnd, World.Height);
-		patchZ = Random_Next(&rnd, World.Length);
-
-		for (j = 0; j < 20; j++) {
-			mushX = patchX; mushY = patchY; mushZ = patchZ;
-			for (k = 0; k < 5; k++) {
-				mushX += Random_Next(&rnd, 6) - Random_Next(&rnd, 6);
-				mushZ += Random_Next(&rnd, 6) - Random_Next(&rnd, 6);
-
-				if (!World_ContainsXZ(mushX, mushZ)) continue;
-				groundHeight = Heightmap[mushZ * World.Width + mushX];
-				if (mushY >= (groundHeight - 1)) continue;
-
-				index = World_Pack(mushX, mushY, mushZ);
-				if (Gen_Blocks[index] == BLOCK_AIR && Gen_Blocks[index - World.OneY] == BLOCK_STONE)
-					Gen_Blocks[index] = block;
-			}
+	int j, k, index;
+
+	block  = (BlockRaw)(BLOCK_BROWN_SHROOM + Random_Next(rnd, 2));
+	patchX = Random_Next(rnd, World.Width);
+	patchY = Random_Next(rnd, World.Height);
+	patchZ = Random_Next(rnd, World.Length);
+
+	for (j = 0; j < 20; j++) {
+		mushX = patchX; mushY = patchY; mushZ = patchZ;
+		for (k = 0; k < 5; k++) {
+			mushX += Random_Next(rnd, 6) - Random_Next(rnd, 6);
+			mushZ += Random_Next(rnd, 6) - Random_Next(rnd, 6);
+
+			if (!World_ContainsXZ(mushX, mushZ)) continue;
+			groundHeight = Heightmap[mushZ * World.Width + mushX];
+			if (mushY >= (groundHeight - 1)) continue;
+
+			index = World_Pack(mushX, mushY, mushZ);
+			if (Gen_Blocks[index] == BLOCK_AIR && Gen_Blocks[index - World.OneY] == BLOCK_STONE)
+				NotchyGen_AddPlant(range, index, block);
 		}
 	}
 }
 
+static void NotchyGen_PlantMushrooms(void) {
+	Gen_CurrentState = "Planting mushrooms";
+	NotchyGen_PlantPatches(NotchyGen_MushroomPatch, World.Volume / 2000, GEN_MUSHROOM_STEPS);
+}
+
 static void NotchyGen_PlantTrees(void) {
 	int numPatches;
 	int patchX, patchZ;
@@ -641,6 +964,13 @@ void NotchyGen_Generate(void) {
 BlockRaw* Tree_Blocks;
 RNGState* Tree_Rnd;
 
+#ifdef PALETTE_BLOCKS
+/* Tree_Blocks is NULL when growing trees in a loaded map, as the map's blocks are then stored in chunks */
+#define TreeGen_GetBlock(index) (Tree_Blocks ? Tree_Blocks[index] : World_GetRawBlock(index))
+#else
+#define TreeGen_GetBlock(index) Tree_Blocks[index]
+#endif
+
 cc_bool TreeGen_CanGrow(int treeX, int treeY, int treeZ, int treeHeight) {
 	int baseHeight = treeHeight - 4;
 	int index;
@@ -653,7 +983,7 @@ cc_bool TreeGen_CanGrow(int treeX, int treeY, int treeZ, int treeHeight) {
 
 				if (!World_Contains(x, y, z)) return false;
 				index = World_Pack(x, y, z);
-				if (Tree_Blocks[index] != BLOCK_AIR) return false;
+				if (TreeGen_GetBlock(index) != BLOCK_AIR) return false;
 			}
 		}
 	}
@@ -665,7 +995,7 @@ cc_bool TreeGen_CanGrow(int treeX, int treeY, int treeZ, int treeHeight) {
 
 				if (!World_Contains(x, y, z)) return false;
 				index = World_Pack(x, y, z);
-				if (Tree_Blocks[index] != BLOCK_AIR) return false;
+				if (TreeGen_GetBlock(index) != BLOCK_AIR) return false;
 			}
 		}
 	}
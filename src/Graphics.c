@@ -24,7 +24,7 @@ struct _GfxData Gfx;
 GfxResourceID Gfx_defaultIb;
 GfxResourceID Gfx_quadVb, Gfx_texVb;
 
-static const int strideSizes[2] = { SIZEOF_VERTEX_COLOURED, SIZEOF_VERTEX_TEXTURED };
+static const int strideSizes[3] = { SIZEOF_VERTEX_COLOURED, SIZEOF_VERTEX_TEXTURED, SIZEOF_VERTEX_CHUNK };
 /* Current format and size of vertices */
 static int curStride, curFormat = -1;
 /* Whether mipmaps must be created for all dimensions down to 1x1 or not */
@@ -1592,6 +1592,7 @@ void Gfx_OnWindowResize(void) {
 #define FTR_LINEAR_FOG (1 << 3)
 #define FTR_DENSIT_FOG (1 << 4)
 #define FTR_HASANY_FOG (FTR_LINEAR_FOG | FTR_DENSIT_FOG)
+#define FTR_CHUNK_UV   (1 << 5)
 #define FTR_FS_MEDIUMP (1 << 7)
 
 #define UNI_MVP_MATRIX (1 << 0)
@@ -1599,20 +1600,22 @@ void Gfx_OnWindowResize(void) {
 #define UNI_FOG_COL    (1 << 2)
 #define UNI_FOG_END    (1 << 3)
 #define UNI_FOG_DENS   (1 << 4)
-#define UNI_MASK_ALL   0x1F
+#define UNI_TEX_SCALE  (1 << 5)
+#define UNI_MASK_ALL   0x3F
 
 /* cached uniforms (cached for multiple programs */
 static struct Matrix _view, _proj, _mvp;
 static cc_bool gfx_alphaTest, gfx_texTransform;
 static float _texX, _texY;
+static float _texScaleU = 1.0f, _texScaleV = 1.0f;
 
 /* shader programs (emulate fixed function) */
 static struct GLShader {
 	int features;     /* what features are enabled for this shader */
 	int uniforms;     /* which associated uniforms need to be resent to GPU */
 	GLuint program;   /* OpenGL program ID (0 if not yet compiled) */
-	int locations[5]; /* location of uniforms (not constant) */
-} shaders[6 * 3] = {
+	int locations[6]; /* location of uniforms (not constant) */
+} shaders[8 * 3] = {
 	/* no fog */
 	{ 0              },
 	{ 0              | FTR_ALPHA_TEST },
@@ -1620,6 +1623,8 @@ static struct GLShader {
 	{ FTR_TEXTURE_UV | FTR_ALPHA_TEST },
 	{ FTR_TEXTURE_UV | FTR_TEX_OFFSET },
 	{ FTR_TEXTURE_UV | FTR_TEX_OFFSET | FTR_ALPHA_TEST },
+	{ FTR_TEXTURE_UV | FTR_CHUNK_UV },
+	{ FTR_TEXTURE_UV | FTR_CHUNK_UV   | FTR_ALPHA_TEST },
 	/* linear fog */
 	{ FTR_LINEAR_FOG | 0              },
 	{ FTR_LINEAR_FOG | 0              | FTR_ALPHA_TEST },
@@ -1627,6 +1632,8 @@ static struct GLShader {
 	{ FTR_LINEAR_FOG | FTR_TEXTURE_UV | FTR_ALPHA_TEST },
 	{ FTR_LINEAR_FOG | FTR_TEXTURE_UV | FTR_TEX_OFFSET },
 	{ FTR_LINEAR_FOG | FTR_TEXTURE_UV | FTR_TEX_OFFSET | FTR_ALPHA_TEST },
+	{ FTR_LINEAR_FOG | FTR_TEXTURE_UV | FTR_CHUNK_UV },
+	{ FTR_LINEAR_FOG | FTR_TEXTURE_UV | FTR_CHUNK_UV   | FTR_ALPHA_TEST },
 	/* density fog */
 	{ FTR_DENSIT_FOG | 0              },
 	{ FTR_DENSIT_FOG | 0              | FTR_ALPHA_TEST },
@@ -1634,6 +1641,8 @@ static struct GLShader {
 	{ FTR_DENSIT_FOG | FTR_TEXTURE_UV | FTR_ALPHA_TEST },
 	{ FTR_DENSIT_FOG | FTR_TEXTURE_UV | FTR_TEX_OFFSET },
 	{ FTR_DENSIT_FOG | FTR_TEXTURE_UV | FTR_TEX_OFFSET | FTR_ALPHA_TEST },
+	{ FTR_DENSIT_FOG | FTR_TEXTURE_UV | FTR_CHUNK_UV },
+	{ FTR_DENSIT_FOG | FTR_TEXTURE_UV | FTR_CHUNK_UV   | FTR_ALPHA_TEST },
 };
 static struct GLShader* gfx_activeShader;
 
@@ -1641,6 +1650,7 @@ static struct GLShader* gfx_activeShader;
 static void GenVertexShader(const struct GLShader* shader, cc_string* dst) {
 	int uv = shader->features & FTR_TEXTURE_UV;
 	int tm = shader->features & FTR_TEX_OFFSET;
+	int cu = shader->features & FTR_CHUNK_UV;
 
 	String_AppendConst(dst,         "attribute vec3 in_pos;\n");
 	String_AppendConst(dst,         "attribute vec4 in_col;\n");
@@ -1649,12 +1659,14 @@ static void GenVertexShader(const struct GLShader* shader, cc_string* dst) {
 	if (uv) String_AppendConst(dst, "varying vec2 out_uv;\n");
 	String_AppendConst(dst,         "uniform mat4 mvp;\n");
 	if (tm) String_AppendConst(dst, "uniform vec2 texOffset;\n");
+	if (cu) String_AppendConst(dst, "uniform vec2 texScale;\n");
 
 	String_AppendConst(dst,         "void main() {\n");
 	String_AppendConst(dst,         "  gl_Position = mvp * vec4(in_pos, 1.0);\n");
 	String_AppendConst(dst,         "  out_col = in_col;\n");
 	if (uv) String_AppendConst(dst, "  out_uv  = in_uv;\n");
 	if (tm) String_AppendConst(dst, "  out_uv  = out_uv + texOffset;\n");
+	if (cu) String_AppendConst(dst, "  out_uv  = out_uv * texScale;\n");
 	String_AppendConst(dst,         "}");
 }
 
@@ -1777,6 +1789,7 @@ static void CompileProgram(struct GLShader* shader) {
 		shader->locations[2] = glGetUniformLocation(program, "fogCol");
 		shader->locations[3] = glGetUniformLocation(program, "fogEnd");
 		shader->locations[4] = glGetUniformLocation(program, "fogDensity");
+		shader->locations[5] = glGetUniformLocation(program, "texScale");
 		return;
 	}
 	temp = 0;
@@ -1826,6 +1839,10 @@ static void ReloadUniforms(void) {
 		glUniform1f(s->locations[4], -gfx_fogDensity);
 		s->uniforms &= ~UNI_FOG_DENS;
 	}
+	if ((s->uniforms & UNI_TEX_SCALE) && (s->features & FTR_CHUNK_UV)) {
+		glUniform2f(s->locations[5], _texScaleU, _texScaleV);
+		s->uniforms &= ~UNI_TEX_SCALE;
+	}
 }
 
 /* Switches program to one that duplicates current fixed function state */
@@ -1835,13 +1852,17 @@ static void SwitchProgram(void) {
 	int index = 0;
 
 	if (gfx_fogEnabled) {
-		index += 6;                       /* linear fog */
-		if (gfx_fogMode >= 1) index += 6; /* exp fog */
+		index += 8;                       /* linear fog */
+		if (gfx_fogMode >= 1) index += 8; /* exp fog */
 	}
 
-	if (curFormat == VERTEX_FORMAT_TEXTURED) index += 2;
-	if (gfx_texTransform) index += 2;
-	if (gfx_alphaTest)    index += 1;
+	if (curFormat == VERTEX_FORMAT_CHUNK) {
+		index += 6;
+	} else {
+		if (curFormat == VERTEX_FORMAT_TEXTURED) index += 2;
+		if (gfx_texTransform) index += 2;
+	}
+	if (gfx_alphaTest) index += 1;
 
 	shader = &shaders[index];
 	if (shader == gfx_activeShader) { ReloadUniforms(); return; }
@@ -1907,6 +1928,13 @@ void Gfx_DisableTextureOffset(void) {
 	SwitchProgram();
 }
 
+void Gfx_SetChunkTexScale(float u, float v) {
+	if (_texScaleU == 1.0f / u && _texScaleV == 1.0f / v) return;
+	_texScaleU = 1.0f / u; _texScaleV = 1.0f / v;
+	DirtyUniform(UNI_TEX_SCALE);
+	ReloadUniforms();
+}
+
 static void GL_CheckSupport(void) {
 #ifndef CC_BUILD_GLES
 	customMipmapsLevels = true;
@@ -1961,6 +1989,19 @@ static void GL_SetupVbTextured_Range(int startVertex) {
 	glVertexAttribPointer(2, 2, GL_FLOAT,         false, SIZEOF_VERTEX_TEXTURED, (void*)(offset + 16));
 }
 
+static void GL_SetupVbChunk(void) {
+	glVertexAttribPointer(0, 3, GL_SHORT,         false, SIZEOF_VERTEX_CHUNK, (void*)0);
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, true,  SIZEOF_VERTEX_CHUNK, (void*)8);
+	glVertexAttribPointer(2, 2, GL_SHORT,         false, SIZEOF_VERTEX_CHUNK, (void*)12);
+}
+
+static void GL_SetupVbChunk_Range(int startVertex) {
+	cc_uint32 offset = startVertex * SIZEOF_VERTEX_CHUNK;
+	glVertexAttribPointer(0, 3, GL_SHORT,         false, SIZEOF_VERTEX_CHUNK, (void*)(offset));
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, true,  SIZEOF_VERTEX_CHUNK, (void*)(offset + 8));
+	glVertexAttribPointer(2, 2, GL_SHORT,         false, SIZEOF_VERTEX_CHUNK, (void*)(offset + 12));
+}
+
 void Gfx_SetVertexFormat(VertexFormat fmt) {
 	if (fmt == curFormat) return;
 	curFormat = fmt;
@@ -1970,6 +2011,10 @@ void Gfx_SetVertexFormat(VertexFormat fmt) {
 		glEnableVertexAttribArray(2);
 		gfx_setupVBFunc      = GL_SetupVbTextured;
 		gfx_setupVBRangeFunc = GL_SetupVbTextured_Range;
+	} else if (fmt == VERTEX_FORMAT_CHUNK) {
+		glEnableVertexAttribArray(2);
+		gfx_setupVBFunc      = GL_SetupVbChunk;
+		gfx_setupVBRangeFunc = GL_SetupVbChunk_Range;
 	} else {
 		glDisableVertexAttribArray(2);
 		gfx_setupVBFunc      = GL_SetupVbColoured;
@@ -1995,14 +2040,14 @@ void Gfx_DrawVb_IndexedTris(int verticesCount) {
 
 void Gfx_BindVb_T2fC4b(GfxResourceID vb) {
 	Gfx_BindVb(vb);
-	GL_SetupVbTextured();
+	gfx_setupVBFunc();
 }
 
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
 	if (startVertex + verticesCount > GFX_MAX_VERTICES) {
-		GL_SetupVbTextured_Range(startVertex);
+		gfx_setupVBRangeFunc(startVertex);
 		glDrawElements(GL_TRIANGLES, ICOUNT(verticesCount), GL_UNSIGNED_SHORT, NULL);
-		GL_SetupVbTextured();
+		gfx_setupVBFunc();
 	} else {
 		/* ICOUNT(startVertex) * 2 = startVertex * 3  */
 		glDrawElements(GL_TRIANGLES, ICOUNT(verticesCount), GL_UNSIGNED_SHORT, (void*)(startVertex * 3));
@@ -2144,8 +2189,38 @@ static void GL_SetupVbTextured_Range(int startVertex) {
 	glTexCoordPointer(2, GL_FLOAT,        SIZEOF_VERTEX_TEXTURED, (void*)(VB_PTR + offset + 16));
 }
 
+#ifdef CC_BUILD_COMPACTCHUNKS
+/* Undoes the fixed point scale of VertexChunk texture coordinates */
+static struct Matrix chunkTexMatrix = Matrix_IdentityValue;
+void Gfx_SetChunkTexScale(float u, float v) {
+	chunkTexMatrix.row1.X = 1.0f / u;
+	chunkTexMatrix.row2.Y = 1.0f / v;
+	if (curFormat == VERTEX_FORMAT_CHUNK) Gfx_LoadMatrix(2, &chunkTexMatrix);
+}
+
+static void GL_SetupVbChunk(void) {
+	glVertexPointer(3, GL_SHORT,        SIZEOF_VERTEX_CHUNK, (void*)(VB_PTR + 0));
+	glColorPointer(4, GL_UNSIGNED_BYTE, SIZEOF_VERTEX_CHUNK, (void*)(VB_PTR + 8));
+	glTexCoordPointer(2, GL_SHORT,      SIZEOF_VERTEX_CHUNK, (void*)(VB_PTR + 12));
+}
+
+static void GL_SetupVbChunk_Range(int startVertex) {
+	cc_uint32 offset = startVertex * SIZEOF_VERTEX_CHUNK;
+	glVertexPointer(3, GL_SHORT,        SIZEOF_VERTEX_CHUNK, (void*)(VB_PTR + offset));
+	glColorPointer(4, GL_UNSIGNED_BYTE, SIZEOF_VERTEX_CHUNK, (void*)(VB_PTR + offset + 8));
+	glTexCoordPointer(2, GL_SHORT,      SIZEOF_VERTEX_CHUNK, (void*)(VB_PTR + offset + 12));
+}
+#endif
+
 void Gfx_SetVertexFormat(VertexFormat fmt) {
 	if (fmt == curFormat) return;
+#ifdef CC_BUILD_COMPACTCHUNKS
+	if (fmt == VERTEX_FORMAT_CHUNK) {
+		Gfx_LoadMatrix(2, &chunkTexMatrix);
+	} else if (curFormat == VERTEX_FORMAT_CHUNK) {
+		Gfx_LoadIdentityMatrix(2);
+	}
+#endif
 	curFormat = fmt;
 	curStride = strideSizes[fmt];
 
@@ -2153,6 +2228,12 @@ void Gfx_SetVertexFormat(VertexFormat fmt) {
 		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
 		gfx_setupVBFunc      = GL_SetupVbTextured;
 		gfx_setupVBRangeFunc = GL_SetupVbTextured_Range;
+#ifdef CC_BUILD_COMPACTCHUNKS
+	} else if (fmt == VERTEX_FORMAT_CHUNK) {
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		gfx_setupVBFunc      = GL_SetupVbChunk;
+		gfx_setupVBRangeFunc = GL_SetupVbChunk_Range;
+#endif
 	} else {
 		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 		gfx_setupVBFunc      = GL_SetupVbColoured;
@@ -2183,11 +2264,8 @@ void Gfx_DrawVb_IndexedTris(int verticesCount) {
 
 #ifndef CC_BUILD_GL11
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
-	cc_uint32 offset = startVertex * SIZEOF_VERTEX_TEXTURED;
-	glVertexPointer(3, GL_FLOAT,        SIZEOF_VERTEX_TEXTURED, (void*)(offset));
-	glColorPointer(4, GL_UNSIGNED_BYTE, SIZEOF_VERTEX_TEXTURED, (void*)(offset + 12));
-	glTexCoordPointer(2, GL_FLOAT,      SIZEOF_VERTEX_TEXTURED, (void*)(offset + 16));
-	glDrawElements(GL_TRIANGLES,        ICOUNT(verticesCount),   GL_UNSIGNED_SHORT, NULL);
+	gfx_setupVBRangeFunc(startVertex);
+	glDrawElements(GL_TRIANGLES, ICOUNT(verticesCount), GL_UNSIGNED_SHORT, NULL);
 }
 
 static void GL_CheckSupport(void) {
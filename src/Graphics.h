@@ -12,7 +12,7 @@ struct IGameComponent;
 extern struct IGameComponent Gfx_Component;
 
 typedef enum VertexFormat_ {
-	VERTEX_FORMAT_COLOURED, VERTEX_FORMAT_TEXTURED
+	VERTEX_FORMAT_COLOURED, VERTEX_FORMAT_TEXTURED, VERTEX_FORMAT_CHUNK
 } VertexFormat;
 typedef enum FogFunc_ {
 	FOG_LINEAR, FOG_EXP, FOG_EXP2
@@ -23,11 +23,18 @@ typedef enum MatrixType_ {
 
 #define SIZEOF_VERTEX_COLOURED 16
 #define SIZEOF_VERTEX_TEXTURED 24
+#define SIZEOF_VERTEX_CHUNK    16
+/* Fixed point scale of VertexChunk positions */
+#define VERTEX_CHUNK_POS_SCALE 1024
 
 /* 3 floats for position (XYZ), 4 bytes for colour. */
 struct VertexColoured { float X, Y, Z; PackedCol Col; };
 /* 3 floats for position (XYZ), 2 floats for texture coordinates (UV), 4 bytes for colour. */
 struct VertexTextured { float X, Y, Z; PackedCol Col; float U, V; };
+/* 3 fixed point shorts for position (XYZ) relative to chunk origin, 4 bytes for colour, */
+/*  2 fixed point shorts for texture coordinates (UV). W is unused padding. */
+/* NOTE: Only supported when CC_BUILD_COMPACTCHUNKS is defined. */
+struct VertexChunk { cc_int16 X, Y, Z, W; PackedCol Col; cc_int16 U, V; };
 
 void Gfx_Create(void);
 void Gfx_Free(void);
@@ -172,6 +179,7 @@ CC_API void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex);
 /* Renders vertices from the currently bound vertex and index buffer as triangles. */
 CC_API void Gfx_DrawVb_IndexedTris(int verticesCount);
 /* Special case Gfx_DrawVb_IndexedTris_Range for map renderer */
+/* NOTE: Vertices are in the current vertex format. (textured, or chunk when CC_BUILD_COMPACTCHUNKS) */
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex);
 
 /* Loads the given matrix over the currently active matrix. */
@@ -180,6 +188,10 @@ CC_API void Gfx_LoadMatrix(MatrixType type, struct Matrix* matrix);
 CC_API void Gfx_LoadIdentityMatrix(MatrixType type);
 CC_API void Gfx_EnableTextureOffset(float x, float y);
 CC_API void Gfx_DisableTextureOffset(void);
+#ifdef CC_BUILD_COMPACTCHUNKS
+/* Sets the fixed point scale that VertexChunk texture coordinates are divided by. */
+void Gfx_SetChunkTexScale(float u, float v);
+#endif
 /* Calculates an orthographic matrix suitable with this backend. (usually for 2D) */
 void Gfx_CalcOrthoMatrix(float width, float height, struct Matrix* matrix);
 /* Calculates a projection matrix suitable with this backend. (usually for 3D) */
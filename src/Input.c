@@ -645,14 +645,17 @@ static cc_bool PushbackPlace(struct AABB* blockBB) {
 
 static cc_bool IntersectsOthers(Vec3 pos, BlockID block) {
 	struct AABB blockBB, entityBB;
+	const EntityID* ids;
 	struct Entity* e;
-	int id;
+	int i, count;
 
 	Vec3_Add(&blockBB.Min, &pos, &Blocks.MinBB[block]);
 	Vec3_Add(&blockBB.Max, &pos, &Blocks.MaxBB[block]);
+	ids = Entities_UNSAFE_GetIDs(&count);
 	
-	for (id = 0; id < ENTITIES_SELF_ID; id++) {
-		e = Entities.List[id];
+	for (i = 0; i < count; i++) {
+		if (ids[i] == ENTITIES_SELF_ID) continue;
+		e = Entities.List[ids[i]];
 		if (!e) continue;
 
 		Entity_GetBounds(e, &entityBB);
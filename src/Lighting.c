@@ -7,10 +7,27 @@
 #include "Logger.h"
 #include "Event.h"
 #include "Game.h"
+#include "Workers.h"
 
 cc_int16* Lighting_Heightmap;
+int Lighting_HeightmapTime;
 #define HEIGHT_UNCALCULATED Int16_MaxValue
 
+#if defined PALETTE_BLOCKS
+/* World_GetBlock is slow with palette chunks, so rows and columns of blocks are read at once instead */
+#define Lighting_ReadRow(x, y, z, count) World_GetBlockRow(row, x, y, z, count);
+
+/* Returns the block at the given coordinates, while going down a column starting at maxY */
+/* NOTE: The rest of the column in the same chunk is read when y is the first block read from a chunk */
+static CC_INLINE BlockID Lighting_ColumnBlock(BlockID* column, int x, int y, int z, int maxY) {
+	int cy = y & CHUNK_MASK;
+	if (y == maxY || cy == CHUNK_MASK) World_GetBlockColumn(column, x, y - cy, z, cy + 1);
+	return column[cy];
+}
+#else
+#define Lighting_ReadRow(x, y, z, count)
+#endif
+
 #define Lighting_CalcBody(get_block)\
 for (y = maxY; y >= 0; y--, i -= World.OneY) {\
 	block = get_block;\
@@ -26,14 +43,16 @@ static int Lighting_CalcHeightAt(int x, int maxY, int z, int hIndex) {
 	int i = World_Pack(x, maxY, z);
 	BlockID block;
 	int y, offset;
-
-#ifndef EXTENDED_BLOCKS
+#if defined PALETTE_BLOCKS
+	BlockID column[CHUNK_SIZE];
+	Lighting_CalcBody(Lighting_ColumnBlock(column, x, y, z, maxY));
+#elif !defined EXTENDED_BLOCKS
 	Lighting_CalcBody(World.Blocks[i]);
 #else
 	if (World.IDMask <= 0xFF) {
 		Lighting_CalcBody(World.Blocks[i]);
 	} else {
-		Lighting_CalcBody(World.Blocks[i] | (World.Blocks2[i] << 8));
+		Lighting_CalcBody(World.Blocks[i] | (World_GetUpper(i) << 8));
 	}
 #endif
 
@@ -138,17 +157,21 @@ for (; y >= minY; y--, i -= World.OneY) {\
 	if (affected) return true;\
 }
 
-static cc_bool Lighting_NeedsNeighour(BlockID block, int i, int minY, int y, int nY) {
+static cc_bool Lighting_NeedsNeighour(BlockID block, int x, int z, int minY, int y, int nY) {
+	int i = World_Pack(x, y, z);
 	BlockID other;
 	cc_bool affected;
-
-#ifndef EXTENDED_BLOCKS
+#if defined PALETTE_BLOCKS
+	BlockID column[CHUNK_SIZE];
+	int maxY = y;
+	Lighting_NeedsNeighourBody(Lighting_ColumnBlock(column, x, y, z, maxY));
+#elif !defined EXTENDED_BLOCKS
 	Lighting_NeedsNeighourBody(World.Blocks[i]);
 #else
 	if (World.IDMask <= 0xFF) {
 		Lighting_NeedsNeighourBody(World.Blocks[i]);
 	} else {
-		Lighting_NeedsNeighourBody(World.Blocks[i] | (World.Blocks2[i] << 8));
+		Lighting_NeedsNeighourBody(World.Blocks[i] | (World_GetUpper(i) << 8));
 	}
 #endif
 	return false;
@@ -160,7 +183,7 @@ static void Lighting_ResetNeighbour(int x, int y, int z, BlockID block, int cx,
 	if (minCy == maxCy) {
 		minY = cy << CHUNK_SHIFT;
 
-		if (Lighting_NeedsNeighour(block, World_Pack(x, y, z), minY, y, y)) {
+		if (Lighting_NeedsNeighour(block, x, z, minY, y, y)) {
 			MapRenderer_RefreshChunk(cx, cy, cz);
 		}
 	} else {
@@ -169,7 +192,7 @@ static void Lighting_ResetNeighbour(int x, int y, int z, BlockID block, int cx,
 			maxY = (cy << CHUNK_SHIFT) + CHUNK_MAX;
 			if (maxY > World.MaxY) maxY = World.MaxY;
 
-			if (Lighting_NeedsNeighour(block, World_Pack(x, maxY, z), minY, maxY, y)) {
+			if (Lighting_NeedsNeighour(block, x, z, minY, maxY, y)) {
 				MapRenderer_RefreshChunk(cx, cy, cz);
 			}
 		}
@@ -233,6 +256,133 @@ void Lighting_OnBlockChanged(int x, int y, int z, BlockID oldBlock, BlockID newB
 }
 
 
+/*########################################################################################################################*
+*-------------------------------------------------Lighting batched update-------------------------------------------------*
+*#########################################################################################################################*/
+#define LIGHTING_MAX_BATCH 256
+#define LIGHTING_BATCH_HASH (LIGHTING_MAX_BATCH * 2)
+/* Summary of the blocks changed in a single column of the world in a batch */
+struct LightingColumn { int x, z, hIndex, minY, maxY; cc_bool lightChanged; };
+static struct LightingColumn batchColumns[LIGHTING_MAX_BATCH];
+static cc_int16 batchSlots[LIGHTING_BATCH_HASH];
+
+static struct LightingColumn* Lighting_GetColumn(int x, int z, int* numColumns) {
+	int hIndex = Lighting_Pack(x, z);
+	int slot   = (hIndex * 31) & (LIGHTING_BATCH_HASH - 1);
+	struct LightingColumn* col;
+
+	for (; batchSlots[slot] >= 0; slot = (slot + 1) & (LIGHTING_BATCH_HASH - 1)) {
+		col = &batchColumns[batchSlots[slot]];
+		if (col->hIndex == hIndex) return col;
+	}
+
+	batchSlots[slot] = *numColumns;
+	col = &batchColumns[(*numColumns)++];
+	col->x = x; col->z = z; col->hIndex = hIndex;
+	col->minY = Int32_MaxValue; col->maxY = -1;
+	col->lightChanged = false;
+	return col;
+}
+
+static void Lighting_RefreshNeighbourColumn(int x, int z, int cx, int cz, int minCy, int maxCy) {
+	int cy, minY, maxY;
+	for (cy = maxCy; cy >= minCy; cy--) {
+		minY = (cy << CHUNK_SHIFT);
+		maxY = (cy << CHUNK_SHIFT) + CHUNK_MAX;
+		if (maxY > World.MaxY) maxY = World.MaxY;
+
+		/* nY of -1 means any non-gas block in this part of the column needs redrawing */
+		if (Lighting_NeedsNeighour(BLOCK_AIR, x, z, minY, maxY, -1)) {
+			MapRenderer_RefreshChunk(cx, cy, cz);
+		}
+	}
+}
+
+static void Lighting_UpdateColumn(struct LightingColumn* col) {
+	int x = col->x, cx = x >> CHUNK_SHIFT, bX = x & CHUNK_MASK;
+	int z = col->z, cz = z >> CHUNK_SHIFT, bZ = z & CHUNK_MASK;
+	int oldHeight = Lighting_Heightmap[col->hIndex], newHeight = oldHeight;
+	int minCy = col->minY >> CHUNK_SHIFT, maxCy = col->maxY >> CHUNK_SHIFT;
+	int oldCy, newCy, cy, top;
+
+	if (col->lightChanged) {
+		/* Blocks above both the old light height and highest changed block still do not block light */
+		top = max(oldHeight + 1, col->maxY);
+		if (top > World.MaxY) top = World.MaxY;
+		newHeight = Lighting_CalcHeightAt(x, top, z, col->hIndex);
+	}
+
+	if (newHeight != oldHeight) {
+		oldCy = oldHeight + 1 < 0 ? 0 : (oldHeight + 1) >> 4;
+		newCy = newHeight + 1 < 0 ? 0 : (newHeight + 1) >> 4;
+
+		for (cy = max(oldCy, newCy); cy >= min(oldCy, newCy); cy--) {
+			MapRenderer_RefreshChunk(cx, cy, cz);
+		}
+		minCy = min(minCy, min(oldCy, newCy));
+		maxCy = max(maxCy, max(oldCy, newCy));
+	}
+
+	if (bX == 0 && cx > 0) {
+		Lighting_RefreshNeighbourColumn(x - 1, z, cx - 1, cz, minCy, maxCy);
+	}
+	if (bZ == 0 && cz > 0) {
+		Lighting_RefreshNeighbourColumn(x, z - 1, cx, cz - 1, minCy, maxCy);
+	}
+	if (bX == 15 && cx < MapRenderer_ChunksX - 1) {
+		Lighting_RefreshNeighbourColumn(x + 1, z, cx + 1, cz, minCy, maxCy);
+	}
+	if (bZ == 15 && cz < MapRenderer_ChunksZ - 1) {
+		Lighting_RefreshNeighbourColumn(x, z + 1, cx, cz + 1, minCy, maxCy);
+	}
+}
+
+void Lighting_OnBlocksChanged(const IVec3* coords, const BlockID* oldBlocks, const BlockID* newBlocks, int count) {
+	struct LightingColumn* col;
+	int i, x, y, z, cy, numColumns;
+	BlockID oldBlock, newBlock;
+
+	/* Heightmap is always recalculated from the final state of the world, so batches can be split up */
+	for (; count > LIGHTING_MAX_BATCH; count -= LIGHTING_MAX_BATCH) {
+		Lighting_OnBlocksChanged(coords, oldBlocks, newBlocks, LIGHTING_MAX_BATCH);
+		coords += LIGHTING_MAX_BATCH; oldBlocks += LIGHTING_MAX_BATCH; newBlocks += LIGHTING_MAX_BATCH;
+	}
+
+	numColumns = 0;
+	Mem_Set(batchSlots, 0xFF, sizeof(batchSlots));
+
+	for (i = 0; i < count; i++) {
+		x = coords[i].X; y = coords[i].Y; z = coords[i].Z;
+		/* Same as Lighting_OnBlockChanged, columns that were never lit never had any meshes built */
+		if (Lighting_Heightmap[Lighting_Pack(x, z)] == HEIGHT_UNCALCULATED) continue;
+
+		oldBlock = oldBlocks[i]; newBlock = newBlocks[i];
+		col = Lighting_GetColumn(x, z, &numColumns);
+		col->minY = min(col->minY, y);
+		col->maxY = max(col->maxY, y);
+
+		/* Same two cases as in Lighting_UpdateLighting that cannot change the heightmap */
+		if (Blocks.BlocksLight[oldBlock] != Blocks.BlocksLight[newBlock]) {
+			col->lightChanged = true;
+		} else if (Blocks.BlocksLight[oldBlock]) {
+			col->lightChanged |= ((Blocks.LightOffset[oldBlock] ^ Blocks.LightOffset[newBlock]) >> FACE_YMAX) & 1;
+		}
+
+		cy = y >> CHUNK_SHIFT;
+		if ((y & CHUNK_MASK) == 0 && cy > 0 && Lighting_Needs(newBlock, World_GetBlock(x, y - 1, z))) {
+			MapRenderer_RefreshChunk(x >> CHUNK_SHIFT, cy - 1, z >> CHUNK_SHIFT);
+		}
+		if ((y & CHUNK_MASK) == 15 && cy < MapRenderer_ChunksY - 1 && Lighting_Needs(newBlock, World_GetBlock(x, y + 1, z))) {
+			MapRenderer_RefreshChunk(x >> CHUNK_SHIFT, cy + 1, z >> CHUNK_SHIFT);
+		}
+	}
+
+	for (i = 0; i < numColumns; i++) {
+		Lighting_UpdateColumn(&batchColumns[i]);
+	}
+}
+
+
 /*########################################################################################################################*
 *---------------------------------------------------Lighting heightmap----------------------------------------------------*
 *#########################################################################################################################*/
@@ -269,6 +419,7 @@ for (y = World.Height - 1; y >= 0; y--) {\
 	for (z = 0; z < zCount; z++) {\
 		baseIndex = mapIndex;\
 		index = z * xCount;\
+		Lighting_ReadRow(x1, y, z1 + z, xCount)\
 		for (x = 0; x < xCount;) {\
 			curRunCount = skip[index];\
 			x += curRunCount; mapIndex += curRunCount; index += curRunCount;\
@@ -308,14 +459,16 @@ static cc_bool Lighting_CalculateHeightmapCoverage(int x1, int z1, int xCount, i
 	int lightOffset, offset;
 	int mapIndex, hIndex, baseIndex, index;
 	int x, y, z;
-
-#ifndef EXTENDED_BLOCKS
+#if defined PALETTE_BLOCKS
+	BlockID row[EXTCHUNK_SIZE];
+	Lighting_CalculateBody(row[x]);
+#elif !defined EXTENDED_BLOCKS
 	Lighting_CalculateBody(World.Blocks[mapIndex]);
 #else
 	if (World.IDMask <= 0xFF) {
 		Lighting_CalculateBody(World.Blocks[mapIndex]);
 	} else {
-		Lighting_CalculateBody(World.Blocks[mapIndex] | (World.Blocks2[mapIndex] << 8));
+		Lighting_CalculateBody(World.Blocks[mapIndex] | (World_GetUpper(mapIndex) << 8));
 	}
 #endif
 	return false;
@@ -349,18 +502,125 @@ void Lighting_LightHint(int startX, int startZ) {
 }
 
 
+/*########################################################################################################################*
+*-----------------------------------------------------Eager heightmap-----------------------------------------------------*
+*#########################################################################################################################*/
+/* Number of rows along Z that each worker calculates at once */
+#define LIGHTING_STRIP_ROWS 16
+/* Maximum number of columns along X that are calculated at once */
+#define LIGHTING_SEGMENT_SIZE 256
+/* 0 if block doesn't block light, otherwise 1 + light offset of the block */
+static cc_uint8 lightStates[BLOCK_COUNT];
+static cc_bool skipAir;
+
+/* Returns whether the given run of blocks in World.Blocks are all air, checking 8 blocks at a time */
+static cc_bool Lighting_IsAirRun(int i, int count) {
+	int end = i + count;
+	cc_uint64 blocks;
+	/* Check 8 blocks at once (copied, as World.Blocks isn't guaranteed to be suitably aligned) */
+	for (; i + 8 <= end; i += 8) {
+		Mem_Copy(&blocks, &World.Blocks[i], 8);
+		if (blocks) return false;
+	}
+	for (; i < end; i++) {
+		if (World.Blocks[i]) return false;
+	}
+	return true;
+}
+
+#define Lighting_CalcSegmentBody(get_block)\
+for (y = World.MaxY; y >= 0 && left; y--) {\
+	i = World_Pack(x1, y, z);\
+	/* Air makes up most of the upper part of maps, so skip past it quickly */\
+	if (skip && left == count && Lighting_IsAirRun(i, count)) continue;\
+	Lighting_ReadRow(x1, y, z, count)\
+\
+	for (j = 0, n = 0; j < left; j++) {\
+		x     = pending[j];\
+		state = lightStates[get_block];\
+\
+		if (state) {\
+			heights[x] = (cc_int16)(y - (state - 1));\
+		} else {\
+			pending[n++] = (cc_uint16)x;\
+		}\
+	}\
+	left = n;\
+}
+
+/* Calculates the light height of count columns starting at (x1, z) */
+static void Lighting_CalcHeightmapSegment(int x1, int z, int count) {
+	cc_uint16 pending[LIGHTING_SEGMENT_SIZE];
+#if defined PALETTE_BLOCKS
+	BlockID row[LIGHTING_SEGMENT_SIZE];
+#endif
+	cc_int16* heights = &Lighting_Heightmap[Lighting_Pack(x1, z)];
+	cc_bool skip = skipAir;
+	int i, j, n, x, y, state;
+	int left = count;
+
+	/* Only columns still not known to be in shadow need to be checked in each layer */
+	for (x = 0; x < count; x++) { pending[x] = (cc_uint16)x; }
+
+#if defined PALETTE_BLOCKS
+	/* Chunks would need to be unpacked to know a run of blocks is air */
+	skip = false;
+	Lighting_CalcSegmentBody(row[x]);
+#elif !defined EXTENDED_BLOCKS
+	Lighting_CalcSegmentBody(World.Blocks[i + x]);
+#else
+	if (World.IDMask <= 0xFF) {
+		Lighting_CalcSegmentBody(World.Blocks[i + x]);
+	} else {
+		/* Upper bits would also need to be checked to know a run of blocks is air */
+		skip = false;
+		Lighting_CalcSegmentBody(World.Blocks[i + x] | (World_GetUpper(i + x) << 8));
+	}
+#endif
+
+	for (j = 0; j < left; j++) { heights[pending[j]] = -10; }
+}
+
+static void Lighting_CalcHeightmapStrip(int item, int worker) {
+	int z    = item * LIGHTING_STRIP_ROWS;
+	int maxZ = min(z + LIGHTING_STRIP_ROWS, World.Length);
+	int x;
+
+	for (; z < maxZ; z++) {
+		for (x = 0; x < World.Width; x += LIGHTING_SEGMENT_SIZE) {
+			Lighting_CalcHeightmapSegment(x, z, min(LIGHTING_SEGMENT_SIZE, World.Width - x));
+		}
+	}
+}
+
+void Lighting_CalcHeightmap(void) {
+	cc_uint64 beg = Stopwatch_Measure();
+	int i, strips;
+
+	for (i = 0; i < BLOCK_COUNT; i++) {
+		lightStates[i] = Blocks.BlocksLight[i] ? 1 + ((Blocks.LightOffset[i] >> FACE_YMAX) & 1) : 0;
+	}
+	skipAir = !lightStates[BLOCK_AIR];
+
+	strips = (World.Length + (LIGHTING_STRIP_ROWS - 1)) / LIGHTING_STRIP_ROWS;
+	Workers_Run(Lighting_CalcHeightmapStrip, strips);
+	Lighting_HeightmapTime = (int)Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+}
+
+
 /*########################################################################################################################*
 *---------------------------------------------------Lighting component----------------------------------------------------*
 *#########################################################################################################################*/
 static void OnReset(void) {
 	Mem_Free(Lighting_Heightmap);
-	Lighting_Heightmap = NULL;
+	Lighting_Heightmap     = NULL;
+	Lighting_HeightmapTime = 0;
 }
 
 static void OnNewMapLoaded(void) {
 	Lighting_Heightmap = (cc_int16*)Mem_TryAlloc(World.Width * World.Length, 2);
 	if (Lighting_Heightmap) {
-		Lighting_Refresh();
+		Lighting_CalcHeightmap();
 	} else {
 		World_OutOfMemory();
 	}
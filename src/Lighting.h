@@ -1,6 +1,7 @@
 #ifndef CC_WORLDLIGHTING_H
 #define CC_WORLDLIGHTING_H
 #include "PackedCol.h"
+#include "Vectors.h"
 /* Manages lighting of blocks in the world.
 BasicLighting: Uses a simple heightmap, where each block is either in sun or shadow.
    Copyright 2014-2021 ClassiCube | Licensed under BSD-3
@@ -10,16 +11,25 @@ extern struct IGameComponent Lighting_Component;
 
 #define Lighting_Pack(x, z) ((x) + World.Width * (z))
 extern cc_int16* Lighting_Heightmap;
+/* Time taken to calculate the heightmap when the current map was loaded, in microseconds. */
+/* NOTE: 0 when the heightmap could not be allocated, as it is then never calculated. */
+extern int Lighting_HeightmapTime;
 
 /* Equivalent to (but far more optimised form of)
 * for x = startX; x < startX + 18; x++
 *   for z = startZ; z < startZ + 18; z++
 *      CalcLight(x, maxY, z)                         */
 void Lighting_LightHint(int startX, int startZ);
+/* Calculates the light height of every column in the world, split across the worker threads. */
+/* NOTE: This is done when a map is loaded, so that chunk building never has to calculate light heights. */
+void Lighting_CalcHeightmap(void);
 
 /* Called when a block is changed to update internal lighting state. */
 /* NOTE: Implementations ***MUST*** mark all chunks affected by this lighting change as needing to be refreshed. */
 void Lighting_OnBlockChanged(int x, int y, int z, BlockID oldBlock, BlockID newBlock);
+/* Called after multiple blocks have changed, instead of calling Lighting_OnBlockChanged for each block. */
+/* NOTE: The blocks must already be changed in the world, as each affected column is only recalculated once. */
+void Lighting_OnBlocksChanged(const IVec3* coords, const BlockID* oldBlocks, const BlockID* newBlocks, int count);
 void Lighting_Refresh(void);
 
 /* Returns whether the block at the given coordinates is fully in sunlight. */
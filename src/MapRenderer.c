@@ -14,9 +14,13 @@
 #include "Utils.h"
 #include "World.h"
 #include "Options.h"
+#include "Workers.h"
+#include "MeshCache.h"
 
 int MapRenderer_ChunksX, MapRenderer_ChunksY, MapRenderer_ChunksZ;
 int MapRenderer_1DUsedCount, MapRenderer_ChunksCount;
+cc_bool MapRenderer_OcclusionCulling;
+int MapRenderer_FrustumTests, MapRenderer_VisibleChunks;
 struct ChunkPartInfo* MapRenderer_PartsNormal;
 struct ChunkPartInfo* MapRenderer_PartsTranslucent;
 
@@ -43,8 +47,23 @@ static struct ChunkInfo** renderChunks;
 static int renderChunksCount;
 /* Distance of each chunk from the camera. */
 static cc_uint32* distances;
+/* Whether each chunk is inside the frustum. Unsorted. (i.e. same order as mapChunks) */
+static cc_uint8* inFrustum;
+/* Temp arrays used when sorting chunks by distance */
+static struct ChunkInfo** sortTempChunks;
+static cc_uint32* sortTempDists;
+static int sortTempCapacity;
 /* Maximum number of chunk updates that can be performed in one frame. */
+/* NOTE: This is per worker thread, so the actual limit is this multiplied by Workers_Count. */
 static int maxChunkUpdates;
+/* Chunks that need to have their meshes built at the end of this frame's chunk updates. */
+static struct ChunkInfo** pendingChunks;
+static int pendingChunksCount;
+/* Connects of each pending chunk from before it was deleted, FACE_COUNT values per chunk */
+static cc_uint8* pendingConnects;
+/* Whether which chunks are occluded needs to be recalculated */
+/* (e.g. because camera moved into another chunk, or a rebuilt chunk's Connects changed) */
+static cc_bool occlusionDirty;
 
 static void ChunkInfo_Reset(struct ChunkInfo* chunk, int x, int y, int z) {
 	chunk->CentreX = x + HALF_CHUNK_SIZE; chunk->CentreY = y + HALF_CHUNK_SIZE; 
@@ -55,6 +74,8 @@ static void ChunkInfo_Reset(struct ChunkInfo* chunk, int x, int y, int z) {
 
 	chunk->Visible = true;        chunk->Empty = false;
 	chunk->PendingDelete = false; chunk->AllAir = false;
+	chunk->Occluded = false;
+	Mem_Set(chunk->Connects, CHUNK_CONNECTS_ALL, FACE_COUNT);
 	chunk->DrawXMin = false; chunk->DrawXMax = false; chunk->DrawZMin = false;
 	chunk->DrawZMax = false; chunk->DrawYMin = false; chunk->DrawYMax = false;
 
@@ -102,6 +123,22 @@ static void CheckWeather(double delta) {
 #define DrawFaces(f1, f2, offset) Gfx_DrawIndexedTris_T2fC4b(part.Counts[f1] + part.Counts[f2], offset);
 #endif
 
+#ifdef CC_BUILD_COMPACTCHUNKS
+/* Chunk mesh positions are fixed point and relative to the chunk's origin */
+static void LoadChunkMatrix(struct ChunkInfo* info) {
+	struct Matrix m = Matrix_Identity;
+	float scale = 1.0f / VERTEX_CHUNK_POS_SCALE;
+
+	m.row1.X = scale; m.row2.Y = scale; m.row3.Z = scale;
+	m.row4.X = (float)(info->CentreX - HALF_CHUNK_SIZE);
+	m.row4.Y = (float)(info->CentreY - HALF_CHUNK_SIZE);
+	m.row4.Z = (float)(info->CentreZ - HALF_CHUNK_SIZE);
+
+	Matrix_Mul(&m, &m, &Gfx.View);
+	Gfx_LoadMatrix(MATRIX_VIEW, &m);
+}
+#endif
+
 #define DrawNormalFaces(minFace, maxFace) \
 if (drawMin && drawMax) { \
 	Gfx_SetFaceCulling(true); \
@@ -134,6 +171,9 @@ static void RenderNormalBatch(int batch) {
 #ifndef CC_BUILD_GL11
 		Gfx_BindVb_T2fC4b(info->Vb);
 #endif
+#ifdef CC_BUILD_COMPACTCHUNKS
+		LoadChunkMatrix(info);
+#endif
 
 		offset  = part.Offset + part.SpriteCount;
 		drawMin = info->DrawXMin && part.Counts[FACE_XMIN];
@@ -185,7 +225,10 @@ void MapRenderer_RenderNormal(double delta) {
 	int batch;
 	if (!mapChunks) return;
 
-	Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
+	Gfx_SetVertexFormat(CHUNK_VERTEX_FORMAT);
+#ifdef CC_BUILD_COMPACTCHUNKS
+	Gfx_SetChunkTexScale(CHUNK_TEX_SCALE_U, CHUNK_TEX_SCALE_V);
+#endif
 	Gfx_SetTexturing(true);
 	Gfx_SetAlphaTest(true);
 	
@@ -199,13 +242,13 @@ void MapRenderer_RenderNormal(double delta) {
 		}
 	}
 	Gfx_DisableMipmaps();
+#ifdef CC_BUILD_COMPACTCHUNKS
+	Gfx_LoadMatrix(MATRIX_VIEW, &Gfx.View);
+#endif
 
 	CheckWeather(delta);
 	Gfx_SetAlphaTest(false);
 	Gfx_SetTexturing(false);
-#if DEBUG_OCCLUSION
-	DebugPickedPos();
-#endif
 }
 
 #define DrawTranslucentFaces(minFace, maxFace) \
@@ -238,6 +281,9 @@ static void RenderTranslucentBatch(int batch) {
 #ifndef CC_BUILD_GL11
 		Gfx_BindVb_T2fC4b(info->Vb);
 #endif
+#ifdef CC_BUILD_COMPACTCHUNKS
+		LoadChunkMatrix(info);
+#endif
 
 		offset  = part.Offset;
 		drawMin = (inTranslucent || info->DrawXMin) && part.Counts[FACE_XMIN];
@@ -262,7 +308,10 @@ void MapRenderer_RenderTranslucent(double delta) {
 
 	/* First fill depth buffer */
 	vertices = Game_Vertices;
-	Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
+	Gfx_SetVertexFormat(CHUNK_VERTEX_FORMAT);
+#ifdef CC_BUILD_COMPACTCHUNKS
+	Gfx_SetChunkTexScale(CHUNK_TEX_SCALE_U, CHUNK_TEX_SCALE_V);
+#endif
 	Gfx_SetTexturing(false);
 	Gfx_SetAlphaBlending(false);
 	Gfx_SetColWriteMask(false, false, false, false);
@@ -290,6 +339,9 @@ void MapRenderer_RenderTranslucent(double delta) {
 		RenderTranslucentBatch(batch);
 	}
 	Gfx_DisableMipmaps();
+#ifdef CC_BUILD_COMPACTCHUNKS
+	Gfx_LoadMatrix(MATRIX_VIEW, &Gfx.View);
+#endif
 
 	Gfx_SetDepthWrite(true);
 	/* If we weren't under water, render weather after to blend properly */
@@ -317,10 +369,8 @@ static void DeleteChunk(struct ChunkInfo* info) {
 #endif
 
 	info->Empty = false; info->AllAir = false;
-#ifdef OCCLUSION
-	info.OcclusionFlags = 0;
-	info.OccludedFlags = 0;
-#endif
+	/* Connects is left as is, as it is still correct until a block in the chunk changes */
+	/*  (see MapRenderer_OnBlockChanged), and is compared against when the chunk is rebuilt */
 
 	if (info->NormalParts) {
 		ptr = info->NormalParts;
@@ -347,15 +397,34 @@ static void DeleteChunk(struct ChunkInfo* info) {
 	}
 }
 
-/* Builds the mesh (hence vertex buffer) for the given chunk, and updates internal state */
-static void BuildChunk(struct ChunkInfo* info, int* chunkUpdates) {
-	struct ChunkPartInfo* ptr;
-	int i;
+/* Occlusion only needs to be recalculated when which faces of a rebuilt chunk can see each other changed */
+static void CheckConnectsChanged(struct ChunkInfo* info, const cc_uint8* oldConnects) {
+	if (!Mem_Equal(info->Connects, oldConnects, FACE_COUNT)) occlusionDirty = true;
+}
+
+/* Deletes the given chunk, then queues it to have its mesh (hence vertex buffer) built */
+static void RebuildChunk(struct ChunkInfo* info, int* chunkUpdates) {
+	cc_uint8 connects[FACE_COUNT];
+	Mem_Copy(connects, info->Connects, FACE_COUNT);
+	DeleteChunk(info);
+	info->PendingDelete = false;
+
+	/* Empty chunks don't count towards the chunk updates limit */
+	if (Builder_IsChunkEmpty(info)) {
+		info->Empty = true;
+		CheckConnectsChanged(info, connects); return;
+	}
 
 	Game.ChunkUpdates++;
 	(*chunkUpdates)++;
-	info->PendingDelete = false;
-	Builder_MakeChunk(info);
+	Mem_Copy(&pendingConnects[pendingChunksCount * FACE_COUNT], connects, FACE_COUNT);
+	pendingChunks[pendingChunksCount++] = info;
+}
+
+/* Updates internal state after the mesh of the given chunk has been built */
+static void OnChunkBuilt(struct ChunkInfo* info) {
+	struct ChunkPartInfo* ptr;
+	int i;
 
 	if (!info->NormalParts && !info->TranslucentParts) {
 		info->Empty = true; return;
@@ -376,6 +445,88 @@ static void BuildChunk(struct ChunkInfo* info, int* chunkUpdates) {
 	}
 }
 
+/* Builds the meshes of all the queued chunks at once, so they can be built in parallel */
+static void BuildPendingChunks(void) {
+	int i;
+	Builder_MakeChunks(pendingChunks, pendingChunksCount);
+
+	for (i = 0; i < pendingChunksCount; i++) {
+		OnChunkBuilt(pendingChunks[i]);
+		CheckConnectsChanged(pendingChunks[i], &pendingConnects[i * FACE_COUNT]);
+	}
+	pendingChunksCount = 0;
+}
+
+
+/*########################################################################################################################*
+*----------------------------------------------------Occlusion culling----------------------------------------------------*
+*#########################################################################################################################*/
+/* A chunk which has been flood filled into, but whose neighbours have not been flood filled into yet */
+struct OcclusionEntry {
+	int index;      /* Index of the chunk (see MapRenderer_Pack) */
+	cc_uint8 from;  /* Face of the chunk that was flood filled through, or FACE_COUNT for the starting chunk */
+	cc_uint8 dirs;  /* Directions travelled so far, as a mask of faces */
+};
+static struct OcclusionEntry* occlusionQueue;
+static int occlusionCapacity;
+
+int MapRenderer_CalcOcclusion(struct ChunkInfo* chunks, int cx, int cy, int cz) {
+	static const int offsetsX[FACE_COUNT] = { -1,1, 0,0, 0,0 };
+	static const int offsetsY[FACE_COUNT] = { 0,0, 0,0, -1,1 };
+	static const int offsetsZ[FACE_COUNT] = { 0,0, -1,1, 0,0 };
+	struct OcclusionEntry cur, *next;
+	struct ChunkInfo* info;
+	int i, face, head, tail;
+	int x, y, z;
+
+	/* Can't tell what can be seen from outside the map, so just treat all chunks as possibly visible */
+	if (cx < 0 || cy < 0 || cz < 0 || cx >= MapRenderer_ChunksX
+		|| cy >= MapRenderer_ChunksY || cz >= MapRenderer_ChunksZ) {
+		for (i = 0; i < MapRenderer_ChunksCount; i++) { chunks[i].Occluded = false; }
+		return MapRenderer_ChunksCount;
+	}
+
+	if (MapRenderer_ChunksCount > occlusionCapacity) {
+		Mem_Free(occlusionQueue);
+		occlusionCapacity = MapRenderer_ChunksCount;
+		occlusionQueue    = (struct OcclusionEntry*)Mem_Alloc(occlusionCapacity, sizeof(struct OcclusionEntry), "occlusion queue");
+	}
+	for (i = 0; i < MapRenderer_ChunksCount; i++) { chunks[i].Occluded = true; }
+
+	cur.index = MapRenderer_Pack(cx, cy, cz);
+	cur.from  = FACE_COUNT;
+	cur.dirs  = 0;
+	chunks[cur.index].Occluded = false;
+	occlusionQueue[0] = cur;
+
+	/* Breadth first, so each chunk is flood filled into from the nearest path to the camera's chunk */
+	for (head = 0, tail = 1; head < tail; head++) {
+		cur  = occlusionQueue[head];
+		info = &chunks[cur.index];
+		x = info->CentreX >> CHUNK_SHIFT; y = info->CentreY >> CHUNK_SHIFT; z = info->CentreZ >> CHUNK_SHIFT;
+
+		for (face = 0; face < FACE_COUNT; face++) {
+			/* Only ever move away from the camera's chunk */
+			if (cur.dirs & (1 << (face ^ 1))) continue;
+			if (cur.from != FACE_COUNT && !(info->Connects[cur.from] & (1 << face))) continue;
+
+			cx = x + offsetsX[face]; cy = y + offsetsY[face]; cz = z + offsetsZ[face];
+			if (cx < 0 || cy < 0 || cz < 0 || cx >= MapRenderer_ChunksX
+				|| cy >= MapRenderer_ChunksY || cz >= MapRenderer_ChunksZ) continue;
+
+			i = MapRenderer_Pack(cx, cy, cz);
+			if (!chunks[i].Occluded) continue;
+			chunks[i].Occluded = false;
+
+			next = &occlusionQueue[tail++];
+			next->index = i;
+			next->from  = face ^ 1; /* e.g. moving in +X direction enters through X min face */
+			next->dirs  = cur.dirs | (1 << face);
+		}
+	}
+	return tail;
+}
+
 
 /*########################################################################################################################*
 *----------------------------------------------------Chunks mangagement---------------------------------------------------*
@@ -387,15 +538,27 @@ static void FreeParts(void) {
 }
 
 static void FreeChunks(void) {
+	Mem_Free(occlusionQueue);
+	occlusionQueue    = NULL;
+	occlusionCapacity = 0;
+
+	Mem_Free(sortTempChunks);
+	Mem_Free(sortTempDists);
+	sortTempChunks   = NULL;
+	sortTempDists    = NULL;
+	sortTempCapacity = 0;
+
 	Mem_Free(mapChunks);
 	Mem_Free(sortedChunks);
 	Mem_Free(renderChunks);
 	Mem_Free(distances);
+	Mem_Free(inFrustum);
 
 	mapChunks    = NULL;
 	sortedChunks = NULL;
 	renderChunks = NULL;
 	distances    = NULL;
+	inFrustum    = NULL;
 }
 
 static void AllocateParts(void) {
@@ -412,6 +575,7 @@ static void AllocateChunks(void) {
 	sortedChunks = (struct ChunkInfo**)Mem_Alloc(MapRenderer_ChunksCount, sizeof(struct ChunkInfo*), "sorted chunk info");
 	renderChunks = (struct ChunkInfo**)Mem_Alloc(MapRenderer_ChunksCount, sizeof(struct ChunkInfo*), "render chunk info");
 	distances    = (cc_uint32*)Mem_Alloc(MapRenderer_ChunksCount, 4, "chunk distances");
+	inFrustum    = (cc_uint8*)Mem_Alloc(MapRenderer_ChunksCount, 1, "chunks in frustum");
 }
 
 static void ResetPartFlags(void) {
@@ -473,7 +637,7 @@ void MapRenderer_Refresh(void) {
 	int oldCount;
 	chunkPos = IVec3_MaxValue();
 
-	if (mapChunks && World.Blocks) {
+	if (mapChunks && World_HasBlocks()) {
 		DeleteChunks();
 		ResetChunks();
 
@@ -494,7 +658,7 @@ static void RefreshBorderChunks(int maxHeight) {
 	cc_bool onBorder;
 
 	chunkPos = IVec3_MaxValue();
-	if (!mapChunks || !World.Blocks) return;
+	if (!mapChunks || !World_HasBlocks()) return;
 
 	for (cz = 0; cz < MapRenderer_ChunksZ; cz++) {
 		for (cy = 0; cy < MapRenderer_ChunksY; cy++) {
@@ -510,6 +674,80 @@ static void RefreshBorderChunks(int maxHeight) {
 }
 
 
+/*########################################################################################################################*
+*-----------------------------------------------------Frustum culling-----------------------------------------------------*
+*#########################################################################################################################*/
+/* Chunks are grouped into regions of 4x4x4 chunks, which are grouped into regions of 4x4x4 regions, and so on */
+/*  up to one region covering the whole map. Regions entirely inside or outside the frustum are accepted or */
+/*  rejected as a whole, so only chunks in regions on the edges of the frustum need to be tested individually. */
+#define REGION_SIZE 4
+#define CHUNK_RADIUS 14 /* 14 ~ sqrt(3 * 8^2) */
+
+static void MarkInFrustum(int x1, int y1, int z1, int x2, int y2, int z2) {
+	int x, y, z, index;
+	for (z = z1; z < z2; z++) {
+		for (y = y1; y < y2; y++) {
+			index = MapRenderer_Pack(x1, y, z);
+			for (x = x1; x < x2; x++, index++) { inFrustum[index] = true; }
+		}
+	}
+}
+
+static void CullRegion(int x1, int y1, int z1, int size) {
+	int x2 = min(x1 + size, MapRenderer_ChunksX);
+	int y2 = min(y1 + size, MapRenderer_ChunksY);
+	int z2 = min(z1 + size, MapRenderer_ChunksZ);
+	struct ChunkInfo* info;
+	int x, y, z, index;
+	Vec3 min, max;
+
+	/* Box covering the centres of all the chunks in this region */
+	min.X = (float)((x1 << CHUNK_SHIFT) + HALF_CHUNK_SIZE); max.X = (float)(((x2 - 1) << CHUNK_SHIFT) + HALF_CHUNK_SIZE);
+	min.Y = (float)((y1 << CHUNK_SHIFT) + HALF_CHUNK_SIZE); max.Y = (float)(((y2 - 1) << CHUNK_SHIFT) + HALF_CHUNK_SIZE);
+	min.Z = (float)((z1 << CHUNK_SHIFT) + HALF_CHUNK_SIZE); max.Z = (float)(((z2 - 1) << CHUNK_SHIFT) + HALF_CHUNK_SIZE);
+
+	MapRenderer_FrustumTests++;
+	switch (FrustumCulling_BoxInFrustum(&min, &max, CHUNK_RADIUS)) {
+	case FRUSTUM_OUTSIDE:
+		return;
+	case FRUSTUM_INSIDE:
+		MarkInFrustum(x1, y1, z1, x2, y2, z2); return;
+	}
+
+	if (size == REGION_SIZE) {
+		for (z = z1; z < z2; z++) {
+			for (y = y1; y < y2; y++) {
+				index = MapRenderer_Pack(x1, y, z);
+				for (x = x1; x < x2; x++, index++) {
+					info = &mapChunks[index];
+					inFrustum[index] = FrustumCulling_SphereInFrustum(info->CentreX, info->CentreY, info->CentreZ, CHUNK_RADIUS);
+				}
+			}
+		}
+		MapRenderer_FrustumTests += (x2 - x1) * (y2 - y1) * (z2 - z1);
+		return;
+	}
+
+	size /= REGION_SIZE;
+	for (z = z1; z < z2; z += size) {
+		for (y = y1; y < y2; y += size) {
+			for (x = x1; x < x2; x += size) { CullRegion(x, y, z, size); }
+		}
+	}
+}
+
+/* Calculates which chunks are inside the frustum */
+static void CalcInFrustum(void) {
+	int size = REGION_SIZE;
+	while (size < MapRenderer_ChunksX || size < MapRenderer_ChunksY || size < MapRenderer_ChunksZ) {
+		size *= REGION_SIZE;
+	}
+
+	Mem_Set(inFrustum, 0, MapRenderer_ChunksCount);
+	CullRegion(0, 0, 0, size);
+}
+
+
 /*########################################################################################################################*
 *--------------------------------------------------Chunks updating/sorting------------------------------------------------*
 *#########################################################################################################################*/
@@ -542,6 +780,7 @@ static int UpdateChunksAndVisibility(int* chunkUpdates) {
 	struct ChunkInfo* info;
 	int i, j = 0, distSqr;
 	cc_bool noData;
+	CalcInFrustum();
 
 	for (i = 0; i < MapRenderer_ChunksCount; i++) {
 		info = sortedChunks[i];
@@ -557,12 +796,11 @@ static int UpdateChunksAndVisibility(int* chunkUpdates) {
 		noData |= info->PendingDelete;
 
 		if (noData && distSqr <= buildDistSqr && *chunkUpdates < chunksTarget) {
-			DeleteChunk(info);
-			BuildChunk(info, chunkUpdates);
+			RebuildChunk(info, chunkUpdates);
 		}
 
-		info->Visible = distSqr <= renderDistSqr &&
-			FrustumCulling_SphereInFrustum(info->CentreX, info->CentreY, info->CentreZ, 14); /* 14 ~ sqrt(3 * 8^2) */
+		info->Visible = !info->Occluded && distSqr <= renderDistSqr &&
+			inFrustum[info - mapChunks];
 		if (info->Visible && !info->Empty) { renderChunks[j] = info; j++; }
 	}
 	return j;
@@ -590,12 +828,11 @@ static int UpdateChunksStill(int* chunkUpdates) {
 		noData |= info->PendingDelete;
 
 		if (noData && distSqr <= buildDistSqr && *chunkUpdates < chunksTarget) {
-			DeleteChunk(info);
-			BuildChunk(info, chunkUpdates);
+			RebuildChunk(info, chunkUpdates);
 
 			/* only need to update the visibility of chunks in range. */
-			info->Visible = distSqr <= renderDistSqr &&
-				FrustumCulling_SphereInFrustum(info->CentreX, info->CentreY, info->CentreZ, 14); /* 14 ~ sqrt(3 * 8^2) */
+			info->Visible = !info->Occluded && distSqr <= renderDistSqr &&
+				inFrustum[info - mapChunks];
 			if (info->Visible && !info->Empty) { renderChunks[j] = info; j++; }
 		} else if (info->Visible) {
 			renderChunks[j] = info; j++;
@@ -604,6 +841,16 @@ static int UpdateChunksStill(int* chunkUpdates) {
 	return j;
 }
 
+/* Removes chunks which turned out to be empty after being built from the list of chunks to render */
+static void RemoveEmptyChunks(void) {
+	int i, j = 0;
+	for (i = 0; i < renderChunksCount; i++) {
+		if (renderChunks[i]->Empty) continue;
+		renderChunks[j] = renderChunks[i]; j++;
+	}
+	renderChunksCount = j;
+}
+
 static void UpdateChunks(double delta) {
 	struct LocalPlayer* p;
 	cc_bool samePos;
@@ -611,15 +858,21 @@ static void UpdateChunks(double delta) {
 
 	/* Build more chunks if 30 FPS or over, otherwise slowdown */
 	chunksTarget += delta < CHUNK_TARGET_TIME ? 1 : -1; 
-	Math_Clamp(chunksTarget, 4, maxChunkUpdates);
+	Math_Clamp(chunksTarget, 4, maxChunkUpdates * Workers_Count);
 
 	p = &LocalPlayer_Instance;
 	samePos = Vec3_Equals(&Camera.CurrentPos, &lastCamPos)
 		&& p->Base.Pitch == lastPitch && p->Base.Yaw == lastYaw;
+	MapRenderer_FrustumTests = 0;
 
 	renderChunksCount = samePos ?
 		UpdateChunksStill(&chunkUpdates) :
 		UpdateChunksAndVisibility(&chunkUpdates);
+	if (chunkUpdates) {
+		BuildPendingChunks();
+		RemoveEmptyChunks();
+	}
+	MapRenderer_VisibleChunks = renderChunksCount;
 
 	lastCamPos = Camera.CurrentPos;
 	lastPitch  = p->Base.Pitch;
@@ -628,27 +881,95 @@ static void UpdateChunks(double delta) {
 	if (!samePos || chunkUpdates) ResetPartFlags();
 }
 
-static void SortMapChunks(int left, int right) {
-	struct ChunkInfo** values = sortedChunks; struct ChunkInfo* value;
-	cc_uint32* keys = distances; cc_uint32 key;
+/* Sorts chunks by distance using insertion sort, which is very fast when chunks are already mostly sorted */
+/* Returns false, leaving chunks only partially sorted, when chunks had to be moved more than maxMoves times */
+static cc_bool InsertionSortChunks(struct ChunkInfo** chunks, cc_uint32* dists, int count, int maxMoves) {
+	struct ChunkInfo* chunk;
+	cc_uint32 dist;
+	int i, j;
 
-	while (left < right) {
-		int i = left, j = right;
-		cc_uint32 pivot = keys[(i + j) >> 1];
+	for (i = 1; i < count; i++) {
+		dist  = dists[i];
+		chunk = chunks[i];
 
-		/* partition the list */
-		while (i <= j) {
-			while (pivot > keys[i]) i++;
-			while (pivot < keys[j]) j--;
-			QuickSort_Swap_KV_Maybe();
+		for (j = i - 1; j >= 0 && dists[j] > dist; j--) {
+			dists[j + 1]  = dists[j];
+			chunks[j + 1] = chunks[j];
 		}
-		/* recurse into the smaller subset */
-		QuickSort_Recurse(SortMapChunks)
+		dists[j + 1]  = dist;
+		chunks[j + 1] = chunk;
+
+		maxMoves -= (i - 1) - j;
+		if (maxMoves < 0) return false;
 	}
+	return true;
+}
+
+/* Sorts chunks by distance using LSD radix sort, one byte of the distances at a time */
+static void RadixSortChunks(struct ChunkInfo** chunks, cc_uint32* dists, int count) {
+	struct ChunkInfo** srcChunks = chunks;
+	struct ChunkInfo** dstChunks = sortTempChunks;
+	struct ChunkInfo** tmpChunks;
+	cc_uint32* srcDists = dists;
+	cc_uint32* dstDists = sortTempDists;
+	cc_uint32* tmpDists;
+
+	int offsets[4][256];
+	int i, pass, shift, total, digitCount, index;
+	/* Nothing to sort (and dists[0] may not even exist) */
+	if (count <= 1) return;
+	Mem_Set(offsets, 0, sizeof(offsets));
+
+	for (i = 0; i < count; i++) {
+		offsets[0][ dists[i]        & 0xFF]++;
+		offsets[1][(dists[i] >>  8) & 0xFF]++;
+		offsets[2][(dists[i] >> 16) & 0xFF]++;
+		offsets[3][(dists[i] >> 24)       ]++;
+	}
+
+	for (pass = 0, shift = 0; pass < 4; pass++, shift += 8) {
+		/* Nothing to sort when all distances have the same value for this byte (e.g. upper bytes are 0) */
+		if (offsets[pass][(dists[0] >> shift) & 0xFF] == count) continue;
+
+		for (i = 0, total = 0; i < 256; i++) {
+			digitCount = offsets[pass][i];
+			offsets[pass][i] = total;
+			total += digitCount;
+		}
+
+		for (i = 0; i < count; i++) {
+			index = offsets[pass][(srcDists[i] >> shift) & 0xFF]++;
+			dstDists[index]  = srcDists[i];
+			dstChunks[index] = srcChunks[i];
+		}
+
+		tmpDists  = srcDists;  srcDists  = dstDists;  dstDists  = tmpDists;
+		tmpChunks = srcChunks; srcChunks = dstChunks; dstChunks = tmpChunks;
+	}
+
+	if (srcDists == dists) return;
+	Mem_Copy(dists,  srcDists,  count * sizeof(cc_uint32));
+	Mem_Copy(chunks, srcChunks, count * sizeof(struct ChunkInfo*));
+}
+
+void MapRenderer_SortChunks(struct ChunkInfo** chunks, cc_uint32* distances, int count, cc_bool nearlySorted) {
+	if (count > sortTempCapacity) {
+		Mem_Free(sortTempChunks);
+		Mem_Free(sortTempDists);
+
+		sortTempCapacity = count;
+		sortTempChunks   = (struct ChunkInfo**)Mem_Alloc(count, sizeof(struct ChunkInfo*), "sort temp chunks");
+		sortTempDists    = (cc_uint32*)Mem_Alloc(count, 4, "sort temp distances");
+	}
+
+	/* Fall back to radix sort if insertion sort turns out to be too slow */
+	if (nearlySorted && InsertionSortChunks(chunks, distances, count, count)) return;
+	RadixSortChunks(chunks, distances, count);
 }
 
 static void UpdateSortOrder(void) {
 	struct ChunkInfo* info;
+	cc_bool nearlySorted;
 	IVec3 pos;
 	int i, dx, dy, dz;
 
@@ -660,6 +981,10 @@ static void UpdateSortOrder(void) {
 
 	/* If in same chunk, don't need to recalculate sort order */
 	if (pos.X == chunkPos.X && pos.Y == chunkPos.Y && pos.Z == chunkPos.Z) return;
+
+	/* Sort order barely changes when the camera only moves into a neighbouring chunk */
+	nearlySorted = chunkPos.X != Int32_MaxValue && Math_AbsI(pos.X - chunkPos.X) <= CHUNK_SIZE
+		&& Math_AbsI(pos.Y - chunkPos.Y) <= CHUNK_SIZE && Math_AbsI(pos.Z - chunkPos.Z) <= CHUNK_SIZE;
 	chunkPos = pos;
 	if (!MapRenderer_ChunksCount) return;
 
@@ -682,14 +1007,24 @@ static void UpdateSortOrder(void) {
 		info->DrawYMin = dy >= 0; info->DrawYMax = dy <= 0;
 	}
 
-	SortMapChunks(0, MapRenderer_ChunksCount - 1);
+	MapRenderer_SortChunks(sortedChunks, distances, MapRenderer_ChunksCount, nearlySorted);
 	ResetPartFlags();
-	/*SimpleOcclusionCulling();*/
+	occlusionDirty = true;
+}
+static void UpdateOcclusion(void) {
+	if (!occlusionDirty || !MapRenderer_OcclusionCulling) return;
+	occlusionDirty = false;
+
+	MapRenderer_CalcOcclusion(mapChunks, chunkPos.X >> CHUNK_SHIFT,
+		chunkPos.Y >> CHUNK_SHIFT, chunkPos.Z >> CHUNK_SHIFT);
+	/* Force visibility of all chunks to be recalculated */
+	lastCamPos = Vec3_BigPos();
 }
 
 void MapRenderer_Update(double delta) {
 	if (!mapChunks) return;
 	UpdateSortOrder();
+	UpdateOcclusion();
 	UpdateChunks(delta);
 }
 
@@ -714,8 +1049,14 @@ void MapRenderer_OnBlockChanged(int x, int y, int z, BlockID block) {
 
 	chunk = &mapChunks[MapRenderer_Pack(cx, cy, cz)];
 	chunk->AllAir &= Blocks.Draw[block] == DRAW_GAS;
-	/* TODO: Don't lookup twice, refresh directly using chunk pointer */
-	MapRenderer_RefreshChunk(cx, cy, cz);
+	if (chunk->AllAir) return; /* do not recreate chunks completely air */
+
+	chunk->Empty         = false;
+	chunk->PendingDelete = true;
+	MeshCache_Invalidate(MapRenderer_Pack(cx, cy, cz));
+	/* Block may have opened up a path through the chunk, so assume all faces see each other until rebuilt */
+	Mem_Set(chunk->Connects, CHUNK_CONNECTS_ALL, FACE_COUNT);
+	occlusionDirty = true;
 }
 
 static void OnEnvVariableChanged(void* obj, int envVar) {
@@ -800,6 +1141,9 @@ static void OnInit(void) {
 	MapRenderer_1DUsedCount = 87; /* Atlas1D_UsedAtlasesCount(); */
 	chunkPos   = IVec3_MaxValue();
 	maxChunkUpdates = Options_GetInt(OPT_MAX_CHUNK_UPDATES, 4, 1024, 30);
+	MapRenderer_OcclusionCulling = Options_GetBool(OPT_OCCLUSION_CULLING, true);
+	pendingChunks   = (struct ChunkInfo**)Mem_Alloc(maxChunkUpdates * Workers_Count, sizeof(struct ChunkInfo*), "pending chunks");
+	pendingConnects = (cc_uint8*)Mem_Alloc(maxChunkUpdates * Workers_Count, FACE_COUNT, "pending connects");
 	CalcViewDists();
 }
 
@@ -36,6 +36,24 @@ struct ChunkPartInfo {
 	cc_uint16 Counts[FACE_COUNT]; /* Counts per face */
 };
 
+#ifdef CC_BUILD_COMPACTCHUNKS
+/* Format of the vertices in chunk meshes */
+#define CHUNK_VERTEX_FORMAT VERTEX_FORMAT_CHUNK
+#define CHUNK_VERTEX_SIZE   SIZEOF_VERTEX_CHUNK
+/* Fixed point scale of texture coordinates in chunk meshes. */
+/* NOTE: V goes past 1 when the greedy mesh builder repeats a 1D atlas of just one tile */
+/* NOTE: With several tiles per 1D atlas, V is rounded to stay inside its tile (see Builder_CompactVertices), */
+/*  so the largest V is always 32767 and fits in a cc_int16 */
+#define CHUNK_TEX_SCALE_U 1024
+#define CHUNK_TEX_SCALE_V (Atlas1D.TilesPerAtlas > 1 ? 32768 : 1024)
+#else
+#define CHUNK_VERTEX_FORMAT VERTEX_FORMAT_TEXTURED
+#define CHUNK_VERTEX_SIZE   SIZEOF_VERTEX_TEXTURED
+#endif
+
+/* Value of ChunkInfo Connects for a face that can see all the other faces of the chunk. */
+#define CHUNK_CONNECTS_ALL ((1 << FACE_COUNT) - 1)
+
 /* Describes data necessary for rendering a chunk. */
 struct ChunkInfo {	
 	cc_uint16 CentreX, CentreY, CentreZ; /* Centre coordinates of the chunk */
@@ -44,6 +62,7 @@ struct ChunkInfo {
 	cc_uint8 Empty : 1;         /* Whether the chunk is empty of data */
 	cc_uint8 PendingDelete : 1; /* Whether chunk is pending deletion */
 	cc_uint8 AllAir : 1;        /* Whether chunk is completely air */
+	cc_uint8 Occluded : 1;      /* Whether chunk is hidden from the camera behind opaque blocks in other chunks */
 	cc_uint8 : 0;               /* pad to next byte*/
 
 	cc_uint8 DrawXMin : 1;
@@ -53,10 +72,9 @@ struct ChunkInfo {
 	cc_uint8 DrawYMin : 1;
 	cc_uint8 DrawYMax : 1;
 	cc_uint8 : 0;          /* pad to next byte */
-#ifdef OCCLUSION
-	public cc_bool Visited = false, Occluded = false;
-	public byte OcclusionFlags, OccludedFlags, DistanceFlags;
-#endif
+	/* Faces of the chunk that can be seen from each face, through the non-opaque blocks in the chunk */
+	/* e.g. Connects[FACE_XMIN] & (1 << FACE_YMAX) is whether top face can be seen from the left face */
+	cc_uint8 Connects[FACE_COUNT];
 #ifndef CC_BUILD_GL11
 	GfxResourceID Vb;
 #endif
@@ -80,4 +98,20 @@ void MapRenderer_RefreshChunk(int cx, int cy, int cz);
 void MapRenderer_OnBlockChanged(int x, int y, int z, BlockID block);
 /* Deletes all chunks and resets internal state. */
 void MapRenderer_Refresh(void);
+/* Whether chunks hidden from the camera behind opaque blocks in other chunks are skipped when rendering. */
+extern cc_bool MapRenderer_OcclusionCulling;
+/* Marks which of the given chunks cannot be seen from the given chunk, by flood filling outwards */
+/*  from that chunk through the faces of chunks that can see each other. (see ChunkInfo Connects) */
+/* Returns the number of chunks that may be visible. (i.e. that are not occluded) */
+/* NOTE: chunks must be in the same order as MapRenderer_Pack, and have MapRenderer_ChunksCount elements. */
+int MapRenderer_CalcOcclusion(struct ChunkInfo* chunks, int cx, int cy, int cz);
+/* Sorts the given chunks and their distances, from nearest to furthest distance. */
+/* nearlySorted is whether chunks are expected to be mostly in sorted order already, */
+/*  such as when distances were recalculated after camera moved into a neighbouring chunk. */
+void MapRenderer_SortChunks(struct ChunkInfo** chunks, cc_uint32* distances, int count, cc_bool nearlySorted);
+/* Number of frustum culling tests (of both chunks and regions of chunks) performed in the last frame. */
+/* NOTE: This is 0 when the camera did not move or rotate, as visibility is then not recalculated. */
+extern int MapRenderer_FrustumTests;
+/* Number of chunks which were visible (and hence drawn) in the last frame. */
+extern int MapRenderer_VisibleChunks;
 #endif
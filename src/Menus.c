@@ -1364,7 +1364,10 @@ static void SaveLevelScreen_SaveMap(struct SaveLevelScreen* s, const cc_string*
 
 	res = Stream_CreateFile(&stream, path);
 	if (res) { Logger_SysWarn2(res, "creating", path); return; }
-	GZip_MakeStream(&compStream, &state, &stream);
+
+	/* Compressing large maps is slow, so try to compress across all the worker threads */
+	res = GZip_MakeParallelStream(&compStream, &stream, DEFLATE_DEFAULT_LEVEL);
+	if (res) GZip_MakeStream(&compStream, &state, &stream);
 
 #ifdef CC_BUILD_WEB
 	res = Cw_Save(&compStream);
@@ -1377,6 +1380,7 @@ static void SaveLevelScreen_SaveMap(struct SaveLevelScreen* s, const cc_string*
 #endif
 
 	if (res) {
+		compStream.Close(&compStream);
 		stream.Close(&stream);
 		Logger_SysWarn2(res, "encoding", path); return;
 	}
@@ -0,0 +1,576 @@
+#include "MeshCache.h"
+#include "Game.h"
+#include "Options.h"
+#include "Platform.h"
+#include "Stream.h"
+#include "String.h"
+#include "Utils.h"
+#include "Logger.h"
+#include "World.h"
+#include "MapRenderer.h"
+#include "Graphics.h"
+#include "TexturePack.h"
+#include "Funcs.h"
+#include "Errors.h"
+
+cc_bool MeshCache_Enabled, MeshCache_Active;
+/* NOTE: Vertices are stored in the native endianness and vertex format, so the cache is only valid for this client */
+#define MESHCACHE_MAGIC   0x4843434DUL /* "MCCH" */
+#define MESHCACHE_VERSION 2
+/* Positions in the file are 32 bit, and seeking takes a signed offset */
+#define MESHCACHE_MAX_SIZE (256 * 1024 * 1024)
+/* Most space the cache files of all maps can take up, before the least recently used files are deleted */
+#define MESHCACHE_DIR_MAX_SIZE (1024 * 1024 * 1024)
+/* Cache files of maps not loaded for this many minutes are always deleted */
+#define MESHCACHE_MAX_UNUSED_MINS (30 * 24 * 60)
+/* Stores when the cache file of each map was last used */
+#define MESHCACHE_INDEX_FILE "meshcache/index.txt"
+/* Most vertices a chunk's mesh can have (every face of every block, plus sprites) */
+#define MESHCACHE_MAX_VERTICES (CHUNK_SIZE_3 * (FACE_COUNT + 4) * 4)
+/* Records are buffered in memory, and written to the file once this much is buffered or once a second */
+#define MESHCACHE_FLUSH_SIZE (4 * 1024 * 1024)
+
+struct MeshCacheHeader { cc_uint32 Magic, Version, VertexSize, ChunksCount; };
+/* Each mesh is appended as a record, followed by its parts and then its vertices */
+struct MeshCacheRecord {
+	cc_uint64 Key;
+	cc_uint32 Chunk, Count, CRC32, Check;
+	cc_uint8 Connects[FACE_COUNT];
+	cc_uint16 PartsCount;
+};
+
+static struct Stream cacheFile;
+static char pathBuffer[FILENAME_SIZE];
+static cc_string cachePath = String_FromArray(pathBuffer);
+static struct MeshCacheEntry* entries;
+static int entriesCount;
+/* Position new records are written at, and total size of the records still used */
+static cc_uint32 writePos, usedSize;
+/* Records not written to the file yet, which end at writePos */
+static cc_uint8* pendingData;
+static cc_uint32 pendingSize, pendingCapacity;
+/* Read only mapping of the whole cache file, so vertices can be copied without seeking and reading */
+/* NOTE: NULL when the file could not be mapped, in which case vertices are read from the file instead */
+static const cc_uint8* cacheMap;
+
+#define MESHCACHE_HASH_PRIME 0x9E3779B97F4A7C15ULL
+cc_uint64 MeshCache_Hash(cc_uint64 hash, const void* data, cc_uint32 length) {
+	const cc_uint8* src = (const cc_uint8*)data;
+	cc_uint64 word;
+	cc_uint32 i, lo, hi;
+
+	/* Mixes in 8 bytes at a time, to keep the chain of dependent multiplies short */
+	for (i = 0; i + 8 <= length; i += 8, src += 8) {
+		lo    = src[0] | (src[1] << 8) | (src[2] << 16) | ((cc_uint32)src[3] << 24);
+		hi    = src[4] | (src[5] << 8) | (src[6] << 16) | ((cc_uint32)src[7] << 24);
+		word  = lo | ((cc_uint64)hi << 32);
+		hash  = (hash ^ word) * MESHCACHE_HASH_PRIME;
+		hash ^= hash >> 32;
+	}
+	for (; i < length; i++, src++) {
+		hash  = (hash ^ *src) * MESHCACHE_HASH_PRIME;
+		hash ^= hash >> 32;
+	}
+	return hash;
+}
+
+static cc_uint32 MeshCache_RecordSize(const struct MeshCacheRecord* rec) {
+	return sizeof(struct MeshCacheRecord) + rec->PartsCount * sizeof(struct MeshCachePart) + rec->Count * CHUNK_VERTEX_SIZE;
+}
+
+/* Calculates the checksum of a record's header and parts, to detect partially written records */
+static cc_uint32 MeshCache_CalcCheck(struct MeshCacheRecord* rec, const struct MeshCachePart* parts) {
+	cc_uint32 check = rec->Check;
+	cc_uint64 hash;
+
+	rec->Check = 0;
+	hash = MeshCache_Hash(MESHCACHE_HASH_SEED, rec, sizeof(struct MeshCacheRecord));
+	hash = MeshCache_Hash(hash, parts, rec->PartsCount * sizeof(struct MeshCachePart));
+	rec->Check = check;
+	return (cc_uint32)(hash ^ (hash >> 32));
+}
+
+static void MeshCache_SetEntry(const struct MeshCacheRecord* rec, const struct MeshCachePart* parts, cc_uint32 pos) {
+	struct MeshCacheEntry* entry = &entries[rec->Chunk];
+	if (entry->Key) MeshCache_Invalidate(rec->Chunk);
+
+	entry->Key    = rec->Key;
+	entry->Offset = pos + sizeof(struct MeshCacheRecord) + rec->PartsCount * sizeof(struct MeshCachePart);
+	entry->CRC32  = rec->CRC32;
+	entry->Count  = rec->Count;
+	Mem_Copy(entry->Connects, rec->Connects, FACE_COUNT);
+
+	entry->PartsCount = rec->PartsCount;
+	if (rec->PartsCount) {
+		entry->Parts = (struct MeshCachePart*)Mem_Alloc(rec->PartsCount, sizeof(struct MeshCachePart), "cached mesh parts");
+		Mem_Copy(entry->Parts, parts, rec->PartsCount * sizeof(struct MeshCachePart));
+	}
+	usedSize += MeshCache_RecordSize(rec);
+}
+
+static cc_bool MeshCache_IsValid(struct MeshCacheRecord* rec, const struct MeshCachePart* parts) {
+	int i;
+	for (i = 0; i < rec->PartsCount; i++) {
+		if (parts[i].Index >= ATLAS1D_MAX_ATLASES * 2) return false;
+	}
+	return rec->Check == MeshCache_CalcCheck(rec, parts);
+}
+
+/* Reads the records in the cache file, stopping at the first partially written or corrupted record */
+static cc_result MeshCache_ReadRecords(cc_uint32 length) {
+	static struct MeshCachePart parts[ATLAS1D_MAX_ATLASES * 2];
+	struct MeshCacheRecord rec;
+	cc_uint32 pos = sizeof(struct MeshCacheHeader);
+	cc_result res;
+
+	usedSize = 0;
+	while (pos + sizeof(rec) <= length) {
+		if ((res = cacheFile.Seek(&cacheFile, pos)))                           return res;
+		if ((res = Stream_Read(&cacheFile, (cc_uint8*)&rec, sizeof(rec))))     return res;
+
+		if (rec.Chunk >= (cc_uint32)entriesCount || rec.Count > MESHCACHE_MAX_VERTICES) break;
+		if (rec.PartsCount > ATLAS1D_MAX_ATLASES * 2 || !rec.Key) break;
+		if (pos + MeshCache_RecordSize(&rec) > length) break;
+
+		res = Stream_Read(&cacheFile, (cc_uint8*)parts, rec.PartsCount * sizeof(struct MeshCachePart));
+		if (res) return res;
+		if (!MeshCache_IsValid(&rec, parts)) break;
+
+		MeshCache_SetEntry(&rec, parts, pos);
+		pos += MeshCache_RecordSize(&rec);
+	}
+	writePos = pos;
+	return 0;
+}
+
+/* Copies a record's data from one position in the file to an earlier position */
+static cc_result MeshCache_Move(cc_uint32 src, cc_uint32 dst, cc_uint32 size) {
+	static cc_uint8 buffer[64 * 1024];
+	cc_uint32 count;
+	cc_result res;
+
+	for (; size; size -= count, src += count, dst += count) {
+		count = min(size, sizeof(buffer));
+		if ((res = cacheFile.Seek(&cacheFile, src)))         return res;
+		if ((res = Stream_Read(&cacheFile,  buffer, count))) return res;
+		if ((res = cacheFile.Seek(&cacheFile, dst)))         return res;
+		if ((res = Stream_Write(&cacheFile, buffer, count))) return res;
+	}
+	return 0;
+}
+
+/* Writes an empty record at writePos, so that reading stops there instead of at any leftover data afterwards */
+static cc_result MeshCache_WriteEnd(void) {
+	static struct MeshCacheRecord end;
+	return Stream_Write(&cacheFile, (const cc_uint8*)&end, sizeof(end));
+}
+
+/* Moves the records still used towards the start of the file, over the records of meshes that were later rebuilt */
+/* NOTE: Records only ever move backwards, so the file stays readable (minus the record being moved) if this is interrupted */
+static cc_result MeshCache_Compact(void) {
+	struct MeshCacheEntry* entry;
+	struct MeshCacheRecord rec;
+	cc_uint32 src = sizeof(struct MeshCacheHeader), dst = src;
+	cc_uint32 size, dataOffset;
+	cc_result res;
+
+	while (src < writePos) {
+		if ((res = cacheFile.Seek(&cacheFile, src)))                       return res;
+		if ((res = Stream_Read(&cacheFile, (cc_uint8*)&rec, sizeof(rec)))) return res;
+
+		size       = MeshCache_RecordSize(&rec);
+		dataOffset = sizeof(rec) + rec.PartsCount * sizeof(struct MeshCachePart);
+		entry      = &entries[rec.Chunk];
+
+		/* Only the last record stored for a chunk is still used */
+		if (entry->Key && entry->Offset == src + dataOffset) {
+			if (dst != src && (res = MeshCache_Move(src, dst, size))) return res;
+			entry->Offset = dst + dataOffset;
+			dst += size;
+		}
+		src += size;
+	}
+
+	writePos = dst;
+	if ((res = cacheFile.Seek(&cacheFile, writePos))) return res;
+	return MeshCache_WriteEnd();
+}
+
+/* Starts the cache file afresh, discarding all of its records */
+static cc_result MeshCache_Reset(void) {
+	struct MeshCacheHeader header;
+	cc_result res;
+	int i;
+	for (i = 0; i < entriesCount; i++) { MeshCache_Invalidate(i); }
+
+	cacheFile.Close(&cacheFile);
+	Stream_Init(&cacheFile);
+	if ((res = Stream_CreateFile(&cacheFile, &cachePath))) return res;
+
+	header.Magic       = MESHCACHE_MAGIC;
+	header.Version     = MESHCACHE_VERSION;
+	header.VertexSize  = CHUNK_VERTEX_SIZE;
+	header.ChunksCount = entriesCount;
+
+	writePos = sizeof(header);
+	usedSize = 0;
+	return Stream_Write(&cacheFile, (cc_uint8*)&header, sizeof(header));
+}
+
+static cc_result MeshCache_Load(void) {
+	struct MeshCacheHeader header;
+	cc_uint32 length;
+	cc_result res;
+
+	if ((res = cacheFile.Length(&cacheFile, &length))) return res;
+	if (length < sizeof(header)) return MeshCache_Reset();
+
+	if ((res = cacheFile.Seek(&cacheFile, 0)))                                return res;
+	if ((res = Stream_Read(&cacheFile, (cc_uint8*)&header, sizeof(header)))) return res;
+
+	if (header.Magic != MESHCACHE_MAGIC || header.Version != MESHCACHE_VERSION
+		|| header.VertexSize != CHUNK_VERTEX_SIZE || header.ChunksCount != (cc_uint32)entriesCount) {
+		return MeshCache_Reset();
+	}
+	if ((res = MeshCache_ReadRecords(length))) return res;
+
+	/* Records of meshes that were later rebuilt are never used again, so reclaim their space when they take up most of the file */
+	if (writePos - usedSize > usedSize + 4 * 1024 * 1024) return MeshCache_Compact();
+	return 0;
+}
+
+/* Hashes the initial blocks of the map, so the cache file is the same whenever the same map is loaded */
+/* NOTE: World.Uuid is not used, as it is regenerated each time a map is loaded */
+#ifdef PALETTE_BLOCKS
+static cc_uint64 MeshCache_MapKey(void) {
+	BlockRaw tmp[8192];
+	int dims[3], i, count;
+	cc_uint64 key;
+	dims[0] = World.Width; dims[1] = World.Height; dims[2] = World.Length;
+	key = MeshCache_Hash(MESHCACHE_HASH_SEED, dims, sizeof(dims));
+
+	/* Blocks are hashed in pieces of a multiple of 8 bytes, so the key is the same as hashing them all at once */
+	for (i = 0; i < World.Volume; i += count) {
+		count = min(World.Volume - i, (int)sizeof(tmp));
+		World_UnpackLower(tmp, i, count);
+		key = MeshCache_Hash(key, tmp, count);
+	}
+	if (World.IDMask <= 0xFF) return key;
+
+	for (i = 0; i < World.Volume; i += count) {
+		count = min(World.Volume - i, (int)sizeof(tmp));
+		World_UnpackUpper(tmp, i, count);
+		key = MeshCache_Hash(key, tmp, count);
+	}
+	return key;
+}
+#else
+static cc_uint64 MeshCache_MapKey(void) {
+	int dims[3];
+	cc_uint64 key;
+	dims[0] = World.Width; dims[1] = World.Height; dims[2] = World.Length;
+
+	key = MeshCache_Hash(MESHCACHE_HASH_SEED, dims, sizeof(dims));
+	key = MeshCache_Hash(key, World.Blocks, World.Volume);
+#ifdef EXTENDED_BLOCKS
+	if (World.BlocksUpper) key = MeshCache_Hash(key, World.BlocksUpper, World_UpperSize(World.Volume));
+#endif
+	return key;
+}
+#endif
+
+/* Writes out the buffered records, and stops using the cache if that fails */
+static void MeshCache_Flush(void) {
+	cc_result res;
+	if (!pendingSize) return;
+
+	res = cacheFile.Seek(&cacheFile, writePos - pendingSize);
+	if (!res) res = Stream_Write(&cacheFile, pendingData, pendingSize);
+	if (!res) res = MeshCache_WriteEnd();
+
+	/* NOTE: Buffered records are kept, as meshes in the current batch may still need to read their vertices */
+	if (res) { Logger_SysWarn(res, "writing mesh cache"); MeshCache_Active = false; return; }
+	pendingSize = 0;
+}
+
+/* Maps the cache file into memory, if supported */
+/* NOTE: The whole maximum size is mapped, as the file keeps growing while it is used */
+static void MeshCache_Map(void) {
+	cc_result res = File_Map(cacheFile.Meta.File, MESHCACHE_MAX_SIZE, &cacheMap);
+	if (res && res != ERR_NOT_SUPPORTED) Platform_Log1("Mesh cache file not mapped (error %h)", &res);
+}
+
+static void MeshCache_Unmap(void) {
+	if (!cacheMap) return;
+	File_Unmap(cacheMap, MESHCACHE_MAX_SIZE);
+	cacheMap = NULL;
+}
+
+static void MeshCache_Close(void) {
+	int i;
+	if (MeshCache_Active) MeshCache_Flush();
+	MeshCache_Unmap();
+
+	Mem_Free(pendingData);
+	pendingData     = NULL;
+	pendingSize     = 0;
+	pendingCapacity = 0;
+	if (!entries) return;
+	for (i = 0; i < entriesCount; i++) { Mem_Free(entries[i].Parts); }
+
+	Mem_Free(entries);
+	entries      = NULL;
+	entriesCount = 0;
+	MeshCache_Active = false;
+	cacheFile.Close(&cacheFile);
+}
+
+/*########################################################################################################################*
+*-------------------------------------------------------Cache files-------------------------------------------------------*
+*#########################################################################################################################*/
+struct MeshCacheFileInfo { cc_uint32 Size, LastUsed; cc_bool Deleted, Pinned; };
+static struct StringsBuffer cacheFiles, cacheIndex;
+
+static void MeshCache_AddFile(const cc_string* path, void* obj) {
+	static const cc_string bin = String_FromConst(".bin");
+	if (String_CaselessEnds(path, &bin)) StringsBuffer_Add(&cacheFiles, path);
+}
+
+static cc_uint32 MeshCache_FileSize(const cc_string* path) {
+	cc_file file;
+	cc_uint32 size = 0;
+	if (File_Open(&file, path)) return 0;
+
+	File_Length(file, &size);
+	File_Close(file);
+	return size;
+}
+
+static cc_uint32 MeshCache_LastUsed(const cc_string* path, cc_uint32 now) {
+	cc_string value = EntryList_UNSAFE_Get(&cacheIndex, path, '=');
+	int mins;
+	/* Files not in the index yet are treated as just used */
+	if (!Convert_ParseInt(&value, &mins) || mins < 0 || (cc_uint32)mins > now) return now;
+	return mins;
+}
+
+static void MeshCache_DeleteFile(const cc_string* path, struct MeshCacheFileInfo* info) {
+	cc_result res = File_Delete(path);
+	/* Files that could not be deleted are left alone from then on */
+	if (res) { Logger_SysWarn2(res, "deleting", path); info->Pinned = true; return; }
+	info->Deleted = true;
+}
+
+/* Deletes the cache files of maps not loaded recently, then the least recently used */
+/*  cache files until all of them (including the current map's cache file) fit in MESHCACHE_DIR_MAX_SIZE */
+static void MeshCache_Prune(void) {
+	static const cc_string dir = String_FromConst("meshcache");
+	cc_string path, value; char valueBuffer[STRING_INT_CHARS];
+	struct MeshCacheFileInfo* infos = NULL;
+	cc_uint32 now, total = MESHCACHE_MAX_SIZE;
+	int i, oldest;
+
+	now = (cc_uint32)(DateTime_CurrentUTC_MS() / (60 * 1000));
+	EntryList_Load(&cacheIndex, MESHCACHE_INDEX_FILE, '=', NULL);
+	Directory_Enum(&dir, NULL, MeshCache_AddFile);
+	if (cacheFiles.count) {
+		infos = (struct MeshCacheFileInfo*)Mem_AllocCleared(cacheFiles.count, sizeof(struct MeshCacheFileInfo), "mesh cache files");
+	}
+
+	for (i = 0; i < cacheFiles.count; i++) {
+		path = StringsBuffer_UNSAFE_Get(&cacheFiles, i);
+		/* The current map's cache file is assumed to grow to its maximum size */
+		if (String_CaselessEquals(&path, &cachePath)) { infos[i].Pinned = true; continue; }
+
+		infos[i].Size     = MeshCache_FileSize(&path);
+		infos[i].LastUsed = MeshCache_LastUsed(&path, now);
+
+		if (now - infos[i].LastUsed > MESHCACHE_MAX_UNUSED_MINS) {
+			MeshCache_DeleteFile(&path, &infos[i]);
+		}
+		if (!infos[i].Deleted) total += infos[i].Size;
+	}
+
+	while (total > MESHCACHE_DIR_MAX_SIZE) {
+		oldest = -1;
+		for (i = 0; i < cacheFiles.count; i++) {
+			if (infos[i].Deleted || infos[i].Pinned) continue;
+			if (oldest == -1 || infos[i].LastUsed < infos[oldest].LastUsed) oldest = i;
+		}
+		if (oldest == -1) break;
+
+		total -= infos[oldest].Size;
+		path   = StringsBuffer_UNSAFE_Get(&cacheFiles, oldest);
+		MeshCache_DeleteFile(&path, &infos[oldest]);
+	}
+
+	/* Rewrite the index, so that it only contains the files still remaining */
+	StringsBuffer_Clear(&cacheIndex);
+	String_InitArray(value, valueBuffer);
+	for (i = 0; i < cacheFiles.count; i++) {
+		if (infos[i].Deleted) continue;
+		path = StringsBuffer_UNSAFE_Get(&cacheFiles, i);
+
+		value.length = 0;
+		String_AppendUInt32(&value, infos[i].LastUsed);
+		EntryList_Set(&cacheIndex, &path, &value, '=');
+	}
+
+	value.length = 0;
+	String_AppendUInt32(&value, now);
+	EntryList_Set(&cacheIndex, &cachePath, &value, '=');
+	EntryList_Save(&cacheIndex, MESHCACHE_INDEX_FILE);
+
+	Mem_Free(infos);
+	StringsBuffer_Clear(&cacheFiles);
+	StringsBuffer_Clear(&cacheIndex);
+}
+
+static void MeshCache_Open(void) {
+	cc_uint64 key;
+	cc_uint32 hi, lo;
+	cc_result res;
+	if (!Utils_EnsureDirectory("meshcache")) return;
+
+	key = MeshCache_MapKey();
+	hi  = (cc_uint32)(key >> 32);
+	lo  = (cc_uint32)key;
+	cachePath.length = 0;
+	String_Format2(&cachePath, "meshcache/%h%h.bin", &hi, &lo);
+	MeshCache_Prune();
+
+	res = Stream_AppendFile(&cacheFile, &cachePath);
+	if (res) { Logger_SysWarn2(res, "opening", &cachePath); return; }
+
+	/* Same number of chunks as MapRenderer, which may not have been told about the new map yet */
+	entriesCount = ((World.Width  + CHUNK_MAX) >> CHUNK_SHIFT) * ((World.Height + CHUNK_MAX) >> CHUNK_SHIFT)
+				 * ((World.Length + CHUNK_MAX) >> CHUNK_SHIFT);
+	entries      = (struct MeshCacheEntry*)Mem_AllocCleared(entriesCount, sizeof(struct MeshCacheEntry), "mesh cache");
+
+	res = MeshCache_Load();
+	if (res) { Logger_SysWarn2(res, "reading", &cachePath); MeshCache_Close(); return; }
+	MeshCache_Map();
+	MeshCache_Active = true;
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Mesh access-------------------------------------------------------*
+*#########################################################################################################################*/
+const struct MeshCacheEntry* MeshCache_Find(int chunkIndex, cc_uint64 key) {
+	if (!MeshCache_Active || entries[chunkIndex].Key != key) return NULL;
+	return &entries[chunkIndex];
+}
+
+cc_bool MeshCache_ReadVertices(const struct MeshCacheEntry* entry, void* vertices) {
+	cc_uint32 size = entry->Count * CHUNK_VERTEX_SIZE;
+	cc_uint32 pendingPos = writePos - pendingSize;
+	cc_result res;
+	if (!size) return true;
+
+	if (entry->Offset >= pendingPos) {
+		Mem_Copy(vertices, pendingData + (entry->Offset - pendingPos), size);
+		return true;
+	}
+
+	/* Records before pendingPos have been written, so always lie inside the file */
+	if (cacheMap) {
+		Mem_Copy(vertices, cacheMap + entry->Offset, size);
+		return Utils_CRC32((cc_uint8*)vertices, size) == entry->CRC32;
+	}
+
+	res = cacheFile.Seek(&cacheFile, entry->Offset);
+	if (!res) res = Stream_Read(&cacheFile, (cc_uint8*)vertices, size);
+
+	if (res) { Logger_SysWarn(res, "reading mesh cache"); return false; }
+	return Utils_CRC32((cc_uint8*)vertices, size) == entry->CRC32;
+}
+
+static void MeshCache_Append(const void* data, cc_uint32 size) {
+	if (pendingSize + size > pendingCapacity) {
+		pendingCapacity = max(pendingCapacity * 2, pendingSize + size);
+		pendingData     = (cc_uint8*)Mem_Realloc(pendingData, pendingCapacity, 1, "mesh cache records");
+	}
+	Mem_Copy(pendingData + pendingSize, data, size);
+	pendingSize += size;
+}
+
+/* Compacts the file to make room for a record, when the file has reached its maximum size */
+/* NOTE: This can take a while, but only happens after most of the chunks are rebuilt many times over */
+static cc_bool MeshCache_MakeRoom(cc_uint32 size) {
+	cc_result res;
+	if (writePos - usedSize < MESHCACHE_MAX_SIZE / 2) return false;
+
+	MeshCache_Flush();
+	if (!MeshCache_Active) return false;
+
+	res = MeshCache_Compact();
+	if (res) { Logger_SysWarn(res, "compacting mesh cache"); MeshCache_Active = false; return false; }
+	return writePos + size <= MESHCACHE_MAX_SIZE;
+}
+
+void MeshCache_Store(int chunkIndex, cc_uint64 key, const cc_uint8* connects,
+					const struct MeshCachePart* parts, int partsCount, const void* vertices, int count) {
+	struct MeshCacheRecord rec;
+	cc_uint32 size = count * CHUNK_VERTEX_SIZE, recordSize;
+	if (!MeshCache_Active) return;
+
+	rec.Key   = key;
+	rec.Chunk = chunkIndex;
+	rec.Count = count;
+	rec.CRC32 = Utils_CRC32((const cc_uint8*)vertices, size);
+	Mem_Copy(rec.Connects, connects, FACE_COUNT);
+	rec.PartsCount = partsCount;
+	rec.Check      = MeshCache_CalcCheck(&rec, parts);
+	recordSize     = MeshCache_RecordSize(&rec);
+	if (writePos + recordSize > MESHCACHE_MAX_SIZE && !MeshCache_MakeRoom(recordSize)) return;
+
+	MeshCache_Append(&rec,     sizeof(rec));
+	MeshCache_Append(parts,    partsCount * sizeof(struct MeshCachePart));
+	MeshCache_Append(vertices, size);
+
+	MeshCache_SetEntry(&rec, parts, writePos);
+	writePos += recordSize;
+	if (pendingSize >= MESHCACHE_FLUSH_SIZE) MeshCache_Flush();
+}
+
+void MeshCache_Invalidate(int chunkIndex) {
+	struct MeshCacheEntry* entry;
+	struct MeshCacheRecord rec;
+	if (!entries) return;
+
+	entry = &entries[chunkIndex];
+	if (!entry->Key) return;
+	rec.Count      = entry->Count;
+	rec.PartsCount = entry->PartsCount;
+	usedSize      -= MeshCache_RecordSize(&rec);
+
+	Mem_Free(entry->Parts);
+	entry->Parts = NULL;
+	entry->Key   = 0;
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------Cache component-----------------------------------------------------*
+*#########################################################################################################################*/
+static void MeshCache_FlushTask(struct ScheduledTask* task) {
+	if (MeshCache_Active) MeshCache_Flush();
+}
+
+static void OnInit(void) {
+	MeshCache_Enabled = Options_GetBool(OPT_MESH_CACHE, false);
+	ScheduledTask_Add(1, MeshCache_FlushTask);
+}
+
+static void OnNewMapLoaded(void) {
+	if (MeshCache_Enabled && World_HasBlocks()) MeshCache_Open();
+}
+
+struct IGameComponent MeshCache_Component = {
+	OnInit,          /* Init  */
+	MeshCache_Close, /* Free  */
+	NULL,            /* Reset */
+	MeshCache_Close, /* OnNewMap */
+	OnNewMapLoaded   /* OnNewMapLoaded */
+};
@@ -0,0 +1,47 @@
+#ifndef CC_MESHCACHE_H
+#define CC_MESHCACHE_H
+#include "Core.h"
+#include "Constants.h"
+/* Stores the built meshes of chunks on disk, so rejoining the same map does not need to build every chunk again.
+   Each map has its own cache file, which new meshes are appended to as chunks are built.
+   Copyright 2014-2021 ClassiCube | Licensed under BSD-3
+*/
+struct IGameComponent;
+extern struct IGameComponent MeshCache_Component;
+
+/* Whether meshes of chunks are cached on disk. (off by default) */
+extern cc_bool MeshCache_Enabled;
+/* Whether the mesh cache of the current map can be used. */
+extern cc_bool MeshCache_Active;
+
+/* Vertex counts of a part of a cached mesh */
+struct MeshCachePart {
+	cc_uint32 Index; /* Index of the part in the builder (see Builder1DPart) */
+	cc_uint32 Counts[FACE_COUNT + 1]; /* Vertices per face, then sprite vertices */
+};
+
+/* Describes the cached mesh of a chunk. */
+struct MeshCacheEntry {
+	cc_uint64 Key;    /* Hash of everything the mesh was built from, 0 if no valid mesh is cached */
+	cc_uint32 Offset; /* Position of the vertices in the cache file */
+	cc_uint32 CRC32;  /* Checksum of the vertices */
+	int Count, PartsCount;
+	cc_uint8 Connects[FACE_COUNT];
+	struct MeshCachePart* Parts;
+};
+
+/* Updates a running hash with the given data. Start with MESHCACHE_HASH_SEED. */
+cc_uint64 MeshCache_Hash(cc_uint64 hash, const void* data, cc_uint32 length);
+#define MESHCACHE_HASH_SEED 0xCBF29CE484222325ULL
+
+/* Returns the cached mesh of the given chunk, or NULL if there isn't one with the given key. */
+/* NOTE: Can be called from worker threads, as the cache is only ever modified by the main thread. */
+const struct MeshCacheEntry* MeshCache_Find(int chunkIndex, cc_uint64 key);
+/* Reads the vertices of the given cached mesh, returning false if they could not be read or are corrupted. */
+cc_bool MeshCache_ReadVertices(const struct MeshCacheEntry* entry, void* vertices);
+/* Appends the newly built mesh of the given chunk to the cache. */
+void MeshCache_Store(int chunkIndex, cc_uint64 key, const cc_uint8* connects,
+					const struct MeshCachePart* parts, int partsCount, const void* vertices, int count);
+/* Marks the cached mesh of the given chunk as out of date. (e.g. a block in it changed) */
+void MeshCache_Invalidate(int chunkIndex);
+#endif
@@ -444,7 +444,8 @@ void Model_Register(struct Model* model) {
 }
 
 void Model_Unregister(struct Model* model) {
-	int i;
+	const EntityID* ids;
+	int i, count;
 	
 	/* remove the model from the list */
 	struct Model* item = models_head;
@@ -461,8 +462,9 @@ void Model_Unregister(struct Model* model) {
 	}
 
 	/* unset this model from all entities, replacing with default fallback */
-	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
-		struct Entity* e = Entities.List[i];
+	ids = Entities_UNSAFE_GetIDs(&count);
+	for (i = 0; i < count; i++) {
+		struct Entity* e = Entities.List[ids[i]];
 		if (e && e->Model == model) {
 			cc_string humanModelName = String_FromReadonly(Models.Human->name);
 			Entity_SetModel(e, &humanModelName);
@@ -49,6 +49,7 @@ const cc_result ReturnCode_DirectoryExists  = ERROR_ALREADY_EXISTS;
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/mman.h>
 #include <utime.h>
 #include <signal.h>
 #include <stdio.h>
@@ -357,6 +358,18 @@ int File_Exists(const cc_string* path) {
 	return attribs != INVALID_FILE_ATTRIBUTES && !(attribs & FILE_ATTRIBUTE_DIRECTORY);
 }
 
+cc_result File_Delete(const cc_string* path) {
+	WCHAR str[NATIVE_STR_LEN];
+	cc_result res;
+
+	Platform_EncodeUtf16(str, path);
+	if (DeleteFileW(str)) return 0;
+	if ((res = GetLastError()) != ERROR_CALL_NOT_IMPLEMENTED) return res;
+
+	Platform_Utf16ToAnsi(str);
+	return DeleteFileA((LPCSTR)str) ? 0 : GetLastError();
+}
+
 static cc_result Directory_EnumCore(const cc_string* dirPath, const cc_string* file, DWORD attribs,
 									void* obj, Directory_EnumCallback callback) {
 	cc_string path; char pathBuffer[MAX_PATH + 10];
@@ -475,6 +488,10 @@ cc_result File_Length(cc_file file, cc_uint32* len) {
 	*len = GetFileSize(file, NULL);
 	return *len != INVALID_FILE_SIZE ? 0 : GetLastError();
 }
+
+/* Read only file mappings can't be larger than the file, so would need recreating whenever the file grows */
+cc_result File_Map(cc_file file, cc_uint32 size, const cc_uint8** data) { *data = NULL; return ERR_NOT_SUPPORTED; }
+cc_result File_Unmap(const cc_uint8* data, cc_uint32 size) { return ERR_NOT_SUPPORTED; }
 #elif defined CC_BUILD_POSIX
 cc_result Directory_Create(const cc_string* path) {
 	char str[NATIVE_STR_LEN];
@@ -491,6 +508,12 @@ int File_Exists(const cc_string* path) {
 	return stat(str, &sb) == 0 && S_ISREG(sb.st_mode);
 }
 
+cc_result File_Delete(const cc_string* path) {
+	char str[NATIVE_STR_LEN];
+	Platform_EncodeUtf8(str, path);
+	return unlink(str) == -1 ? errno : 0;
+}
+
 cc_result Directory_Enum(const cc_string* dirPath, void* obj, Directory_EnumCallback callback) {
 	cc_string path; char pathBuffer[FILENAME_SIZE];
 	char str[NATIVE_STR_LEN];
@@ -587,6 +610,23 @@ cc_result File_Length(cc_file file, cc_uint32* len) {
 	if (fstat(file, &st) == -1) { *len = -1; return errno; }
 	*len = st.st_size; return 0;
 }
+
+#ifndef CC_BUILD_WEB
+cc_result File_Map(cc_file file, cc_uint32 size, const cc_uint8** data) {
+	void* ptr = mmap(NULL, size, PROT_READ, MAP_SHARED, file, 0);
+	if (ptr == MAP_FAILED) { *data = NULL; return errno; }
+
+	*data = (const cc_uint8*)ptr; return 0;
+}
+
+cc_result File_Unmap(const cc_uint8* data, cc_uint32 size) {
+	return munmap((void*)data, size) == -1 ? errno : 0;
+}
+#else
+/* Files are stored in an in-memory filesystem, which can't be mapped */
+cc_result File_Map(cc_file file, cc_uint32 size, const cc_uint8** data) { *data = NULL; return ERR_NOT_SUPPORTED; }
+cc_result File_Unmap(const cc_uint8* data, cc_uint32 size) { return ERR_NOT_SUPPORTED; }
+#endif
 #endif
 
 
@@ -621,6 +661,12 @@ void Thread_Join(void* handle) {
 	Thread_Detach(handle);
 }
 
+int Thread_ProcessorCount(void) {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors ? info.dwNumberOfProcessors : 1;
+}
+
 void* Mutex_Create(void) {
 	CRITICAL_SECTION* ptr = (CRITICAL_SECTION*)Mem_Alloc(1, sizeof(CRITICAL_SECTION), "mutex");
 	InitializeCriticalSection(ptr);
@@ -662,6 +708,7 @@ void Thread_Sleep(cc_uint32 milliseconds) { }
 void* Thread_Start(Thread_StartFunc func) { func(); return NULL; }
 void Thread_Detach(void* handle) { }
 void Thread_Join(void* handle) { }
+int Thread_ProcessorCount(void) { return 1; }
 
 void* Mutex_Create(void) { return NULL; }
 void Mutex_Free(void* handle) { }
@@ -715,6 +762,11 @@ void Thread_Join(void* handle) {
 	Mem_Free(ptr);
 }
 
+int Thread_ProcessorCount(void) {
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (int)count : 1;
+}
+
 void* Mutex_Create(void) {
 	pthread_mutex_t* ptr = (pthread_mutex_t*)Mem_Alloc(1, sizeof(pthread_mutex_t), "mutex");
 	int res = pthread_mutex_init(ptr, NULL);
@@ -982,11 +1034,13 @@ cc_result Socket_Close(cc_socket s) {
 
 /* Alas, a simple cross-platform select() is not good enough */
 #if defined CC_BUILD_WIN
-cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
+cc_result Socket_PollFor(cc_socket s, int mode, cc_uint32 milliseconds, cc_bool* success) {
 	fd_set set;
-	struct timeval time = { 0 };
+	struct timeval time;
 	int selectCount;
 
+	time.tv_sec  = milliseconds / 1000;
+	time.tv_usec = (milliseconds % 1000) * 1000;
 	set.fd_count    = 1;
 	set.fd_array[0] = s;
 
@@ -1002,11 +1056,13 @@ cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
 }
 #elif defined CC_BUILD_DARWIN
 /* poll is broken on old OSX apparently https://daniel.haxx.se/docs/poll-vs-select.html */
-cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
+cc_result Socket_PollFor(cc_socket s, int mode, cc_uint32 milliseconds, cc_bool* success) {
 	fd_set set;
-	struct timeval time = { 0 };
+	struct timeval time;
 	int selectCount;
 
+	time.tv_sec  = milliseconds / 1000;
+	time.tv_usec = (milliseconds % 1000) * 1000;
 	FD_ZERO(&set);
 	FD_SET(s, &set);
 
@@ -1021,13 +1077,13 @@ cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
 }
 #else
 #include <poll.h>
-cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
+cc_result Socket_PollFor(cc_socket s, int mode, cc_uint32 milliseconds, cc_bool* success) {
 	struct pollfd pfd;
 	int flags;
 
 	pfd.fd     = s;
 	pfd.events = mode == SOCKET_POLL_READ ? POLLIN : POLLOUT;
-	if (poll(&pfd, 1, 0) == -1) { *success = false; return Socket__Error(); }
+	if (poll(&pfd, 1, milliseconds) == -1) { *success = false; return Socket__Error(); }
 	
 	/* to match select, closed socket still counts as readable */
 	flags    = mode == SOCKET_POLL_READ ? (POLLIN | POLLHUP) : POLLOUT;
@@ -1036,6 +1092,10 @@ cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
 }
 #endif
 
+cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
+	return Socket_PollFor(s, mode, 0, success);
+}
+
 
 /*########################################################################################################################*
 *-----------------------------------------------------Process/Module------------------------------------------------------*
@@ -157,6 +157,8 @@ typedef void Directory_EnumCallback(const cc_string* filename, void* obj);
 CC_API cc_result Directory_Enum(const cc_string* path, void* obj, Directory_EnumCallback callback);
 /* Returns non-zero if the given file exists. */
 CC_API int File_Exists(const cc_string* path);
+/* Attempts to delete the given file. */
+CC_API cc_result File_Delete(const cc_string* path);
 
 /* Attempts to create a new (or overwrite) file for writing. */
 /* NOTE: If the file already exists, its contents are discarded. */
@@ -177,6 +179,12 @@ cc_result File_Seek(cc_file file, int offset, int seekType);
 cc_result File_Position(cc_file file, cc_uint32* pos);
 /* Attempts to retrieve the length of the given file. */
 cc_result File_Length(cc_file file, cc_uint32* len);
+/* Attempts to map the first size bytes of the given file into memory, for reading only. */
+/* NOTE: Only the parts of the mapping that lie inside the file can be read. (writes to the file are visible) */
+/* NOTE: Returns ERR_NOT_SUPPORTED on platforms where this is not supported. */
+cc_result File_Map(cc_file file, cc_uint32 size, const cc_uint8** data);
+/* Attempts to unmap memory previously mapped with File_Map. */
+cc_result File_Unmap(const cc_uint8* data, cc_uint32 size);
 
 /* Blocks the current thread for the given number of milliseconds. */
 CC_API void Thread_Sleep(cc_uint32 milliseconds);
@@ -190,6 +198,8 @@ CC_API void Thread_Detach(void* handle);
 /* Blocks the current thread, until the given thread has finished. */
 /* NOTE: This cannot be used on a thread that has been detached. */
 CC_API void Thread_Join(void* handle);
+/* Returns the number of logical processors/cores, or 1 if this cannot be determined. */
+CC_API int Thread_ProcessorCount(void);
 
 /* Allocates a new mutex. (used to synchronise access to a shared resource) */
 CC_API void* Mutex_Create(void);
@@ -236,6 +246,8 @@ CC_API cc_result Socket_Close(cc_socket s);
 /* NOTE: A closed socket is still considered readable. */
 /* NOTE: A socket is considered writable once it has finished connecting. */
 CC_API cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success);
+/* Waits up to the given number of milliseconds for the given socket to become readable or writable. */
+CC_API cc_result Socket_PollFor(cc_socket s, int mode, cc_uint32 milliseconds, cc_bool* success);
 
 #ifdef CC_BUILD_ANDROID
 #include <jni.h>
@@ -45,6 +45,11 @@ static struct Stream map_part;
 static struct GZipHeader map_gzHeader;
 static int map_sizeIndex, map_volume;
 static cc_uint8 map_size[4];
+static cc_result map_result; /* Error encountered while decompressing map data */
+static float map_progress;   /* Fraction of the map's blocks decompressed so far */
+/* Decoder's own copies of map_result/map_progress, which are then published to the main thread */
+static cc_result map_decodeResult;
+static float map_decodeProgress;
 
 struct MapState {
 	struct InflateState inflateState;
@@ -63,7 +68,7 @@ cc_bool cpe_needD3Fix;
 static int cpe_serverExtensionsCount, cpe_pingTicks;
 static int cpe_envMapVer = 2, cpe_blockDefsExtVer = 2, cpe_customModelsVer = 2;
 static cc_bool cpe_sendHeldBlock, cpe_useMessageTypes, cpe_extEntityPos, cpe_blockPerms, cpe_fastMap;
-static cc_bool cpe_twoWayPing, cpe_extTextures, cpe_extBlocks;
+static cc_bool cpe_twoWayPing, cpe_extTextures, cpe_extBlocks, cpe_extEntityIDs;
 
 /*########################################################################################################################*
 *-----------------------------------------------------Common handlers-----------------------------------------------------*
@@ -90,6 +95,20 @@ if (cpe_extBlocks) {\
 } else { *data++ = (BlockRaw)value; }
 #endif
 
+/* Entity IDs are 2 bytes instead of 1 when the server supports ExtEntityIDs */
+#define ReadEntityID(data, value)\
+if (cpe_extEntityIDs) {\
+	value = Stream_GetU16_BE(data) % ENTITIES_MAX_COUNT; data += 2;\
+} else { value = *data++; }
+
+#define WriteEntityID(data, value)\
+if (cpe_extEntityIDs) {\
+	Stream_SetU16_BE(data, value); data += 2;\
+} else { *data++ = (cc_uint8)value; }
+
+/* Tab list IDs are always 2 bytes, but only the lower byte is used without ExtEntityIDs */
+#define GetTabListID(data) (cpe_extEntityIDs ? Stream_GetU16_BE(data) % TABLIST_MAX_NAMES : data[1])
+
 static cc_string UNSAFE_GetString(cc_uint8* data) {
 	int i, length = 0;
 	for (i = STRING_SIZE - 1; i >= 0; i--) {
@@ -167,11 +186,10 @@ static void AddEntity(cc_uint8* data, EntityID id, const cc_string* name, const
 
 	if (id != ENTITIES_SELF_ID) {
 		if (Entities.List[id]) Entities_Remove(id);
-		e = &NetPlayers_List[id].Base;
+		e = &NetPlayers_Alloc(id)->Base;
 
 		NetPlayer_Init((struct NetPlayer*)e);
-		Entities.List[id] = e;
-		Event_RaiseInt(&EntityEvents.Added, id);
+		Entities_Add(id, e);
 	} else {
 		e = &LocalPlayer_Instance.Base;
 	}
@@ -409,6 +427,11 @@ static void DisconnectInvalidMap(cc_result res) {
 	Game_Disconnect(&title, &tmp); return;
 }
 
+static void ShowMapOutOfMemory(void) {
+	Window_ShowDialog("Out of memory", "Not enough free memory to join that map.\nTry joining a different map.");
+}
+
+static void MapDecoder_Stop(void);
 static void MapState_Init(struct MapState* m) {
 	Inflate_MakeStream2(&m->stream, &m->inflateState, &map_part);
 	m->index  = 0;
@@ -417,6 +440,7 @@ static void MapState_Init(struct MapState* m) {
 }
 
 static void FreeMapStates(void) {
+	MapDecoder_Stop();
 	Mem_Free(map.blocks);
 	map.blocks  = NULL;
 #ifdef EXTENDED_BLOCKS
@@ -425,6 +449,40 @@ static void FreeMapStates(void) {
 #endif
 }
 
+#ifdef PALETTE_BLOCKS
+/* Blocks are palette compressed as soon as each run of CHUNK_SIZE_3 blocks is decompressed, */
+/*  so that a flat array of the entire map is never needed (see World_BeginStream) */
+static void MapState_ReadBlocks(struct MapState* m, int shift) {
+	cc_uint32 left, read, offset;
+	cc_result res;
+	if (m->allocFailed) return;
+
+	if (!m->blocks) {
+		m->blocks = (BlockRaw*)Mem_TryAlloc(CHUNK_SIZE_3, 1);
+		/* unlikely but possible */
+		if (!m->blocks || !World_BeginStream(map_volume)) {
+			Mem_Free(m->blocks);
+			m->blocks = NULL;
+			m->allocFailed = true; return;
+		}
+	}
+
+	while ((left = map_volume - m->index)) {
+		offset = m->index & (CHUNK_SIZE_3 - 1);
+		res    = m->stream.Read(&m->stream, &m->blocks[offset], min(left, CHUNK_SIZE_3 - offset), &read);
+		if (res) { map_decodeResult = res; return; }
+		if (!read) return;
+
+		m->index += read;
+		offset   += read;
+		if (offset == CHUNK_SIZE_3 || m->index == map_volume) {
+			World_StreamBlocks(m->blocks, m->index - offset, offset, shift);
+		}
+	}
+}
+#define MapState_Read(m)      MapState_ReadBlocks(m, 0)
+#define MapState_ReadUpper(m) MapState_ReadBlocks(m, 8)
+#else
 static void MapState_Read(struct MapState* m) {
 	cc_uint32 left, read;
 	cc_result res;
@@ -433,21 +491,207 @@ static void MapState_Read(struct MapState* m) {
 	if (!m->blocks) {
 		m->blocks = (BlockRaw*)Mem_TryAlloc(map_volume, 1);
 		/* unlikely but possible */
-		if (!m->blocks) {
-			Window_ShowDialog("Out of memory", "Not enough free memory to join that map.\nTry joining a different map.");
-			m->allocFailed = true;
-			return;
-		}
+		if (!m->blocks) { m->allocFailed = true; return; }
 	}
 
 	left = map_volume - m->index;
 	res  = m->stream.Read(&m->stream, &m->blocks[m->index], left, &read);
 
-	if (res) DisconnectInvalidMap(res);
+	if (res) map_decodeResult = res;
 	m->index += read;
 }
 
+#ifdef EXTENDED_BLOCKS
+/* Upper bits of blocks are bit-packed as soon as they are decompressed, to avoid needing a full size array */
+static void MapState_ReadUpper(struct MapState* m) {
+	BlockRaw buffer[4096];
+	cc_uint32 left, read;
+	cc_result res;
+	if (m->allocFailed) return;
+
+	if (!m->blocks) {
+		m->blocks = (BlockRaw*)Mem_TryAllocCleared(World_UpperSize(map_volume), 1);
+		/* unlikely but possible */
+		if (!m->blocks) { m->allocFailed = true; return; }
+	}
+
+	while ((left = map_volume - m->index)) {
+		res = m->stream.Read(&m->stream, buffer, min(left, (cc_uint32)sizeof(buffer)), &read);
+		if (res) { map_decodeResult = res; return; }
+		if (!read) return;
+
+		World_PackUpper(m->blocks, m->index, buffer, read);
+		m->index += read;
+	}
+}
+#endif
+#endif
+
+struct MapChunk {
+	cc_uint16 length;     /* Number of bytes of compressed data */
+	cc_uint8 value, end;  /* value is whether data is for upper bits of blocks, end is whether no more data */
+	cc_uint8 data[1024];
+};
+
+/* Decompresses the given chunk of compressed map data */
+static void MapState_Process(struct MapChunk* chunk) {
+	cc_uint32 left, read;
+	cc_result res;
+	if (map_decodeResult) return;
+
+	map_part.Meta.Mem.Cur    = chunk->data;
+	map_part.Meta.Mem.Base   = chunk->data;
+	map_part.Meta.Mem.Left   = chunk->length;
+	map_part.Meta.Mem.Length = chunk->length;
+
+	if (!map_gzHeader.done) {
+		res = GZipHeader_Read(&map_part, &map_gzHeader);
+		if (res && res != ERR_END_OF_STREAM) { map_decodeResult = res; return; }
+	}
+	if (!map_gzHeader.done) return;
+
+	if (map_sizeIndex < MAP_SIZE_LEN) {
+		left = MAP_SIZE_LEN - map_sizeIndex;
+		res  = map.stream.Read(&map.stream, &map_size[map_sizeIndex], left, &read); 
+
+		if (res) { map_decodeResult = res; return; }
+		map_sizeIndex += read;
+	}
+	if (map_sizeIndex < MAP_SIZE_LEN) return;
+	if (!map_volume) map_volume = Stream_GetU32_BE(map_size);
+
+#ifndef EXTENDED_BLOCKS
+	MapState_Read(&map);
+#else
+	if (cpe_extBlocks && chunk->value) {
+		MapState_ReadUpper(&map2);
+	} else {
+		MapState_Read(&map);
+	}
+#endif
+	map_decodeProgress = !map.blocks ? 0.0f : (float)map.index / map_volume;
+}
+
+#ifdef CC_BUILD_WEB
+/* No real threading support with emscripten backend, so decompress chunks as soon as they are received */
+static struct MapChunk map_chunk;
+static cc_bool map_decoding;
+
+static void MapDecoder_Start(void) { map_decoding = true; }
+static void MapDecoder_Stop(void)  { map_decoding = false; }
+static struct MapChunk* MapDecoder_Reserve(void) { return &map_chunk; }
+
+static cc_result MapDecoder_Commit(float* progress) {
+	MapState_Process(&map_chunk);
+	map_progress = map_decodeProgress;
+	map_result   = map_decodeResult;
+
+	*progress = map_progress;
+	return map_result;
+}
+#else
+/* Chunks are decompressed on a background thread, so decompression overlaps with receiving the rest of the map */
+/*  (and so that the map is usually already decompressed by the time the last chunk is received) */
+#define MAP_QUEUE_SIZE 64
+static struct MapChunk map_queue[MAP_QUEUE_SIZE];
+/* Chunks are added at head by main thread, and removed from tail by decoder thread */
+/* NOTE: Protected by map_mutex (head only changes on main thread, tail only changes on decoder thread) */
+static cc_uint32 map_queueHead, map_queueTail;
+static cc_bool map_decoding;
+
+static void* map_thread;
+static void* map_mutex;
+/* Signalled when a chunk is added to the queue */
+static void* map_pushed;
+/* Signalled when a chunk is removed from the queue */
+static void* map_popped;
+
+static void MapDecoder_Run(void) {
+	struct MapChunk* chunk;
+	cc_bool empty;
+
+	for (;;) {
+		Mutex_Lock(map_mutex);
+		{
+			empty = map_queueHead == map_queueTail;
+		}
+		Mutex_Unlock(map_mutex);
+		if (empty) { Waitable_Wait(map_pushed); continue; }
+
+		chunk = &map_queue[map_queueTail % MAP_QUEUE_SIZE];
+		if (chunk->end) return;
+		MapState_Process(chunk);
+
+		Mutex_Lock(map_mutex);
+		{
+			map_queueTail++;
+			map_progress = map_decodeProgress;
+			map_result   = map_decodeResult;
+		}
+		Mutex_Unlock(map_mutex);
+		Waitable_Signal(map_popped);
+	}
+}
+
+static void MapDecoder_Start(void) {
+	map_queueHead = 0;
+	map_queueTail = 0;
+	map_mutex  = Mutex_Create();
+	map_pushed = Waitable_Create();
+	map_popped = Waitable_Create();
+
+	map_thread   = Thread_Start(MapDecoder_Run);
+	map_decoding = true;
+}
+
+/* Waits until there is space in the queue, then returns the chunk to fill in */
+static struct MapChunk* MapDecoder_Reserve(void) {
+	cc_bool full;
+	for (;;) {
+		Mutex_Lock(map_mutex);
+		{
+			full = map_queueHead - map_queueTail == MAP_QUEUE_SIZE;
+		}
+		Mutex_Unlock(map_mutex);
+
+		if (!full) return &map_queue[map_queueHead % MAP_QUEUE_SIZE];
+		Waitable_Wait(map_popped);
+	}
+}
+
+/* Adds the previously reserved chunk to the queue */
+static cc_result MapDecoder_Commit(float* progress) {
+	cc_result res;
+	Mutex_Lock(map_mutex);
+	{
+		map_queueHead++;
+		*progress = map_progress;
+		res       = map_result;
+	}
+	Mutex_Unlock(map_mutex);
+
+	Waitable_Signal(map_pushed);
+	return res;
+}
+
+/* Waits for all queued chunks to be decompressed, then stops the decoder thread */
+static void MapDecoder_Stop(void) {
+	float progress;
+	if (!map_decoding) return;
+
+	MapDecoder_Reserve()->end = true;
+	MapDecoder_Commit(&progress);
+	Thread_Join(map_thread);
+
+	Mutex_Free(map_mutex);
+	Waitable_Free(map_pushed);
+	Waitable_Free(map_popped);
+	map_decoding = false;
+}
+#endif
+
 static void Classic_StartLoading(void) {
+	MapDecoder_Stop();
 	World_NewMap();
 	Stream_ReadonlyMemory(&map_part, NULL, 0);
 
@@ -460,11 +704,16 @@ static void Classic_StartLoading(void) {
 	map_sizeIndex    = 0;
 	map_receiveBeg   = Stopwatch_Measure();
 	map_volume       = 0;
+	map_result       = 0;
+	map_progress     = 0.0f;
+	map_decodeResult   = 0;
+	map_decodeProgress = 0.0f;
 
 	MapState_Init(&map);
 #ifdef EXTENDED_BLOCKS
 	MapState_Init(&map2);
 #endif
+	MapDecoder_Start();
 }
 
 static void Classic_LevelInit(cc_uint8* data) {
@@ -478,54 +727,23 @@ static void Classic_LevelInit(cc_uint8* data) {
 }
 
 static void Classic_LevelDataChunk(cc_uint8* data) {
-	int usedLength;
+	struct MapChunk* chunk;
 	float progress;
-	cc_uint32 left, read;
-	cc_uint8 value;
 	cc_result res;
 
 	/* Workaround for some servers that send LevelDataChunk before LevelInit due to their async sending behaviour */
 	if (!map_begunLoading) Classic_StartLoading();
-	usedLength = Stream_GetU16_BE(data); data += 2;
-
-	map_part.Meta.Mem.Cur    = data;
-	map_part.Meta.Mem.Base   = data;
-	map_part.Meta.Mem.Left   = usedLength;
-	map_part.Meta.Mem.Length = usedLength;
-
-	data += 1024;
-	value = *data; /* progress in original classic, but we ignore it */
-
-	if (!map_gzHeader.done) {
-		res = GZipHeader_Read(&map_part, &map_gzHeader);
-		if (res && res != ERR_END_OF_STREAM) { DisconnectInvalidMap(res); return; }
-	}
-
-	if (map_gzHeader.done) {
-		if (map_sizeIndex < MAP_SIZE_LEN) {
-			left = MAP_SIZE_LEN - map_sizeIndex;
-			res  = map.stream.Read(&map.stream, &map_size[map_sizeIndex], left, &read); 
-
-			if (res) { DisconnectInvalidMap(res); return; }
-			map_sizeIndex += read;
-		}
-
-		if (map_sizeIndex == MAP_SIZE_LEN) {
-			if (!map_volume) map_volume = Stream_GetU32_BE(map_size);
+	/* Map data was invalid, so rest of map data is ignored */
+	if (!map_decoding) return;
 
-#ifndef EXTENDED_BLOCKS
-			MapState_Read(&map);
-#else
-			if (cpe_extBlocks && value) {
-				MapState_Read(&map2);
-			} else {
-				MapState_Read(&map);
-			}
-#endif
-		}
-	}
+	chunk = MapDecoder_Reserve();
+	chunk->length = min(Stream_GetU16_BE(data), 1024);
+	chunk->value  = data[2 + 1024]; /* progress in original classic, but we ignore it */
+	chunk->end    = false;
+	Mem_Copy(chunk->data, data + 2, chunk->length);
 
-	progress = !map.blocks ? 0.0f : (float)map.index / map_volume;
+	res = MapDecoder_Commit(&progress);
+	if (res) { MapDecoder_Stop(); DisconnectInvalidMap(res); return; }
 	Event_RaiseFloat(&WorldEvents.Loading, progress);
 }
 
@@ -534,14 +752,23 @@ static void Classic_LevelFinalise(cc_uint8* data) {
 	cc_uint64 end;
 	int delta;
 
+	/* Wait for any remaining map data to be decompressed */
+	/*  (decoder thread has exited after this, so map_result can be safely read) */
+	MapDecoder_Stop();
 	end   = Stopwatch_Measure();
 	delta = Stopwatch_ElapsedMS(map_receiveBeg, end);
 	Platform_Log1("map loading took: %i", &delta);
 	map_begunLoading = false;
 	WoM_CheckSendWomID();
 
+	if (map_result) {
+		FreeMapStates();
+		DisconnectInvalidMap(map_result); return;
+	}
+
+	if (map.allocFailed) ShowMapOutOfMemory();
 #ifdef EXTENDED_BLOCKS
-	if (map2.allocFailed) FreeMapStates();
+	if (map2.allocFailed) { ShowMapOutOfMemory(); FreeMapStates(); }
 #endif
 
 	width  = Stream_GetU16_BE(data + 0);
@@ -554,6 +781,15 @@ static void Classic_LevelFinalise(cc_uint8* data) {
 		FreeMapStates();
 	}
 	
+#if defined PALETTE_BLOCKS
+	/* Blocks were already streamed into the world as they were decompressed (map.blocks is only a buffer) */
+	if (map.blocks) {
+		World_SetStreamedMap(width, height, length);
+	} else {
+		World_SetNewMap(NULL, width, height, length);
+	}
+	FreeMapStates();
+#else
 #ifdef EXTENDED_BLOCKS
 	/* defer allocation of second map array if possible */
 	if (cpe_extBlocks && map2.blocks) World_SetMapUpper(map2.blocks);
@@ -561,6 +797,8 @@ static void Classic_LevelFinalise(cc_uint8* data) {
 #endif
 	World_SetNewMap(map.blocks, width, height, length);
 	map.blocks  = NULL;
+#endif
+	if (Lighting_Heightmap) Platform_Log1("lighting heightmap took: %i us", &Lighting_HeightmapTime);
 }
 
 static void Classic_SetBlock(cc_uint8* data) {
@@ -586,7 +824,7 @@ static void Classic_AddEntity(cc_uint8* data) {
 	String_InitArray(name, nameBuffer);
 	String_InitArray(skin, skinBuffer);
 
-	id = *data++;
+	ReadEntityID(data, id);
 	ReadString(&data, &name);
 	CheckName(id, &name, &skin);
 	AddEntity(data, id, &name, &skin, true);
@@ -597,21 +835,23 @@ static void Classic_AddEntity(cc_uint8* data) {
 }
 
 static void Classic_EntityTeleport(cc_uint8* data) {
-	EntityID id = *data++;
+	EntityID id;
+	ReadEntityID(data, id);
 	Classic_ReadAbsoluteLocation(data, id, true);
 }
 
 static void Classic_RelPosAndOrientationUpdate(cc_uint8* data) {
 	struct LocationUpdate update;
-	EntityID id = data[0];
+	EntityID id;
 	Vec3 pos;
 	float yaw, pitch;
+	ReadEntityID(data, id);
 
-	pos.X = (cc_int8)data[1] / 32.0f;
-	pos.Y = (cc_int8)data[2] / 32.0f;
-	pos.Z = (cc_int8)data[3] / 32.0f;
-	yaw   = Math_Packed2Deg(data[4]);
-	pitch = Math_Packed2Deg(data[5]);
+	pos.X = (cc_int8)data[0] / 32.0f;
+	pos.Y = (cc_int8)data[1] / 32.0f;
+	pos.Z = (cc_int8)data[2] / 32.0f;
+	yaw   = Math_Packed2Deg(data[3]);
+	pitch = Math_Packed2Deg(data[4]);
 
 	LocationUpdate_MakePosAndOri(&update, pos, yaw, pitch, true);
 	UpdateLocation(id, &update, true);
@@ -619,12 +859,13 @@ static void Classic_RelPosAndOrientationUpdate(cc_uint8* data) {
 
 static void Classic_RelPositionUpdate(cc_uint8* data) {
 	struct LocationUpdate update;
-	EntityID id = data[0];
+	EntityID id;
 	Vec3 pos;
+	ReadEntityID(data, id);
 
-	pos.X = (cc_int8)data[1] / 32.0f;
-	pos.Y = (cc_int8)data[2] / 32.0f;
-	pos.Z = (cc_int8)data[3] / 32.0f;
+	pos.X = (cc_int8)data[0] / 32.0f;
+	pos.Y = (cc_int8)data[1] / 32.0f;
+	pos.Z = (cc_int8)data[2] / 32.0f;
 
 	LocationUpdate_MakePos(&update, pos, true);
 	UpdateLocation(id, &update, true);
@@ -632,18 +873,20 @@ static void Classic_RelPositionUpdate(cc_uint8* data) {
 
 static void Classic_OrientationUpdate(cc_uint8* data) {
 	struct LocationUpdate update;
-	EntityID id = data[0];
+	EntityID id;
 	float yaw, pitch;
+	ReadEntityID(data, id);
 
-	yaw   = Math_Packed2Deg(data[1]);
-	pitch = Math_Packed2Deg(data[2]);
+	yaw   = Math_Packed2Deg(data[0]);
+	pitch = Math_Packed2Deg(data[1]);
 
 	LocationUpdate_MakeOri(&update, yaw, pitch);
 	UpdateLocation(id, &update, true);
 }
 
 static void Classic_RemoveEntity(cc_uint8* data) {
-	EntityID id = data[0];
+	EntityID id;
+	ReadEntityID(data, id);
 	Protocol_RemoveEntity(id);
 }
 
@@ -740,6 +983,8 @@ static void Classic_Tick(void) {
 	struct LocalPlayer* p = &LocalPlayer_Instance;
 	struct Entity* e      = &LocalPlayer_Instance.Base;
 	if (!classic_receivedFirstPos) return;
+	/* Skip this update when the connection is congested, as the next one has the latest position anyway */
+	if (Net_IsCongested()) return;
 	/* Report end position of each physics tick, rather than current position */
 	/*  (otherwise can miss landing on a block then jumping off of it again) */
 	Classic_WritePosition(p->Interp.Next.Pos, e->Yaw, e->Pitch);
@@ -749,22 +994,23 @@ static void Classic_Tick(void) {
 /*########################################################################################################################*
 *------------------------------------------------------CPE protocol-------------------------------------------------------*
 *#########################################################################################################################*/
-static const char* cpe_clientExtensions[35] = {
+static const char* cpe_clientExtensions[36] = {
 	"ClickDistance", "CustomBlocks", "HeldBlock", "EmoteFix", "TextHotKey", "ExtPlayerList",
 	"EnvColors", "SelectionCuboid", "BlockPermissions", "ChangeModel", "EnvMapAppearance",
 	"EnvWeatherType", "MessageTypes", "HackControl", "PlayerClick", "FullCP437", "LongerMessages",
 	"BlockDefinitions", "BlockDefinitionsExt", "BulkBlockUpdate", "TextColors", "EnvMapAspect",
 	"EntityProperty", "ExtEntityPositions", "TwoWayPing", "InventoryOrder", "InstantMOTD", "FastMap", "SetHotbar",
-	"SetSpawnpoint", "VelocityControl", "CustomParticles", "CustomModels",
+	"SetSpawnpoint", "VelocityControl", "CustomParticles", "CustomModels", "ExtEntityIDs",
 	/* NOTE: These must be placed last for when EXTENDED_TEXTURES or EXTENDED_BLOCKS are not defined */
 	"ExtendedTextures", "ExtendedBlocks"
 };
 static void CPE_SetMapEnvUrl(cc_uint8* data);
 
 #define Ext_Deg2Packed(x) ((int)((x) * 65536.0f / 360.0f))
-void CPE_SendPlayerClick(int button, cc_bool pressed, cc_uint8 targetId, struct RayTracer* t) {
+void CPE_SendPlayerClick(int button, cc_bool pressed, EntityID targetId, struct RayTracer* t) {
 	struct Entity* p = &LocalPlayer_Instance.Base;
-	cc_uint8 data[15];
+	cc_uint8 data[16];
+	cc_uint8* cur;
 
 	data[0] = OPCODE_PLAYER_CLICK;
 	{
@@ -773,23 +1019,24 @@ void CPE_SendPlayerClick(int button, cc_bool pressed, cc_uint8 targetId, struct
 		Stream_SetU16_BE(&data[3], Ext_Deg2Packed(p->Yaw));
 		Stream_SetU16_BE(&data[5], Ext_Deg2Packed(p->Pitch));
 
-		data[7] = targetId;
-		Stream_SetU16_BE(&data[8],  t->pos.X);
-		Stream_SetU16_BE(&data[10], t->pos.Y);
-		Stream_SetU16_BE(&data[12], t->pos.Z);
+		cur = &data[7];
+		WriteEntityID(cur, targetId);
+		Stream_SetU16_BE(cur + 0, t->pos.X);
+		Stream_SetU16_BE(cur + 2, t->pos.Y);
+		Stream_SetU16_BE(cur + 4, t->pos.Z);
 
-		data[14] = 255;
+		cur[6] = 255;
 		/* Our own face values differ from CPE block face */
 		switch (t->Closest) {
-		case FACE_XMAX: data[14] = 0; break;
-		case FACE_XMIN: data[14] = 1; break;
-		case FACE_YMAX: data[14] = 2; break;
-		case FACE_YMIN: data[14] = 3; break;
-		case FACE_ZMAX: data[14] = 4; break;
-		case FACE_ZMIN: data[14] = 5; break;
+		case FACE_XMAX: cur[6] = 0; break;
+		case FACE_XMIN: cur[6] = 1; break;
+		case FACE_YMAX: cur[6] = 2; break;
+		case FACE_YMIN: cur[6] = 3; break;
+		case FACE_ZMAX: cur[6] = 4; break;
+		case FACE_ZMIN: cur[6] = 5; break;
 		}
 	}
-	Server.SendData(data, 15);
+	Server.SendData(data, (cc_uint32)(cur + 7 - data));
 }
 
 static void CPE_SendExtInfo(int extsCount) {
@@ -919,6 +1166,18 @@ static void CPE_ExtEntry(cc_uint8* data) {
 		Protocol.Sizes[OPCODE_EXT_ADD_ENTITY2] += 6;
 		Protocol.Sizes[OPCODE_SET_SPAWNPOINT]  += 6;
 		cpe_extEntityPos = true;
+	} else if (String_CaselessEqualsConst(&ext, "ExtEntityIDs")) {
+		Protocol.Sizes[OPCODE_ADD_ENTITY]              += 1;
+		Protocol.Sizes[OPCODE_ENTITY_TELEPORT]         += 1;
+		Protocol.Sizes[OPCODE_RELPOS_AND_ORI_UPDATE]   += 1;
+		Protocol.Sizes[OPCODE_RELPOS_UPDATE]           += 1;
+		Protocol.Sizes[OPCODE_ORI_UPDATE]              += 1;
+		Protocol.Sizes[OPCODE_REMOVE_ENTITY]           += 1;
+		Protocol.Sizes[OPCODE_EXT_ADD_ENTITY]          += 1;
+		Protocol.Sizes[OPCODE_EXT_ADD_ENTITY2]         += 1;
+		Protocol.Sizes[OPCODE_SET_MODEL]               += 1;
+		Protocol.Sizes[OPCODE_SET_ENTITY_PROPERTY]     += 1;
+		cpe_extEntityIDs = true;
 	} else if (String_CaselessEqualsConst(&ext, "TwoWayPing")) {
 		cpe_twoWayPing = true;
 	} else if (String_CaselessEqualsConst(&ext, "FastMap")) {
@@ -1004,7 +1263,7 @@ static void CPE_SetTextHotkey(cc_uint8* data) {
 }
 
 static void CPE_ExtAddPlayerName(cc_uint8* data) {
-	EntityID id = data[1]; /* 16 bit id */
+	EntityID id = GetTabListID(data);
 	cc_string playerName = UNSAFE_GetString(&data[2]);
 	cc_string listName   = UNSAFE_GetString(&data[66]);
 	cc_string groupName  = UNSAFE_GetString(&data[130]);
@@ -1022,16 +1281,16 @@ static void CPE_ExtAddEntity(cc_uint8* data) {
 	cc_string name, skin;
 	EntityID id;
 
-	id   = data[0];
-	name = UNSAFE_GetString(data + 1);
-	skin = UNSAFE_GetString(data + 65);
+	ReadEntityID(data, id);
+	name = UNSAFE_GetString(data);
+	skin = UNSAFE_GetString(data + 64);
 
 	CheckName(id, &name, &skin);
-	AddEntity(data + 129, id, &name, &skin, false);
+	AddEntity(data + 128, id, &name, &skin, false);
 }
 
 static void CPE_ExtRemovePlayerName(cc_uint8* data) {
-	EntityID id = data[1];
+	EntityID id = GetTabListID(data);
 	TabList_Remove(id);
 }
 
@@ -1093,9 +1352,11 @@ static void CPE_SetBlockPermission(cc_uint8* data) {
 
 static void CPE_ChangeModel(cc_uint8* data) {
 	struct Entity* e;
-	EntityID id     = data[0];
-	cc_string model = UNSAFE_GetString(data + 1);
+	cc_string model;
+	EntityID id;
 
+	ReadEntityID(data, id);
+	model = UNSAFE_GetString(data);
 	e = Entities.List[id];
 	if (e) Entity_SetModel(e, &model);
 }
@@ -1144,20 +1405,19 @@ static void CPE_ExtAddEntity2(cc_uint8* data) {
 	cc_string name, skin;
 	EntityID id;
 
-	id   = data[0];
-	name = UNSAFE_GetString(data + 1);
-	skin = UNSAFE_GetString(data + 65);
+	ReadEntityID(data, id);
+	name = UNSAFE_GetString(data);
+	skin = UNSAFE_GetString(data + 64);
 
 	CheckName(id, &name, &skin);
-	AddEntity(data + 129, id, &name, &skin, true);
+	AddEntity(data + 128, id, &name, &skin, true);
 }
 
 #define BULK_MAX_BLOCKS 256
 static void CPE_BulkBlockUpdate(cc_uint8* data) {
 	cc_int32 indices[BULK_MAX_BLOCKS];
 	BlockID blocks[BULK_MAX_BLOCKS];
-	int index, i;
-	int x, y, z;
+	int i;
 	int count = 1 + *data++;
 
 	for (i = 0; i < count; i++) {
@@ -1181,17 +1441,12 @@ static void CPE_BulkBlockUpdate(cc_uint8* data) {
 		data += BULK_MAX_BLOCKS / 4;
 	}
 
-	for (i = 0; i < count; i++) {
-		index = indices[i];
-		if (index < 0 || index >= World.Volume) continue;
-		World_Unpack(index, x, y, z);
-
 #ifdef EXTENDED_BLOCKS
-		Game_UpdateBlock(x, y, z, blocks[i] % BLOCK_COUNT);
-#else
-		Game_UpdateBlock(x, y, z, blocks[i]);
-#endif
+	for (i = 0; i < count; i++) {
+		blocks[i] %= BLOCK_COUNT;
 	}
+#endif
+	Game_UpdateBlocks(indices, blocks, count);
 }
 
 static void CPE_SetTextColor(cc_uint8* data) {
@@ -1255,11 +1510,13 @@ static void CPE_SetEntityProperty(cc_uint8* data) {
 	struct LocationUpdate update = { 0 };
 	struct Entity* e;
 	float scale;
+	EntityID id;
+	cc_uint8 type;
+	int value;
 
-	EntityID id   = data[0];
-	cc_uint8 type = data[1];
-	int value     = (int)Stream_GetU32_BE(data + 2);
-
+	ReadEntityID(data, id);
+	type  = data[0];
+	value = (int)Stream_GetU32_BE(data + 1);
 	e = Entities.List[id];
 	if (!e) return;
 
@@ -1529,7 +1786,7 @@ static void CPE_Reset(void) {
 	cpe_sendHeldBlock = false; cpe_useMessageTypes = false;
 	cpe_envMapVer = 2; cpe_blockDefsExtVer = 2; cpe_customModelsVer = 2;
 	cpe_needD3Fix = false; cpe_extEntityPos = false; cpe_twoWayPing = false; 
-	cpe_extTextures = false; cpe_fastMap = false; cpe_extBlocks = false;
+	cpe_extTextures = false; cpe_fastMap = false; cpe_extBlocks = false; cpe_extEntityIDs = false;
 	Game_UseCPEBlocks = false; cpe_blockPerms = false;
 	if (!Game_UseCPE) return;
 
@@ -62,5 +62,5 @@ void Classic_SendChat(const cc_string* text, cc_bool partial);
 void Classic_WritePosition(Vec3 pos, float yaw, float pitch);
 void Classic_WriteSetBlock(int x, int y, int z, cc_bool place, BlockID block);
 void Classic_SendLogin(void);
-void CPE_SendPlayerClick(int button, cc_bool pressed, cc_uint8 targetId, struct RayTracer* t);
+void CPE_SendPlayerClick(int button, cc_bool pressed, EntityID targetId, struct RayTracer* t);
 #endif
@@ -21,6 +21,7 @@
 #include "World.h"
 #include "Input.h"
 #include "Utils.h"
+#include "MapRenderer.h"
 
 #define CHAT_MAX_STATUS Array_Elems(Chat_Status)
 #define CHAT_MAX_BOTTOMRIGHT Array_Elems(Chat_BottomRight)
@@ -90,9 +91,11 @@ static void HUDScreen_MakeText(struct HUDScreen* s, cc_string* status) {
 
 		indices = ICOUNT(Game_Vertices);
 		String_Format1(status, "%i vertices", &indices);
+		String_Format2(status, ", %i chunks (%i culling tests)", &MapRenderer_VisibleChunks, &MapRenderer_FrustumTests);
 
 		ping = Ping_AveragePingMS();
 		if (ping) String_Format1(status, ", ping %i ms", &ping);
+		if (Server.Stats.QueuedPackets) String_Format1(status, ", %i queued packets", &Server.Stats.QueuedPackets);
 	}
 }
 
@@ -324,7 +327,10 @@ void HUDScreen_Show(void) {
 #define GROUP_NAME_ID UInt16_MaxValue
 #define LIST_COLUMN_PADDING 5
 #define LIST_NAMES_PER_COLUMN 16
-#define TABLIST_MAX_ENTRIES (TABLIST_MAX_NAMES * 2)
+/* Max number of names shown, as there's only room on screen for so many anyways */
+#define TABLIST_MAX_SHOWN 256
+/* Names plus group names (at most one group per name) */
+#define TABLIST_MAX_ENTRIES (TABLIST_MAX_SHOWN * 2)
 typedef int (*TabListEntryCompare)(int x, int y);
 
 static struct TabListOverlay {
@@ -332,6 +338,8 @@ static struct TabListOverlay {
 	int x, y, width, height;
 	cc_bool active, classic;
 	int namesCount, elementOffset;
+	/* Number of player names shown, and number of names not shown due to TABLIST_MAX_SHOWN */
+	int playersCount, hiddenCount;
 	struct TextWidget title;
 	struct FontDesc font;
 	TabListEntryCompare compare;
@@ -440,7 +448,11 @@ static void TabListOverlay_Layout(void* screen) {
 static void TabListOverlay_AddName(struct TabListOverlay* s, EntityID id, int index) {
 	cc_string name;
 	/* insert at end of list */
-	if (index == -1) { index = s->namesCount; s->namesCount++; }
+	if (index == -1) {
+		if (s->playersCount >= TABLIST_MAX_SHOWN) { s->hiddenCount++; return; }
+		index = s->namesCount; s->namesCount++;
+		s->playersCount++;
+	}
 
 	name = TabList_UNSAFE_GetList(id);
 	s->ids[index] = id;
@@ -449,6 +461,7 @@ static void TabListOverlay_AddName(struct TabListOverlay* s, EntityID id, int in
 
 static void TabListOverlay_DeleteAt(struct TabListOverlay* s, int i) {
 	Gfx_DeleteTexture(&s->textures[i].ID);
+	if (s->ids[i] != GROUP_NAME_ID) s->playersCount--;
 
 	for (; i < s->namesCount - 1; i++) {
 		s->ids[i]      = s->ids[i + 1];
@@ -595,16 +608,37 @@ static void TabListOverlay_Update(void* obj, int id) {
 	}
 }
 
+/* Adds all the names in the tab list, then sorts them */
+static void TabListOverlay_AddAll(struct TabListOverlay* s) {
+	int i, id;
+	for (i = 0; i < s->namesCount; i++) {
+		Gfx_DeleteTexture(&s->textures[i].ID);
+	}
+	s->namesCount   = 0;
+	s->playersCount = 0;
+	s->hiddenCount  = 0;
+
+	for (id = 0; id < TABLIST_MAX_NAMES; id++) {
+		if (!TabList.NameOffsets[id]) continue;
+		TabListOverlay_AddName(s, (EntityID)id, -1);
+	}
+	TabListOverlay_SortAndLayout(s);
+}
+
 static void TabListOverlay_Remove(void* obj, int id) {
 	struct TabListOverlay* s = (struct TabListOverlay*)obj;
 	int i;
 	for (i = 0; i < s->namesCount; i++) {
 		if (s->ids[i] != id) continue;
 
+		/* A name that wasn't shown before might now fit */
+		if (s->hiddenCount) { TabListOverlay_AddAll(s); return; }
 		TabListOverlay_DeleteAt(s, i);
 		TabListOverlay_SortAndLayout(s);
 		return;
 	}
+	/* The removed name wasn't shown */
+	if (s->hiddenCount) s->hiddenCount--;
 }
 
 static int TabListOverlay_PointerDown(void* screen, int id, int x, int y) {
@@ -649,7 +683,7 @@ static void TabListOverlay_ContextLost(void* screen) {
 
 static void TabListOverlay_ContextRecreated(void* screen) {
 	struct TabListOverlay* s = (struct TabListOverlay*)screen;
-	int size, id;
+	int size;
 
 	size = Drawer2D_BitmappedText ? 16 : 11;
 	Drawer2D_MakeFont(&s->font, size, FONT_FLAGS_PADDING);
@@ -659,11 +693,7 @@ static void TabListOverlay_ContextRecreated(void* screen) {
 	Font_SetPadding(&s->font, 1);
 
 	/* TODO: Just recreate instead of this? maybe */
-	for (id = 0; id < TABLIST_MAX_NAMES; id++) {
-		if (!TabList.NameOffsets[id]) continue;
-		TabListOverlay_AddName(s, (EntityID)id, -1);
-	}
-	TabListOverlay_SortAndLayout(s); /* TODO: Not do layout here too */
+	TabListOverlay_AddAll(s); /* TODO: Not do layout here too */
 }
 
 static void TabListOverlay_BuildMesh(void* screen) { }
@@ -23,6 +23,8 @@
 #include "Inventory.h"
 #include "Platform.h"
 #include "Input.h"
+#include "Options.h"
+#include "Utils.h"
 
 static char nameBuffer[STRING_SIZE];
 static char motdBuffer[STRING_SIZE];
@@ -223,7 +225,7 @@ static void SPConnection_Init(void) {
 
 
 /*########################################################################################################################*
-*--------------------------------------------------Multiplayer connection-------------------------------------------------*
+*-----------------------------------------------------Multiplayer state---------------------------------------------------*
 *#########################################################################################################################*/
 static cc_socket net_socket;
 static cc_uint8  net_readBuffer[4096 * 5];
@@ -231,6 +233,17 @@ static cc_uint8  net_writeBuffer[131];
 static cc_uint8* net_readCurrent;
 
 static cc_bool net_writeFailed;
+/* Data waiting to be sent to the server is from net_sendStart to net_sendEnd */
+/* Everything queued during a tick is then sent with as few Socket_Write calls as possible */
+#define NET_SEND_DEF_SIZE 4096
+/* Connection is treated as failed if this much data is waiting to be sent */
+#define NET_SEND_MAX_SIZE (1024 * 1024)
+static cc_uint8  net_sendDefault[NET_SEND_DEF_SIZE];
+static cc_uint8* net_sendBuffer   = net_sendDefault;
+static int       net_sendCapacity = NET_SEND_DEF_SIZE;
+static int net_sendStart, net_sendEnd;
+/* Whether data was still waiting to be sent after the last flush */
+static cc_bool net_sendCongested;
 static double lastPacket;
 static cc_uint8 lastOpcode;
 
@@ -238,7 +251,325 @@ static cc_bool net_connecting;
 static double net_connectTimeout;
 #define NET_TIMEOUT_SECS 15
 
+/* Maximum milliseconds spent processing received packets each tick (0 for no limit) */
+static int net_dispatchBudget;
+/* Counters that Server.Stats is calculated from once per second */
+static cc_uint32 stats_bytes;
+static int stats_dispatched;
+static float stats_totalLatency, stats_maxLatency;
+static double stats_lastUpdate;
+
+static void DisconnectInvalidOpcode(cc_uint8 opcode);
+static void DisconnectReadError(cc_result res);
+static void DisconnectLostConnection(void);
+
+static void Net_DispatchPacket(cc_uint8* data, float latency) {
+	lastOpcode = data[0];
+	lastPacket = Game.Time;
+
+	stats_dispatched++;
+	stats_totalLatency += latency;
+	stats_maxLatency    = max(stats_maxLatency, latency);
+	Protocol.Handlers[data[0]](data + 1); /* skip opcode */
+}
+
+static void Net_UpdateStats(void) {
+	double elapsed = Game.Time - stats_lastUpdate;
+	if (elapsed < 1.0) return;
+
+	Server.Stats.BytesPerSec   = (int)(stats_bytes / elapsed);
+	Server.Stats.PacketsPerSec = (int)(stats_dispatched / elapsed);
+	Server.Stats.AvgLatency    = stats_dispatched ? stats_totalLatency / stats_dispatched : 0.0f;
+	Server.Stats.MaxLatency    = stats_maxLatency;
+
+	stats_bytes        = 0;
+	stats_dispatched   = 0;
+	stats_totalLatency = 0.0f;
+	stats_maxLatency   = 0.0f;
+	stats_lastUpdate   = Game.Time;
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------Network I/O thread----------------------------------------------------*
+*#########################################################################################################################*/
+#ifndef CC_BUILD_WEB
+/* The network thread reads from the socket and splits the received data up into packets. */
+/* Packets are then added to a queue, which MPConnection_Tick processes on the main thread. */
+/* The network thread only ever writes to the head of the queue, and the main thread only reads from the tail. */
+#define NET_QUEUE_SIZE (256 * 1024)
+enum NetRecordType { NET_RECORD_PACKET, NET_RECORD_WRAP, NET_RECORD_D3_SKIP };
+/* Header of an entry in the queue, followed by size bytes of packet data */
+struct NetRecord { cc_uint64 received; cc_uint32 size, type; };
+/* Records are kept 8 byte aligned, so the headers in the queue are always aligned */
+#define NET_RECORD_SIZE(dataSize) ((sizeof(struct NetRecord) + (dataSize) + 7) & ~7)
+
+static cc_bool net_useThread;
+static void* net_thread;
+static volatile cc_bool net_threadStop;
+/* Signalled whenever the main thread processes queued packets */
+static void* net_queueWaitable;
+static cc_uint8* net_queue;
+/* Protects the queue state and thread state below */
+static void* net_queueMutex;
+/* Offsets of where the next record is written to (head) and read from (tail). Empty when head == tail */
+static cc_uint32 net_queueHead, net_queueTail;
+static int net_queuedPackets, net_queuedBytes;
+static cc_uint32 net_threadBytes;
+/* Whether the network thread has stopped reading packets, and why */
+static cc_bool net_threadExited, net_threadClosed;
+static cc_result net_threadResult;
+static int net_threadInvalid;
+
+/* Attempts to add a record to the head of the queue, returning false if there isn't enough space */
+static cc_bool NetThread_Enqueue(const cc_uint8* data, cc_uint32 size, int type) {
+	cc_uint32 head = net_queueHead, tail, space;
+	cc_uint32 needed = NET_RECORD_SIZE(size);
+	struct NetRecord* record;
+
+	Mutex_Lock(net_queueMutex);
+	{
+		tail = net_queueTail;
+	}
+	Mutex_Unlock(net_queueMutex);
+
+	/* Records are never split across the end of the queue, and head must never catch up to tail */
+	if (head >= tail) {
+		space = NET_QUEUE_SIZE - head;
+		if (space < needed || (space == needed && tail == 0)) {
+			if (tail <= needed) return false;
+			/* Too small to fit a header is also treated as the end of the queue */
+			if (space >= sizeof(struct NetRecord)) {
+				record = (struct NetRecord*)(net_queue + head);
+				record->type = NET_RECORD_WRAP;
+			}
+			head = 0;
+		}
+	} else if (tail - head <= needed) {
+		return false;
+	}
+
+	record = (struct NetRecord*)(net_queue + head);
+	record->received = Stopwatch_Measure();
+	record->size     = size;
+	record->type     = type;
+	if (size) Mem_Copy(record + 1, data, size);
+
+	head += needed;
+	if (head == NET_QUEUE_SIZE) head = 0;
+
+	Mutex_Lock(net_queueMutex);
+	{
+		net_queueHead = head;
+		if (type == NET_RECORD_PACKET) { net_queuedPackets++; net_queuedBytes += size; }
+	}
+	Mutex_Unlock(net_queueMutex);
+	return true;
+}
+
+static cc_bool NetThread_QueueEmpty(void) {
+	cc_bool empty;
+	Mutex_Lock(net_queueMutex);
+	{
+		empty = net_queueHead == net_queueTail;
+	}
+	Mutex_Unlock(net_queueMutex);
+	return empty;
+}
+
+/* Handlers for ExtInfo and ExtEntry packets change Protocol.Sizes and cpe_needD3Fix, */
+/*  so any other packet after them is only split up once they have been processed */
+static cc_bool NetThread_IsNegotiation(cc_uint8 opcode) {
+	return opcode == OPCODE_EXT_INFO || opcode == OPCODE_EXT_ENTRY;
+}
+
+static void NetThread_Run(void) {
+	cc_uint8* cur     = net_readBuffer;
+	cc_uint8* readEnd = net_readBuffer;
+	cc_uint8 opcode, prevOpcode = 0;
+	cc_bool negotiating = false, blocked, readable;
+	cc_bool closed = false;
+	int i, remaining, invalid = -1;
+	cc_uint32 read;
+	cc_result res = 0;
+
+	while (!net_threadStop) {
+		for (blocked = false; cur < readEnd; ) {
+			opcode = cur[0];
+
+			/* Workaround for older D3 servers which wrote one byte too many for HackControl packets */
+			if (cpe_needD3Fix && prevOpcode == OPCODE_HACK_CONTROL && (opcode == 0x00 || opcode == 0xFF)) {
+				if (!NetThread_Enqueue(NULL, 0, NET_RECORD_D3_SKIP)) { blocked = true; break; }
+				cur++; continue;
+			}
+
+			if (negotiating && !NetThread_IsNegotiation(opcode)) {
+				if (!NetThread_QueueEmpty()) { blocked = true; break; }
+				negotiating = false;
+			}
+
+			if (cur + Protocol.Sizes[opcode] > readEnd) break;
+			if (!Protocol.Handlers[opcode]) { invalid = opcode; break; }
+
+			if (!NetThread_Enqueue(cur, Protocol.Sizes[opcode], NET_RECORD_PACKET)) { blocked = true; break; }
+			prevOpcode   = opcode;
+			negotiating |= NetThread_IsNegotiation(opcode);
+			cur += Protocol.Sizes[opcode];
+		}
+		if (invalid >= 0) break;
+
+		/* Protocol packets might be split up across TCP packets */
+		/* If so, copy last few unprocessed bytes back to beginning of buffer */
+		remaining = (int)(readEnd - cur);
+		for (i = 0; i < remaining; i++) {
+			net_readBuffer[i] = cur[i];
+		}
+		cur     = net_readBuffer;
+		readEnd = net_readBuffer + remaining;
+
+		/* Wait for the main thread to process some of the queued packets */
+		if (blocked) { Waitable_WaitFor(net_queueWaitable, 50); continue; }
+
+		res = Socket_PollFor(net_socket, SOCKET_POLL_READ, 50, &readable);
+		if (res) break;
+		if (!readable) continue;
+
+		res = Socket_Read(net_socket, readEnd, 4096 * 4, &read);
+		/* Ignore errors for 'no data available for non-blocking read' */
+		if (res == ReturnCode_SocketInProgess || res == ReturnCode_SocketWouldBlock) { res = 0; continue; }
+		if (res) break;
+		/* Socket is readable but has no data, so the server has closed the connection */
+		if (!read) { closed = true; break; }
+
+		readEnd += read;
+		Mutex_Lock(net_queueMutex);
+		{
+			net_threadBytes += read;
+		}
+		Mutex_Unlock(net_queueMutex);
+	}
+
+	Mutex_Lock(net_queueMutex);
+	{
+		net_threadExited  = true;
+		net_threadClosed  = closed;
+		net_threadResult  = res;
+		net_threadInvalid = invalid;
+	}
+	Mutex_Unlock(net_queueMutex);
+}
+
+static void NetThread_Start(void) {
+	/* NOTE: Queue is only freed in OnFree, as handlers (e.g. kick) may still use packet data after OnClose */
+	if (!net_queue) net_queue = (cc_uint8*)Mem_Alloc(NET_QUEUE_SIZE, 1, "network queue");
+	net_queueHead     = 0; net_queueTail   = 0;
+	net_queuedPackets = 0; net_queuedBytes = 0;
+	net_threadBytes   = 0;
+
+	net_threadExited  = false;
+	net_threadClosed  = false;
+	net_threadResult  = 0;
+	net_threadInvalid = -1;
+	net_threadStop    = false;
+
+	net_queueMutex    = Mutex_Create();
+	net_queueWaitable = Waitable_Create();
+	net_thread        = Thread_Start(NetThread_Run);
+}
+
+static void NetThread_Stop(void) {
+	if (!net_thread) return;
+	net_threadStop = true;
+	Waitable_Signal(net_queueWaitable);
+
+	Thread_Join(net_thread);
+	net_thread = NULL;
+	Mutex_Free(net_queueMutex);
+	Waitable_Free(net_queueWaitable);
+}
+
+/* Processes packets from the tail of the queue, until the queue is empty or the time budget is used up */
+static void NetThread_Dispatch(void) {
+	cc_uint64 beg = Stopwatch_Measure(), now;
+	struct NetRecord* record;
+	cc_uint32 head, tail, size;
+	cc_bool exited;
+	int type, dispatched = 0;
+
+	Mutex_Lock(net_queueMutex);
+	{
+		head   = net_queueHead;
+		tail   = net_queueTail;
+		exited = net_threadExited;
+		stats_bytes    += net_threadBytes;
+		net_threadBytes = 0;
+	}
+	Mutex_Unlock(net_queueMutex);
+
+	while (tail != head) {
+		record = (struct NetRecord*)(net_queue + tail);
+		if (NET_QUEUE_SIZE - tail < sizeof(struct NetRecord) || record->type == NET_RECORD_WRAP) {
+			tail = 0; continue;
+		}
+
+		now = Stopwatch_Measure();
+		if (dispatched && net_dispatchBudget && Stopwatch_ElapsedMicroseconds(beg, now) >= net_dispatchBudget * 1000) break;
+		size = record->size;
+		type = record->type;
+
+		if (type == NET_RECORD_D3_SKIP) {
+			Platform_LogConst("Skipping invalid HackControl byte from D3 server");
+			LocalPlayer_ResetJumpVelocity();
+		} else {
+			Net_DispatchPacket((cc_uint8*)(record + 1), Stopwatch_ElapsedMicroseconds(record->received, now) / 1000.0f);
+			/* Handler may have disconnected (e.g. kick packet) */
+			if (Server.Disconnected) return;
+			dispatched++;
+		}
+
+		tail += NET_RECORD_SIZE(size);
+		if (tail == NET_QUEUE_SIZE) tail = 0;
+
+		Mutex_Lock(net_queueMutex);
+		{
+			net_queueTail = tail;
+			if (type == NET_RECORD_PACKET) { net_queuedPackets--; net_queuedBytes -= size; }
+		}
+		Mutex_Unlock(net_queueMutex);
+	}
+
+	Mutex_Lock(net_queueMutex);
+	{
+		Server.Stats.QueuedPackets = net_queuedPackets;
+		Server.Stats.QueuedBytes   = net_queuedBytes;
+	}
+	Mutex_Unlock(net_queueMutex);
+	if (dispatched) Waitable_Signal(net_queueWaitable);
+
+	/* Network thread has stopped, and all the packets it received before stopping have been processed */
+	if (!exited || tail != head) return;
+
+	if (net_threadInvalid >= 0) {
+		DisconnectInvalidOpcode((cc_uint8)net_threadInvalid);
+	} else if (net_threadResult) {
+		DisconnectReadError(net_threadResult);
+	} else if (net_threadClosed) {
+		DisconnectLostConnection();
+	}
+}
+#else
+static cc_bool net_useThread;
+static void NetThread_Start(void)    { }
+static void NetThread_Stop(void)     { }
+static void NetThread_Dispatch(void) { }
+#endif
+
+
+/*########################################################################################################################*
+*--------------------------------------------------Multiplayer connection-------------------------------------------------*
+*#########################################################################################################################*/
 static void OnClose(void);
+static void MPConnection_FlushData(void);
 static void MPConnection_FinishConnect(void) {
 	net_connecting = false;
 	Event_RaiseVoid(&NetEvents.Connected);
@@ -247,8 +578,14 @@ static void MPConnection_FinishConnect(void) {
 	net_readCurrent    = net_readBuffer;
 	Server.WriteBuffer = net_writeBuffer;
 
+	net_sendStart = 0; net_sendEnd = 0;
+	net_sendCongested = false;
 	Classic_SendLogin();
+	MPConnection_FlushData();
 	lastPacket = Game.Time;
+	stats_lastUpdate = Game.Time;
+	Mem_Set(&Server.Stats, 0, sizeof(Server.Stats));
+	if (net_useThread) NetThread_Start();
 }
 
 static void MPConnection_FailConnect(cc_result result) {
@@ -347,19 +684,30 @@ static void MPConnection_SendPosition(Vec3 pos, float yaw, float pitch) {
 	Net_SendPacket();
 }
 
-static void MPConnection_CheckDisconnection(void) {
+static void DisconnectLostConnection(void) {
 	static const cc_string title  = String_FromConst("Disconnected!");
 	static const cc_string reason = String_FromConst("You've lost connection to the server");
+	Game_Disconnect(&title, &reason);
+}
+
+static void MPConnection_CheckDisconnection(void) {
 	cc_result availRes, selectRes;
 	cc_uint32 pending = 0;
 	cc_bool poll_read;
 
+	/* The network thread is the only reader of the socket, and it already reports when */
+	/*  the connection is closed. Polling here would race with its reads, so only check writes */
+	if (net_useThread) {
+		if (net_writeFailed) DisconnectLostConnection();
+		return;
+	}
+
 	availRes  = Socket_Available(net_socket, &pending);
 	/* poll read returns true when socket is closed */
 	selectRes = Socket_Poll(net_socket, SOCKET_POLL_READ, &poll_read);
 
 	if (net_writeFailed || availRes || selectRes || (pending == 0 && poll_read)) {	
-		Game_Disconnect(&title, &reason);
+		DisconnectLostConnection();
 	}
 }
 
@@ -372,23 +720,25 @@ static void DisconnectInvalidOpcode(cc_uint8 opcode) {
 	Game_Disconnect(&title, &tmp); return;
 }
 
-static void MPConnection_Tick(struct ScheduledTask* task) {
+static void DisconnectReadError(cc_result res) {
 	static const cc_string title_lost  = String_FromConst("&eLost connection to the server");
 	static const cc_string reason_err  = String_FromConst("I/O error when reading packets");
 	cc_string msg; char msgBuffer[STRING_SIZE * 2];
+
+	String_InitArray(msg, msgBuffer);
+	String_Format3(&msg, "Error reading from %s:%i: %i" _NL, &Server.IP, &Server.Port, &res);
+
+	Logger_Log(&msg);
+	Game_Disconnect(&title_lost, &reason_err);
+}
+
+/* Reads and processes packets on the main thread (when the network thread is not used) */
+static void MPConnection_ReadPackets(void) {
 	cc_uint32 pending;
 	cc_uint8* readEnd;
-	Net_Handler handler;
 	int i, remaining;
 	cc_result res;
 
-	if (Server.Disconnected) return;
-	if (net_connecting) { MPConnection_TickConnect(); return; }
-
-	/* Over 30 seconds since last packet, connection likely dropped */
-	if (lastPacket + 30 < Game.Time) MPConnection_CheckDisconnection();
-	if (Server.Disconnected) return;
-
 	pending = 0;
 	res     = Socket_Available(net_socket, &pending);
 	readEnd = net_readCurrent;
@@ -401,17 +751,10 @@ static void MPConnection_Tick(struct ScheduledTask* task) {
 			if (res == ReturnCode_SocketInProgess)  return;
 			if (res == ReturnCode_SocketWouldBlock) return;
 		}
-		readEnd += pending;
-	}
-
-	if (res) {
-		String_InitArray(msg, msgBuffer);
-		String_Format3(&msg, "Error reading from %s:%i: %i" _NL, &Server.IP, &Server.Port, &res);
-
-		Logger_Log(&msg);
-		Game_Disconnect(&title_lost, &reason_err);
-		return;
+		readEnd     += pending;
+		stats_bytes += pending;
 	}
+	if (res) { DisconnectReadError(res); return; }
 
 	net_readCurrent = net_readBuffer;
 	while (net_readCurrent < readEnd) {
@@ -426,12 +769,9 @@ static void MPConnection_Tick(struct ScheduledTask* task) {
 		}
 
 		if (net_readCurrent + Protocol.Sizes[opcode] > readEnd) break;
-		handler = Protocol.Handlers[opcode];
-		if (!handler) { DisconnectInvalidOpcode(opcode); return; }
+		if (!Protocol.Handlers[opcode]) { DisconnectInvalidOpcode(opcode); return; }
 
-		lastOpcode = opcode;
-		lastPacket = Game.Time;
-		handler(net_readCurrent + 1); /* skip opcode */
+		Net_DispatchPacket(net_readCurrent, 0.0f);
 		net_readCurrent += Protocol.Sizes[opcode];
 	}
 
@@ -443,6 +783,23 @@ static void MPConnection_Tick(struct ScheduledTask* task) {
 		net_readBuffer[i] = net_readCurrent[i];
 	}
 	net_readCurrent = net_readBuffer + remaining;
+}
+
+static void MPConnection_Tick(struct ScheduledTask* task) {
+	if (Server.Disconnected) return;
+	if (net_connecting) { MPConnection_TickConnect(); return; }
+
+	/* Over 30 seconds since last packet, connection likely dropped */
+	if (lastPacket + 30 < Game.Time) MPConnection_CheckDisconnection();
+	if (Server.Disconnected) return;
+
+	if (net_useThread) {
+		NetThread_Dispatch();
+	} else {
+		MPConnection_ReadPackets();
+	}
+	if (Server.Disconnected) return;
+	Net_UpdateStats();
 
 	/* Network is ticked 60 times a second. We only send position updates 20 times a second */
 	if ((ticks % 3) == 0) {
@@ -451,29 +808,53 @@ static void MPConnection_Tick(struct ScheduledTask* task) {
 		/* Have any packets been written? */
 		if (Server.WriteBuffer != net_writeBuffer) Net_SendPacket();
 	}
+	MPConnection_FlushData();
 	ticks++;
 }
 
-static void MPConnection_SendData(const cc_uint8* data, cc_uint32 len) {
+/* Sends as much of the queued data as the socket will currently accept */
+static void MPConnection_FlushData(void) {
 	cc_uint32 wrote;
 	cc_result res;
-	int tries = 0;
-	if (Server.Disconnected) return;
 
-	while (len) {
-		res = Socket_Write(net_socket, data, len, &wrote);
-		/* If sending would block (send buffer full), retry for a bit up to 10 seconds */
-		/* TODO: Avoid doing this and manually buffer data when this happens */
-		if (res && tries < 1000 && (res == ReturnCode_SocketInProgess || res == ReturnCode_SocketWouldBlock)) {
-			Thread_Sleep(10);
-			tries++;
-			continue;
-		}
+	while (net_sendStart < net_sendEnd) {
+		res = Socket_Write(net_socket, net_sendBuffer + net_sendStart, net_sendEnd - net_sendStart, &wrote);
+		/* Socket's send buffer is full, so try again next tick */
+		if (res == ReturnCode_SocketInProgess || res == ReturnCode_SocketWouldBlock) break;
 
 		/* NOTE: Not immediately disconnecting here, as otherwise we sometimes miss out on kick messages */
-		if (res || !wrote) { net_writeFailed = true; return; }
-		data += wrote; len -= wrote;
+		if (res || !wrote) { net_writeFailed = true; break; }
+		net_sendStart += wrote;
+	}
+
+	net_sendCongested = net_sendStart < net_sendEnd;
+	if (!net_sendCongested) { net_sendStart = 0; net_sendEnd = 0; }
+}
+
+static void MPConnection_SendData(const cc_uint8* data, cc_uint32 len) {
+	int i, unsent;
+	if (Server.Disconnected || net_writeFailed) return;
+	unsent = net_sendEnd - net_sendStart;
+
+	if (unsent + len > NET_SEND_MAX_SIZE) { net_writeFailed = true; return; }
+	if (net_sendEnd + len > net_sendCapacity) {
+		/* Move unsent data back to the start of the buffer */
+		for (i = 0; i < unsent; i++) {
+			net_sendBuffer[i] = net_sendBuffer[net_sendStart + i];
+		}
+		net_sendStart = 0; net_sendEnd = unsent;
 	}
+
+	if (net_sendEnd + len > net_sendCapacity) {
+		Utils_Resize((void**)&net_sendBuffer, &net_sendCapacity,
+					1, NET_SEND_DEF_SIZE, max(net_sendCapacity, (int)len));
+	}
+	Mem_Copy(net_sendBuffer + net_sendEnd, data, len);
+	net_sendEnd += len;
+}
+
+cc_bool Net_IsCongested(void) {
+	return !Server.IsSinglePlayer && net_sendCongested;
 }
 
 void Net_SendPacket(void) {
@@ -495,6 +876,11 @@ static void MPConnection_Init(void) {
 
 	net_readCurrent    = net_readBuffer;
 	Server.WriteBuffer = net_writeBuffer;
+
+#ifndef CC_BUILD_WEB
+	net_useThread      = Options_GetBool(OPT_NET_THREAD, true);
+#endif
+	net_dispatchBudget = Options_GetInt(OPT_NET_DISPATCH_BUDGET, 0, 1000, 5);
 }
 
 
@@ -531,13 +917,23 @@ static void OnInit(void) {
 
 static void OnReset(void) {
 	if (Server.IsSinglePlayer) return;
-	net_writeFailed = false;
+	net_writeFailed   = false;
+	net_sendCongested = false;
+	net_sendStart = 0; net_sendEnd = 0;
 	OnClose();
 }
 
 static void OnFree(void) {
 	Server.IP.length = 0;
 	OnClose();
+#ifndef CC_BUILD_WEB
+	Mem_Free(net_queue);
+	net_queue = NULL;
+#endif
+
+	if (net_sendBuffer != net_sendDefault) Mem_Free(net_sendBuffer);
+	net_sendBuffer   = net_sendDefault;
+	net_sendCapacity = NET_SEND_DEF_SIZE;
 }
 
 static void OnClose(void) {
@@ -547,6 +943,7 @@ static void OnClose(void) {
 		Ping_Reset();
 		if (Server.Disconnected) return;
 
+		NetThread_Stop();
 		Socket_Close(net_socket);
 		Server.Disconnected = true;
 	}
@@ -16,6 +16,16 @@ void Ping_Update(int id);
 /* Calculates average ping time based on most recent ping entries. */
 int Ping_AveragePingMS(void);
 
+/* Statistics about packets received from a multiplayer server, for diagnosing laggy connections. */
+struct ServerNetStats {
+	int QueuedPackets;  /* Number of received packets still waiting to be processed */
+	int QueuedBytes;    /* Size of the received packets still waiting to be processed */
+	int BytesPerSec;    /* Bytes received from the server over the last second */
+	int PacketsPerSec;  /* Packets processed over the last second */
+	float AvgLatency;   /* Average milliseconds between a packet being received and processed */
+	float MaxLatency;   /* Highest milliseconds between a packet being received and processed */
+};
+
 /* Data for currently active connection to a server. */
 CC_VAR extern struct _ServerConnectionData {
 	/* Begins connecting to the server. */
@@ -61,10 +71,15 @@ CC_VAR extern struct _ServerConnectionData {
 	cc_string IP;
 	/* Port of the server if multiplayer, 0 if singleplayer. */
 	int Port;
+	/* Statistics about received packets, which are updated once per second. (multiplayer only) */
+	struct ServerNetStats Stats;
 } Server;
 
 /* If user hasn't previously accepted url, displays a dialog asking to confirm downloading it. */
 /* Otherwise just calls TexturePack_Extract. */
 void Server_RetrieveTexturePack(const cc_string* url);
 void Net_SendPacket(void);
+/* Whether data sent to the server is backing up, because the connection is congested. */
+/* NOTE: Data is only actually sent to the server once per network tick. */
+cc_bool Net_IsCongested(void);
 #endif
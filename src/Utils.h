@@ -39,7 +39,16 @@ int Utils_AccumulateWheelDelta(float* accumulator, float delta);
 #define Utils_AdjViewDist(value) ((int)(1.4142135f * (value)))
 
 cc_uint8 Utils_CalcSkinType(const struct Bitmap* bmp);
+/* Calculates the CRC32 checksum of the given data. */
 cc_uint32 Utils_CRC32(const cc_uint8* data, cc_uint32 length);
+/* Updates a running CRC32 checksum with the given data. */
+/* NOTE: crc starts out as 0xFFFFFFFF, and must be XORed with 0xFFFFFFFF at the end. */
+cc_uint32 Utils_UpdateCRC32(cc_uint32 crc, const cc_uint8* data, cc_uint32 length);
+/* Combines the CRC32 checksums of two adjacent pieces of data into the CRC32 checksum of all the data. */
+/* NOTE: length2 is the length of the second piece of data. */
+cc_uint32 Utils_CombineCRC32(cc_uint32 crc1, cc_uint32 crc2, cc_uint32 length2);
+/* Updates a running Adler32 checksum with the given data. (adler starts out as 1) */
+cc_uint32 Utils_UpdateAdler32(cc_uint32 adler, const cc_uint8* data, cc_uint32 length);
 /* CRC32 lookup table, for faster CRC32 calculations. */
 /* NOTE: This cannot be just indexed by byte value - see Utils_CRC32 implementation. */
 extern const cc_uint32 Utils_Crc32Table[256];
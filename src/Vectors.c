@@ -236,6 +236,31 @@ cc_bool FrustumCulling_SphereInFrustum(float x, float y, float z, float radius)
 	return true;
 }
 
+/* Calculates the min and max distance from the given plane of any point in the given box */
+#define FrustumCulling_TestPlane(a, b, c, d) \
+dist   = a * centre.X + b * centre.Y + c * centre.Z + d;\
+extent = Math_AbsF(a) * half.X + Math_AbsF(b) * half.Y + Math_AbsF(c) * half.Z;\
+if (dist + extent <= -radius) return FRUSTUM_OUTSIDE;\
+if (dist - extent <= -radius) result = FRUSTUM_INTERSECT;
+
+int FrustumCulling_BoxInFrustum(const Vec3* min, const Vec3* max, float radius) {
+	int result = FRUSTUM_INSIDE;
+	float dist, extent;
+	Vec3 centre, half;
+
+	centre.X = (min->X + max->X) * 0.5f; half.X = (max->X - min->X) * 0.5f;
+	centre.Y = (min->Y + max->Y) * 0.5f; half.Y = (max->Y - min->Y) * 0.5f;
+	centre.Z = (min->Z + max->Z) * 0.5f; half.Z = (max->Z - min->Z) * 0.5f;
+
+	FrustumCulling_TestPlane(frustum00, frustum01, frustum02, frustum03);
+	FrustumCulling_TestPlane(frustum10, frustum11, frustum12, frustum13);
+	FrustumCulling_TestPlane(frustum20, frustum21, frustum22, frustum23);
+	FrustumCulling_TestPlane(frustum30, frustum31, frustum32, frustum33);
+	FrustumCulling_TestPlane(frustum40, frustum41, frustum42, frustum43);
+	/* Don't test NEAR plane, it's pointless */
+	return result;
+}
+
 void FrustumCulling_CalcFrustumEquations(struct Matrix* projection, struct Matrix* modelView) {
 	struct Matrix clipMatrix;
 	float* clip = (float*)&clipMatrix;
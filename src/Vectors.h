@@ -133,5 +133,11 @@ void Matrix_PerspectiveFieldOfView(struct Matrix* result, float fovy, float aspe
 void Matrix_LookRot(struct Matrix* result, Vec3 pos, Vec2 rot);
 
 cc_bool FrustumCulling_SphereInFrustum(float x, float y, float z, float radius);
+#define FRUSTUM_OUTSIDE   0 /* Every sphere is outside the frustum */
+#define FRUSTUM_INTERSECT 1 /* Some spheres may be inside the frustum */
+#define FRUSTUM_INSIDE    2 /* Every sphere is inside the frustum */
+/* Tests spheres of the given radius, centred at every point in the given box, against the frustum. */
+/* i.e. FRUSTUM_INSIDE means FrustumCulling_SphereInFrustum would return true for every point in the box */
+int FrustumCulling_BoxInFrustum(const Vec3* min, const Vec3* max, float radius);
 void FrustumCulling_CalcFrustumEquations(struct Matrix* projection, struct Matrix* modelView);
 #endif
@@ -0,0 +1,153 @@
+#include "Workers.h"
+#include "Platform.h"
+#include "Options.h"
+#include "Funcs.h"
+#include "Game.h"
+
+int Workers_Count = 1;
+#ifndef CC_BUILD_WEB
+static void* workerThreads[WORKERS_MAX_COUNT];
+/* Signalled to wake up a particular worker thread when there are items to process */
+static void* workerWaitables[WORKERS_MAX_COUNT];
+/* Signalled by the last worker thread to finish processing items */
+static void* doneWaitable;
+/* Protects the current batch state below */
+static void* batchMutex;
+/* Ensures that only one batch of items is being processed at a time */
+static void* runMutex;
+
+static Workers_ArgItemFunc batchFunc;
+static void* batchArg;
+static int batchNext, batchCount, batchBusy;
+static int nextWorkerID;
+static volatile cc_bool workers_terminate;
+
+static cc_bool Workers_NextItem(int* item) {
+	cc_bool hasItem;
+	Mutex_Lock(batchMutex);
+	{
+		*item   = batchNext++;
+		hasItem = *item < batchCount;
+	}
+	Mutex_Unlock(batchMutex);
+	return hasItem;
+}
+
+static void Workers_ProcessItems(int worker) {
+	int item;
+	while (Workers_NextItem(&item)) { batchFunc(batchArg, item, worker); }
+}
+
+static void WorkerLoop(void) {
+	cc_bool finished;
+	int id;
+
+	Mutex_Lock(batchMutex);
+	{
+		id = ++nextWorkerID;
+	}
+	Mutex_Unlock(batchMutex);
+
+	for (;;) {
+		Waitable_Wait(workerWaitables[id]);
+		if (workers_terminate) return;
+		Workers_ProcessItems(id);
+
+		Mutex_Lock(batchMutex);
+		{
+			finished = --batchBusy == 0;
+		}
+		Mutex_Unlock(batchMutex);
+		if (finished) Waitable_Signal(doneWaitable);
+	}
+}
+
+void Workers_RunWith(Workers_ArgItemFunc func, void* arg, int count) {
+	int i, threads = min(Workers_Count, count) - 1;
+	/* Items are always processed while holding runMutex, as even when no other threads */
+	/*  are woken up, per-worker state of worker 0 must not be used by two callers at once */
+	Mutex_Lock(runMutex);
+	/* No point waking up other threads for just one item */
+	if (threads <= 0) {
+		for (i = 0; i < count; i++) { func(arg, i, 0); }
+		Mutex_Unlock(runMutex);
+		return;
+	}
+
+	{
+		batchFunc  = func;
+		batchArg   = arg;
+		batchNext  = 0;
+		batchCount = count;
+		batchBusy  = threads;
+
+		for (i = 1; i <= threads; i++) { Waitable_Signal(workerWaitables[i]); }
+		Workers_ProcessItems(0);
+		Waitable_Wait(doneWaitable);
+	}
+	Mutex_Unlock(runMutex);
+}
+
+static void OnInit(void) {
+	int i, count = min(Thread_ProcessorCount(), WORKERS_MAX_COUNT);
+	count = Options_GetInt(OPT_WORKER_THREADS, 1, WORKERS_MAX_COUNT, count);
+	runMutex = Mutex_Create();
+	if (count <= 1) return;
+
+	workers_terminate = false;
+	nextWorkerID  = 0;
+	batchMutex    = Mutex_Create();
+	doneWaitable  = Waitable_Create();
+
+	/* Worker 0 is always the thread calling Workers_Run */
+	for (i = 1; i < count; i++) {
+		workerWaitables[i] = Waitable_Create();
+	}
+	for (i = 1; i < count; i++) {
+		workerThreads[i] = Thread_Start(WorkerLoop);
+	}
+	Workers_Count = count;
+	Platform_Log1("Using %i worker threads", &count);
+}
+
+static void OnFree(void) {
+	int i;
+	Mutex_Free(runMutex);
+	runMutex = NULL;
+	if (Workers_Count <= 1) return;
+	workers_terminate = true;
+
+	for (i = 1; i < Workers_Count; i++) {
+		Waitable_Signal(workerWaitables[i]);
+		Thread_Join(workerThreads[i]);
+		Waitable_Free(workerWaitables[i]);
+	}
+
+	Mutex_Free(batchMutex);
+	Waitable_Free(doneWaitable);
+	Workers_Count = 1;
+}
+#else
+/* No real threading support with emscripten backend */
+void Workers_RunWith(Workers_ArgItemFunc func, void* arg, int count) {
+	int i;
+	for (i = 0; i < count; i++) { func(arg, i, 0); }
+}
+
+static void OnInit(void) { }
+static void OnFree(void) { }
+#endif
+
+static void Workers_CallItemFunc(void* arg, int item, int worker) {
+	Workers_ItemFunc func = *(Workers_ItemFunc*)arg;
+	func(item, worker);
+}
+
+void Workers_Run(Workers_ItemFunc func, int count) {
+	Workers_RunWith(Workers_CallItemFunc, &func, count);
+}
+
+struct IGameComponent Workers_Component = {
+	OnInit, /* Init  */
+	OnFree  /* Free  */
+};
@@ -0,0 +1,32 @@
+#ifndef CC_WORKERS_H
+#define CC_WORKERS_H
+#include "Core.h"
+/* Manages a pool of background threads, which expensive work can be split across.
+   (e.g. building the meshes of several chunks at once)
+   Work is split in a fork/join manner, so no work is ever still running after Workers_Run returns.
+   Copyright 2014-2021 ClassiCube | Licensed under BSD-3
+*/
+struct IGameComponent;
+extern struct IGameComponent Workers_Component;
+
+/* Maximum number of threads (including the calling thread) that work can be split across. */
+#define WORKERS_MAX_COUNT 16
+/* Number of threads (including the calling thread) that work is split across. */
+/* NOTE: This is always 1 when threading is not supported. (e.g. web client) */
+extern int Workers_Count;
+
+/* Function called to process a single item of work. */
+/* worker is the index of the thread processing the item, and ranges from 0 to Workers_Count - 1. */
+/* NOTE: Only one item is ever processed at a time by a given worker, so per-worker state is safe. */
+typedef void (*Workers_ItemFunc)(int item, int worker);
+/* Calls func for each item from 0 to count - 1, with the items split across all the worker threads. */
+/* NOTE: The calling thread is worker 0 and also processes items, and this only returns once all items are done. */
+/* NOTE: Must NOT be called from inside an item function. */
+void Workers_Run(Workers_ItemFunc func, int count);
+
+/* Function called to process a single item of work, with the argument given to Workers_RunWith. */
+typedef void (*Workers_ArgItemFunc)(void* arg, int item, int worker);
+/* Same as Workers_Run, but also passes arg to func. */
+/* This avoids needing static variables to pass state to func, so it can be safely called from multiple threads. */
+void Workers_RunWith(Workers_ArgItemFunc func, void* arg, int count);
+#endif
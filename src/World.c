@@ -7,11 +7,521 @@
 #include "Entity.h"
 #include "ExtMath.h"
 #include "Physics.h"
+#include "BlockPhysics.h"
 #include "Game.h"
 #include "TexturePack.h"
 #include "Window.h"
+#include "Workers.h"
+#include "Constants.h"
+#include "Funcs.h"
 
 struct _WorldData World;
+/*########################################################################################################################*
+*-----------------------------------------------------Chunk summaries-----------------------------------------------------*
+*#########################################################################################################################*/
+static struct ChunkSummary* chunkSummaries;
+static int summariesX, summariesY, summariesZ;
+#define World_PackSummary(cx, cy, cz) (((cy) * summariesZ + (cz)) * summariesX + (cx))
+
+static void CalcChunkSummary(struct ChunkSummary* summary, int x1, int y1, int z1) {
+	int x2 = min(World.Width,  x1 + CHUNK_SIZE);
+	int y2 = min(World.Height, y1 + CHUNK_SIZE);
+	int z2 = min(World.Length, z1 + CHUNK_SIZE);
+	int gas = 0, opaque = 0, ticks = 0, sponges = 0;
+	int x, y, z, i;
+	BlockID block;
+
+	for (y = y1; y < y2; y++) {
+		for (z = z1; z < z2; z++) {
+			i = World_Pack(x1, y, z);
+
+			for (x = x1; x < x2; x++, i++) {
+#if defined PALETTE_BLOCKS
+				block = World_GetBlock(x, y, z);
+#elif defined EXTENDED_BLOCKS
+				block = World.BlocksUpper ? (BlockID)(World.Blocks[i] | (World_GetUpper(i) << 8)) : World.Blocks[i];
+#else
+				block = World.Blocks[i];
+#endif
+				gas    += Blocks.Draw[block] == DRAW_GAS;
+				opaque += Blocks.FullOpaque[block];
+				ticks  += Physics.OnRandomTick[(BlockRaw)block] != NULL;
+				sponges += block == BLOCK_SPONGE;
+			}
+		}
+	}
+
+	summary->Total  = (x2 - x1) * (y2 - y1) * (z2 - z1);
+	summary->Gas    = gas;
+	summary->Opaque = opaque;
+	summary->RandomTicks = ticks;
+	summary->Sponges = sponges;
+	summary->Dirty  = false;
+}
+
+static void CalcChunkSummaryWorker(int item, int worker) {
+	int cx = item % summariesX;
+	int cz = (item / summariesX) % summariesZ;
+	int cy = (item / summariesX) / summariesZ;
+	CalcChunkSummary(&chunkSummaries[item], cx << CHUNK_SHIFT, cy << CHUNK_SHIFT, cz << CHUNK_SHIFT);
+}
+
+static void InitChunkSummaries(void) {
+	summariesX = (World.Width  + CHUNK_MAX) >> CHUNK_SHIFT;
+	summariesY = (World.Height + CHUNK_MAX) >> CHUNK_SHIFT;
+	summariesZ = (World.Length + CHUNK_MAX) >> CHUNK_SHIFT;
+
+	/* Summaries are only an optimisation, so not being able to allocate them isn't an error */
+	chunkSummaries = (struct ChunkSummary*)Mem_TryAlloc(summariesX * summariesY * summariesZ, sizeof(struct ChunkSummary));
+	if (!chunkSummaries) return;
+	Workers_Run(CalcChunkSummaryWorker, summariesX * summariesY * summariesZ);
+}
+
+static void FreeChunkSummaries(void) {
+	Mem_Free(chunkSummaries);
+	chunkSummaries = NULL;
+}
+
+static void UpdateChunkSummary(int x, int y, int z, BlockID old, BlockID block) {
+	struct ChunkSummary* summary;
+	summary = &chunkSummaries[World_PackSummary(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT)];
+	summary->Sponges += (block == BLOCK_SPONGE) - (old == BLOCK_SPONGE);
+	if (summary->Dirty) return;
+
+	summary->Gas    += (Blocks.Draw[block] == DRAW_GAS) - (Blocks.Draw[old] == DRAW_GAS);
+	summary->Opaque += Blocks.FullOpaque[block] - Blocks.FullOpaque[old];
+	/* Random ticks only look at the lower 8 bits of blocks */
+	summary->RandomTicks += (Physics.OnRandomTick[(BlockRaw)block] != NULL) - (Physics.OnRandomTick[(BlockRaw)old] != NULL);
+}
+
+struct ChunkSummary* World_GetChunkSummary(int cx, int cy, int cz) {
+	struct ChunkSummary* summary;
+	if (!chunkSummaries) return NULL;
+
+	summary = &chunkSummaries[World_PackSummary(cx, cy, cz)];
+	if (summary->Dirty) CalcChunkSummary(summary, cx << CHUNK_SHIFT, cy << CHUNK_SHIFT, cz << CHUNK_SHIFT);
+	return summary;
+}
+
+int World_CountChunkSponges(int cx, int cy, int cz) {
+	if (!chunkSummaries) return -1;
+	return chunkSummaries[World_PackSummary(cx, cy, cz)].Sponges;
+}
+
+void World_InvalidateChunkSummaries(void) {
+	int i, count = summariesX * summariesY * summariesZ;
+	if (!chunkSummaries) return;
+
+	for (i = 0; i < count; i++) {
+		chunkSummaries[i].Dirty = true;
+	}
+}
+
+/* Block properties that summaries depend on may have changed, so lazily recalculate them */
+static void OnBlockDefChanged(void* obj) { World_InvalidateChunkSummaries(); }
+
+
+#ifdef PALETTE_BLOCKS
+/*########################################################################################################################*
+*-----------------------------------------------------Palette chunks------------------------------------------------------*
+*#########################################################################################################################*/
+/* Each chunk stores its blocks as indices into a palette of the different blocks in the chunk, */
+/*  bit-packed into 32 bit words using as few bits per block as the size of the palette allows. */
+/* Chunks with more than 256 different blocks instead store block IDs directly, using 10 bits per block. */
+/* NOTE: Blocks are never removed from the palette, until the chunk is converted again on the next map load. */
+#define CHUNK_RAW_BITS 10
+/* Number of 10 bit block IDs stored in each 32 bit word */
+#define CHUNK_RAW_PER_WORD 3
+
+struct WorldChunk {
+	cc_uint32* Data;    /* Bit-packed palette indices (or block IDs), or NULL when Bits is 0 */
+	BlockID* Palette;   /* The different blocks in the chunk, or NULL when Bits is CHUNK_RAW_BITS */
+	cc_uint16 PaletteCount;
+	cc_uint8  Bits;     /* 0, 1, 2, 4, 8 or CHUNK_RAW_BITS. (0 means all blocks are Palette[0]) */
+};
+static int chunksX, chunksY, chunksZ;
+#define World_PackChunk(x, y, z) ((((y) >> CHUNK_SHIFT) * chunksZ + ((z) >> CHUNK_SHIFT)) * chunksX + ((x) >> CHUNK_SHIFT))
+#define Chunk_Index(x, y, z) ((((y) & CHUNK_MASK) << 8) | (((z) & CHUNK_MASK) << 4) | ((x) & CHUNK_MASK))
+/* log2 of the number of values in each 32 bit word, for a given number of bits per block */
+static const cc_uint8 chunk_wordShift[9] = { 0, 5, 4, 0, 3, 0, 0, 0, 2 };
+/* Per worker lookup of a block's index in the palette plus 1 (0 if not in the palette), when converting chunks */
+static cc_uint16 chunk_lookup[WORKERS_MAX_COUNT][BLOCK_COUNT];
+
+static int Chunk_DataWords(int bits) {
+	if (bits == CHUNK_RAW_BITS) return (CHUNK_SIZE_3 + CHUNK_RAW_PER_WORD - 1) / CHUNK_RAW_PER_WORD;
+	return CHUNK_SIZE_3 >> chunk_wordShift[bits];
+}
+
+static int Chunk_BitsFor(int paletteCount) {
+	if (paletteCount <= 1)   return 0;
+	if (paletteCount <= 2)   return 1;
+	if (paletteCount <= 4)   return 2;
+	if (paletteCount <= 16)  return 4;
+	if (paletteCount <= 256) return 8;
+	return CHUNK_RAW_BITS;
+}
+
+/* Calculates which word and bit offset in the chunk's data the i'th value is stored at */
+#define Chunk_Locate(c, i, word, shift)\
+if (c->Bits == CHUNK_RAW_BITS) {\
+	word  = i / CHUNK_RAW_PER_WORD;\
+	shift = (i - word * CHUNK_RAW_PER_WORD) * CHUNK_RAW_BITS;\
+} else {\
+	word  = i >> chunk_wordShift[c->Bits];\
+	shift = (i & ((1 << chunk_wordShift[c->Bits]) - 1)) * c->Bits;\
+}
+
+static int Chunk_GetValue(const struct WorldChunk* c, int i) {
+	int word, shift;
+	Chunk_Locate(c, i, word, shift);
+	return (c->Data[word] >> shift) & ((1 << c->Bits) - 1);
+}
+
+static void Chunk_SetValue(struct WorldChunk* c, int i, int value) {
+	cc_uint32 mask;
+	int word, shift;
+	Chunk_Locate(c, i, word, shift);
+
+	mask = ((1U << c->Bits) - 1) << shift;
+	c->Data[word] = (c->Data[word] & ~mask) | ((cc_uint32)value << shift);
+}
+
+static BlockID Chunk_GetBlock(const struct WorldChunk* c, int i) {
+	if (!c->Bits) return c->Palette[0];
+	if (c->Bits == CHUNK_RAW_BITS) return (BlockID)Chunk_GetValue(c, i);
+	return c->Palette[Chunk_GetValue(c, i)];
+}
+
+static void Chunk_Alloc(struct WorldChunk* c, int bits) {
+	c->Bits    = bits;
+	c->Data    = bits ? (cc_uint32*)Mem_AllocCleared(Chunk_DataWords(bits), 4, "world chunk") : NULL;
+	c->Palette = bits == CHUNK_RAW_BITS ? NULL : (BlockID*)Mem_Alloc(1 << bits, sizeof(BlockID), "chunk palette");
+}
+
+static void Chunk_Free(struct WorldChunk* c) {
+	Mem_Free(c->Data);
+	Mem_Free(c->Palette);
+}
+
+/* Changes the chunk to use more bits per block, so that its palette has room for another block */
+static void Chunk_Grow(struct WorldChunk* c) {
+	struct WorldChunk old = *c;
+	int i;
+	Chunk_Alloc(c, Chunk_BitsFor(old.PaletteCount + 1));
+
+	if (c->Bits == CHUNK_RAW_BITS) {
+		for (i = 0; i < CHUNK_SIZE_3; i++) { Chunk_SetValue(c, i, Chunk_GetBlock(&old, i)); }
+		c->PaletteCount = 0;
+	} else {
+		/* Palette stays in the same order, so the indices stay the same */
+		Mem_Copy(c->Palette, old.Palette, old.PaletteCount * sizeof(BlockID));
+		if (old.Bits) {
+			for (i = 0; i < CHUNK_SIZE_3; i++) { Chunk_SetValue(c, i, Chunk_GetValue(&old, i)); }
+		}
+	}
+	Chunk_Free(&old);
+}
+
+static void Chunk_SetBlock(struct WorldChunk* c, int i, BlockID block) {
+	int p;
+	if (c->Bits != CHUNK_RAW_BITS) {
+		for (p = 0; p < c->PaletteCount; p++) {
+			if (c->Palette[p] == block) break;
+		}
+
+		if (p == c->PaletteCount) {
+			if (p == (1 << c->Bits)) Chunk_Grow(c);
+			if (c->Bits != CHUNK_RAW_BITS) c->Palette[c->PaletteCount++] = block;
+		}
+		if (c->Bits != CHUNK_RAW_BITS) {
+			if (c->Bits) Chunk_SetValue(c, i, p);
+			return;
+		}
+	}
+	Chunk_SetValue(c, i, block);
+}
+
+/* Initialises the chunk from the given blocks, using as few bits per block as the different blocks in it allow */
+static void Chunk_Build(struct WorldChunk* c, const BlockID* blocks, cc_uint16* lookup) {
+	BlockID palette[BLOCK_COUNT];
+	cc_uint16 values[CHUNK_SIZE_3];
+	int i, count = 0;
+	BlockID block;
+
+	for (i = 0; i < CHUNK_SIZE_3; i++) {
+		block = blocks[i];
+		if (!lookup[block]) { palette[count++] = block; lookup[block] = count; }
+		values[i] = lookup[block] - 1;
+	}
+
+	Chunk_Alloc(c, Chunk_BitsFor(count));
+	if (c->Bits == CHUNK_RAW_BITS) {
+		for (i = 0; i < CHUNK_SIZE_3; i++) { Chunk_SetValue(c, i, blocks[i]); }
+	} else {
+		Mem_Copy(c->Palette, palette, count * sizeof(BlockID));
+		c->PaletteCount = count;
+		if (c->Bits) {
+			for (i = 0; i < CHUNK_SIZE_3; i++) { Chunk_SetValue(c, i, values[i]); }
+		}
+	}
+	for (i = 0; i < count; i++) { lookup[palette[i]] = 0; }
+}
+
+/* Reads count blocks in map order, starting at the given block index, from wherever the map is being converted from */
+static void (*convertRow)(BlockID* dst, int index, int count);
+/* Index of the first chunk in the slab of chunks currently being converted */
+static int convertBase;
+
+static void ConvertChunk(int item, int worker) {
+	BlockID blocks[CHUNK_SIZE_3];
+	struct WorldChunk* c;
+	int x1, y1, z1, width, height, length;
+	int x, y, z, i;
+
+	item += convertBase;
+	c  = &World.Chunks[item];
+	x1 = (item % chunksX) << CHUNK_SHIFT; width  = min(World.Width  - x1, CHUNK_SIZE);
+	z1 = ((item / chunksX) % chunksZ) << CHUNK_SHIFT; length = min(World.Length - z1, CHUNK_SIZE);
+	y1 = ((item / chunksX) / chunksZ) << CHUNK_SHIFT; height = min(World.Height - y1, CHUNK_SIZE);
+
+	for (y = 0; y < height; y++) {
+		for (z = 0; z < length; z++) {
+			convertRow(&blocks[Chunk_Index(0, y, z)], World_Pack(x1, y1 + y, z1 + z), width);
+		}
+	}
+
+	/* Parts of chunks on the map edges outside the map reuse an existing block, to avoid growing the palette */
+	if (width < CHUNK_SIZE || height < CHUNK_SIZE || length < CHUNK_SIZE) {
+		for (y = 0; y < CHUNK_SIZE; y++) {
+			for (z = 0; z < CHUNK_SIZE; z++) {
+				for (x = 0; x < CHUNK_SIZE; x++) {
+					if (x < width && y < height && z < length) continue;
+					i = Chunk_Index(x, y, z);
+					blocks[i] = blocks[0];
+				}
+			}
+		}
+	}
+	Chunk_Build(c, blocks, chunk_lookup[worker]);
+}
+
+static void StreamedRuns_Free(int end);
+/* Converts the blocks of a newly loaded map into chunks, one 16 block high slab at a time */
+static void ConvertChunks(void) {
+	int cy, slabChunks;
+	chunksX = (World.Width  + CHUNK_MAX) >> CHUNK_SHIFT;
+	chunksY = (World.Height + CHUNK_MAX) >> CHUNK_SHIFT;
+	chunksZ = (World.Length + CHUNK_MAX) >> CHUNK_SHIFT;
+	slabChunks = chunksX * chunksZ;
+
+	World.Chunks = (struct WorldChunk*)Mem_AllocCleared(slabChunks * chunksY, sizeof(struct WorldChunk), "world chunks");
+	for (cy = 0; cy < chunksY; cy++) {
+		convertBase = cy * slabChunks;
+		Workers_Run(ConvertChunk, slabChunks);
+		/* Streamed blocks of the slab are no longer needed, so free them as soon as possible to lower peak memory */
+		StreamedRuns_Free(World_Pack(0, min(World.Height, (cy + 1) << CHUNK_SHIFT), 0));
+	}
+}
+
+static void ReadFlatRow(BlockID* dst, int index, int count) {
+	int i;
+	for (i = 0; i < count; i++, index++) {
+#ifdef EXTENDED_BLOCKS
+		dst[i] = World.BlocksUpper ? (BlockID)(World.Blocks[index] | (World_GetUpper(index) << 8)) : World.Blocks[index];
+#else
+		dst[i] = World.Blocks[index];
+#endif
+	}
+}
+
+/* Converts the flat blocks arrays of a newly loaded map into chunks, then frees the blocks arrays */
+static void ConvertFlatChunks(void) {
+	convertRow = ReadFlatRow;
+	ConvertChunks();
+
+	Mem_Free(World.Blocks);
+	World.Blocks  = NULL;
+#ifdef EXTENDED_BLOCKS
+	Mem_Free(World.BlocksUpper);
+	World.BlocksUpper = NULL;
+#endif
+}
+
+static void FreeChunks(void) {
+	int i, count = chunksX * chunksY * chunksZ;
+	if (!World.Chunks) return;
+
+	for (i = 0; i < count; i++) { Chunk_Free(&World.Chunks[i]); }
+	Mem_Free(World.Chunks);
+	World.Chunks = NULL;
+}
+
+BlockID World_GetBlock(int x, int y, int z) {
+	return Chunk_GetBlock(&World.Chunks[World_PackChunk(x, y, z)], Chunk_Index(x, y, z));
+}
+
+BlockID World_GetBlockAt(int i) {
+	int x, y, z;
+	World_Unpack(i, x, y, z);
+	return World_GetBlock(x, y, z);
+}
+
+/* Gets count blocks from the chunk, starting at the i'th block and advancing by step blocks each time */
+static void Chunk_GetBlocks(const struct WorldChunk* c, BlockID* dst, int i, int step, int count) {
+	int j, bits = c->Bits, wordShift, mask;
+	if (!bits) {
+		for (j = 0; j < count; j++) { dst[j] = c->Palette[0]; }
+	} else if (bits == CHUNK_RAW_BITS) {
+		for (j = 0; j < count; j++, i += step) { dst[j] = (BlockID)Chunk_GetValue(c, i); }
+	} else {
+		/* Same as Chunk_GetValue, but without working out the bit layout for every block */
+		wordShift = chunk_wordShift[bits];
+		mask      = (1 << wordShift) - 1;
+		for (j = 0; j < count; j++, i += step) {
+			dst[j] = c->Palette[(c->Data[i >> wordShift] >> ((i & mask) * bits)) & ((1 << bits) - 1)];
+		}
+	}
+}
+
+void World_GetBlockRow(BlockID* dst, int x, int y, int z, int count) {
+	int n;
+	for (; count > 0; x += n, dst += n, count -= n) {
+		n = min(count, CHUNK_SIZE - (x & CHUNK_MASK));
+		Chunk_GetBlocks(&World.Chunks[World_PackChunk(x, y, z)], dst, Chunk_Index(x, y, z), 1, n);
+	}
+}
+
+void World_GetBlockColumn(BlockID* dst, int x, int y, int z, int count) {
+	int n;
+	for (; count > 0; y += n, dst += n, count -= n) {
+		n = min(count, CHUNK_SIZE - (y & CHUNK_MASK));
+		Chunk_GetBlocks(&World.Chunks[World_PackChunk(x, y, z)], dst, Chunk_Index(x, y, z), CHUNK_SIZE_2, n);
+	}
+}
+
+void World_SetBlock(int x, int y, int z, BlockID block) {
+	struct WorldChunk* c = &World.Chunks[World_PackChunk(x, y, z)];
+	int i = Chunk_Index(x, y, z);
+	if (chunkSummaries) UpdateChunkSummary(x, y, z, Chunk_GetBlock(c, i), block);
+
+	Chunk_SetBlock(c, i, block);
+#ifdef EXTENDED_BLOCKS
+	if (block > 0xFF) World.IDMask = 0x3FF;
+#endif
+}
+
+static void UnpackBlocks(BlockRaw* dst, int index, int count, int shift) {
+	BlockID row[CHUNK_SIZE];
+	int i, n, x, y, z;
+	World_Unpack(index, x, y, z);
+
+	for (; count > 0; dst += n, count -= n) {
+		n = min(count, min(CHUNK_SIZE, World.Width - x));
+		World_GetBlockRow(row, x, y, z, n);
+		for (i = 0; i < n; i++) { dst[i] = (BlockRaw)(row[i] >> shift); }
+
+		if ((x += n) < World.Width) continue;
+		x = 0;
+		if (++z < World.Length) continue;
+		z = 0; y++;
+	}
+}
+
+void World_UnpackLower(BlockRaw* dst, int index, int count) { UnpackBlocks(dst, index, count, 0); }
+#ifdef EXTENDED_BLOCKS
+void World_UnpackUpper(BlockRaw* dst, int index, int count) { UnpackBlocks(dst, index, count, 8); }
+#endif
+
+
+/*########################################################################################################################*
+*------------------------------------------------------Streamed map-------------------------------------------------------*
+*#########################################################################################################################*/
+/* The dimensions of a map received from a server are only known after all of its blocks have been received. */
+/* So until then, blocks are stored as runs of CHUNK_SIZE_3 blocks in map order, with each run palette compressed */
+/*  the same way as chunks are. The runs are then converted into chunks once the dimensions are known. */
+static struct WorldChunk* streamRuns;
+static int streamVolume, streamRunsCount, streamRunsFreed;
+static cc_bool streamUpper;
+/* Lookup for Chunk_Build, as blocks are streamed in on a different thread to the worker threads */
+static cc_uint16 stream_lookup[BLOCK_COUNT];
+#define STREAM_RUN_SHIFT (CHUNK_SHIFT * 3)
+
+/* Frees all the streamed runs of blocks before the given block index */
+static void StreamedRuns_Free(int end) {
+	int last = min(end >> STREAM_RUN_SHIFT, streamRunsCount);
+	if (!streamRuns) return;
+
+	for (; streamRunsFreed < last; streamRunsFreed++) {
+		Chunk_Free(&streamRuns[streamRunsFreed]);
+	}
+}
+
+static void FreeStream(void) {
+	StreamedRuns_Free(Int32_MaxValue);
+	Mem_Free(streamRuns);
+	streamRuns = NULL;
+}
+
+cc_bool World_BeginStream(int volume) {
+	/* Lower and upper bits of blocks are streamed in separately, and both begin the stream */
+	if (streamRuns && streamVolume == volume) return true;
+	FreeStream();
+	streamVolume    = volume;
+	streamRunsCount = (volume + CHUNK_SIZE_3 - 1) >> STREAM_RUN_SHIFT;
+	streamRunsFreed = 0;
+	streamUpper     = false;
+
+	streamRuns = (struct WorldChunk*)Mem_TryAllocCleared(streamRunsCount, sizeof(struct WorldChunk));
+	return streamRuns != NULL;
+}
+
+void World_StreamBlocks(const BlockRaw* src, int index, int count, int shift) {
+	struct WorldChunk* run = &streamRuns[index >> STREAM_RUN_SHIFT];
+	BlockID blocks[CHUNK_SIZE_3];
+	/* Keeps the bits of the blocks that are not being streamed in */
+	int i, keep = shift ? 0xFF : ~0xFF;
+
+	if (shift) {
+		/* Most maps have very few blocks above 255, so avoid rebuilding runs when nothing would change */
+		for (i = 0; i < count && !src[i]; i++) { }
+		if (i == count) return;
+		streamUpper = true;
+	}
+
+	/* Bits is 0 and Palette is NULL only when the run has not been built yet (i.e. is all air) */
+	if (run->Bits || run->Palette) {
+		Chunk_GetBlocks(run, blocks, 0, 1, CHUNK_SIZE_3);
+	} else {
+		Mem_Set(blocks, 0, sizeof(blocks));
+	}
+
+	for (i = 0; i < count; i++) {
+		blocks[i] = (BlockID)((blocks[i] & keep) | (src[i] << shift));
+	}
+	/* Reuse an existing block for the part of the last run past the end of the map */
+	for (; i < CHUNK_SIZE_3; i++) { blocks[i] = blocks[0]; }
+
+	Chunk_Free(run);
+	Chunk_Build(run, blocks, stream_lookup);
+}
+
+static void ReadStreamedRow(BlockID* dst, int index, int count) {
+	int n;
+	for (; count > 0; index += n, dst += n, count -= n) {
+		n = min(count, CHUNK_SIZE_3 - (index & (CHUNK_SIZE_3 - 1)));
+		Chunk_GetBlocks(&streamRuns[index >> STREAM_RUN_SHIFT], dst, index & (CHUNK_SIZE_3 - 1), 1, n);
+	}
+}
+
+/* Converts the streamed in runs of blocks into chunks */
+static void ConvertStreamedChunks(void) {
+	convertRow = ReadStreamedRow;
+	ConvertChunks();
+	FreeStream();
+}
+#endif
+
+
 /*########################################################################################################################*
 *----------------------------------------------------------World----------------------------------------------------------*
 *#########################################################################################################################*/
@@ -38,12 +548,17 @@ static void GenerateNewUuid(void) {
 
 void World_Reset(void) {
 #ifdef EXTENDED_BLOCKS
-	if (World.Blocks != World.Blocks2) Mem_Free(World.Blocks2);
-	World.Blocks2 = NULL;
+	Mem_Free(World.BlocksUpper);
+	World.BlocksUpper = NULL;
 	World.IDMask  = 0xFF;
 #endif
 	Mem_Free(World.Blocks);
 	World.Blocks = NULL;
+#ifdef PALETTE_BLOCKS
+	FreeChunks();
+	FreeStream();
+#endif
+	FreeChunkSummaries();
 
 	World_SetDimensions(0, 0, 0);
 	World.Loaded = false;
@@ -55,6 +570,19 @@ void World_NewMap(void) {
 	Event_RaiseVoid(&WorldEvents.NewMap);
 }
 
+/* Raises the events for a newly loaded map, after its blocks have been set */
+static void FinishNewMap(void) {
+	if (Env.EdgeHeight == -1)   { Env.EdgeHeight   = World.Height / 2; }
+	if (Env.CloudsHeight == -1) { Env.CloudsHeight = World.Height + 2; }
+
+	GenerateNewUuid();
+	FreeChunkSummaries();
+	if (World_HasBlocks()) InitChunkSummaries();
+
+	World.Loaded = true;
+	Event_RaiseVoid(&WorldEvents.MapLoaded);
+}
+
 void World_SetNewMap(BlockRaw* blocks, int width, int height, int length) {
 	/* TODO: TEMP HACK */
 	if (!blocks) { width = 0; height = 0; length = 0; }
@@ -65,19 +593,34 @@ void World_SetNewMap(BlockRaw* blocks, int width, int height, int length) {
 	if (!World.Volume) World.Blocks = NULL;
 #ifdef EXTENDED_BLOCKS
 	/* .cw maps may have set this to a non-NULL when importing */
-	if (!World.Blocks2) {
-		World.Blocks2 = World.Blocks;
-		World.IDMask  = 0xFF;
+	if (!World.Blocks) {
+		Mem_Free(World.BlocksUpper);
+		World.BlocksUpper = NULL;
 	}
+	if (!World.BlocksUpper) World.IDMask = 0xFF;
+#endif
+#ifdef PALETTE_BLOCKS
+	/* Any partially streamed map is discarded (e.g. its volume did not match the dimensions) */
+	FreeStream();
+	if (World.Blocks) ConvertFlatChunks();
 #endif
+	FinishNewMap();
+}
 
-	if (Env.EdgeHeight == -1)   { Env.EdgeHeight   = height / 2; }
-	if (Env.CloudsHeight == -1) { Env.CloudsHeight = height + 2; }
+#ifdef PALETTE_BLOCKS
+void World_SetStreamedMap(int width, int height, int length) {
+	if (!streamRuns || !streamVolume || width * height * length != streamVolume) {
+		World_SetNewMap(NULL, width, height, length); return;
+	}
 
-	GenerateNewUuid();
-	World.Loaded = true;
-	Event_RaiseVoid(&WorldEvents.MapLoaded);
+	World_SetDimensions(width, height, length);
+#ifdef EXTENDED_BLOCKS
+	World.IDMask = streamUpper ? 0x3FF : 0xFF;
+#endif
+	ConvertStreamedChunks();
+	FinishNewMap();
 }
+#endif
 
 CC_NOINLINE void World_SetDimensions(int width, int height, int length) {
 	World.Width  = width; World.Height = height; World.Length = length;
@@ -91,9 +634,26 @@ CC_NOINLINE void World_SetDimensions(int width, int height, int length) {
 
 #ifdef EXTENDED_BLOCKS
 void World_SetMapUpper(BlockRaw* blocks) {
-	World.Blocks2 = blocks;
+	World.BlocksUpper = blocks;
 	World.IDMask  = 0x3FF;
 }
+
+static CC_INLINE void SetUpper(BlockRaw* upper, int i, int value) {
+	int shift = (i & 3) << 1;
+	upper[i >> 2] = (BlockRaw)((upper[i >> 2] & ~(3 << shift)) | ((value & 3) << shift));
+}
+
+void World_PackUpper(BlockRaw* upper, int index, const BlockRaw* src, int count) {
+	int i;
+	for (i = 0; i < count; i++) { SetUpper(upper, index + i, src[i]); }
+}
+
+#ifndef PALETTE_BLOCKS
+void World_UnpackUpper(BlockRaw* dst, int index, int count) {
+	int i;
+	for (i = 0; i < count; i++) { dst[i] = World_GetUpper(index + i); }
+}
+#endif
 #endif
 
 void World_OutOfMemory(void) {
@@ -102,30 +662,35 @@ void World_OutOfMemory(void) {
 }
 
 
-#ifdef EXTENDED_BLOCKS
+#if defined PALETTE_BLOCKS
+/* World_SetBlock is implemented along with the palette chunks */
+#elif defined EXTENDED_BLOCKS
 static CC_NOINLINE void LazyInitUpper(int i, BlockID block) {
-	BlockRaw* data = (BlockRaw*)Mem_TryAllocCleared(World.Volume, 1);
+	BlockRaw* data = (BlockRaw*)Mem_TryAllocCleared(World_UpperSize(World.Volume), 1);
 	if (!data) { World_OutOfMemory(); return; }
 
 	World_SetMapUpper(data);
-	World.Blocks2[i] = (BlockRaw)(block >> 8);
+	SetUpper(World.BlocksUpper, i, block >> 8);
 }
 
 void World_SetBlock(int x, int y, int z, BlockID block) {
 	int i = World_Pack(x, y, z);
+	if (chunkSummaries) UpdateChunkSummary(x, y, z, World_GetBlock(x, y, z), block);
 	World.Blocks[i] = (BlockRaw)block;
 
 	/* defer allocation of second map array if possible */
-	if (World.Blocks == World.Blocks2) {
+	if (!World.BlocksUpper) {
 		if (block < 256) return;
 		LazyInitUpper(i, block);
 		return;
 	}
-	World.Blocks2[i] = (BlockRaw)(block >> 8);
+	SetUpper(World.BlocksUpper, i, block >> 8);
 }
 #else
 void World_SetBlock(int x, int y, int z, BlockID block) {
-	World.Blocks[World_Pack(x, y, z)] = block; 
+	int i = World_Pack(x, y, z);
+	if (chunkSummaries) UpdateChunkSummary(x, y, z, World.Blocks[i], block);
+	World.Blocks[i] = block; 
 }
 #endif
 
@@ -302,7 +867,12 @@ Vec3 Respawn_FindSpawnPosition(float x, float z, Vec3 modelSize) {
 	return spawn;
 }
 
+static void OnInit(void) {
+	Event_Register_(&BlockEvents.BlockDefChanged, NULL, OnBlockDefChanged);
+	World_Reset();
+}
+
 struct IGameComponent World_Component = {
-	World_Reset, /* Init  */
+	OnInit,      /* Init  */
 	World_Reset  /* Free  */
 };
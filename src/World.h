@@ -6,7 +6,13 @@
    Also contains associated environment metadata.
    Copyright 2014-2021 ClassiCube | Licensed under BSD-3
 */
+/* NOTE: When PALETTE_BLOCKS is defined, blocks are instead stored in 16x16x16 chunks, with each chunk */
+/*  only using as many bits per block as the number of different blocks in it needs (see World.c). */
+/*  This uses far less memory for most maps, but accessing blocks is slower. */
+/*  World.Blocks/World.BlocksUpper are then only used while loading or generating a map, and are NULL once it is loaded. */
+/*  Maps received from servers skip them entirely. (see World_BeginStream) */
 struct AABB;
+struct WorldChunk;
 extern struct IGameComponent World_Component;
 
 /* Unpacka an index into x,y,z (slow!) */
@@ -19,9 +25,15 @@ CC_VAR extern struct _WorldData {
 	/* The blocks in the world. */
 	BlockRaw* Blocks;
 #ifdef EXTENDED_BLOCKS
-	/* The upper 8 bit of blocks in the world. */
-	/* If only 8 bit blocks are used, equals World_Blocks. */
-	BlockRaw* Blocks2;
+	/* The upper bits of blocks in the world, bit-packed as 2 bits per block. */
+	/* NULL if only 8 bit blocks are used. (see World_GetUpper) */
+	/* NOTE: This replaces Blocks2, which stored the upper 8 bits as one byte per block. */
+	/*  It was renamed so that plugins still indexing it as bytes fail to compile instead. */
+	BlockRaw* BlocksUpper;
+#endif
+#ifdef PALETTE_BLOCKS
+	/* The blocks in the world, stored as 16x16x16 chunks. */
+	struct WorldChunk* Chunks;
 #endif
 	/* Volume of the world. */
 	int Volume;
@@ -37,8 +49,9 @@ CC_VAR extern struct _WorldData {
 	cc_uint8 Uuid[WORLD_UUID_LEN];
 
 #ifdef EXTENDED_BLOCKS
-	/* Masks access to World.Blocks/World.Blocks2 */
+	/* Masks access to World.Blocks/World.BlocksUpper */
 	/* e.g. this will be 255 if only 8 bit blocks are used */
+	/* NOTE: With PALETTE_BLOCKS, greater than 255 once any block above 255 has been placed */
 	int IDMask;
 #endif
 	/* Whether the world has finished loading/generating. */
@@ -60,18 +73,71 @@ CC_NOINLINE void World_SetDimensions(int width, int height, int length);
 void World_OutOfMemory(void);
 
 #ifdef EXTENDED_BLOCKS
-/* Sets World.Blocks2 and updates internal state for more than 256 blocks. */
+/* Size in bytes of the bit-packed upper bits array for the given number of blocks. */
+#define World_UpperSize(volume) (((volume) + 3) >> 2)
+/* Gets the upper bits of the block at the given index. */
+/* NOTE: World.BlocksUpper must not be NULL. (i.e. World.IDMask is greater than 0xFF) */
+#define World_GetUpper(i) ((World.BlocksUpper[(i) >> 2] >> (((i) & 3) << 1)) & 3)
+
+/* Sets World.BlocksUpper and updates internal state for more than 256 blocks. */
+/* NOTE: The upper bits in blocks must already be bit-packed. (see World_PackUpper) */
 void World_SetMapUpper(BlockRaw* blocks);
+/* Bit-packs the upper 8 bits of count blocks into the upper bits array, starting at the given block index. */
+void World_PackUpper(BlockRaw* upper, int index, const BlockRaw* src, int count);
+/* Unpacks the upper bits of count blocks, starting at the given block index. */
+void World_UnpackUpper(BlockRaw* dst, int index, int count);
+#endif
 
+#if defined PALETTE_BLOCKS
+/* Gets the block at the given coordinates. */
+/* NOTE: Does NOT check that the coordinates are inside the map. */
+BlockID World_GetBlock(int x, int y, int z);
+/* Gets the block at the given index. (see World_Pack) */
+/* NOTE: Does NOT check that the index is inside the map. */
+BlockID World_GetBlockAt(int i);
+/* Gets count blocks along the X axis, starting at the given coordinates. */
+/* NOTE: Much faster than calling World_GetBlock for each block. */
+/* NOTE: Does NOT check that the blocks are inside the map. */
+void World_GetBlockRow(BlockID* dst, int x, int y, int z, int count);
+/* Gets count blocks along the Y axis, starting at the given coordinates and going upwards. */
+/* NOTE: Much faster than calling World_GetBlock for each block. */
+/* NOTE: Does NOT check that the blocks are inside the map. */
+void World_GetBlockColumn(BlockID* dst, int x, int y, int z, int count);
+/* Gets the lower 8 bits of the block at the given index. */
+#define World_GetRawBlock(i) ((BlockRaw)World_GetBlockAt(i))
+/* Unpacks the lower 8 bits of count blocks, starting at the given block index. */
+void World_UnpackLower(BlockRaw* dst, int index, int count);
+/* Whether the blocks of the world have been loaded. (i.e. a map was loaded without errors) */
+#define World_HasBlocks() (World.Chunks != NULL)
+
+/* Begins streaming in the blocks of a map, whose dimensions are not known yet. (e.g. a map from a server) */
+/* NOTE: Blocks are palette compressed as they are streamed in, so the map never needs a flat blocks array. */
+/* Returns false if there was not enough memory. */
+/* NOTE: Does nothing if a map with the same volume is already being streamed in. (World_Reset stops streaming) */
+cc_bool World_BeginStream(int volume);
+/* Streams in the lower (shift of 0) or upper (shift of 8) bits of count blocks, starting at the given block index. */
+/* NOTE: index must be a multiple of CHUNK_SIZE_3, and count must be CHUNK_SIZE_3 unless it reaches the end of the map. */
+void World_StreamBlocks(const BlockRaw* src, int index, int count, int shift);
+/* Converts the streamed in blocks into chunks, then sets up the map like World_SetNewMap. */
+/* NOTE: If the stream failed or its volume does not match the dimensions, the map is left empty instead. */
+void World_SetStreamedMap(int width, int height, int length);
+#else
+#ifdef EXTENDED_BLOCKS
 /* Gets the block at the given coordinates. */
 /* NOTE: Does NOT check that the coordinates are inside the map. */
 static CC_INLINE BlockID World_GetBlock(int x, int y, int z) {
 	int i = World_Pack(x, y, z);
-	return (BlockID)((World.Blocks[i] | (World.Blocks2[i] << 8)) & World.IDMask);
+	if (!World.BlocksUpper) return World.Blocks[i];
+	return (BlockID)(World.Blocks[i] | (World_GetUpper(i) << 8));
 }
 #else
 #define World_GetBlock(x, y, z) World_Blocks[World_Pack(x, y, z)]
 #endif
+/* Gets the lower 8 bits of the block at the given index. */
+#define World_GetRawBlock(i) World.Blocks[i]
+/* Whether the blocks of the world have been loaded. (i.e. a map was loaded without errors) */
+#define World_HasBlocks() (World.Blocks != NULL)
+#endif
 
 /* If Y is above the map, returns BLOCK_AIR. */
 /* If coordinates are outside the map, returns BLOCK_AIR. */
@@ -84,6 +150,28 @@ void World_SetBlock(int x, int y, int z, BlockID block);
 /* Otherwise returns the block at the given coordinates. */
 BlockID World_SafeGetBlock(int x, int y, int z);
 
+/* Summary of the blocks in a 16x16x16 chunk of the world. */
+/* Calculated for all chunks when a map is loaded, then kept up to date by World_SetBlock. */
+struct ChunkSummary {
+	cc_uint16 Total;  /* Number of blocks in the chunk. (less than 4096 for chunks on the map edges) */
+	cc_uint16 Gas;    /* Number of blocks with DRAW_GAS draw type. (e.g. air) */
+	cc_uint16 Opaque; /* Number of fully opaque blocks. (see Blocks.FullOpaque) */
+	cc_uint16 RandomTicks; /* Number of blocks that are randomly ticked. (see Physics.OnRandomTick) */
+	cc_uint16 Sponges; /* Number of sponge blocks. (kept up to date even when Dirty, as it only depends on block IDs) */
+	cc_bool Dirty;    /* Whether counts need to be recalculated. (e.g. block definitions changed) */
+};
+/* Returns the summary of the blocks in the chunk at the given chunk coordinates, or NULL if not available. */
+/* NOTE: Does NOT check that the coordinates are inside the map. */
+/* NOTE: Dirty summaries are recalculated, so this must only be called from the main thread. */
+struct ChunkSummary* World_GetChunkSummary(int cx, int cy, int cz);
+/* Returns the number of sponges in the chunk at the given chunk coordinates, or -1 if not available. */
+/* NOTE: Does NOT check that the coordinates are inside the map. */
+/* NOTE: Unlike World_GetChunkSummary, can be called from worker threads while the main thread waits on them. */
+int World_CountChunkSponges(int cx, int cy, int cz);
+/* Marks all chunk summaries as needing to be recalculated, the next time they are retrieved. */
+/* NOTE: Physics automatically calls this when which blocks have Physics.OnRandomTick handlers changes. */
+void World_InvalidateChunkSummaries(void);
+
 /* Whether the given coordinates lie inside the map. */
 static CC_INLINE cc_bool World_Contains(int x, int y, int z) {
 	return (unsigned)x < (unsigned)World.Width